@@ -1,15 +1,87 @@
 #pragma once
 #include <Arduino.h>
+#include <Wire.h>
+
+#if !configUSE_TICKLESS_IDLE
+#error "LowPower::sleepMs relies on the FreeRTOS tickless idle (configUSE_TICKLESS_IDLE)"
+#endif
 
 namespace LowPower {
 
-    // Sleep using nRF52 low power wait-for-event
+    // Sleep with the RTOS tick stopped. Blocking the loop task leaves only
+    // the idle task to run, and its tickless hook sets an RTC1 compare for
+    // the wake-up tick, masks the tick interrupt and waits for events; on
+    // wake the tick count is stepped over the sleep, so millis() stays
+    // right. A __WFE() loop here would keep the task runnable and wake the
+    // CPU on every 1024 Hz tick for the whole interval.
     inline void sleepMs(uint32_t ms) {
-        uint32_t start = millis();
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    }
+
+    // ===== TWIM =====
+    // Wire runs on TWIM0. Disabling it is not always enough: the EasyDMA
+    // peripheral can keep drawing a static current afterwards (anomaly 89),
+    // so it is also power-cycled through its POWER register, which puts
+    // every register back to reset.
+    inline void i2cPowerDown() {
+        Wire.end();
+        volatile uint32_t *power = (volatile uint32_t *)((uint32_t)NRF_TWIM0 + 0xFFC);
+        *power = 0;
+        (void)*power;
+        *power = 1;
+    }
+
+    // Pins, frequency and interrupt set up again from reset.
+    inline void i2cPowerUp(uint32_t clock_hz) {
+        Wire.begin();
+        Wire.setClock(clock_hz);
+    }
+
+    // ===== CURRENT ESTIMATE =====
+    // Datasheet typicals at 3 V. They cover the nRF52840 and the sensors,
+    // not the board's regulator; measure a board to replace them.
+    constexpr float MCU_RUN_MA = 6.3f;          // CPU running from flash, LDO
+    constexpr float LED_MA = 2.0f;              // status LED, lit while reading
+    // One measurement of each per cycle; they sleep in between.
+    constexpr float AHT20_MEASURE_MA = 0.98f;
+    constexpr float AHT20_MEASURE_MS = 80.0f;
+    constexpr float BMP280_MEASURE_MA = 0.72f;  // forced, x1 temp / x4 pressure
+    constexpr float BMP280_MEASURE_MS = 13.3f;
+    // One force-state measurement, stand-by (PC = 0) otherwise; the
+    // datasheet gives no measuring current, so this is a generous guess.
+    constexpr float HSCDTD_MEASURE_MA = 0.5f;
+    constexpr float HSCDTD_MEASURE_MS = 5.0f;
+    // Each sensor only at its stand-by figure: the HSCDTD008A's 1 uA holds
+    // only because SensorManager parks it in stand-by between reads.
+    constexpr float SLEEP_UA = 3.16f + 0.25f + 0.1f + 1.0f;  // nRF System ON + RTC, AHT20, BMP280, HSCDTD
+    constexpr float COIN_CELL_MAH = 220.0f;     // CR2032
+
+    // Mean current over one cycle of `awake_ms` running and `sleep_ms`
+    // asleep. Awake time counts as CPU time throughout, so this is an upper
+    // bound: the waits inside the sensor drivers are delay()s, which sleep
+    // tickless too.
+    inline float averageCurrentUa(uint32_t awake_ms, uint32_t sleep_ms) {
+        // mA x ms = uC
+        float charge_uc = awake_ms * (MCU_RUN_MA + LED_MA);
+        charge_uc += AHT20_MEASURE_MA * AHT20_MEASURE_MS + BMP280_MEASURE_MA * BMP280_MEASURE_MS +
+                     HSCDTD_MEASURE_MA * HSCDTD_MEASURE_MS;
+        charge_uc += sleep_ms * SLEEP_UA / 1000.0f;
+        return charge_uc * 1000.0f / (awake_ms + sleep_ms);
+    }
+
+    inline void printEstimate(uint32_t awake_ms, uint32_t sleep_ms) {
+        float avg_ua = averageCurrentUa(awake_ms, sleep_ms);
+        float charge_uc = avg_ua * (awake_ms + sleep_ms) / 1000.0f;
 
-        while ((millis() - start) < ms) {
-            __WFE();   // CPU sleep until interrupt/event
-        }
+        Serial.print("Power: awake ");
+        Serial.print(awake_ms);
+        Serial.print(" ms, ");
+        Serial.print(charge_uc, 1);
+        Serial.print(" uC/cycle, avg ");
+        Serial.print(avg_ua, 1);
+        Serial.print(" uA, CR2032 ~");
+        Serial.print(COIN_CELL_MAH * 1000.0f / avg_ua / 24.0f, 0);
+        Serial.println(" days");
     }
 
 }
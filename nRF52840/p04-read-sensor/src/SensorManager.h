@@ -4,11 +4,21 @@
 #include <Wire.h>
 #include <Adafruit_AHTX0.h>
 #include <Adafruit_BMP280.h>
+#include "LowPower.h"
 
 // ===== HSCDTD008A DEFINITIONS =====
 #define HSCDTD_ADDR 0x0C
-#define HSCDTD_CTRL 0x0B
-#define HSCDTD_DATA 0x00
+#define HSCDTD_DATA 0x10          // OUTX_L; X, Y, Z little-endian
+#define HSCDTD_STAT 0x18
+#define HSCDTD_CTRL1 0x1B
+#define HSCDTD_CTRL3 0x1D
+#define HSCDTD_STAT_DRDY 0x40
+#define HSCDTD_CTRL1_STANDBY 0x02  // PC = stand-by, FS = force state
+#define HSCDTD_CTRL1_ACTIVE 0x82   // PC = active, FS = force state
+#define HSCDTD_CTRL3_FORCE 0x40    // FRC: start one measurement
+#define HSCDTD_MEASURE_TIMEOUT_MS 20
+
+#define I2C_CLOCK_HZ 100000
 
 class SensorManager {
 public:
@@ -23,7 +33,7 @@ public:
         Serial.println("Initializing Sensors...");
 
         Wire.setPins(_sda, _scl);
-        Wire.setClock(100000);
+        Wire.setClock(I2C_CLOCK_HZ);
 
         // ----- AHT20 -----
         if (!_aht.begin()) {
@@ -36,6 +46,13 @@ public:
             Serial.println("ERROR: BMP280 not found");
             errorBlink();
         }
+        // Forced mode: one conversion per read, asleep in between. The
+        // library's default is normal mode, converting continuously.
+        _bmp.setSampling(Adafruit_BMP280::MODE_FORCED,
+                         Adafruit_BMP280::SAMPLING_X1,
+                         Adafruit_BMP280::SAMPLING_X4,
+                         Adafruit_BMP280::FILTER_OFF,
+                         Adafruit_BMP280::STANDBY_MS_1);
 
         // ----- HSCDTD008A -----
         delay(3000);
@@ -44,9 +61,13 @@ public:
 
         Serial.println("All sensors initialized successfully");
         Serial.println();
+
+        LowPower::i2cPowerDown();
     }
+    // The bus is powered up for the reads and down again after them.
     void readAndPrint() {
         digitalWrite(_led, HIGH);
+        LowPower::i2cPowerUp(I2C_CLOCK_HZ);
         debugMagID();
 
         // ===== AHT20 =====
@@ -54,12 +75,14 @@ public:
         _aht.getEvent(&humidity, &temp);
 
         // ===== BMP280 =====
+        _bmp.takeForcedMeasurement();
         float pressure = _bmp.readPressure() / 100.0;
         float altitude = _bmp.readAltitude(1013.25);
 
         // ===== HSCDTD008A =====
         int16_t mx = 0, my = 0, mz = 0;
         bool mag_ok = readMagnetometer(mx, my, mz);
+        LowPower::i2cPowerDown();
         float heading = computeHeading(mx, my);
 
         // ===== PRINT =====
@@ -107,54 +130,48 @@ private:
     Adafruit_BMP280 _bmp;
 
     // ===== HSCDTD INIT =====
-void initMagnetometer() {
-    Serial.println("Initializing HSCDTD008A...");
-
-    // Step 1: Power Control - set PC bit (active)
-    Wire.beginTransmission(HSCDTD_ADDR);
-    Wire.write(0x1B);   // Control Register 1
-    Wire.write(0x80);   // Set PC bit to 1 (active)
-    Wire.endTransmission();
-    delay(10);
-
-    // Step 2: Set Normal (Continuous) Mode
-    Wire.beginTransmission(HSCDTD_ADDR);
-    Wire.write(0x1C);   // Mode register
-    Wire.write(0x00);   // Normal (continuous) mode
-    Wire.endTransmission();
-    delay(10);
-
-    // Optional: Read back registers for debug
-    // Read Control Register 1 (0x1B)
-    Wire.beginTransmission(HSCDTD_ADDR);
-    Wire.write(0x1B);
-    Wire.endTransmission(false);
-    Wire.requestFrom(HSCDTD_ADDR, (uint8_t)1);
-    if (Wire.available()) {
-        uint8_t ctrl1 = Wire.read();
-        Serial.print("HSCDTD008A CTRL1 reg: 0x");
-        Serial.println(ctrl1, HEX);
-    } else {
-        Serial.println("Failed to read CTRL1 reg");
-    }
+    // Force state, parked in stand-by: each read powers it up for one
+    // measurement and puts it back. Continuous (normal) mode would keep it
+    // measuring between reads, far above its stand-by current.
+    void initMagnetometer() {
+        Serial.println("Initializing HSCDTD008A...");
+
+        writeMagRegister(HSCDTD_CTRL1, HSCDTD_CTRL1_STANDBY);
+        delay(10);
+
+        uint8_t ctrl1 = 0;
+        if (readMagRegisters(HSCDTD_CTRL1, &ctrl1, 1)) {
+            Serial.print("HSCDTD008A CTRL1 reg: 0x");
+            Serial.println(ctrl1, HEX);
+        } else {
+            Serial.println("Failed to read CTRL1 reg");
+        }
 
-    // Read Mode Register (0x1C)
-    Wire.beginTransmission(HSCDTD_ADDR);
-    Wire.write(0x1C);
-    Wire.endTransmission(false);
-    Wire.requestFrom(HSCDTD_ADDR, (uint8_t)1);
-    if (Wire.available()) {
-        uint8_t mode = Wire.read();
-        Serial.print("HSCDTD008A MODE reg: 0x");
-        Serial.println(mode, HEX);
-    } else {
-        Serial.println("Failed to read MODE reg");
+        Serial.println("HSCDTD008A force state, stand-by between reads");
     }
 
-    Serial.println("HSCDTD008A continuous mode enabled");
-}
-
+    bool writeMagRegister(uint8_t reg, uint8_t value) {
+        Wire.beginTransmission(HSCDTD_ADDR);
+        Wire.write(reg);
+        Wire.write(value);
+        return Wire.endTransmission() == 0;
+    }
 
+    bool readMagRegisters(uint8_t reg, uint8_t *dst, uint8_t len) {
+        // Set register pointer with repeated start (no stop)
+        Wire.beginTransmission(HSCDTD_ADDR);
+        Wire.write(reg);
+        if (Wire.endTransmission(false) != 0) {
+            return false;
+        }
+        if (Wire.requestFrom(HSCDTD_ADDR, len) != len) {
+            return false;
+        }
+        for (uint8_t i = 0; i < len; i++) {
+            dst[i] = Wire.read();
+        }
+        return true;
+    }
 
     void debugMagID() {
         Wire.beginTransmission(HSCDTD_ADDR);
@@ -175,48 +192,55 @@ void initMagnetometer() {
     }
 
     // ===== HSCDTD READ =====
-bool readMagnetometer(int16_t &mx, int16_t &my, int16_t &mz) {
-    uint8_t reg = 0x00;
-    uint8_t raw[6];
-
-    // Set register pointer with repeated start (no stop)
-    Wire.beginTransmission(HSCDTD_ADDR);
-    Wire.write(reg);
-    if (Wire.endTransmission(false) != 0) {
-        Serial.println("Magnetometer register pointer set failed");
-        return false;
-    }
-
-    // Read 6 bytes
-    Wire.requestFrom(HSCDTD_ADDR, (uint8_t)6);
-    if (Wire.available() != 6) {
-        Serial.println("Magnetometer read failed");
-        return false;
-    }
-    for (int i = 0; i < 6; i++) {
-        raw[i] = Wire.read();
-    }
-
-    Serial.print("Mag raw bytes: ");
-    for (int i = 0; i < 6; i++) {
-        Serial.print("0x");
-        Serial.print(raw[i], HEX);
-        Serial.print(" ");
+    // One force-state measurement, from stand-by and back to it whatever
+    // happens in between.
+    bool readMagnetometer(int16_t &mx, int16_t &my, int16_t &mz) {
+        bool ok = measureMagnetometer(mx, my, mz);
+        if (!writeMagRegister(HSCDTD_CTRL1, HSCDTD_CTRL1_STANDBY)) {
+            Serial.println("Magnetometer stand-by failed");
+        }
+        return ok;
     }
-    Serial.println();
-
-    mx = (raw[0] << 8) | raw[1];
-    my = (raw[2] << 8) | raw[3];
-    mz = (raw[4] << 8) | raw[5];
-
-    return true;
-}
 
+    bool measureMagnetometer(int16_t &mx, int16_t &my, int16_t &mz) {
+        if (!writeMagRegister(HSCDTD_CTRL1, HSCDTD_CTRL1_ACTIVE) ||
+            !writeMagRegister(HSCDTD_CTRL3, HSCDTD_CTRL3_FORCE)) {
+            Serial.println("Magnetometer trigger failed");
+            return false;
+        }
 
+        uint32_t start = millis();
+        uint8_t stat = 0;
+        while (!(stat & HSCDTD_STAT_DRDY)) {
+            if (millis() - start > HSCDTD_MEASURE_TIMEOUT_MS || !readMagRegisters(HSCDTD_STAT, &stat, 1)) {
+                Serial.println("Magnetometer measurement timed out");
+                return false;
+            }
+            if (!(stat & HSCDTD_STAT_DRDY)) {
+                delay(1);
+            }
+        }
 
+        uint8_t raw[6];
+        if (!readMagRegisters(HSCDTD_DATA, raw, sizeof(raw))) {
+            Serial.println("Magnetometer read failed");
+            return false;
+        }
 
+        Serial.print("Mag raw bytes: ");
+        for (int i = 0; i < 6; i++) {
+            Serial.print("0x");
+            Serial.print(raw[i], HEX);
+            Serial.print(" ");
+        }
+        Serial.println();
 
+        mx = (int16_t)((raw[1] << 8) | raw[0]);
+        my = (int16_t)((raw[3] << 8) | raw[2]);
+        mz = (int16_t)((raw[5] << 8) | raw[4]);
 
+        return true;
+    }
 
     // ===== HEADING CALCULATION =====
     float computeHeading(int16_t mx, int16_t my) {
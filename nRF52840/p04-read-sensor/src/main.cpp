@@ -10,6 +10,8 @@
 #define SCL_PIN PIN_106
 #define LED_PIN PIN_015
 
+#define SLEEP_MS 2000
+
 // ====== GLOBAL OBJECT ======
 SensorManager sensors(SDA_PIN, SCL_PIN, LED_PIN);
 
@@ -21,8 +23,10 @@ void setup() {
 }
 
 void loop() {
+    uint32_t awake_start = millis();
     sensors.readAndPrint();
+    LowPower::printEstimate(millis() - awake_start, SLEEP_MS);
 
-    // Sleep 2000 ms using low power
-    LowPower::sleepMs(2000);
+    // Tickless sleep until the next cycle
+    LowPower::sleepMs(SLEEP_MS);
 }
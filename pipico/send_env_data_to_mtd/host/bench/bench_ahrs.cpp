@@ -0,0 +1,145 @@
+// Host benchmark: the float and Q30 builds of the Mahony filter, fed with
+// the simulated board's IMU and magnetometer at several update rates.
+// Reports time per update and per second of sensor data, and the RMS error
+// of roll, pitch and heading against the simulated truth next to the
+// heading the HSCDTD driver computes from the raw field. Times are for the
+// host CPU; on the target, the float build leans on the RP2350 FPU, and
+// the Q30 build is the one to measure on an RP2040.
+//
+//   ./build-host/bench_ahrs [seconds of data]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ahrs/mahony.h"
+#include "sim/environment.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kMagUtPerLsb = 0.15f;  // as the simulated HSCDTD008A
+constexpr double kSettleS = 10.0;
+
+struct Input {
+    int16_t accel[3];
+    int16_t gyro[3];
+    int16_t mag[3];
+    float roll_deg;
+    float pitch_deg;
+    float heading_deg;
+};
+
+int16_t Counts(float value) {
+    return static_cast<int16_t>(std::lround(value));
+}
+
+std::vector<Input> Generate(uint32_t rate_hz, double seconds) {
+    std::vector<Input> inputs(static_cast<std::size_t>(seconds * rate_hz));
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        const uint64_t t_us = 1000000ull * i / rate_hz;
+        const sim::environment::Conditions c = sim::environment::At(t_us);
+        Input &in = inputs[i];
+        for (int axis = 0; axis < 3; ++axis) {
+            in.accel[axis] = Counts(c.accel_g[axis] * 16384.0f);
+            in.gyro[axis] = Counts(c.gyro_dps[axis] * 131.0f);
+            in.mag[axis] = Counts(c.mag_ut[axis] / kMagUtPerLsb);
+        }
+        in.roll_deg = c.roll_deg;
+        in.pitch_deg = c.pitch_deg;
+        in.heading_deg = c.heading_deg;
+    }
+    return inputs;
+}
+
+double AngleError(double estimate, double truth) {
+    double error = std::fmod(estimate - truth, 360.0);
+    if (error > 180.0) {
+        error -= 360.0;
+    } else if (error < -180.0) {
+        error += 360.0;
+    }
+    return error;
+}
+
+struct Result {
+    double ns_per_update = 0.0;
+    double roll_rms = 0.0;
+    double pitch_rms = 0.0;
+    double heading_rms = 0.0;
+};
+
+template <typename Filter>
+Result Run(uint32_t rate_hz, const std::vector<Input> &inputs) {
+    Result result;
+
+    // Timing pass: updates only.
+    Filter timed(rate_hz);
+    const auto start = std::chrono::steady_clock::now();
+    for (const Input &in : inputs) {
+        timed.Update(in.accel, in.gyro, in.mag);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    result.ns_per_update = std::chrono::duration<double, std::nano>(elapsed).count() / inputs.size();
+    volatile float sink = timed.Get().w;
+    (void)sink;
+
+    // Accuracy pass, once the filter has settled.
+    Filter filter(rate_hz);
+    const std::size_t settle = static_cast<std::size_t>(kSettleS * rate_hz);
+    double roll = 0.0;
+    double pitch = 0.0;
+    double heading = 0.0;
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        const Input &in = inputs[i];
+        filter.Update(in.accel, in.gyro, in.mag);
+        if (i < settle) {
+            continue;
+        }
+        const ahrs::Euler e = ahrs::ToEuler(filter.Get());
+        roll += std::pow(e.roll_deg - in.roll_deg, 2.0);
+        pitch += std::pow(e.pitch_deg - in.pitch_deg, 2.0);
+        heading += std::pow(AngleError(-e.yaw_deg, in.heading_deg), 2.0);
+        ++n;
+    }
+    result.roll_rms = std::sqrt(roll / n);
+    result.pitch_rms = std::sqrt(pitch / n);
+    result.heading_rms = std::sqrt(heading / n);
+    return result;
+}
+
+// hscdtd::DecodeSample's heading: atan2 of the raw horizontal axes.
+double RawHeadingRms(const std::vector<Input> &inputs) {
+    double sum = 0.0;
+    for (const Input &in : inputs) {
+        double heading = std::atan2(static_cast<double>(in.mag[1]), static_cast<double>(in.mag[0])) * 180.0 / kPi;
+        sum += std::pow(AngleError(heading, in.heading_deg), 2.0);
+    }
+    return std::sqrt(sum / inputs.size());
+}
+
+void Print(const char *name, uint32_t rate_hz, const Result &r) {
+    std::printf("%-6s %6lu %11.1f %12.3f %9.2f %9.2f %9.2f\n", name, static_cast<unsigned long>(rate_hz),
+                r.ns_per_update, r.ns_per_update * rate_hz / 1e6, r.roll_rms, r.pitch_rms, r.heading_rms);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 600.0;
+    const uint32_t rates[] = {100, 200, 500, 1000};
+
+    std::printf("filter  rate Hz   ns/update  ms/s of data  roll rms pitch rms  hdg rms  (deg)\n");
+    for (uint32_t rate : rates) {
+        const std::vector<Input> inputs = Generate(rate, seconds);
+        Print("float", rate, Run<ahrs::MahonyFloat>(rate, inputs));
+        Print("q30", rate, Run<ahrs::MahonyFixed>(rate, inputs));
+        if (rate == rates[0]) {
+            std::printf("raw atan2 heading (hscdtd driver): %.2f deg rms\n", RawHeadingRms(inputs));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Host benchmark: cost of composing one frame of display text, formatting
+// every available reading and shuffling them (what display::Render did
+// before the line table) versus display::ComposeRows, which formats only
+// the rows shown. Drawing and the I2C transfer are not included.
+//
+//   ./build-host/bench_display [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "display/lines.h"
+#include "gps/coordinates.h"
+
+// ComposeRows seeds rand() from the clock on first use.
+namespace hal {
+uint64_t TimeUs() {
+    return 1;
+}
+}  // namespace hal
+
+namespace {
+
+constexpr int kMaxEntries = 20;
+
+app::model::SensorSnapshot MakeSnapshot() {
+    app::model::SensorSnapshot s;
+    s.aht20 = {true, 16.13f, 70.0f, 0x18};
+    s.bmp280 = {true, 16.73f, 101321.70f, 0.27f};
+    s.mpu6050.valid = true;
+    s.mpu6050.accel_x = -191;
+    s.mpu6050.accel_y = -568;
+    s.mpu6050.accel_z = 16384;
+    s.mpu6050.gyro_x = 45;
+    s.mpu6050.gyro_y = 71;
+    s.mpu6050.gyro_z = 61;
+    s.mpu6050.temperature_c = 24.16f;
+    s.veml7700 = {true, 61.75f};
+    s.hscdtd = {true, 143, 57, 347, 21.73f};
+    s.orientation = {true, -3.12f, 1.87f, 21.40f};
+    s.gps.fix = true;
+    s.gps.latitude_e7 = -412861798;
+    s.gps.longitude_e7 = 1747766260;
+    return s;
+}
+
+// The eager version: all entries into a stack array, a full shuffle, then
+// the first two copied out.
+void ComposeEager(const app::model::SensorSnapshot &s, char rows[display::kRows][display::kLineLength]) {
+    constexpr std::size_t n = display::kLineLength;
+    std::snprintf(rows[0], n, "AHT T:%5.1fC", s.aht20.temperature_c);
+    char latitude[10];
+    char longitude[10];
+    gps::FormatDegrees(s.gps.latitude_e7, 4, latitude, sizeof(latitude));
+    gps::FormatDegrees(s.gps.longitude_e7, 4, longitude, sizeof(longitude));
+    std::snprintf(rows[1], n, "GPS %s %s", latitude, longitude);
+
+    char entries[kMaxEntries][display::kLineLength];
+    int count = 0;
+    std::snprintf(entries[count++], n, "AHT H:%5.1f%%", s.aht20.humidity_pct);
+    std::snprintf(entries[count++], n, "AHT St:0x%02X", s.aht20.status);
+    std::snprintf(entries[count++], n, "BMP T:%5.1fC", s.bmp280.temperature_c);
+    std::snprintf(entries[count++], n, "BMP P:%7.1fhPa", s.bmp280.pressure_pa / 100.0f);
+    std::snprintf(entries[count++], n, "BMP Alt:%6.1fm", s.bmp280.altitude_m);
+    std::snprintf(entries[count++], n, "VEML Lux:%6.1f", s.veml7700.lux);
+    std::snprintf(entries[count++], n, "MPU T:%5.1fC", s.mpu6050.temperature_c);
+    std::snprintf(entries[count++], n, "MPU Ax:%6d", s.mpu6050.accel_x);
+    std::snprintf(entries[count++], n, "MPU Ay:%6d", s.mpu6050.accel_y);
+    std::snprintf(entries[count++], n, "MPU Az:%6d", s.mpu6050.accel_z);
+    std::snprintf(entries[count++], n, "MPU Gx:%6d", s.mpu6050.gyro_x);
+    std::snprintf(entries[count++], n, "MPU Gy:%6d", s.mpu6050.gyro_y);
+    std::snprintf(entries[count++], n, "MPU Gz:%6d", s.mpu6050.gyro_z);
+    std::snprintf(entries[count++], n, "HSCD Head:%5.1f", s.hscdtd.heading_deg);
+    std::snprintf(entries[count++], n, "AHRS Hdg:%5.1f", s.orientation.heading_deg);
+    std::snprintf(entries[count++], n, "R:%+5.1f P:%+5.1f", s.orientation.roll_deg, s.orientation.pitch_deg);
+    std::snprintf(entries[count++], n, "HSCD X:%6d", s.hscdtd.x);
+    std::snprintf(entries[count++], n, "HSCD Y:%6d", s.hscdtd.y);
+    std::snprintf(entries[count++], n, "HSCD Z:%6d", s.hscdtd.z);
+
+    int indices[kMaxEntries];
+    for (int i = 0; i < count; ++i) {
+        indices[i] = i;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        const int j = std::rand() % (i + 1);
+        const int tmp = indices[i];
+        indices[i] = indices[j];
+        indices[j] = tmp;
+    }
+    std::memcpy(rows[2], entries[indices[0]], n);
+    std::memcpy(rows[3], entries[indices[1]], n);
+}
+
+template <typename Fn>
+double NsPerFrame(long iterations, Fn compose) {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        compose();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+    app::model::SensorSnapshot snapshot = MakeSnapshot();
+    char rows[display::kRows][display::kLineLength];
+    unsigned checksum = 0;
+
+    const double eager_ns = NsPerFrame(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;  // keep the compiler honest
+        ComposeEager(snapshot, rows);
+        checksum += static_cast<unsigned char>(rows[3][4]);
+    });
+    const double shuffle_ns = NsPerFrame(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;
+        display::ComposeRows(snapshot, display::Rotation::kShuffle, rows);
+        checksum += static_cast<unsigned char>(rows[3][4]);
+    });
+    const double round_robin_ns = NsPerFrame(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;
+        display::ComposeRows(snapshot, display::Rotation::kRoundRobin, rows);
+        checksum += static_cast<unsigned char>(rows[3][4]);
+    });
+
+    std::printf("                     ns/frame   speed-up\n");
+    std::printf("format all, shuffle %9.1f\n", eager_ns);
+    std::printf("lazy, shuffle       %9.1f   %7.2fx\n", shuffle_ns, eager_ns / shuffle_ns);
+    std::printf("lazy, round robin   %9.1f   %7.2fx\n", round_robin_ns, eager_ns / round_robin_ns);
+    std::printf("(checksum %u)\n", checksum);
+    return 0;
+}
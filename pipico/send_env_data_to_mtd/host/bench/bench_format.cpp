@@ -0,0 +1,240 @@
+// Benchmark: utils::format::Writer versus snprintf for the text the firmware
+// builds, the telemetry key=value line and the display rows, plus a check
+// that the two agree digit for digit on a sweep of float values.
+//
+// Builds for the host (std::chrono) and, with BUILD_BENCHMARKS in the
+// firmware project, for the Pico (time_us_64, results on stdio), where the
+// float and double arithmetic behind %f is the cost that matters.
+//
+//   ./build-host/bench_format [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef PICO_ON_DEVICE
+#include "pico/stdlib.h"
+#else
+#include <chrono>
+#endif
+
+#include "app/measurement_types.h"
+#include "gps/coordinates.h"
+#include "utils/format.h"
+
+namespace {
+
+using utils::format::Writer;
+
+app::model::SensorSnapshot MakeSnapshot() {
+    app::model::SensorSnapshot s;
+    s.aht20 = {true, 16.13f, 70.0f, 0x18};
+    s.bmp280 = {true, 16.73f, 101321.70f, 0.27f};
+    s.mpu6050.valid = true;
+    s.mpu6050.accel_x = -191;
+    s.mpu6050.accel_y = -568;
+    s.mpu6050.accel_z = 16384;
+    s.mpu6050.gyro_x = 45;
+    s.mpu6050.gyro_y = 71;
+    s.mpu6050.gyro_z = 61;
+    s.mpu6050.temperature_c = 24.16f;
+    s.veml7700 = {true, 61.75f};
+    s.hscdtd = {true, 143, 57, 347, 21.73f};
+    s.orientation = {true, -3.12f, 1.87f, 21.40f};
+    s.gps.fix = true;
+    s.gps.latitude_e7 = -412861798;
+    s.gps.longitude_e7 = 1747766260;
+    s.gps.satellites_used = 8;
+    s.gps.hdop_centi = 101;
+    s.gps.speed_mm_s = 1198;
+    s.gps.course_centideg = 4500;
+    return s;
+}
+
+// The telemetry line as telemetry::PublishAscii built it with snprintf.
+std::size_t TelemetryPrintf(const app::model::SensorSnapshot &s, char *buffer, std::size_t size) {
+    int length = std::snprintf(buffer, size,
+                               "ahtT=%.2f,ahtH=%.2f,ahtStatus=0x%02X,bmpT=%.2f,bmpP=%.2f,alt=%.2f,"
+                               "mpuOk=%d,ax=%d,ay=%d,az=%d,gx=%d,gy=%d,gz=%d,mpuT=%.2f,luxOk=%d,lux=%.2f,"
+                               "magOk=%d,magX=%d,magY=%d,magZ=%d,head=%.1f,"
+                               "ahrsOk=%d,roll=%.1f,pitch=%.1f,hdg=%.1f,gpsfix=%d",
+                               s.aht20.temperature_c, s.aht20.humidity_pct, s.aht20.status, s.bmp280.temperature_c,
+                               s.bmp280.pressure_pa, s.bmp280.altitude_m, 1, s.mpu6050.accel_x, s.mpu6050.accel_y,
+                               s.mpu6050.accel_z, s.mpu6050.gyro_x, s.mpu6050.gyro_y, s.mpu6050.gyro_z,
+                               s.mpu6050.temperature_c, 1, s.veml7700.lux, 1, s.hscdtd.x, s.hscdtd.y, s.hscdtd.z,
+                               s.hscdtd.heading_deg, 1, s.orientation.roll_deg, s.orientation.pitch_deg,
+                               s.orientation.heading_deg, 1);
+    char latitude[16];
+    char longitude[16];
+    gps::FormatDegrees(s.gps.latitude_e7, 7, latitude, sizeof(latitude));
+    gps::FormatDegrees(s.gps.longitude_e7, 7, longitude, sizeof(longitude));
+    length += std::snprintf(buffer + length, size - static_cast<std::size_t>(length),
+                            ",lat=%s,lon=%s,sats=%u,hdop=%u.%02u,spd=%lu,crs=%u.%02u\n", latitude, longitude,
+                            static_cast<unsigned>(s.gps.satellites_used), static_cast<unsigned>(s.gps.hdop_centi / 100),
+                            static_cast<unsigned>(s.gps.hdop_centi % 100), static_cast<unsigned long>(s.gps.speed_mm_s),
+                            static_cast<unsigned>(s.gps.course_centideg / 100),
+                            static_cast<unsigned>(s.gps.course_centideg % 100));
+    return static_cast<std::size_t>(length);
+}
+
+// The same line as telemetry::PublishAscii builds it now.
+std::size_t TelemetryWriter(const app::model::SensorSnapshot &s, char *buffer, std::size_t size) {
+    Writer out(buffer, size);
+    out.Text("ahtT=").Fixed(s.aht20.temperature_c, 2)
+        .Text(",ahtH=").Fixed(s.aht20.humidity_pct, 2)
+        .Text(",ahtStatus=0x").Hex(s.aht20.status, 2)
+        .Text(",bmpT=").Fixed(s.bmp280.temperature_c, 2)
+        .Text(",bmpP=").Fixed(s.bmp280.pressure_pa, 2)
+        .Text(",alt=").Fixed(s.bmp280.altitude_m, 2)
+        .Text(",mpuOk=").Int(1)
+        .Text(",ax=").Int(s.mpu6050.accel_x)
+        .Text(",ay=").Int(s.mpu6050.accel_y)
+        .Text(",az=").Int(s.mpu6050.accel_z)
+        .Text(",gx=").Int(s.mpu6050.gyro_x)
+        .Text(",gy=").Int(s.mpu6050.gyro_y)
+        .Text(",gz=").Int(s.mpu6050.gyro_z)
+        .Text(",mpuT=").Fixed(s.mpu6050.temperature_c, 2)
+        .Text(",luxOk=").Int(1)
+        .Text(",lux=").Fixed(s.veml7700.lux, 2)
+        .Text(",magOk=").Int(1)
+        .Text(",magX=").Int(s.hscdtd.x)
+        .Text(",magY=").Int(s.hscdtd.y)
+        .Text(",magZ=").Int(s.hscdtd.z)
+        .Text(",head=").Fixed(s.hscdtd.heading_deg, 1)
+        .Text(",ahrsOk=").Int(1)
+        .Text(",roll=").Fixed(s.orientation.roll_deg, 1)
+        .Text(",pitch=").Fixed(s.orientation.pitch_deg, 1)
+        .Text(",hdg=").Fixed(s.orientation.heading_deg, 1)
+        .Text(",gpsfix=").Int(1)
+        .Text(",lat=").Decimal(s.gps.latitude_e7, 7)
+        .Text(",lon=").Decimal(s.gps.longitude_e7, 7)
+        .Text(",sats=").Int(s.gps.satellites_used)
+        .Text(",hdop=").Decimal(s.gps.hdop_centi, 2)
+        .Text(",spd=").Int(s.gps.speed_mm_s)
+        .Text(",crs=").Decimal(s.gps.course_centideg, 2)
+        .Char('\n');
+    return out.Length();
+}
+
+constexpr int kDisplayRows = 4;
+constexpr std::size_t kDisplayLine = 24;
+
+// A typical frame: the fixed row, a float reading, an integer one, and
+// the roll/pitch pair.
+void DisplayPrintf(const app::model::SensorSnapshot &s, char rows[kDisplayRows][kDisplayLine]) {
+    std::snprintf(rows[0], kDisplayLine, "AHT T:%5.1fC", s.aht20.temperature_c);
+    std::snprintf(rows[1], kDisplayLine, "BMP P:%7.1fhPa", s.bmp280.pressure_pa / 100.0f);
+    std::snprintf(rows[2], kDisplayLine, "MPU Az:%6d", s.mpu6050.accel_z);
+    std::snprintf(rows[3], kDisplayLine, "R:%+5.1f P:%+5.1f", s.orientation.roll_deg, s.orientation.pitch_deg);
+}
+
+void DisplayWriter(const app::model::SensorSnapshot &s, char rows[kDisplayRows][kDisplayLine]) {
+    Writer(rows[0], kDisplayLine).Text("AHT T:").Fixed(s.aht20.temperature_c, 1, 5).Char('C');
+    Writer(rows[1], kDisplayLine).Text("BMP P:").Fixed(s.bmp280.pressure_pa / 100.0f, 1, 7).Text("hPa");
+    Writer(rows[2], kDisplayLine).Text("MPU Az:").Int(s.mpu6050.accel_z, 6);
+    Writer(rows[3], kDisplayLine)
+        .Text("R:").Fixed(s.orientation.roll_deg, 1, 5, true)
+        .Text(" P:").Fixed(s.orientation.pitch_deg, 1, 5, true);
+}
+
+// Values across the ranges the firmware prints, formatted both ways at
+// one and two decimals; returns how many differ.
+int CountMismatches(int *checked) {
+    int mismatches = 0;
+    *checked = 0;
+    uint32_t state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 1664525u + 1013904223u;
+        const float scale = (i % 4 == 0) ? 120000.0f : (i % 4 == 1) ? 400.0f : (i % 4 == 2) ? 50.0f : 1.0f;
+        const float value = (static_cast<float>(state >> 8) / 16777216.0f - 0.5f) * 2.0f * scale;
+        for (int decimals = 1; decimals <= 2; ++decimals) {
+            char expected[32];
+            char actual[32];
+            std::snprintf(expected, sizeof(expected), "%.*f", decimals, value);
+            Writer(actual, sizeof(actual)).Fixed(value, decimals);
+            ++*checked;
+            if (std::strcmp(expected, actual) != 0) {
+                if (mismatches < 5) {
+                    std::printf("  mismatch: %s vs %s\n", expected, actual);
+                }
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+uint64_t NowNs() {
+#ifdef PICO_ON_DEVICE
+    return time_us_64() * 1000;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+template <typename Fn>
+double NsPerCall(long iterations, Fn fn) {
+    const uint64_t start = NowNs();
+    for (long i = 0; i < iterations; ++i) {
+        fn();
+    }
+    return static_cast<double>(NowNs() - start) / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+#ifdef PICO_ON_DEVICE
+    (void)argc;
+    (void)argv;
+    stdio_init_all();
+    sleep_ms(2000);  // time to open the USB console
+    const long iterations = 2000;
+#else
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+#endif
+    app::model::SensorSnapshot snapshot = MakeSnapshot();
+    char line[448];
+    char rows[kDisplayRows][kDisplayLine];
+    unsigned checksum = 0;
+
+    std::size_t printf_bytes = 0;
+    std::size_t writer_bytes = 0;
+    const double line_printf_ns = NsPerCall(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;  // keep the compiler honest
+        printf_bytes = TelemetryPrintf(snapshot, line, sizeof(line));
+    });
+    const double line_writer_ns = NsPerCall(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;
+        writer_bytes = TelemetryWriter(snapshot, line, sizeof(line));
+    });
+    const double rows_printf_ns = NsPerCall(iterations, [&] {
+        snapshot.mpu6050.accel_z ^= 1;
+        DisplayPrintf(snapshot, rows);
+        checksum += static_cast<unsigned char>(rows[2][12]);
+    });
+    const double rows_writer_ns = NsPerCall(iterations, [&] {
+        snapshot.mpu6050.accel_z ^= 1;
+        DisplayWriter(snapshot, rows);
+        checksum += static_cast<unsigned char>(rows[2][12]);
+    });
+
+    int checked = 0;
+    const int mismatches = CountMismatches(&checked);
+
+    std::printf("                      snprintf ns   writer ns   speed-up\n");
+    std::printf("telemetry line %4zu B %11.1f %11.1f   %7.2fx\n", writer_bytes, line_printf_ns, line_writer_ns,
+                line_printf_ns / line_writer_ns);
+    std::printf("display rows (4)      %11.1f %11.1f   %7.2fx\n", rows_printf_ns, rows_writer_ns,
+                rows_printf_ns / rows_writer_ns);
+    std::printf("floats differing from %%.*f: %d of %d\n", mismatches, checked);
+    std::printf("(line %zu B with snprintf, checksum %u)\n", printf_bytes, checksum);
+#ifdef PICO_ON_DEVICE
+    while (true) {
+        sleep_ms(1000);
+    }
+#endif
+    return 0;
+}
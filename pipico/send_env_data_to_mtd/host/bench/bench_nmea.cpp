@@ -0,0 +1,204 @@
+// Host benchmark: the strtok/atof GGA+RMC parser that gps.cpp used to run on
+// every line versus gps::nmea::Parse, over the sentences one simulated
+// receiver second produces. Numbers are for the host CPU; the ratio is what
+// carries over to the RP2040, where atof is soft-float and far slower still.
+//
+//   ./build-host/bench_nmea [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gps/nmea.h"
+
+namespace {
+
+const char *const kBurst[] = {
+    "$GPRMC,123519.00,A,4117.17130,S,17446.59839,E,2.330,45.00,010126,,,A*40",
+    "$GPVTG,45.00,T,,M,2.330,N,4.315,K,A*0D",
+    "$GPGGA,123519.00,4117.17130,S,17446.59839,E,1,08,1.01,12.3,M,19.2,M,,*77",
+    "$GPGSA,A,3,02,05,12,13,15,18,24,29,,,,,1.87,1.01,1.57*09",
+    "$GPGSV,3,1,12,02,24,074,27,05,45,185,30,12,14,084,37,13,21,121,38*77",
+    "$GPGSV,3,2,12,15,35,195,40,18,56,306,43,20,10,020,,24,38,168,*7B",
+    "$GPGSV,3,3,12,25,45,205,,29,63,353,,31,17,067,,32,24,104,*77",
+    "$GPGLL,4117.17130,S,17446.59839,E,123519.00,A,A*70",
+};
+constexpr int kBurstLines = sizeof(kBurst) / sizeof(kBurst[0]);
+
+// GpsData as the previous parser filled it.
+struct LegacyGpsData {
+    bool fix = false;
+    float latitude = 0.0f;
+    float longitude = 0.0f;
+    bool datetime_valid = false;
+    char datetime[20] = {0};
+};
+
+// The previous parser, condensed but doing the same work per line.
+void LegacyParseGga(const char *line, LegacyGpsData &data) {
+    if (std::strncmp(line, "$GNGGA", 6) != 0 && std::strncmp(line, "$GPGGA", 6) != 0) {
+        return;
+    }
+    char temp[128];
+    std::strncpy(temp, line, sizeof(temp));
+    temp[sizeof(temp) - 1] = '\0';
+    char *token = std::strtok(temp, ",");
+    int field = 0;
+    float latitude = 0.0f;
+    float longitude = 0.0f;
+    char lat_dir = 0;
+    char lon_dir = 0;
+    int fix = 0;
+    while (token != nullptr) {
+        token = std::strtok(nullptr, ",");
+        ++field;
+        if (token == nullptr) {
+            break;
+        }
+        switch (field) {
+            case 2: latitude = std::atof(token); break;
+            case 3: lat_dir = token[0]; break;
+            case 4: longitude = std::atof(token); break;
+            case 5: lon_dir = token[0]; break;
+            case 6: fix = std::atoi(token); break;
+            default: break;
+        }
+    }
+    data.fix = fix > 0;
+    if (!data.fix) {
+        return;
+    }
+    const int lat_deg = static_cast<int>(latitude / 100.0f);
+    data.latitude = lat_deg + (latitude - lat_deg * 100.0f) / 60.0f;
+    if (lat_dir == 'S') {
+        data.latitude = -data.latitude;
+    }
+    const int lon_deg = static_cast<int>(longitude / 100.0f);
+    data.longitude = lon_deg + (longitude - lon_deg * 100.0f) / 60.0f;
+    if (lon_dir == 'W') {
+        data.longitude = -data.longitude;
+    }
+}
+
+void LegacyParseRmc(const char *line, LegacyGpsData &data) {
+    if (std::strncmp(line, "$GNRMC", 6) != 0 && std::strncmp(line, "$GPRMC", 6) != 0) {
+        return;
+    }
+    char temp[128];
+    std::strncpy(temp, line, sizeof(temp));
+    temp[sizeof(temp) - 1] = '\0';
+    char *token = std::strtok(temp, ",");
+    int field = 0;
+    float latitude = 0.0f;
+    float longitude = 0.0f;
+    char lat_dir = 0;
+    char lon_dir = 0;
+    char status = 'V';
+    char time_field[16] = {0};
+    char date_field[16] = {0};
+    while (token != nullptr) {
+        token = std::strtok(nullptr, ",");
+        ++field;
+        if (token == nullptr) {
+            break;
+        }
+        switch (field) {
+            case 1: std::strncpy(time_field, token, sizeof(time_field) - 1); break;
+            case 2: status = token[0]; break;
+            case 3: latitude = std::atof(token); break;
+            case 4: lat_dir = token[0]; break;
+            case 5: longitude = std::atof(token); break;
+            case 6: lon_dir = token[0]; break;
+            case 9: std::strncpy(date_field, token, sizeof(date_field) - 1); break;
+            default: break;
+        }
+    }
+    if (status != 'A') {
+        data.fix = false;
+        data.datetime_valid = false;
+        return;
+    }
+    if (latitude != 0.0f && longitude != 0.0f) {
+        const int lat_deg = static_cast<int>(latitude / 100.0f);
+        data.latitude = lat_deg + (latitude - lat_deg * 100.0f) / 60.0f;
+        if (lat_dir == 'S') {
+            data.latitude = -data.latitude;
+        }
+        const int lon_deg = static_cast<int>(longitude / 100.0f);
+        data.longitude = lon_deg + (longitude - lon_deg * 100.0f) / 60.0f;
+        if (lon_dir == 'W') {
+            data.longitude = -data.longitude;
+        }
+        data.fix = true;
+    }
+    if (std::strlen(time_field) >= 6 && std::strlen(date_field) == 6) {
+        char hh[3] = {time_field[0], time_field[1], '\0'};
+        char mm[3] = {time_field[2], time_field[3], '\0'};
+        char ss[3] = {time_field[4], time_field[5], '\0'};
+        char dd[3] = {date_field[0], date_field[1], '\0'};
+        char mo[3] = {date_field[2], date_field[3], '\0'};
+        char yy[3] = {date_field[4], date_field[5], '\0'};
+        const auto two = [](const char *digits) { return static_cast<unsigned>(std::atoi(digits)) % 100u; };
+        std::snprintf(data.datetime, sizeof(data.datetime), "%04u%02u%02u %02u%02u%02u", 2000u + two(yy), two(mo),
+                      two(dd), two(hh), two(mm), two(ss));
+        data.datetime_valid = true;
+    } else {
+        data.datetime_valid = false;
+    }
+}
+
+template <typename Fn>
+double NsPerLine(long iterations, const char *const *lines, int count, Fn parse) {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        for (int l = 0; l < count; ++l) {
+            parse(lines[l]);
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(iterations) * count);
+}
+
+struct Result {
+    double legacy_ns;
+    double nmea_ns;
+};
+
+Result Compare(long iterations, const char *const *lines, int count, LegacyGpsData &legacy,
+               app::model::GpsData &parsed) {
+    Result result;
+    result.legacy_ns = NsPerLine(iterations, lines, count, [&](const char *line) {
+        LegacyParseGga(line, legacy);
+        LegacyParseRmc(line, legacy);
+    });
+    result.nmea_ns = NsPerLine(iterations, lines, count, [&](const char *line) {
+        gps::nmea::Parse(line, std::strlen(line), parsed);
+    });
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+    const char *const position_lines[] = {kBurst[0], kBurst[2]};
+
+    LegacyGpsData legacy;
+    app::model::GpsData parsed;
+    const Result position = Compare(iterations, position_lines, 2, legacy, parsed);
+    const Result burst = Compare(iterations, kBurst, kBurstLines, legacy, parsed);
+
+    std::printf("                     legacy strtok/atof   nmea::Parse   speedup\n");
+    std::printf("RMC+GGA lines        %12.1f ns   %8.1f ns   %6.2fx\n", position.legacy_ns, position.nmea_ns,
+                position.legacy_ns / position.nmea_ns);
+    std::printf("whole burst (%d)      %12.1f ns   %8.1f ns   %6.2fx  (legacy skips 6 of 8 lines)\n", kBurstLines,
+                burst.legacy_ns, burst.nmea_ns, burst.legacy_ns / burst.nmea_ns);
+    std::printf("legacy  lat=%.6f lon=%.6f\n", legacy.latitude, legacy.longitude);
+    std::printf("nmea    lat=%ld lon=%ld (1e-7 deg) sats=%u hdop=%u spd=%lu mm/s crs=%u, %lu bad checksum\n",
+                static_cast<long>(parsed.latitude_e7), static_cast<long>(parsed.longitude_e7), static_cast<unsigned>(parsed.satellites_used),
+                static_cast<unsigned>(parsed.hdop_centi), static_cast<unsigned long>(parsed.speed_mm_s),
+                static_cast<unsigned>(parsed.course_centideg),
+                static_cast<unsigned long>(gps::nmea::GetStats().bad_checksum));
+    return 0;
+}
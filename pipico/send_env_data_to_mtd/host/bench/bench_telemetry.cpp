@@ -0,0 +1,117 @@
+// Host benchmark: cost and size of one telemetry record as the ASCII
+// key=value line (built with snprintf; see bench_format for utils::format) versus the
+// binary keyframe (Quantize + PackKeyframe + Frame). Both are built into a buffer only;
+// UART time is not included.
+//
+//   ./build-host/bench_telemetry [iterations]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gps/coordinates.h"
+#include "telemetry/record.h"
+
+namespace {
+
+app::model::SensorSnapshot MakeSnapshot() {
+    app::model::SensorSnapshot s;
+    s.aht20 = {true, 16.13f, 70.0f, 0x18};
+    s.bmp280 = {true, 16.73f, 101321.70f, 0.27f};
+    s.mpu6050.valid = true;
+    s.mpu6050.accel_x = -191;
+    s.mpu6050.accel_y = -568;
+    s.mpu6050.accel_z = 16384;
+    s.mpu6050.gyro_x = 45;
+    s.mpu6050.gyro_y = 71;
+    s.mpu6050.gyro_z = 61;
+    s.mpu6050.temperature_c = 24.16f;
+    s.veml7700 = {true, 61.75f};
+    s.hscdtd = {true, 143, 57, 347, 21.73f};
+    s.orientation = {true, -3.12f, 1.87f, 21.40f};
+    s.gps.fix = true;
+    s.gps.latitude_e7 = -412861798;
+    s.gps.longitude_e7 = 1747766260;
+    s.gps.datetime_valid = true;
+    std::strcpy(s.gps.datetime, "20260101 000042");
+    s.gps.fix_type = 3;
+    s.gps.satellites_used = 8;
+    s.gps.hdop_centi = 101;
+    s.gps.motion_valid = true;
+    s.gps.speed_mm_s = 1198;
+    s.gps.course_centideg = 4500;
+    return s;
+}
+
+// Same format as telemetry::PublishAscii.
+std::size_t EncodeAscii(const app::model::SensorSnapshot &s, char *buffer, std::size_t size) {
+    int length = std::snprintf(buffer, size,
+                               "ahtT=%.2f,ahtH=%.2f,ahtStatus=0x%02X,bmpT=%.2f,bmpP=%.2f,alt=%.2f,"
+                               "mpuOk=%d,ax=%d,ay=%d,az=%d,gx=%d,gy=%d,gz=%d,mpuT=%.2f,luxOk=%d,lux=%.2f,"
+                               "magOk=%d,magX=%d,magY=%d,magZ=%d,head=%.1f,"
+                               "ahrsOk=%d,roll=%.1f,pitch=%.1f,hdg=%.1f,gpsfix=%d",
+                               s.aht20.temperature_c, s.aht20.humidity_pct, s.aht20.status, s.bmp280.temperature_c,
+                               s.bmp280.pressure_pa, s.bmp280.altitude_m, 1, s.mpu6050.accel_x, s.mpu6050.accel_y,
+                               s.mpu6050.accel_z, s.mpu6050.gyro_x, s.mpu6050.gyro_y, s.mpu6050.gyro_z,
+                               s.mpu6050.temperature_c, 1, s.veml7700.lux, 1, s.hscdtd.x, s.hscdtd.y, s.hscdtd.z,
+                               s.hscdtd.heading_deg, 1, s.orientation.roll_deg, s.orientation.pitch_deg,
+                               s.orientation.heading_deg, 1);
+    char latitude[16];
+    char longitude[16];
+    gps::FormatDegrees(s.gps.latitude_e7, 7, latitude, sizeof(latitude));
+    gps::FormatDegrees(s.gps.longitude_e7, 7, longitude, sizeof(longitude));
+    length += std::snprintf(buffer + length, size - static_cast<std::size_t>(length),
+                            ",lat=%s,lon=%s,sats=%u,hdop=%u.%02u,spd=%lu,crs=%u.%02u\n", latitude, longitude,
+                            static_cast<unsigned>(s.gps.satellites_used), static_cast<unsigned>(s.gps.hdop_centi / 100),
+                            static_cast<unsigned>(s.gps.hdop_centi % 100), static_cast<unsigned long>(s.gps.speed_mm_s),
+                            static_cast<unsigned>(s.gps.course_centideg / 100),
+                            static_cast<unsigned>(s.gps.course_centideg % 100));
+    return static_cast<std::size_t>(length);
+}
+
+std::size_t EncodeBinary(const app::model::SensorSnapshot &s, uint8_t *frame) {
+    telemetry::record::Sample sample;
+    telemetry::record::Quantize(s, sample);
+    uint8_t packed[telemetry::record::kMaxRecordBytes];
+    const std::size_t len = telemetry::record::PackKeyframe(sample, packed);
+    return telemetry::record::Frame(packed, len, frame);
+}
+
+template <typename Fn>
+double NsPerRecord(long iterations, Fn encode) {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        encode();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+    app::model::SensorSnapshot snapshot = MakeSnapshot();
+
+    char line[320];
+    uint8_t frame[telemetry::record::kMaxFrameBytes];
+    std::size_t ascii_bytes = 0;
+    std::size_t binary_bytes = 0;
+    const double ascii_ns = NsPerRecord(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;  // keep the compiler honest
+        ascii_bytes = EncodeAscii(snapshot, line, sizeof(line));
+    });
+    const double binary_ns = NsPerRecord(iterations, [&] {
+        snapshot.mpu6050.accel_x ^= 1;
+        binary_bytes = EncodeBinary(snapshot, frame);
+    });
+
+    std::printf("               bytes/record   ns/record\n");
+    std::printf("ascii line     %12zu   %9.1f\n", ascii_bytes, ascii_ns);
+    std::printf("binary frame   %12zu   %9.1f\n", binary_bytes, binary_ns);
+    std::printf("reduction      %11.2fx   %8.2fx\n", static_cast<double>(ascii_bytes) / binary_bytes,
+                ascii_ns / binary_ns);
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Decodes mesh telemetry (e.g. the file written via SIM_MESH_LOG) from
+// stdin. ASCII logs print one position per record with a fix; binary logs
+// (detected by their 0x00 frame delimiters) print every record as a
+// key=value line in the same units as the ASCII telemetry, summaries as
+// mean/min/max/sd like the ASCII summary line, I2C health records like
+// the ASCII health line and stage timing records like the ASCII timing
+// line; deltas that follow a damaged frame are skipped until the next
+// keyframe. Console text between frames (SIM_CONSOLE_ON_MESH) goes to
+// stderr; console text inside a frame damages it.
+//
+//   SIM_MESH_LOG=mesh.log ./build-host/send_env_data_to_mtd_sim > /dev/null
+//   ./build-host/decode_telemetry < mesh.log
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "decoder/telemetry_decoder.h"
+
+namespace {
+
+// Printable lines only, as printf would leave between two frames.
+bool IsConsoleText(const std::vector<uint8_t> &frame) {
+    for (uint8_t byte : frame) {
+        if ((byte < 0x20 || byte > 0x7E) && byte != '\n' && byte != '\r' && byte != '\t') {
+            return false;
+        }
+    }
+    return frame.back() == '\n';
+}
+
+int DecodeAscii(const std::vector<uint8_t> &input) {
+    unsigned long records = 0;
+    unsigned long fixes = 0;
+    unsigned long errors = 0;
+    const char *line = reinterpret_cast<const char *>(input.data());
+    const char *const end = line + input.size();
+    while (line < end) {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', static_cast<std::size_t>(end - line)));
+        const char *line_end = newline != nullptr ? newline : end;
+        ++records;
+        decoder::Position position;
+        if (!decoder::DecodePosition(line, static_cast<std::size_t>(line_end - line), position)) {
+            ++errors;
+        } else if (position.valid) {
+            ++fixes;
+            std::printf("%ld %ld %.7f %.7f\n", static_cast<long>(position.latitude_e7),
+                        static_cast<long>(position.longitude_e7), decoder::DegreesFromE7(position.latitude_e7),
+                        decoder::DegreesFromE7(position.longitude_e7));
+        }
+        line = line_end + 1;
+    }
+    std::fprintf(stderr, "%lu records, %lu with a fix, %lu undecodable\n", records, fixes, errors);
+    return errors == 0 ? 0 : 1;
+}
+
+int Decimals(const telemetry::record::FieldFormat &format) {
+    return format.scale >= 10000000 ? 7 : format.scale >= 1000 ? 3 : format.scale >= 100 ? 2 : 0;
+}
+
+void PrintSample(const decoder::Sample &sample) {
+    using telemetry::record::kFields;
+    std::printf("seq=%u", static_cast<unsigned>(sample.sequence));
+    for (int i = 0; i < telemetry::record::kFieldCount; ++i) {
+        const telemetry::record::FieldFormat &format = kFields[i];
+        if (!decoder::HasSection(sample, format.section)) {
+            continue;
+        }
+        const int decimals = Decimals(format);
+        std::printf(",%s=%.*f", format.name, decimals, decoder::Value(sample, static_cast<decoder::Field>(i)));
+        if (i == telemetry::record::kBmpPressure) {
+            std::printf(",alt=%.2f", decoder::AltitudeM(sample));
+        }
+    }
+    std::printf("\n");
+}
+
+void PrintSummary(const decoder::Summary &summary) {
+    using telemetry::record::kFields;
+    std::printf("seq=%u,win=%u", static_cast<unsigned>(summary.sequence), static_cast<unsigned>(summary.window_s));
+    for (int s = 0; s < telemetry::record::kSectionCount; ++s) {
+        if ((summary.sections & (1u << s)) != 0) {
+            std::printf(",%sN=%lu", telemetry::record::kSectionNames[s],
+                        static_cast<unsigned long>(summary.counts[s]));
+        }
+    }
+    for (int i = 0; i < telemetry::record::kFieldCount; ++i) {
+        const telemetry::record::FieldFormat &format = kFields[i];
+        if ((summary.sections & (1u << format.section)) == 0) {
+            continue;
+        }
+        const decoder::Field field = static_cast<decoder::Field>(i);
+        const telemetry::record::FieldSummary &stats = summary.fields[i];
+        const int decimals = Decimals(format);
+        std::printf(",%s=%.*f/%.*f/%.*f/%.*f", format.name, decimals, decoder::Value(field, stats.mean), decimals,
+                    decoder::Value(field, stats.min), decimals, decoder::Value(field, stats.max), decimals,
+                    decoder::Value(field, stats.sd));
+    }
+    std::printf("\n");
+}
+
+void PrintHealth(const decoder::Health &health) {
+    std::printf("seq=%u,sleep=%.1f,wakeUs=%lu/%lu,i2cRec=%lu/%lu,wdt=%lu/%s", static_cast<unsigned>(health.sequence),
+                health.asleep_permille / 10.0, static_cast<unsigned long>(health.wake_latency_mean_us),
+                static_cast<unsigned long>(health.wake_latency_max_us), static_cast<unsigned long>(health.recoveries),
+                static_cast<unsigned long>(health.recovery_failures), static_cast<unsigned long>(health.watchdog_resets),
+                health.fault_stage < telemetry::record::kStageCount
+                    ? telemetry::record::kStageNames[health.fault_stage]
+                    : "-");
+    for (uint8_t i = 0; i < health.device_count; ++i) {
+        const telemetry::record::DeviceHealth &device = health.devices[i];
+        std::printf(",i2c%02X=%lu/%lu/%lu/%lu/%lu/%lu", static_cast<unsigned>(device.addr),
+                    static_cast<unsigned long>(device.completed), static_cast<unsigned long>(device.nacks),
+                    static_cast<unsigned long>(device.timeouts), static_cast<unsigned long>(device.bus_errors),
+                    static_cast<unsigned long>(device.retries), static_cast<unsigned long>(device.failed));
+    }
+    std::printf("\n");
+}
+
+void PrintTiming(const decoder::Timing &timing) {
+    std::printf("seq=%u", static_cast<unsigned>(timing.sequence));
+    for (int s = 0; s < telemetry::record::kStageCount; ++s) {
+        if ((timing.stages & (1u << s)) == 0) {
+            continue;
+        }
+        const telemetry::record::StageTiming &stage = timing.stage[s];
+        const char *name = telemetry::record::kStageNames[s];
+        std::printf(",%s=%lu/%lu/%lu/%lu,%sH=%lu", name, static_cast<unsigned long>(stage.count),
+                    static_cast<unsigned long>(stage.mean_us), static_cast<unsigned long>(stage.max_us),
+                    static_cast<unsigned long>(stage.peak_us), name, static_cast<unsigned long>(stage.buckets[0]));
+        int last = telemetry::record::kTimingBuckets - 1;
+        while (last > 0 && stage.buckets[last] == 0) {
+            --last;
+        }
+        for (int b = 1; b <= last; ++b) {
+            std::printf(":%lu", static_cast<unsigned long>(stage.buckets[b]));
+        }
+    }
+    std::printf("\n");
+}
+
+int DecodeBinary(const std::vector<uint8_t> &input) {
+    decoder::FrameReader reader;
+    decoder::StreamDecoder stream;
+    unsigned long frames = 0;
+    unsigned long keyframes = 0;
+    unsigned long summaries = 0;
+    unsigned long health_records = 0;
+    unsigned long timing_records = 0;
+    unsigned long unsynced = 0;
+    unsigned long errors = 0;
+    unsigned long console = 0;
+    for (uint8_t byte : input) {
+        if (!reader.Push(byte)) {
+            continue;
+        }
+        // Before decoding: a failed frame would break the delta chain.
+        if (IsConsoleText(reader.Frame())) {
+            ++console;
+            std::fprintf(stderr, "console: %.*s", static_cast<int>(reader.Frame().size()),
+                         reinterpret_cast<const char *>(reader.Frame().data()));
+            continue;
+        }
+        ++frames;
+        decoder::Kind kind;
+        decoder::Sample sample;
+        const decoder::FrameStatus status =
+            stream.Decode(reader.Frame().data(), reader.Frame().size(), kind, sample);
+        if (status == decoder::FrameStatus::kNotSynced) {
+            ++unsynced;
+            continue;
+        }
+        if (status != decoder::FrameStatus::kOk) {
+            ++errors;
+            std::fprintf(stderr, "frame %lu: %s\n", frames, decoder::StatusName(status));
+            continue;
+        }
+        if (kind == decoder::Kind::kSummary) {
+            ++summaries;
+            PrintSummary(stream.LastSummary());
+            continue;
+        }
+        if (kind == decoder::Kind::kHealth) {
+            ++health_records;
+            PrintHealth(stream.LastHealth());
+            continue;
+        }
+        if (kind == decoder::Kind::kTiming) {
+            ++timing_records;
+            PrintTiming(stream.LastTiming());
+            continue;
+        }
+        if (kind == decoder::Kind::kKeyframe) {
+            ++keyframes;
+        }
+        PrintSample(sample);
+    }
+    std::fprintf(stderr,
+                 "%lu frames (%lu keyframes, %lu summaries, %lu health, %lu timing), %lu undecodable, "
+                 "%lu skipped until resync, %lu console lines, %.1f bytes/frame\n",
+                 frames, keyframes, summaries, health_records, timing_records, errors, unsynced, console,
+                 frames > 0 ? static_cast<double>(input.size()) / frames : 0.0);
+    return errors == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+int main() {
+    std::vector<uint8_t> input;
+    uint8_t chunk[4096];
+    std::size_t got;
+    while ((got = std::fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        input.insert(input.end(), chunk, chunk + got);
+    }
+    const bool binary = std::memchr(input.data(), 0, input.size()) != nullptr;
+    return binary ? DecodeBinary(input) : DecodeAscii(input);
+}
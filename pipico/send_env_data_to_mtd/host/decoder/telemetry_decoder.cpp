@@ -0,0 +1,407 @@
+#include "decoder/telemetry_decoder.h"
+
+#include <cmath>
+
+namespace decoder {
+
+namespace {
+
+using telemetry::record::FieldFormat;
+using telemetry::record::kFields;
+
+// Value of `key=` in a comma-separated line, as [begin, end). Of a summary
+// line's mean/min/max/sd that is the mean.
+bool FindValue(const char *line, std::size_t len, const char *key, const char *&begin, const char *&end) {
+    const char *const line_end = line + len;
+    const char *field = line;
+    while (field < line_end) {
+        const char *k = key;
+        const char *p = field;
+        while (*k != '\0' && p < line_end && *p == *k) {
+            ++k;
+            ++p;
+        }
+        if (*k == '\0' && p < line_end && *p == '=') {
+            begin = p + 1;
+            end = begin;
+            while (end < line_end && *end != ',' && *end != '/' && *end != '\n' && *end != '\r') {
+                ++end;
+            }
+            return true;
+        }
+        while (field < line_end && *field != ',') {
+            ++field;
+        }
+        ++field;
+    }
+    return false;
+}
+
+// Inverse of record::Frame's COBS step.
+bool CobsDecode(const uint8_t *in, std::size_t len, std::vector<uint8_t> &out) {
+    out.clear();
+    std::size_t pos = 0;
+    while (pos < len) {
+        const uint8_t code = in[pos++];
+        if (code == 0 || pos + code - 1 > len) {
+            return false;
+        }
+        for (uint8_t i = 1; i < code; ++i) {
+            if (in[pos] == 0) {
+                return false;
+            }
+            out.push_back(in[pos++]);
+        }
+        if (code != 0xFF && pos < len) {
+            out.push_back(0);
+        }
+    }
+    return true;
+}
+
+
+// COBS-decodes, checks the CRC and version; leaves the record without CRC.
+FrameStatus Unframe(const uint8_t *frame, std::size_t len, std::vector<uint8_t> &record) {
+    if (!CobsDecode(frame, len, record)) {
+        return FrameStatus::kBadCobs;
+    }
+    if (record.size() < telemetry::record::kHeaderBytes + telemetry::record::kCrcBytes) {
+        return FrameStatus::kBadLength;
+    }
+    const std::size_t body = record.size() - telemetry::record::kCrcBytes;
+    const uint16_t crc = static_cast<uint16_t>(record[body] | record[body + 1] << 8);
+    if (telemetry::record::Crc16(record.data(), body) != crc) {
+        return FrameStatus::kBadCrc;
+    }
+    if (record[0] >> 4 != telemetry::record::kVersion || (record[0] & 0x0F) > static_cast<uint8_t>(Kind::kTiming)) {
+        return FrameStatus::kBadVersion;
+    }
+    record.resize(body);
+    return FrameStatus::kOk;
+}
+
+bool Present(uint16_t sections, int field) {
+    return (sections & (1u << kFields[field].section)) != 0;
+}
+
+bool ReadVarint(const std::vector<uint8_t> &record, std::size_t &pos, uint32_t &value) {
+    value = 0;
+    for (std::size_t shift = 0;; shift += 7) {
+        if (pos >= record.size() || shift >= 7 * telemetry::record::kMaxVarintBytes) {
+            return false;
+        }
+        const uint8_t byte = record[pos++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+}
+
+int32_t ReadFixed(const std::vector<uint8_t> &record, std::size_t &pos, const FieldFormat &format) {
+    uint32_t value = 0;
+    for (int b = 0; b < format.bytes; ++b) {
+        value |= static_cast<uint32_t>(record[pos++]) << (8 * b);
+    }
+    const int unused = 32 - 8 * format.bytes;
+    if (format.is_signed && unused > 0) {
+        value = static_cast<uint32_t>(static_cast<int32_t>(value << unused) >> unused);
+    }
+    return static_cast<int32_t>(value);
+}
+
+FrameStatus ParseKeyframe(const std::vector<uint8_t> &record, Sample &sample) {
+    sample = Sample();
+    sample.sequence = record[1];
+    sample.sections = static_cast<uint16_t>(record[2] | record[3] << 8);
+    std::size_t pos = telemetry::record::kHeaderBytes;
+    for (int i = 0; i < telemetry::record::kFieldCount; ++i) {
+        if (!Present(sample.sections, i)) {
+            continue;
+        }
+        if (pos + kFields[i].bytes > record.size()) {
+            return FrameStatus::kBadLength;
+        }
+        sample.values[i] = ReadFixed(record, pos, kFields[i]);
+    }
+    return pos == record.size() ? FrameStatus::kOk : FrameStatus::kBadLength;
+}
+
+// Fields outside the record's sections keep their reference values, as on
+// the encoder side (record::Advance).
+FrameStatus ParseDelta(const std::vector<uint8_t> &record, const Sample &reference, Sample &sample) {
+    sample = reference;
+    sample.sequence = record[1];
+    sample.sections = static_cast<uint16_t>(record[2] | record[3] << 8);
+    std::size_t pos = telemetry::record::kHeaderBytes;
+    for (int i = 0; i < telemetry::record::kFieldCount; ++i) {
+        if (!Present(sample.sections, i)) {
+            continue;
+        }
+        uint32_t value = 0;
+        if (!ReadVarint(record, pos, value)) {
+            return FrameStatus::kBadLength;
+        }
+        sample.values[i] = telemetry::record::WrappingAdd(reference.values[i], telemetry::record::UnZigZag(value));
+    }
+    return pos == record.size() ? FrameStatus::kOk : FrameStatus::kBadLength;
+}
+
+FrameStatus ParseSummary(const std::vector<uint8_t> &record, Summary &summary) {
+    using telemetry::record::kWindowBytes;
+    summary = Summary();
+    summary.sequence = record[1];
+    summary.sections = static_cast<uint16_t>(record[2] | record[3] << 8);
+    std::size_t pos = telemetry::record::kHeaderBytes;
+    if (pos + kWindowBytes > record.size()) {
+        return FrameStatus::kBadLength;
+    }
+    summary.window_s = static_cast<uint16_t>(record[pos] | record[pos + 1] << 8);
+    pos += kWindowBytes;
+    for (int s = 0; s < telemetry::record::kSectionCount; ++s) {
+        if ((summary.sections & (1u << s)) != 0 && !ReadVarint(record, pos, summary.counts[s])) {
+            return FrameStatus::kBadLength;
+        }
+    }
+    for (int i = 0; i < telemetry::record::kFieldCount; ++i) {
+        if (!Present(summary.sections, i)) {
+            continue;
+        }
+        if (pos + kFields[i].bytes > record.size()) {
+            return FrameStatus::kBadLength;
+        }
+        telemetry::record::FieldSummary &field = summary.fields[i];
+        field.mean = ReadFixed(record, pos, kFields[i]);
+        uint32_t min = 0;
+        uint32_t max = 0;
+        if (!ReadVarint(record, pos, min) || !ReadVarint(record, pos, max) || !ReadVarint(record, pos, field.sd)) {
+            return FrameStatus::kBadLength;
+        }
+        field.min = telemetry::record::WrappingAdd(field.mean, telemetry::record::UnZigZag(min));
+        field.max = telemetry::record::WrappingAdd(field.mean, telemetry::record::UnZigZag(max));
+    }
+    return pos == record.size() ? FrameStatus::kOk : FrameStatus::kBadLength;
+}
+
+FrameStatus ParseHealth(const std::vector<uint8_t> &record, Health &health) {
+    health = Health();
+    health.sequence = record[1];
+    std::size_t pos = telemetry::record::kHeaderBytes;
+    if (!ReadVarint(record, pos, health.asleep_permille) || !ReadVarint(record, pos, health.wake_latency_mean_us) ||
+        !ReadVarint(record, pos, health.wake_latency_max_us) || !ReadVarint(record, pos, health.recoveries) ||
+        !ReadVarint(record, pos, health.recovery_failures) || !ReadVarint(record, pos, health.watchdog_resets) ||
+        pos + 1 >= record.size()) {
+        return FrameStatus::kBadLength;
+    }
+    health.fault_stage = record[pos++];
+    health.device_count = record[pos++];
+    if (health.device_count > telemetry::record::kMaxHealthDevices) {
+        return FrameStatus::kBadLength;
+    }
+    for (uint8_t i = 0; i < health.device_count; ++i) {
+        telemetry::record::DeviceHealth &device = health.devices[i];
+        if (pos >= record.size()) {
+            return FrameStatus::kBadLength;
+        }
+        device.addr = record[pos++];
+        if (!ReadVarint(record, pos, device.completed) || !ReadVarint(record, pos, device.nacks) ||
+            !ReadVarint(record, pos, device.timeouts) || !ReadVarint(record, pos, device.bus_errors) ||
+            !ReadVarint(record, pos, device.retries) || !ReadVarint(record, pos, device.failed)) {
+            return FrameStatus::kBadLength;
+        }
+    }
+    return pos == record.size() ? FrameStatus::kOk : FrameStatus::kBadLength;
+}
+
+FrameStatus ParseTiming(const std::vector<uint8_t> &record, Timing &timing) {
+    timing = Timing();
+    timing.sequence = record[1];
+    timing.stages = static_cast<uint16_t>(record[2] | record[3] << 8);
+    std::size_t pos = telemetry::record::kHeaderBytes;
+    for (int s = 0; s < telemetry::record::kStageCount; ++s) {
+        if ((timing.stages & (1u << s)) == 0) {
+            continue;
+        }
+        telemetry::record::StageTiming &stage = timing.stage[s];
+        if (!ReadVarint(record, pos, stage.count) || !ReadVarint(record, pos, stage.mean_us) ||
+            !ReadVarint(record, pos, stage.max_us) || !ReadVarint(record, pos, stage.peak_us)) {
+            return FrameStatus::kBadLength;
+        }
+        for (uint32_t &bucket : stage.buckets) {
+            if (!ReadVarint(record, pos, bucket)) {
+                return FrameStatus::kBadLength;
+            }
+        }
+    }
+    return pos == record.size() ? FrameStatus::kOk : FrameStatus::kBadLength;
+}
+
+}  // namespace
+
+bool ParseDegreesE7(const char *text, std::size_t len, int32_t &e7) {
+    const char *p = text;
+    const char *const end = text + len;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+
+    uint32_t whole = 0;
+    int whole_digits = 0;
+    for (; p < end && *p != '.'; ++p) {
+        if (*p < '0' || *p > '9' || ++whole_digits > 3) {
+            return false;
+        }
+        whole = whole * 10 + static_cast<uint32_t>(*p - '0');
+    }
+
+    uint32_t fraction = 0;
+    int decimals = 0;
+    bool round_up = false;
+    if (p < end) {
+        ++p;  // '.'
+        for (; p < end; ++p) {
+            if (*p < '0' || *p > '9') {
+                return false;
+            }
+            if (decimals < 7) {
+                fraction = fraction * 10 + static_cast<uint32_t>(*p - '0');
+                ++decimals;
+            } else if (decimals == 7) {
+                round_up = *p >= '5';
+                ++decimals;
+            }
+        }
+    }
+    for (; decimals < 7; ++decimals) {
+        fraction *= 10;
+    }
+
+    const uint32_t magnitude = whole * static_cast<uint32_t>(kE7PerDegree) + fraction + (round_up ? 1u : 0u);
+    if (whole > 180 || magnitude > 180u * static_cast<uint32_t>(kE7PerDegree)) {
+        return false;
+    }
+    e7 = negative ? -static_cast<int32_t>(magnitude) : static_cast<int32_t>(magnitude);
+    return true;
+}
+
+double DegreesFromE7(int32_t e7) {
+    return static_cast<double>(e7) / kE7PerDegree;
+}
+
+bool DecodePosition(const char *line, std::size_t len, Position &position) {
+    position = Position();
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    if (!FindValue(line, len, "lat", begin, end)) {
+        return true;  // no fix in this record
+    }
+    if (!ParseDegreesE7(begin, static_cast<std::size_t>(end - begin), position.latitude_e7) ||
+        !FindValue(line, len, "lon", begin, end) ||
+        !ParseDegreesE7(begin, static_cast<std::size_t>(end - begin), position.longitude_e7)) {
+        return false;
+    }
+    position.valid = true;
+    return true;
+}
+
+bool FrameReader::Push(uint8_t byte) {
+    constexpr std::size_t kMaxFrame = telemetry::record::kMaxSummaryFrameBytes * 2;
+    if (byte != 0) {
+        if (buffer_.size() < kMaxFrame) {
+            buffer_.push_back(byte);
+        }
+        return false;
+    }
+    frame_.swap(buffer_);
+    buffer_.clear();
+    return !frame_.empty();
+}
+
+FrameStatus DecodeFrame(const uint8_t *frame, std::size_t len, Kind &kind, Sample &sample) {
+    std::vector<uint8_t> record;
+    const FrameStatus status = Unframe(frame, len, record);
+    if (status != FrameStatus::kOk) {
+        return status;
+    }
+    kind = static_cast<Kind>(record[0] & 0x0F);
+    if (kind == Kind::kSummary || kind == Kind::kHealth || kind == Kind::kTiming) {
+        return FrameStatus::kNotSample;
+    }
+    if (kind != Kind::kKeyframe) {
+        return FrameStatus::kNotSynced;
+    }
+    return ParseKeyframe(record, sample);
+}
+
+FrameStatus StreamDecoder::Decode(const uint8_t *frame, std::size_t len, Kind &kind, Sample &sample) {
+    std::vector<uint8_t> record;
+    FrameStatus status = Unframe(frame, len, record);
+    if (status != FrameStatus::kOk) {
+        // Whatever this frame was, the next delta may depend on it.
+        synced_ = false;
+        return status;
+    }
+    kind = static_cast<Kind>(record[0] & 0x0F);
+    if (kind == Kind::kSummary) {
+        // Off the delta chain: sync is neither needed nor affected.
+        return ParseSummary(record, summary_);
+    }
+    if (kind == Kind::kHealth) {
+        return ParseHealth(record, health_);
+    }
+    if (kind == Kind::kTiming) {
+        return ParseTiming(record, timing_);
+    }
+    if (kind == Kind::kKeyframe) {
+        status = ParseKeyframe(record, sample);
+    } else if (!synced_ || record[1] != static_cast<uint8_t>(reference_.sequence + 1)) {
+        status = FrameStatus::kNotSynced;
+    } else {
+        status = ParseDelta(record, reference_, sample);
+    }
+    synced_ = status == FrameStatus::kOk;
+    if (synced_) {
+        reference_ = sample;
+    }
+    return status;
+}
+
+bool HasSection(const Sample &sample, telemetry::record::Section section) {
+    return (sample.sections & (1u << section)) != 0;
+}
+
+double Value(const Sample &sample, Field field) {
+    return static_cast<double>(sample.values[field]) / kFields[field].scale;
+}
+
+double Value(Field field, double wire_value) {
+    return wire_value / kFields[field].scale;
+}
+
+double AltitudeM(const Sample &sample) {
+    const double pressure_pa = Value(sample, telemetry::record::kBmpPressure);
+    if (pressure_pa <= 0.0) {
+        return 0.0;
+    }
+    return 44330.0 * (1.0 - std::pow(pressure_pa / 101325.0, 0.1903));
+}
+
+const char *StatusName(FrameStatus status) {
+    switch (status) {
+        case FrameStatus::kOk: return "ok";
+        case FrameStatus::kBadCobs: return "bad cobs";
+        case FrameStatus::kBadCrc: return "bad crc";
+        case FrameStatus::kBadVersion: return "bad version";
+        case FrameStatus::kBadLength: return "bad length";
+        case FrameStatus::kNotSynced: return "delta without reference";
+        case FrameStatus::kNotSample: return "summary, health or timing record";
+    }
+    return "?";
+}
+
+}  // namespace decoder
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "telemetry/record_format.h"
+
+// Host-side decoding of what the firmware sends to the mesh node: the ASCII
+// key=value line and the binary record. The only firmware header used is
+// the wire-format table, so this can be dropped into a gateway or a log tool.
+namespace decoder {
+
+constexpr int32_t kE7PerDegree = 10000000;
+
+// Parses decimal degrees as written by gps::FormatDegrees ("-41.2861798")
+// back into 1e-7 degree units without going through floating point. Up to
+// seven decimals are exact; further digits are rounded off.
+bool ParseDegreesE7(const char *text, std::size_t len, int32_t &e7);
+
+// For display and maths on the host only; the wire value is the integer.
+double DegreesFromE7(int32_t e7);
+
+struct Position {
+    bool valid = false;
+    int32_t latitude_e7 = 0;
+    int32_t longitude_e7 = 0;
+};
+
+// Finds lat= and lon= in one ASCII telemetry line, the mean position of a
+// summary line. `position.valid` is false when the line has no fix.
+bool DecodePosition(const char *line, std::size_t len, Position &position);
+
+// Binary frames --------------------------------------------------------------
+
+using telemetry::record::Field;
+using telemetry::record::Health;
+using telemetry::record::Kind;
+using telemetry::record::Sample;
+using telemetry::record::Summary;
+using telemetry::record::Timing;
+
+enum class FrameStatus {
+    kOk,
+    kBadCobs,     // not valid COBS, or a stray 0x00
+    kBadCrc,
+    kBadVersion,  // record from a newer firmware
+    kBadLength,   // sections present do not match the record length
+    kNotSynced,   // delta record, but its predecessor was not decoded
+    kNotSample,   // summary, health or timing record, where a keyframe or delta was expected
+};
+
+// Splits the UART byte stream at 0x00 delimiters.
+class FrameReader {
+  public:
+    // Returns true when `byte` completes a frame; Frame() is then valid
+    // until the next Push(). Overlong frames are dropped.
+    bool Push(uint8_t byte);
+    const std::vector<uint8_t> &Frame() const {
+        return frame_;
+    }
+
+  private:
+    std::vector<uint8_t> buffer_;
+    std::vector<uint8_t> frame_;
+};
+
+// Decodes one frame as returned by FrameReader (delimiter excluded) on its
+// own. Only keyframes can be decoded this way; deltas give kNotSynced,
+// summaries, health and timing records kNotSample.
+FrameStatus DecodeFrame(const uint8_t *frame, std::size_t len, Kind &kind, Sample &sample);
+
+// Follows one node's record stream, applying each delta to the record
+// before it. After a lost or corrupt frame deltas are refused with
+// kNotSynced until the next keyframe brings the stream back. Summaries,
+// health and timing records stand alone: they come back in LastSummary(),
+// LastHealth() and LastTiming() with `sample` untouched.
+class StreamDecoder {
+  public:
+    FrameStatus Decode(const uint8_t *frame, std::size_t len, Kind &kind, Sample &sample);
+    bool Synced() const {
+        return synced_;
+    }
+    const Summary &LastSummary() const {
+        return summary_;
+    }
+    const Health &LastHealth() const {
+        return health_;
+    }
+    const Timing &LastTiming() const {
+        return timing_;
+    }
+
+  private:
+    Sample reference_;
+    Summary summary_;
+    Health health_;
+    Timing timing_;
+    bool synced_ = false;
+};
+
+bool HasSection(const Sample &sample, telemetry::record::Section section);
+// Field in engineering units (see the comments in kFields).
+double Value(const Sample &sample, Field field);
+// Any wire value of `field` (such as a summary statistic) in engineering
+// units.
+double Value(Field field, double wire_value);
+// BMP280 altitude, recomputed from pressure the way the firmware does.
+double AltitudeM(const Sample &sample);
+
+const char *StatusName(FrameStatus status);
+
+}  // namespace decoder
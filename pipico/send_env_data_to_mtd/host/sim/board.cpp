@@ -0,0 +1,82 @@
+#include "sim/board.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "app/app_config.h"
+#include "sim/flash.h"
+#include "sim/gps_uart.h"
+#include "sim/i2c_bus.h"
+#include "sim/mesh_uart.h"
+#include "sim/report.h"
+#include "sim/sensor_devices.h"
+#include "sim/virtual_clock.h"
+#include "sim/watchdog.h"
+#include "telemetry/telemetry.h"
+
+namespace sim {
+namespace board {
+
+namespace {
+constexpr double kDefaultDurationS = 3600.0;
+
+Aht20Device aht20;
+Bmp280Device bmp280;
+Mpu6050Device mpu6050;
+Veml7700Device veml7700;
+HscdtdDevice hscdtd;
+Ssd1306Device display;
+bool initialised = false;
+
+}  // namespace
+
+void Init() {
+    if (initialised) {
+        return;
+    }
+    initialised = true;
+
+    double duration_s = kDefaultDurationS;
+    if (const char *value = std::getenv("SIM_DURATION_S")) {
+        duration_s = std::atof(value);
+    }
+    clock::SetDurationUs(static_cast<uint64_t>(duration_s * 1e6));
+    mesh_uart::OpenLog(std::getenv("SIM_MESH_LOG"));
+    mesh_uart::SetOutages(std::getenv("SIM_MESH_OUTAGE"));
+    if (std::getenv("SIM_CONSOLE_ON_MESH") != nullptr) {
+        mesh_uart::TakeConsole();
+    }
+    flash::OpenImage(std::getenv("SIM_FLASH_IMAGE"));
+    watchdog::OpenImage(std::getenv("SIM_RETAINED_IMAGE"));
+    if (const char *value = std::getenv("SIM_TELEMETRY_FORMAT")) {
+        telemetry::SetFormat(std::strcmp(value, "binary") == 0 ? telemetry::Format::kBinary
+                                                                : telemetry::Format::kAscii);
+    }
+    if (const char *value = std::getenv("SIM_TELEMETRY_KEYFRAME_INTERVAL")) {
+        telemetry::SetKeyframeInterval(static_cast<uint32_t>(std::atoi(value)));
+    }
+    i2c_bus::SetFaults(std::getenv("SIM_I2C_FAULTS"));
+    if (const char *value = std::getenv("SIM_GPS_BYTE_ERRORS")) {
+        gps_uart::SetByteErrorRate(std::atof(value));
+    }
+
+    i2c_bus::Attach(app::config::AHT20_ADDR, &aht20);
+    i2c_bus::Attach(app::config::BMP280_ADDR, &bmp280);
+    i2c_bus::Attach(app::config::MPU6050_ADDR, &mpu6050);
+    i2c_bus::Attach(app::config::VEML7700_ADDR, &veml7700);
+    i2c_bus::Attach(app::config::HSCDTD_ADDR, &hscdtd);
+    i2c_bus::Attach(app::config::DISPLAY_ADDR, &display);
+
+    report::Start();
+}
+
+const Ssd1306Device &Display() {
+    return display;
+}
+
+const Mpu6050Device &Imu() {
+    return mpu6050;
+}
+
+}  // namespace board
+}  // namespace sim
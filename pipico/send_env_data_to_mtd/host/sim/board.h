@@ -0,0 +1,22 @@
+#pragma once
+
+#include "sim/sensor_devices.h"
+#include "sim/ssd1306_device.h"
+
+// The simulated board: instantiates every device on the I2C bus, the GPS and
+// mesh UARTs and the virtual clock, configured from the environment:
+//   SIM_DURATION_S  virtual run length in seconds (default 3600)
+//   SIM_MESH_LOG    file receiving every byte written to the mesh UART
+//   SIM_MESH_OUTAGE mesh node downtime, "start_s+duration_s[,...]"
+//   SIM_FLASH_IMAGE file holding the flash contents across runs
+//   SIM_RETAINED_IMAGE file carrying the retained RAM from a run ended by a
+//                   watchdog reset into the next run (see watchdog.h)
+namespace sim {
+namespace board {
+
+void Init();
+const Ssd1306Device &Display();
+const Mpu6050Device &Imu();
+
+}  // namespace board
+}  // namespace sim
@@ -0,0 +1,113 @@
+#include "sim/environment.h"
+
+#include <cmath>
+
+namespace sim {
+namespace environment {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDay = 86400.0;
+constexpr double kStartLatitude = -41.2865;
+constexpr double kStartLongitude = 174.7762;
+constexpr double kMetresPerDegree = 111320.0;
+// Total field strength and inclination roughly matching central NZ.
+constexpr float kFieldUt = 57.0f;
+constexpr float kInclinationDeg = -66.0f;
+// Length of the turn-over at power-up.
+constexpr double kTumbleS = 180.0;
+
+}  // namespace
+
+float Noise(uint64_t time_us, unsigned channel) {
+    uint64_t h = time_us * 0x9E3779B97F4A7C15ull + (static_cast<uint64_t>(channel) + 1) * 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 29;
+    return static_cast<float>(static_cast<double>(h >> 11) / static_cast<double>(1ull << 53) * 2.0 - 1.0);
+}
+
+Conditions At(uint64_t time_us) {
+    const double t = static_cast<double>(time_us) / 1e6;
+    const double day_phase = 2.0 * kPi * t / kDay;
+
+    Conditions c{};
+    c.temperature_c = static_cast<float>(16.0 + 4.0 * std::sin(day_phase) + 0.3 * std::sin(t / 97.0)) +
+                      0.02f * Noise(time_us, 0);
+    c.humidity_pct = static_cast<float>(70.0 - 12.0 * std::sin(day_phase)) + 0.1f * Noise(time_us, 1);
+    c.pressure_pa = static_cast<float>(101325.0 - 250.0 * std::sin(t / 7200.0)) + 2.0f * Noise(time_us, 2);
+    const double sun = std::sin(day_phase);
+    c.lux = static_cast<float>(sun > 0.0 ? 20000.0 * sun : 0.5) * (1.0f + 0.01f * Noise(time_us, 3));
+
+    // Board slowly yawing clockwise and rocking by a few degrees, on a
+    // mount that hums at 23 Hz vertically and 31 Hz fore-aft. The attitude
+    // is heading, then pitch (nose down), then roll (right side down), in a
+    // world frame of x north, y west, z up.
+    // For the first kTumbleS it is also turned over and back, as an
+    // installer would to let the magnetometer calibrate: the extra roll and
+    // pitch swell and fade with a sin^2 envelope, so rates stay smooth.
+    double tumble = 0.0;
+    double tumble_rate = 0.0;
+    if (t < kTumbleS) {
+        tumble = std::pow(std::sin(kPi * t / kTumbleS), 2.0);
+        tumble_rate = kPi / kTumbleS * std::sin(2.0 * kPi * t / kTumbleS);
+    }
+    c.heading_deg = static_cast<float>(std::fmod(t * 0.5, 360.0));
+    c.roll_deg = static_cast<float>(8.0 * std::sin(t * 0.7) + 165.0 * tumble * std::sin(t * 0.31));
+    c.pitch_deg = static_cast<float>(6.0 * std::sin(t * 0.45) + 70.0 * tumble * std::sin(t * 0.19));
+    const double heading_r = c.heading_deg * kPi / 180.0;
+    const double roll_r = c.roll_deg * kPi / 180.0;
+    const double pitch_r = c.pitch_deg * kPi / 180.0;
+    const double roll_rate = 8.0 * 0.7 * std::cos(t * 0.7) +
+                             165.0 * (tumble_rate * std::sin(t * 0.31) + tumble * 0.31 * std::cos(t * 0.31));
+    const double pitch_rate = 6.0 * 0.45 * std::cos(t * 0.45) +
+                              70.0 * (tumble_rate * std::sin(t * 0.19) + tumble * 0.19 * std::cos(t * 0.19));
+    const double yaw_rate = -0.5;  // yaw is counter-clockwise about z
+
+    // World vectors in the board frame: undo heading, pitch and roll.
+    auto to_board = [&](double north, double west, double up, float *out) {
+        const double x1 = north * std::cos(heading_r) - west * std::sin(heading_r);
+        const double y1 = north * std::sin(heading_r) + west * std::cos(heading_r);
+        const double x2 = std::cos(pitch_r) * x1 - std::sin(pitch_r) * up;
+        const double z2 = std::sin(pitch_r) * x1 + std::cos(pitch_r) * up;
+        out[0] = static_cast<float>(x2);
+        out[1] = static_cast<float>(std::cos(roll_r) * y1 + std::sin(roll_r) * z2);
+        out[2] = static_cast<float>(-std::sin(roll_r) * y1 + std::cos(roll_r) * z2);
+    };
+
+    const double hum_z = 0.02 * std::sin(2.0 * kPi * 23.0 * t);
+    const double hum_x = 0.01 * std::sin(2.0 * kPi * 31.0 * t + 1.0);
+    to_board(0.0, 0.0, 1.0, c.accel_g);
+    c.accel_g[0] += static_cast<float>(hum_x) + 0.002f * Noise(time_us, 4);
+    c.accel_g[1] += 0.002f * Noise(time_us, 5);
+    c.accel_g[2] += static_cast<float>(hum_z) + 0.002f * Noise(time_us, 6);
+
+    // Body rates of the heading/pitch/roll sequence.
+    c.gyro_dps[0] = static_cast<float>(roll_rate - yaw_rate * std::sin(pitch_r)) + 0.05f * Noise(time_us, 7);
+    c.gyro_dps[1] = static_cast<float>(pitch_rate * std::cos(roll_r) +
+                                       yaw_rate * std::sin(roll_r) * std::cos(pitch_r)) +
+                    0.05f * Noise(time_us, 8);
+    c.gyro_dps[2] = static_cast<float>(-pitch_rate * std::sin(roll_r) +
+                                       yaw_rate * std::cos(roll_r) * std::cos(pitch_r)) +
+                    0.05f * Noise(time_us, 9);
+
+    // Earth field: horizontal part towards magnetic north, inclination
+    // negative (pointing up) as in the southern hemisphere.
+    const double incl_r = kInclinationDeg * kPi / 180.0;
+    to_board(kFieldUt * std::cos(incl_r), 0.0, -kFieldUt * std::sin(incl_r), c.mag_ut);
+    c.mag_ut[0] += 0.1f * Noise(time_us, 10);
+    c.mag_ut[1] += 0.1f * Noise(time_us, 11);
+    c.mag_ut[2] += 0.1f * Noise(time_us, 12);
+
+    // Walk north-east at ~1.2 m/s.
+    const double metres = 1.2 * t;
+    c.latitude_deg = kStartLatitude + metres * 0.7071 / kMetresPerDegree;
+    c.longitude_deg = kStartLongitude + metres * 0.7071 / (kMetresPerDegree * std::cos(kStartLatitude * kPi / 180.0));
+    c.altitude_m = 42.0f + 0.5f * Noise(time_us / 1000000, 13);
+    c.speed_knots = 2.33f;
+    c.course_deg = 45.0f;
+    return c;
+}
+
+}  // namespace environment
+}  // namespace sim
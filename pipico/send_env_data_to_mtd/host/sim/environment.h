@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// Synthetic world the simulated sensors observe. Everything is a smooth,
+// deterministic function of virtual time plus a little hashed noise, so runs
+// are reproducible and encoders see realistic sample-to-sample deltas.
+namespace sim {
+namespace environment {
+
+struct Conditions {
+    float temperature_c;
+    float humidity_pct;
+    float pressure_pa;
+    float lux;
+    // Board attitude and motion (x forward, y left, z up). Heading is
+    // clockwise from magnetic north, roll positive right side down, pitch
+    // positive nose down: both right-handed about the board axes.
+    float heading_deg;
+    float roll_deg;
+    float pitch_deg;
+    float accel_g[3];
+    float gyro_dps[3];
+    // Earth field in the board frame, microtesla.
+    float mag_ut[3];
+    // Receiver position.
+    double latitude_deg;
+    double longitude_deg;
+    float altitude_m;
+    float speed_knots;
+    float course_deg;
+};
+
+Conditions At(uint64_t time_us);
+
+// Uniform noise in [-1, 1], deterministic in (time_us, channel).
+float Noise(uint64_t time_us, unsigned channel);
+
+}  // namespace environment
+}  // namespace sim
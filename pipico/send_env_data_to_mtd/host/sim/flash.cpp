@@ -0,0 +1,104 @@
+#include "sim/flash.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "app/app_config.h"
+#include "hal/hal.h"
+#include "sim/virtual_clock.h"
+
+namespace sim {
+namespace flash {
+
+namespace {
+// W25Q-class typical times.
+constexpr uint64_t kSectorEraseUs = 45 * 1000;
+constexpr uint64_t kPageProgramUs = 700;
+
+std::vector<uint8_t> memory(app::config::FLASH_SIZE_BYTES, 0xFF);
+std::vector<uint32_t> erase_counts(app::config::FLASH_SIZE_BYTES / hal::kFlashSectorBytes, 0);
+std::string image_path;
+Stats stats = {};
+
+bool InRange(uint32_t offset, std::size_t len) {
+    return offset <= memory.size() && len <= memory.size() - offset;
+}
+
+void SaveImage() {
+    std::FILE *file = std::fopen(image_path.c_str(), "wb");
+    if (file == nullptr) {
+        return;
+    }
+    std::fwrite(memory.data(), 1, memory.size(), file);
+    std::fclose(file);
+}
+
+}  // namespace
+
+void OpenImage(const char *path) {
+    if (path == nullptr || !image_path.empty()) {
+        return;
+    }
+    image_path = path;
+    if (std::FILE *file = std::fopen(path, "rb")) {
+        std::vector<uint8_t> image(memory.size());
+        if (std::fread(image.data(), 1, image.size(), file) == image.size()) {
+            memory.swap(image);
+        }
+        std::fclose(file);
+    }
+    std::atexit(SaveImage);
+}
+
+void Read(uint32_t offset, void *dst, std::size_t len) {
+    if (!InRange(offset, len)) {
+        std::memset(dst, 0xFF, len);
+        return;
+    }
+    std::memcpy(dst, memory.data() + offset, len);
+}
+
+bool Erase(uint32_t offset, std::size_t len) {
+    if (offset % hal::kFlashSectorBytes != 0 || len % hal::kFlashSectorBytes != 0 || !InRange(offset, len)) {
+        return false;
+    }
+    for (std::size_t done = 0; done < len; done += hal::kFlashSectorBytes) {
+        std::memset(memory.data() + offset + done, 0xFF, hal::kFlashSectorBytes);
+        const uint32_t count = ++erase_counts[(offset + done) / hal::kFlashSectorBytes];
+        if (count > stats.max_sector_erases) {
+            stats.max_sector_erases = count;
+        }
+        ++stats.sectors_erased;
+        clock::BusyMasked(kSectorEraseUs);
+    }
+    return true;
+}
+
+bool Program(uint32_t offset, const void *src, std::size_t len) {
+    if (offset % hal::kFlashPageBytes != 0 || len % hal::kFlashPageBytes != 0 || !InRange(offset, len)) {
+        return false;
+    }
+    const uint8_t *bytes = static_cast<const uint8_t *>(src);
+    for (std::size_t i = 0; i < len; ++i) {
+        uint8_t &cell = memory[offset + i];
+        // 0xFF leaves a byte as it is, which is how callers write part of
+        // a page; any other byte is meant to land as given.
+        if (bytes[i] != 0xFF) {
+            stats.lost_bits += static_cast<uint64_t>(__builtin_popcount(bytes[i] & ~cell & 0xFF));
+        }
+        cell &= bytes[i];
+    }
+    stats.pages_programmed += len / hal::kFlashPageBytes;
+    clock::BusyMasked(kPageProgramUs * (len / hal::kFlashPageBytes));
+    return true;
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace flash
+}  // namespace sim
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Simulated QSPI NOR flash behind hal::Flash*. Erase sets whole sectors to
+// 0xFF, programming ANDs whole pages into what is there, as on the chip,
+// and both keep the calling core busy for the chip's typical times with
+// interrupts held off on both cores (clock::BusyMasked()). The stall of the
+// other core's thread code is not modelled. The image can be kept
+// across runs in the file named by SIM_FLASH_IMAGE, so state the firmware
+// stored is there at the next boot.
+namespace sim {
+namespace flash {
+
+struct Stats {
+    uint64_t sectors_erased;
+    uint64_t pages_programmed;
+    uint64_t max_sector_erases;  // wear of the most-erased sector
+    uint64_t lost_bits;          // 1 bits written over 0 bits (not in 0xFF bytes)
+};
+
+// Loads `path` if it exists (else starts erased) and writes the image back
+// to it at exit. Null keeps the flash in memory only.
+void OpenImage(const char *path);
+
+void Read(uint32_t offset, void *dst, std::size_t len);
+bool Erase(uint32_t offset, std::size_t len);
+bool Program(uint32_t offset, const void *src, std::size_t len);
+
+const Stats &GetStats();
+
+}  // namespace flash
+}  // namespace sim
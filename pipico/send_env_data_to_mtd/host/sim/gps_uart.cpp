@@ -0,0 +1,292 @@
+#include "sim/gps_uart.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "sim/environment.h"
+#include "sim/virtual_clock.h"
+
+namespace sim {
+namespace gps_uart {
+
+namespace {
+constexpr std::size_t kFifoDepth = 32;
+constexpr std::size_t kIrqLevel = kFifoDepth / 2;
+// hal_pico's kRxBridgeBytes.
+constexpr std::size_t kBridgeDepth = 512;
+constexpr uint64_t kFixAfterUs = 30ull * 1000000ull;
+constexpr uint64_t kBurstOffsetUs = 50000;
+// 2026-01-01T00:00:00Z as days since 1970-01-01.
+constexpr int64_t kEpochDays = 20454;
+
+uint64_t byte_us = 1042;
+std::string burst;
+std::size_t burst_pos = 0;
+uint64_t burst_second = 0;
+uint64_t next_byte_us = 0;
+uint8_t fifo[kFifoDepth];
+std::size_t fifo_head = 0;
+std::size_t fifo_count = 0;
+bool overrun = false;
+bool bridge_enabled = false;
+uint8_t bridge[kBridgeDepth];
+std::size_t bridge_head = 0;
+std::size_t bridge_count = 0;
+void (*rx_handler)() = nullptr;
+uint32_t error_threshold = 0;  // corrupt when the next random word is below this
+uint32_t noise_state = 0x2545F491u;
+Stats stats = {};
+
+uint32_t NextNoise() {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    return noise_state;
+}
+
+uint8_t ApplyLineNoise(uint8_t byte) {
+    if (error_threshold == 0 || NextNoise() >= error_threshold) {
+        return byte;
+    }
+    ++stats.bytes_corrupted;
+    return static_cast<uint8_t>(byte ^ (1u << (NextNoise() % 8)));
+}
+
+void Append(const char *body) {
+    uint8_t checksum = 0;
+    for (const char *p = body; *p; ++p) {
+        checksum ^= static_cast<uint8_t>(*p);
+    }
+    char sentence[128];
+    std::snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+    burst += sentence;
+    ++stats.sentences_sent;
+}
+
+void CivilFromDays(int64_t z, int &year, int &month, int &day) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+void FormatCoordinate(double degrees, int degree_digits, char positive, char negative,
+                      char *out, std::size_t out_len) {
+    const char hemisphere = degrees >= 0.0 ? positive : negative;
+    degrees = std::fabs(degrees);
+    const int whole = static_cast<int>(degrees);
+    const double minutes = (degrees - whole) * 60.0;
+    std::snprintf(out, out_len, "%0*d%08.5f,%c", degree_digits, whole, minutes, hemisphere);
+}
+
+void BuildBurst(uint64_t second) {
+    burst.clear();
+    burst_pos = 0;
+
+    const uint64_t at_us = second * 1000000ull;
+    const bool fix = at_us >= kFixAfterUs;
+    const environment::Conditions c = environment::At(at_us);
+
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    CivilFromDays(kEpochDays + static_cast<int64_t>(second / 86400), year, month, day);
+    const unsigned seconds_of_day = static_cast<unsigned>(second % 86400);
+    char time_field[16];
+    std::snprintf(time_field, sizeof(time_field), "%02u%02u%02u.00",
+                  seconds_of_day / 3600, (seconds_of_day / 60) % 60, seconds_of_day % 60);
+    char date_field[8];
+    std::snprintf(date_field, sizeof(date_field), "%02d%02d%02d", day, month, year % 100);
+
+    char lat[24];
+    char lon[24];
+    FormatCoordinate(c.latitude_deg, 2, 'N', 'S', lat, sizeof(lat));
+    FormatCoordinate(c.longitude_deg, 3, 'E', 'W', lon, sizeof(lon));
+
+    char body[112];
+    if (fix) {
+        std::snprintf(body, sizeof(body), "GPRMC,%s,A,%s,%s,%.3f,%.2f,%s,,,A",
+                      time_field, lat, lon, c.speed_knots, c.course_deg, date_field);
+    } else {
+        std::snprintf(body, sizeof(body), "GPRMC,%s,V,,,,,,,%s,,,N", time_field, date_field);
+    }
+    Append(body);
+
+    if (fix) {
+        std::snprintf(body, sizeof(body), "GPVTG,%.2f,T,,M,%.3f,N,%.3f,K,A",
+                      c.course_deg, c.speed_knots, c.speed_knots * 1.852f);
+    } else {
+        std::snprintf(body, sizeof(body), "GPVTG,,,,,,,,,N");
+    }
+    Append(body);
+
+    if (fix) {
+        std::snprintf(body, sizeof(body), "GPGGA,%s,%s,%s,1,08,1.01,%.1f,M,19.2,M,,",
+                      time_field, lat, lon, c.altitude_m);
+    } else {
+        std::snprintf(body, sizeof(body), "GPGGA,%s,,,,,0,00,99.99,,,,,,", time_field);
+    }
+    Append(body);
+
+    if (fix) {
+        Append("GPGSA,A,3,02,05,12,13,15,18,24,29,,,,,1.87,1.01,1.57");
+    } else {
+        Append("GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99");
+    }
+
+    static const int kSatellites[12] = {2, 5, 12, 13, 15, 18, 20, 24, 25, 29, 31, 32};
+    for (int msg = 0; msg < 3; ++msg) {
+        int length = std::snprintf(body, sizeof(body), "GPGSV,3,%d,12", msg + 1);
+        for (int i = 0; i < 4; ++i) {
+            const int sv = kSatellites[msg * 4 + i];
+            const int elevation = 10 + (sv * 7) % 70;
+            const int azimuth = (sv * 37) % 360;
+            if (fix && (msg * 4 + i) < 8) {
+                length += std::snprintf(body + length, sizeof(body) - length, ",%02d,%02d,%03d,%02d",
+                                        sv, elevation, azimuth, 25 + sv % 20);
+            } else {
+                length += std::snprintf(body + length, sizeof(body) - length, ",%02d,%02d,%03d,",
+                                        sv, elevation, azimuth);
+            }
+        }
+        Append(body);
+    }
+
+    if (fix) {
+        std::snprintf(body, sizeof(body), "GPGLL,%s,%s,%s,A,A", lat, lon, time_field);
+    } else {
+        std::snprintf(body, sizeof(body), "GPGLL,,,,,%s,V,N", time_field);
+    }
+    Append(body);
+}
+
+// Move every byte that has finished arriving by `now` into the RX FIFO.
+void CatchUp(uint64_t now) {
+    while (next_byte_us <= now) {
+        if (burst_pos >= burst.size()) {
+            ++burst_second;
+            BuildBurst(burst_second);
+            next_byte_us = burst_second * 1000000ull + kBurstOffsetUs;
+            continue;
+        }
+        const uint8_t byte = ApplyLineNoise(static_cast<uint8_t>(burst[burst_pos++]));
+        ++stats.bytes_sent;
+        const bool dma = bridge_enabled && clock::Masked(next_byte_us);
+        if (dma) {
+            // The DMA empties the FIFO first, then takes each byte as it lands.
+            for (; fifo_count > 0 && bridge_count < kBridgeDepth; --fifo_count) {
+                bridge[(bridge_head + bridge_count++) % kBridgeDepth] = fifo[fifo_head];
+                fifo_head = (fifo_head + 1) % kFifoDepth;
+            }
+        }
+        if (dma && fifo_count == 0 && bridge_count < kBridgeDepth) {
+            bridge[(bridge_head + bridge_count++) % kBridgeDepth] = byte;
+        } else if (fifo_count < kFifoDepth) {
+            fifo[(fifo_head + fifo_count) % kFifoDepth] = byte;
+            ++fifo_count;
+        } else {
+            ++stats.bytes_dropped;
+            overrun = true;
+        }
+        next_byte_us += byte_us;
+    }
+}
+
+void OnRxTimeout(void *) {
+    CatchUp(clock::NowUs());
+    if (fifo_count > 0) {
+        rx_handler();
+    }
+}
+
+// One event per received byte drives the interrupt model.
+void OnByteArrived(void *) {
+    const uint64_t now = clock::NowUs();
+    CatchUp(now);
+    if (fifo_count >= kIrqLevel) {
+        rx_handler();
+    }
+    const uint64_t timeout_us = byte_us * 32 / 10;
+    if (fifo_count > 0 && next_byte_us > now + timeout_us) {
+        clock::Schedule(now + timeout_us, OnRxTimeout, nullptr);
+    }
+    clock::Schedule(next_byte_us, OnByteArrived, nullptr);
+}
+
+}  // namespace
+
+void Init(uint32_t baud) {
+    // 8N1: ten bit times per byte.
+    byte_us = (10ull * 1000000ull + baud - 1) / baud;
+    burst.clear();
+    burst_pos = 0;
+    burst_second = clock::NowUs() / 1000000ull;
+    next_byte_us = clock::NowUs();
+    fifo_head = 0;
+    fifo_count = 0;
+}
+
+void SetByteErrorRate(double rate) {
+    if (rate <= 0.0) {
+        error_threshold = 0;
+    } else if (rate >= 1.0) {
+        error_threshold = 0xFFFFFFFFu;
+    } else {
+        error_threshold = static_cast<uint32_t>(rate * 4294967296.0);
+    }
+}
+
+void SetRxIrq(void (*handler)()) {
+    const bool first = rx_handler == nullptr;
+    rx_handler = handler;
+    if (first && handler != nullptr) {
+        CatchUp(clock::NowUs());
+        clock::Schedule(next_byte_us, OnByteArrived, nullptr);
+    }
+}
+
+void EnableFlashBridge() {
+    bridge_enabled = true;
+}
+
+bool TakeOverrun() {
+    const bool was = overrun;
+    overrun = false;
+    return was;
+}
+
+bool Readable() {
+    CatchUp(clock::NowUs());
+    return bridge_count > 0 || fifo_count > 0;
+}
+
+char Getc() {
+    while (!Readable()) {
+        clock::Busy(next_byte_us - clock::NowUs());
+    }
+    char ch;
+    if (bridge_count > 0) {
+        ch = static_cast<char>(bridge[bridge_head]);
+        bridge_head = (bridge_head + 1) % kBridgeDepth;
+        --bridge_count;
+    } else {
+        ch = static_cast<char>(fifo[fifo_head]);
+        fifo_head = (fifo_head + 1) % kFifoDepth;
+        --fifo_count;
+    }
+    ++stats.bytes_received;
+    return ch;
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace gps_uart
+}  // namespace sim
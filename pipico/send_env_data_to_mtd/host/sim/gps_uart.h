@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Simulated GPS receiver on a PL011 UART. The receiver emits a NMEA burst
+// (RMC, VTG, GGA, GSA, GSV, GLL) once per second at the configured baud
+// rate; bytes land in a 32-entry RX FIFO and are lost when nobody drains it.
+// With the RX interrupt enabled the handler runs, like the PL011's, once the
+// FIFO is half full or the line has been quiet for 32 bit times. Line noise
+// can be injected by flipping one bit in a random fraction of the bytes.
+//
+// With the flash bridge on, what arrives while interrupts are masked
+// (clock::BusyMasked()) goes to a RAM buffer, after what the FIFO held,
+// and is read before the FIFO: the RX DMA hal_pico runs around flash
+// writes.
+namespace sim {
+namespace gps_uart {
+
+struct Stats {
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t bytes_dropped;
+    uint64_t sentences_sent;
+    uint64_t bytes_corrupted;
+};
+
+void Init(uint32_t baud);
+// Probability (0..1) that any one byte is corrupted on the wire.
+void SetByteErrorRate(double rate);
+void SetRxIrq(void (*handler)());
+void EnableFlashBridge();
+bool Readable();
+// Returns and clears the sticky FIFO overrun flag.
+bool TakeOverrun();
+// Blocks in virtual time until a byte is available, like uart_getc.
+char Getc();
+
+const Stats &GetStats();
+
+}  // namespace gps_uart
+}  // namespace sim
@@ -0,0 +1,300 @@
+#include "hal/hal.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "app/app_config.h"
+#include "sim/board.h"
+#include "sim/flash.h"
+#include "sim/gps_uart.h"
+#include "sim/i2c_bus.h"
+#include "sim/mesh_uart.h"
+#include "sim/virtual_clock.h"
+#include "sim/watchdog.h"
+
+// HAL backend for the host simulator. main() calls hal::StdioInit() before
+// touching any peripheral, which is where the simulated board is brought up.
+namespace hal {
+
+void StdioInit() {
+    sim::board::Init();
+}
+
+void StdioFlush() {
+    std::fflush(stdout);
+}
+
+uint64_t TimeUs() {
+    return sim::clock::NowUs();
+}
+
+void SleepMs(uint32_t ms) {
+    sim::clock::Idle(static_cast<uint64_t>(ms) * 1000ull);
+}
+
+void SleepUs(uint64_t us) {
+    sim::clock::Idle(us);
+}
+
+namespace {
+void (*alarm_callbacks[kAlarmCount])() = {};
+uint32_t alarm_events[kAlarmCount] = {};
+// Context for FireAlarm(): the alarm's index.
+Alarm alarm_ids[kAlarmCount] = {kAlarmScheduler, kAlarmI2c};
+
+void FireAlarm(void *context) {
+    const Alarm alarm = *static_cast<Alarm *>(context);
+    alarm_events[alarm] = 0;
+    if (alarm_callbacks[alarm] != nullptr) {
+        alarm_callbacks[alarm]();
+    }
+}
+
+}  // namespace
+
+void AlarmInit(Alarm alarm, void (*callback)()) {
+    alarm_callbacks[alarm] = callback;
+}
+
+bool AlarmSetTarget(Alarm alarm, uint64_t at_us) {
+    AlarmCancel(alarm);
+    if (at_us <= sim::clock::NowUs()) {
+        return false;
+    }
+    alarm_events[alarm] = sim::clock::Schedule(at_us, FireAlarm, &alarm_ids[alarm]);
+    return true;
+}
+
+void AlarmCancel(Alarm alarm) {
+    if (alarm_events[alarm] != 0) {
+        sim::clock::Cancel(alarm_events[alarm]);
+        alarm_events[alarm] = 0;
+    }
+}
+
+void AlarmTrigger(Alarm alarm) {
+    AlarmCancel(alarm);
+    alarm_events[alarm] = sim::clock::Schedule(sim::clock::NowUs(), FireAlarm, &alarm_ids[alarm]);
+}
+
+// Every interrupt source in the model is a clock event, so waiting for an
+// event idles the virtual clock up to the next one and runs it.
+void WaitForEvent() {
+    if (!sim::clock::IdleUntilNextEvent()) {
+        sim::clock::Idle(1000);
+    }
+}
+
+namespace {
+SleepStats sleep_stats = {};
+}  // namespace
+
+// The sleep state is only accounted: the model has no clocks to gate, and
+// the oscillators keep running on the chip too. Waking takes no time here,
+// so wake latency is not modelled and stays 0; only the chip measures it.
+void IdleUntil(uint64_t wake_us) {
+    const uint64_t start = sim::clock::NowUs();
+    const bool deep = app::config::LOW_POWER_IDLE && wake_us >= start + app::config::LOW_POWER_MIN_SLEEP_US &&
+                      !sim::i2c_bus::AsyncActive();
+    WaitForEvent();
+    if (!deep) {
+        return;
+    }
+    // The chip only sleeps once core1 has finished too.
+    const uint64_t woke = sim::clock::NowUs();
+    const uint64_t core1_free = sim::clock::Core1FreeAtUs();
+    const uint64_t asleep_from = core1_free > start ? core1_free : start;
+    ++sleep_stats.sleeps;
+    sleep_stats.asleep_us += woke > asleep_from ? woke - asleep_from : 0;
+    if (woke >= wake_us) {
+        ++sleep_stats.timed_wakes;
+    }
+}
+
+const SleepStats &GetSleepStats() {
+    return sleep_stats;
+}
+
+void LowPowerInit() {
+}
+
+// Events only run inside clock calls, never between two firmware statements,
+// and core1 runs to completion inside one, so nothing can interleave.
+void CriticalInit() {
+}
+
+uint32_t CriticalEnter() {
+    return 0;
+}
+
+void CriticalExit(uint32_t state) {
+    (void)state;
+}
+
+namespace {
+void (*core1_service)() = nullptr;
+bool core1_wake_pending = false;
+
+void RunCore1(void *) {
+    core1_wake_pending = false;
+    sim::clock::RunOnCore1(core1_service);
+}
+
+}  // namespace
+
+void Core1Launch(void (*service)()) {
+    core1_service = service;
+}
+
+// Core1 runs its service once per wake-up, after it finishes what it was
+// already doing.
+void SignalEvent() {
+    if (core1_service == nullptr || core1_wake_pending) {
+        return;
+    }
+    core1_wake_pending = true;
+    const uint64_t now = sim::clock::NowUs();
+    const uint64_t free_at = sim::clock::Core1FreeAtUs();
+    sim::clock::Schedule(free_at > now ? free_at : now, RunCore1, nullptr);
+}
+
+unsigned CoreNum() {
+    return sim::clock::OnCore1() ? 1 : 0;
+}
+
+void GpioInitOutput(unsigned pin) {
+    (void)pin;
+}
+
+void GpioPut(unsigned pin, bool value) {
+    (void)pin;
+    (void)value;
+}
+
+void I2cInit(unsigned port, unsigned sda_pin, unsigned scl_pin, uint32_t baud_hz) {
+    (void)port;
+    (void)sda_pin;
+    (void)scl_pin;
+    sim::i2c_bus::SetBaudrate(baud_hz);
+}
+
+void I2cSetClock(unsigned port, uint32_t baud_hz) {
+    (void)port;
+    sim::i2c_bus::SetBaudrate(baud_hz);
+}
+
+int I2cWrite(unsigned port, uint8_t addr, const uint8_t *src, std::size_t len, bool nostop, uint32_t timeout_us) {
+    (void)port;
+    return sim::i2c_bus::Write(addr, src, len, nostop, timeout_us);
+}
+
+int I2cRead(unsigned port, uint8_t addr, uint8_t *dst, std::size_t len, bool nostop, uint32_t timeout_us) {
+    (void)port;
+    return sim::i2c_bus::Read(addr, dst, len, nostop, timeout_us);
+}
+
+bool I2cTransferAsync(unsigned port, uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx,
+                      std::size_t rx_len, I2cDoneFn done, void *context) {
+    (void)port;
+    return sim::i2c_bus::StartAsync(addr, tx, tx_len, rx, rx_len, done, context);
+}
+
+void I2cAbort(unsigned port) {
+    (void)port;
+    sim::i2c_bus::AbortAsync();
+}
+
+bool I2cRecoverBus(unsigned port) {
+    (void)port;
+    return sim::i2c_bus::Recover();
+}
+
+void UartInit(unsigned port, uint32_t baud, unsigned tx_pin, unsigned rx_pin) {
+    (void)tx_pin;
+    (void)rx_pin;
+    if (port == app::config::GPS_UART) {
+        sim::gps_uart::Init(baud);
+    } else if (port == app::config::MESH_UART) {
+        sim::mesh_uart::Init(baud);
+    }
+}
+
+bool UartReadable(unsigned port) {
+    return port == app::config::GPS_UART && sim::gps_uart::Readable();
+}
+
+char UartGetc(unsigned port) {
+    return port == app::config::GPS_UART ? sim::gps_uart::Getc() : '\0';
+}
+
+void UartPuts(unsigned port, const char *text) {
+    if (port == app::config::MESH_UART) {
+        sim::mesh_uart::Write(reinterpret_cast<const uint8_t *>(text), std::strlen(text));
+    }
+}
+
+void UartWrite(unsigned port, const uint8_t *data, std::size_t len) {
+    if (port == app::config::MESH_UART) {
+        sim::mesh_uart::Write(data, len);
+    }
+}
+
+void UartSetRxHandler(unsigned port, void (*handler)()) {
+    if (port == app::config::GPS_UART) {
+        sim::gps_uart::SetRxIrq(handler);
+        sim::gps_uart::EnableFlashBridge();
+    }
+}
+
+bool UartTakeOverrun(unsigned port) {
+    return port == app::config::GPS_UART && sim::gps_uart::TakeOverrun();
+}
+
+void UartEnableCts(unsigned port, unsigned cts_pin) {
+    (void)cts_pin;
+    if (port == app::config::MESH_UART) {
+        sim::mesh_uart::EnableCts();
+    }
+}
+
+bool UartClearToSend(unsigned port) {
+    return port != app::config::MESH_UART || sim::mesh_uart::ClearToSend();
+}
+
+void FlashRead(uint32_t offset, void *dst, std::size_t len) {
+    sim::flash::Read(offset, dst, len);
+}
+
+bool FlashErase(uint32_t offset, std::size_t len) {
+    return sim::flash::Erase(offset, len);
+}
+
+bool FlashProgram(uint32_t offset, const void *src, std::size_t len) {
+    return sim::flash::Program(offset, src, len);
+}
+
+void WatchdogStart(uint32_t timeout_ms) {
+    sim::watchdog::Start(timeout_ms);
+}
+
+void WatchdogFeed() {
+    sim::watchdog::Feed();
+}
+
+bool WatchdogCausedReset() {
+    return sim::watchdog::CausedReset();
+}
+
+void WatchdogScratchWrite(std::size_t index, uint32_t value) {
+    sim::watchdog::Scratch()[index] = value;
+}
+
+uint32_t WatchdogScratchRead(std::size_t index) {
+    return sim::watchdog::Scratch()[index];
+}
+
+uint8_t *RetainedRam() {
+    return sim::watchdog::RetainedRam();
+}
+
+}  // namespace hal
@@ -0,0 +1,237 @@
+#include "sim/i2c_bus.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "hal/hal.h"
+#include "sim/virtual_clock.h"
+
+namespace sim {
+namespace i2c_bus {
+
+namespace {
+// START, repeated START/STOP and ACK bits on top of 8 bits per byte.
+constexpr uint32_t kBitsPerByte = 9;
+constexpr uint32_t kFramingBits = 2;
+// Nine SCL pulses, START and STOP.
+constexpr uint32_t kRecoveryBits = 11;
+
+I2cDevice *devices[128] = {};
+DeviceStats stats[128] = {};
+uint32_t baudrate = 100 * 1000;
+
+struct Fault {
+    uint8_t addr;
+    bool hang;
+    uint64_t start_us;
+    uint64_t end_us;
+};
+std::vector<Fault> faults;
+bool wedged = false;
+uint32_t recoveries = 0;
+
+bool Faulty(uint8_t addr, bool hang) {
+    const uint64_t now = clock::NowUs();
+    for (const Fault &fault : faults) {
+        if (fault.addr == (addr & 0x7F) && fault.hang == hang && now >= fault.start_us && now < fault.end_us) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Whether a transfer to `addr` starting now never finishes.
+bool Hangs(uint8_t addr) {
+    if (!wedged && Faulty(addr, true)) {
+        wedged = true;
+        ++stats[addr & 0x7F].hangs;
+    }
+    return wedged;
+}
+
+uint64_t BitsUs(uint64_t bits) {
+    return (bits * 1000000ull + baudrate - 1) / baudrate;
+}
+
+I2cDevice *Target(uint8_t addr) {
+    return Faulty(addr, false) ? nullptr : devices[addr & 0x7F];
+}
+
+// Account a finished transfer and return its SDK-style result.
+int Account(uint8_t addr, std::size_t len, bool ok, uint64_t bits) {
+    DeviceStats &entry = stats[addr & 0x7F];
+    ++entry.transfers;
+    entry.bits += bits;
+    entry.bus_us += BitsUs(bits);
+    entry.clock_hz = baudrate;
+    if (!ok) {
+        ++entry.nacks;
+        return hal::kI2cNack;
+    }
+    entry.bytes += len;
+    return static_cast<int>(len);
+}
+
+int Complete(uint8_t addr, std::size_t len, bool ok) {
+    const uint64_t bits = TransferBits(ok ? len : 0);
+    clock::Busy(BitsUs(bits));
+    return Account(addr, len, ok, bits);
+}
+
+struct AsyncTransfer {
+    bool active;
+    uint32_t event;
+    uint8_t addr;
+    const uint8_t *tx;
+    std::size_t tx_len;
+    uint8_t *rx;
+    std::size_t rx_len;
+    DoneFn done;
+    void *context;
+};
+AsyncTransfer async = {};
+
+// The device sees both phases when the transfer finishes on the wire; the
+// DMA engine only reports the overall outcome, like the STOP_DET/TX_ABRT IRQ.
+void FinishAsync(void *) {
+    AsyncTransfer transfer = async;
+    async.active = false;
+    I2cDevice *device = Target(transfer.addr);
+    if (device == nullptr) {
+        transfer.done(Account(transfer.addr, 0, false, TransferBits(0)), transfer.context);
+        return;
+    }
+    int result = 0;
+    if (transfer.tx_len > 0) {
+        result = Account(transfer.addr, transfer.tx_len, device->Write(transfer.tx, transfer.tx_len),
+                         TransferBits(transfer.tx_len));
+    }
+    if (result >= 0 && transfer.rx_len > 0) {
+        result = Account(transfer.addr, transfer.rx_len, device->Read(transfer.rx, transfer.rx_len),
+                         TransferBits(transfer.rx_len));
+    }
+    transfer.done(result, transfer.context);
+}
+
+}  // namespace
+
+void Attach(uint8_t addr, I2cDevice *device) {
+    devices[addr & 0x7F] = device;
+    stats[addr & 0x7F].name = device->Name();
+}
+
+void SetBaudrate(uint32_t baud_hz) {
+    baudrate = baud_hz;
+}
+
+uint32_t Baudrate() {
+    return baudrate;
+}
+
+uint64_t TransferBits(std::size_t len) {
+    return (len + 1) * kBitsPerByte + kFramingBits;
+}
+
+uint64_t TransferUs(std::size_t len) {
+    return BitsUs(TransferBits(len));
+}
+
+void SetFaults(const char *spec) {
+    while (spec != nullptr && *spec != '\0') {
+        char *end = nullptr;
+        const unsigned long addr = std::strtoul(spec, &end, 0);
+        if (end == spec || *end != ':') {
+            return;
+        }
+        const char *kind = end + 1;
+        const char *at = kind;
+        while (*at != '\0' && *at != '@') {
+            ++at;
+        }
+        if (*at != '@') {
+            return;
+        }
+        const double start_s = std::strtod(at + 1, &end);
+        if (*end != '+') {
+            return;
+        }
+        const double duration_s = std::strtod(end + 1, &end);
+        const uint64_t start_us = static_cast<uint64_t>(start_s * 1e6);
+        faults.push_back({static_cast<uint8_t>(addr & 0x7F), at - kind == 4 && kind[0] == 'h', start_us,
+                          start_us + static_cast<uint64_t>(duration_s * 1e6)});
+        spec = *end == ',' ? end + 1 : end;
+    }
+}
+
+int Write(uint8_t addr, const uint8_t *src, std::size_t len, bool nostop, uint32_t timeout_us) {
+    (void)nostop;
+    if (Hangs(addr)) {
+        clock::Busy(timeout_us);
+        return hal::kI2cTimeout;
+    }
+    I2cDevice *device = Target(addr);
+    return Complete(addr, len, device != nullptr && device->Write(src, len));
+}
+
+int Read(uint8_t addr, uint8_t *dst, std::size_t len, bool nostop, uint32_t timeout_us) {
+    (void)nostop;
+    if (Hangs(addr)) {
+        clock::Busy(timeout_us);
+        return hal::kI2cTimeout;
+    }
+    I2cDevice *device = Target(addr);
+    return Complete(addr, len, device != nullptr && device->Read(dst, len));
+}
+
+bool StartAsync(uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx, std::size_t rx_len,
+                DoneFn done, void *context) {
+    if (async.active) {
+        return false;
+    }
+    async = AsyncTransfer{true, 0, addr, tx, tx_len, rx, rx_len, done, context};
+    if (Hangs(addr)) {
+        return true;  // SDA held low: no STOP, no completion
+    }
+    uint64_t wire_us = 0;
+    if (tx_len > 0) {
+        wire_us += TransferUs(tx_len);
+    }
+    if (rx_len > 0) {
+        wire_us += TransferUs(rx_len);
+    }
+    async.event = clock::Schedule(clock::NowUs() + wire_us, FinishAsync, nullptr);
+    return true;
+}
+
+void AbortAsync() {
+    if (async.active && async.event != 0) {
+        clock::Cancel(async.event);
+    }
+    async.active = false;
+}
+
+bool AsyncActive() {
+    return async.active;
+}
+
+bool Recover() {
+    clock::Busy(BitsUs(kRecoveryBits));
+    wedged = false;
+    ++recoveries;
+    return true;
+}
+
+uint32_t Recoveries() {
+    return recoveries;
+}
+
+const DeviceStats &Stats(uint8_t addr) {
+    return stats[addr & 0x7F];
+}
+
+I2cDevice *Device(uint8_t addr) {
+    return devices[addr & 0x7F];
+}
+
+}  // namespace i2c_bus
+}  // namespace sim
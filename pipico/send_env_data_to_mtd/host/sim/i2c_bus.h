@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sim/i2c_device.h"
+
+// Simulated I2C controller. Every transfer advances the virtual clock by its
+// wire time at the SCL rate set when it starts and is accounted per target
+// address.
+namespace sim {
+namespace i2c_bus {
+
+struct DeviceStats {
+    const char *name;
+    uint32_t transfers;
+    uint32_t nacks;
+    uint32_t hangs;  // transfers that wedged the bus (SIM_I2C_FAULTS)
+    uint64_t bytes;
+    uint64_t bits;      // SCL periods on the wire, whatever the rate
+    uint64_t bus_us;
+    uint32_t clock_hz;  // rate of the last transfer
+};
+
+void Attach(uint8_t addr, I2cDevice *device);
+void SetBaudrate(uint32_t baud_hz);
+uint32_t Baudrate();
+
+// Injected faults as "addr:kind@start_s+duration_s" in virtual seconds,
+// comma separated, e.g. "0x77:hang@600+30,0x38:nack@1200+60". During a
+// nack window the device NACKs every transfer; during a hang window a
+// transfer to it wedges the bus, holding SDA low so that neither it nor
+// any later transfer finishes until Recover().
+void SetFaults(const char *spec);
+
+// Blocking transfers; a wedged bus costs `timeout_us` and fails.
+int Write(uint8_t addr, const uint8_t *src, std::size_t len, bool nostop, uint32_t timeout_us);
+int Read(uint8_t addr, uint8_t *dst, std::size_t len, bool nostop, uint32_t timeout_us);
+
+// DMA-style transfer: write `tx_len` bytes, then read `rx_len` bytes after a
+// repeated START. The CPU is not charged; the device sees the transfer and
+// `done` runs as a clock event once its wire time has elapsed. Returns false
+// while another asynchronous transfer is in flight.
+using DoneFn = void (*)(int result, void *context);
+bool StartAsync(uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx, std::size_t rx_len,
+                DoneFn done, void *context);
+// Drops the asynchronous transfer in flight without calling `done`.
+void AbortAsync();
+bool AsyncActive();
+// Clocks the bus free: unwedges it and costs the recovery's wire time.
+// Returns true, as the modelled targets always let go.
+bool Recover();
+uint32_t Recoveries();
+
+// SCL periods of a transfer carrying `len` data bytes after the address
+// byte, and their wire time at the current rate.
+uint64_t TransferBits(std::size_t len);
+uint64_t TransferUs(std::size_t len);
+
+const DeviceStats &Stats(uint8_t addr);
+I2cDevice *Device(uint8_t addr);
+
+}  // namespace i2c_bus
+}  // namespace sim
@@ -0,0 +1,38 @@
+#include "sim/i2c_device.h"
+
+namespace sim {
+
+bool RegisterDevice::Write(const uint8_t *src, std::size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    pointer_ = src[0];
+    for (std::size_t i = 1; i < len; ++i) {
+        OnRegisterWrite(pointer_++, src[i]);
+    }
+    return true;
+}
+
+bool RegisterDevice::Read(uint8_t *dst, std::size_t len) {
+    const uint8_t start = pointer_;
+    BeforeRead(start);
+    for (std::size_t i = 0; i < len; ++i) {
+        dst[i] = regs_[pointer_++];
+    }
+    AfterRead(start, len);
+    return true;
+}
+
+void RegisterDevice::Put16Be(uint8_t reg, int32_t value) {
+    const uint16_t raw = static_cast<uint16_t>(value);
+    regs_[reg] = static_cast<uint8_t>(raw >> 8);
+    regs_[static_cast<uint8_t>(reg + 1)] = static_cast<uint8_t>(raw & 0xFF);
+}
+
+void RegisterDevice::Put16Le(uint8_t reg, int32_t value) {
+    const uint16_t raw = static_cast<uint16_t>(value);
+    regs_[reg] = static_cast<uint8_t>(raw & 0xFF);
+    regs_[static_cast<uint8_t>(reg + 1)] = static_cast<uint8_t>(raw >> 8);
+}
+
+}  // namespace sim
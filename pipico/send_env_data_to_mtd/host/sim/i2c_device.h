@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sim {
+
+// A simulated I2C target. Returning false from Write/Read NACKs the transfer.
+class I2cDevice {
+public:
+    virtual ~I2cDevice() = default;
+
+    virtual const char *Name() const = 0;
+    virtual bool Write(const uint8_t *src, std::size_t len) = 0;
+    virtual bool Read(uint8_t *dst, std::size_t len) = 0;
+};
+
+// Devices addressed through an 8-bit auto-incrementing register pointer: the
+// first written byte selects the register, further bytes are stored from it.
+class RegisterDevice : public I2cDevice {
+public:
+    bool Write(const uint8_t *src, std::size_t len) override;
+    bool Read(uint8_t *dst, std::size_t len) override;
+
+protected:
+    // Called before a read starting at `reg`, so data registers can be refreshed.
+    virtual void BeforeRead(uint8_t reg) { (void)reg; }
+    virtual void AfterRead(uint8_t reg, std::size_t len) { (void)reg; (void)len; }
+    virtual void OnRegisterWrite(uint8_t reg, uint8_t value) { regs_[reg] = value; }
+
+    void Put16Be(uint8_t reg, int32_t value);
+    void Put16Le(uint8_t reg, int32_t value);
+
+    uint8_t regs_[256] = {};
+    uint8_t pointer_ = 0;
+};
+
+}  // namespace sim
@@ -0,0 +1,164 @@
+#include "sim/mesh_uart.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sim/virtual_clock.h"
+
+namespace sim {
+namespace mesh_uart {
+
+namespace {
+constexpr uint64_t kFifoDepth = 32;
+// Node side: roughly LoRa LongFast airtime, and a modest serial buffer.
+constexpr uint64_t kAirBytesPerS = 200;
+constexpr uint64_t kNodeHighWater = 1024;
+constexpr uint64_t kNodeBufferBytes = 4096;
+
+struct Outage {
+    uint64_t start_us;
+    uint64_t end_us;
+};
+
+uint64_t byte_us = 87;
+uint64_t drained_at_us = 0;
+std::FILE *log_file = nullptr;
+uint64_t lines = 0;
+uint64_t frames = 0;
+uint8_t last_byte = 0x00;
+Stats stats = {};
+std::vector<Outage> outages;
+bool cts_enabled = false;
+uint64_t node_queued = 0;  // bytes waiting for airtime
+uint64_t node_drained_at_us = 0;
+
+bool Down(uint64_t now) {
+    for (const Outage &outage : outages) {
+        if (now >= outage.start_us && now < outage.end_us) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DrainNode(uint64_t now) {
+    const uint64_t sent = (now - node_drained_at_us) * kAirBytesPerS / 1000000;
+    if (sent >= node_queued) {
+        node_queued = 0;
+        node_drained_at_us = now;
+    } else if (sent > 0) {
+        node_queued -= sent;
+        node_drained_at_us += sent * 1000000 / kAirBytesPerS;
+    }
+}
+
+#ifdef __GLIBC__
+ssize_t WriteConsole(void *, const char *text, size_t len) {
+    Write(reinterpret_cast<const uint8_t *>(text), len);
+    return static_cast<ssize_t>(len);
+}
+#endif
+
+}  // namespace
+
+void Init(uint32_t baud) {
+    // 8N1: ten bit times per byte.
+    byte_us = (10ull * 1000000ull + baud - 1) / baud;
+}
+
+void OpenLog(const char *path) {
+    if (path != nullptr && log_file == nullptr) {
+        log_file = std::fopen(path, "wb");
+    }
+}
+
+void TakeConsole() {
+#ifdef __GLIBC__
+    const cookie_io_functions_t io = {nullptr, WriteConsole, nullptr, nullptr};
+    if (std::FILE *console = fopencookie(nullptr, "w", io)) {
+        // Line by line, at the virtual time each line is finished.
+        std::setvbuf(console, nullptr, _IOLBF, 0);
+        stdout = console;
+    }
+#else
+    std::fprintf(stderr, "SIM_CONSOLE_ON_MESH needs glibc; the console stays on stdout\n");
+#endif
+}
+
+void SetOutages(const char *spec) {
+    while (spec != nullptr && *spec != '\0') {
+        char *end = nullptr;
+        const double start_s = std::strtod(spec, &end);
+        if (end == spec || *end != '+') {
+            return;
+        }
+        const double duration_s = std::strtod(end + 1, &end);
+        const uint64_t start_us = static_cast<uint64_t>(start_s * 1e6);
+        outages.push_back({start_us, start_us + static_cast<uint64_t>(duration_s * 1e6)});
+        spec = *end == ',' ? end + 1 : end;
+    }
+}
+
+void EnableCts() {
+    cts_enabled = true;
+}
+
+bool ClearToSend() {
+    if (!cts_enabled) {
+        return true;
+    }
+    const uint64_t now = clock::NowUs();
+    DrainNode(now);
+    return !Down(now) && node_queued < kNodeHighWater;
+}
+
+void Write(const uint8_t *data, std::size_t len) {
+    const uint64_t now = clock::NowUs();
+    const uint64_t start = drained_at_us > now ? drained_at_us : now;
+    drained_at_us = start + len * byte_us;
+    // The caller is released once everything but the last FIFO-full is queued.
+    const uint64_t fifo_us = kFifoDepth * byte_us;
+    if (drained_at_us > now + fifo_us) {
+        clock::Busy(drained_at_us - fifo_us - now);
+    }
+
+    // Judged once per write: the firmware checks CTS between records.
+    DrainNode(now);
+    if (Down(now) || node_queued + len > kNodeBufferBytes) {
+        stats.lost_bytes += len;
+        return;
+    }
+    node_queued += len;
+
+    stats.bytes += len;
+    for (std::size_t i = 0; i < len; ++i) {
+        // A 0x00 right after another only delimits an empty frame.
+        if (data[i] == 0x00 && last_byte != 0x00) {
+            ++frames;
+        } else if (data[i] == '\n') {
+            ++lines;
+        }
+        last_byte = data[i];
+    }
+    // COBS payloads may contain '\n' but never 0x00.
+    stats.records = frames > 0 ? frames : lines;
+    if (log_file != nullptr) {
+        std::fwrite(data, 1, len, log_file);
+        std::fflush(log_file);
+    }
+}
+
+const Stats &GetStats() {
+    const uint64_t now = clock::NowUs();
+    stats.outage_us = 0;
+    for (const Outage &outage : outages) {
+        if (now > outage.start_us) {
+            stats.outage_us += (now < outage.end_us ? now : outage.end_us) - outage.start_us;
+        }
+    }
+    return stats;
+}
+
+}  // namespace mesh_uart
+}  // namespace sim
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Simulated link to the Meshtastic node. Writes block in virtual time once
+// the 32-byte TX FIFO is full; everything the node receives can be mirrored
+// to the file named by SIM_MESH_LOG for the host-side decoders.
+//
+// The node queues what it receives and sends it over the air at a limited
+// rate. It holds CTS off while that queue is above its high-water mark and
+// while it is down (SIM_MESH_OUTAGE); bytes written to a node that is down
+// or full are lost.
+//
+// With SIM_CONSOLE_ON_MESH set the console (stdout) goes down the same link,
+// as with stdio on the mesh UART, which shows whether the binary stream
+// survives it: run decode_telemetry on the SIM_MESH_LOG.
+namespace sim {
+namespace mesh_uart {
+
+struct Stats {
+    uint64_t bytes;       // received by the node
+    uint64_t records;     // ASCII lines, or binary frames once a 0x00 delimiter is seen
+    uint64_t lost_bytes;  // written while the node was down or full
+    uint64_t outage_us;   // scheduled downtime so far
+};
+
+void Init(uint32_t baud);
+void OpenLog(const char *path);
+// Sends what the firmware prints to the node instead of stdout.
+void TakeConsole();
+// Outages as "start_s+duration_s" in virtual seconds, comma separated.
+void SetOutages(const char *spec);
+void Write(const uint8_t *data, std::size_t len);
+void EnableCts();
+bool ClearToSend();
+
+const Stats &GetStats();
+
+}  // namespace mesh_uart
+}  // namespace sim
@@ -0,0 +1,259 @@
+#include "sim/report.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "app/app_config.h"
+#include "gps/gps.h"
+#include "gps/nmea.h"
+#include "hal/hal.h"
+#include "i2c/transaction_queue.h"
+#include "output/output.h"
+#include "profile/profile.h"
+#include "scheduler/scheduler.h"
+#include "supervisor/supervisor.h"
+#include "sensors/mag_calibration.h"
+#include "sim/board.h"
+#include "sim/flash.h"
+#include "sim/gps_uart.h"
+#include "sim/i2c_bus.h"
+#include "sim/mesh_uart.h"
+#include "sim/virtual_clock.h"
+#include "sim/watchdog.h"
+#include "telemetry/backlog.h"
+#include "telemetry/telemetry.h"
+
+namespace sim {
+namespace report {
+
+namespace {
+std::chrono::steady_clock::time_point wall_start;
+
+double PerCycle(double value, uint64_t cycles) {
+    return cycles > 0 ? value / static_cast<double>(cycles) : 0.0;
+}
+
+// Telemetry periods run. Health records share the mesh link, so records
+// sent no longer count cycles by themselves.
+uint64_t Cycles(const mesh_uart::Stats &mesh) {
+    for (std::size_t i = 0; i < scheduler::TaskCount(); ++i) {
+        const scheduler::Task &task = scheduler::GetTask(i);
+        if (std::strcmp(task.name, "telemetry") == 0) {
+            return task.jobs;
+        }
+    }
+    return mesh.records;
+}
+
+}  // namespace
+
+void Start() {
+    wall_start = std::chrono::steady_clock::now();
+}
+
+int Print() {
+    std::fflush(stdout);
+    const double wall_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    const double virtual_s = static_cast<double>(clock::NowUs()) / 1e6;
+    const double busy_ms = static_cast<double>(clock::NowUs() - clock::IdleUs()) / 1e3;
+    const mesh_uart::Stats &mesh = mesh_uart::GetStats();
+    const uint64_t cycles = Cycles(mesh);
+
+    std::FILE *out = stderr;
+    std::fprintf(out, "\n== send_env_data_to_mtd host simulation ==\n");
+    std::fprintf(out, "virtual time   %12.3f s   wall %.3f s (%.0fx real time)\n",
+                 virtual_s, wall_s, wall_s > 0.0 ? virtual_s / wall_s : 0.0);
+    std::fprintf(out, "cycles         %12llu     (telemetry periods)\n",
+                 static_cast<unsigned long long>(cycles));
+    const clock::WindowStats &windows = clock::Windows();
+    if (windows.count > 0) {
+        std::fprintf(out, "awake window   %12.3f ms avg, %.3f ms max (between idle periods >= 1 s)\n",
+                     PerCycle(static_cast<double>(windows.total_us) / 1e3, windows.count),
+                     static_cast<double>(windows.max_us) / 1e3);
+    }
+    if (app::config::LOW_POWER_IDLE) {
+        const hal::SleepStats &sleep = hal::GetSleepStats();
+        std::fprintf(out, "sleep state    %12.3f %% of the time (both cores down), %lu sleeps, %lu timed wakes, "
+                     "wake latency not modelled\n",
+                     virtual_s > 0.0 ? static_cast<double>(sleep.asleep_us) / (virtual_s * 1e4) : 0.0,
+                     static_cast<unsigned long>(sleep.sleeps), static_cast<unsigned long>(sleep.timed_wakes));
+    }
+    std::fprintf(out, "busy time      %12.3f ms/cycle (virtual time not spent sleeping)\n",
+                 PerCycle(busy_ms, cycles));
+    std::fprintf(out, "host cpu       %12.3f us/cycle\n", PerCycle(wall_s * 1e6, cycles));
+    std::fprintf(out, "cpu duty       %12.3f %% core0, %.3f %% core1\n",
+                 virtual_s > 0.0 ? busy_ms / (virtual_s * 10.0) : 0.0,
+                 virtual_s > 0.0 ? static_cast<double>(clock::Core1BusyUs()) / (virtual_s * 1e4) : 0.0);
+    const output::Stats &handoff = output::GetStats();
+    std::fprintf(out, "core1 handoff  %lu submitted, %lu dropped, %lu rendered, %lu published, max latency %.3f ms\n",
+                 static_cast<unsigned long>(handoff.submitted), static_cast<unsigned long>(handoff.dropped),
+                 static_cast<unsigned long>(handoff.rendered), static_cast<unsigned long>(handoff.published),
+                 handoff.max_latency_us / 1e3);
+
+    if (app::config::WATCHDOG) {
+        const watchdog::Stats &dog = watchdog::GetStats();
+        const supervisor::Stats &supervision = supervisor::GetStats();
+        std::fprintf(out, "watchdog       %llu feeds, %lu held back, %llu resets", static_cast<unsigned long long>(dog.feeds),
+                     static_cast<unsigned long>(supervision.held), static_cast<unsigned long long>(dog.resets));
+        if (dog.resets > 0) {
+            std::fprintf(out, " (first at %.3f s)", static_cast<double>(dog.first_reset_us) / 1e6);
+        }
+        if (dog.warm_boot) {
+            std::fprintf(out, ", booted warm after reset %lu in %s", static_cast<unsigned long>(supervision.resets),
+                         supervision.fault_stage < ::telemetry::record::kStageCount
+                             ? ::telemetry::record::kStageNames[supervision.fault_stage]
+                             : "no stage");
+        }
+        std::fprintf(out, "\n");
+    }
+
+    if (scheduler::TaskCount() > 0) {
+        std::fprintf(out, "\nscheduler\n");
+        std::fprintf(out, "  task          period ms       jobs  missed  skipped  worst ms\n");
+        for (std::size_t i = 0; i < scheduler::TaskCount(); ++i) {
+            const scheduler::Task &t = scheduler::GetTask(i);
+            std::fprintf(out, "  %-11s %11.1f %10lu %7lu %8lu %9.3f\n", t.name, t.period_us / 1e3,
+                         static_cast<unsigned long>(t.jobs), static_cast<unsigned long>(t.deadline_misses),
+                         static_cast<unsigned long>(t.skipped_releases), t.worst_response_us / 1e3);
+        }
+    }
+
+    if constexpr (app::config::STAGE_TIMING) {
+        // Virtual time only moves for bus and UART traffic, so stages that
+        // only compute show as 0 here.
+        std::fprintf(out, "\nstage timing   (histogram buckets under %lu us, doubling; the last is open)\n",
+                     static_cast<unsigned long>(::telemetry::record::kTimingBucketBaseUs));
+        std::fprintf(out, "  stage        samples     mean us     peak us  histogram\n");
+        for (int s = 0; s < ::telemetry::record::kStageCount; ++s) {
+            const profile::StageStats stats = profile::GetStats(static_cast<::telemetry::record::Stage>(s));
+            if (stats.count == 0) {
+                continue;
+            }
+            std::fprintf(out, "  %-10s %9lu %11.1f %11lu  ", ::telemetry::record::kStageNames[s],
+                         static_cast<unsigned long>(stats.count), static_cast<double>(stats.total_us) / stats.count,
+                         static_cast<unsigned long>(stats.peak_us));
+            for (int b = 0; b < ::telemetry::record::kTimingBuckets; ++b) {
+                std::fprintf(out, "%s%lu", b > 0 ? ":" : "", static_cast<unsigned long>(stats.buckets[b]));
+            }
+            std::fprintf(out, "\n");
+        }
+    }
+
+    // Bus utilisation: each target's wire time per cycle at the rate it
+    // ran at, and what the same traffic takes at the start-up clock.
+    const double base_hz = app::config::I2C_FREQUENCY_HZ;
+    std::fprintf(out, "\ni2c bus, targets at up to %lu kHz\n",
+                 static_cast<unsigned long>(app::config::I2C_BUS_MAX_HZ / 1000));
+    std::fprintf(out, "  addr  device        kHz  transfers  nacks      bytes    us/cycle  at %3.0f kHz\n", base_hz / 1e3);
+    uint64_t total_bus_us = 0;
+    uint64_t total_bits = 0;
+    for (int addr = 0; addr < 128; ++addr) {
+        const i2c_bus::DeviceStats &s = i2c_bus::Stats(static_cast<uint8_t>(addr));
+        if (s.transfers == 0) {
+            continue;
+        }
+        total_bus_us += s.bus_us;
+        total_bits += s.bits;
+        std::fprintf(out, "  0x%02X  %-11s %5lu %10lu %6lu %10llu %11.1f %11.1f\n", addr, s.name ? s.name : "(none)",
+                     static_cast<unsigned long>(s.clock_hz / 1000), static_cast<unsigned long>(s.transfers),
+                     static_cast<unsigned long>(s.nacks), static_cast<unsigned long long>(s.bytes),
+                     PerCycle(static_cast<double>(s.bus_us), cycles),
+                     PerCycle(static_cast<double>(s.bits) * 1e6 / base_hz, cycles));
+    }
+    std::fprintf(out, "  total bus time %.3f ms/cycle (%.2f %% busy), %.3f ms/cycle at %.0f kHz\n",
+                 PerCycle(static_cast<double>(total_bus_us) / 1e3, cycles),
+                 virtual_s > 0.0 ? static_cast<double>(total_bus_us) / (virtual_s * 1e4) : 0.0,
+                 PerCycle(static_cast<double>(total_bits) * 1e3 / base_hz, cycles), base_hz / 1e3);
+    const i2c::Stats &queue = i2c::GetStats();
+    std::fprintf(out, "  queue          %lu submitted, %lu errors, max depth %lu, %lu clock changes\n",
+                 static_cast<unsigned long>(queue.submitted), static_cast<unsigned long>(queue.errors),
+                 static_cast<unsigned long>(queue.max_depth), static_cast<unsigned long>(queue.clock_changes));
+    const i2c::Health &health = i2c::GetHealth();
+    std::fprintf(out, "  recovery       %lu bus recoveries (%lu left SDA low), %lu recoveries by the bus model\n",
+                 static_cast<unsigned long>(health.recoveries), static_cast<unsigned long>(health.recovery_failures),
+                 static_cast<unsigned long>(i2c_bus::Recoveries()));
+    const uint32_t imu_hz = i2c::ClockHz(app::config::MPU6050_ADDR);
+    std::fprintf(out, "  worst case     %.3f ms for a 14-byte transaction at %lu kHz (%u attempts, %.3f ms timeout each)\n",
+                 i2c::WorstCaseUs(14, imu_hz) / 1e3, static_cast<unsigned long>(imu_hz / 1000),
+                 static_cast<unsigned>(i2c::kMaxAttempts), i2c::TimeoutUs(14, imu_hz) / 1e3);
+    std::fprintf(out, "  addr   completed  nacks  timeouts  bus err  retries  failed  hangs\n");
+    for (std::size_t i = 0; i < health.device_count; ++i) {
+        const i2c::DeviceHealth &d = health.devices[i];
+        std::fprintf(out, "  0x%02X %11lu %6lu %9lu %8lu %8lu %7lu %6lu\n", d.addr,
+                     static_cast<unsigned long>(d.completed), static_cast<unsigned long>(d.nacks),
+                     static_cast<unsigned long>(d.timeouts), static_cast<unsigned long>(d.bus_errors),
+                     static_cast<unsigned long>(d.retries), static_cast<unsigned long>(d.failed),
+                     static_cast<unsigned long>(i2c_bus::Stats(d.addr).hangs));
+    }
+
+    const gps_uart::Stats &gps = gps_uart::GetStats();
+    std::fprintf(out, "\ngps uart       %llu sentences, %llu bytes sent, %llu received, %llu dropped (rx fifo overrun), "
+                 "%llu corrupted\n",
+                 static_cast<unsigned long long>(gps.sentences_sent), static_cast<unsigned long long>(gps.bytes_sent),
+                 static_cast<unsigned long long>(gps.bytes_received), static_cast<unsigned long long>(gps.bytes_dropped),
+                 static_cast<unsigned long long>(gps.bytes_corrupted));
+    const ::gps::RxStats &rx = ::gps::GetRxStats();
+    std::fprintf(out, "gps rx ring    %lu bytes, %lu ring overflows, %lu fifo overruns, high water %lu\n",
+                 static_cast<unsigned long>(rx.bytes), static_cast<unsigned long>(rx.ring_overflows),
+                 static_cast<unsigned long>(rx.fifo_overruns), static_cast<unsigned long>(rx.high_water));
+    const ::gps::nmea::Stats &nmea = ::gps::nmea::GetStats();
+    std::fprintf(out, "gps nmea       %lu applied, %lu ignored, %lu bad checksum, %lu malformed\n",
+                 static_cast<unsigned long>(nmea.applied), static_cast<unsigned long>(nmea.ignored),
+                 static_cast<unsigned long>(nmea.bad_checksum), static_cast<unsigned long>(nmea.malformed));
+    std::fprintf(out, "mesh uart      %llu bytes, %.1f bytes/cycle (%s), %llu bytes lost, %.1f s node down\n",
+                 static_cast<unsigned long long>(mesh.bytes), PerCycle(static_cast<double>(mesh.bytes), cycles),
+                 ::telemetry::GetFormat() == ::telemetry::Format::kBinary ? "binary" : "ascii",
+                 static_cast<unsigned long long>(mesh.lost_bytes), static_cast<double>(mesh.outage_us) / 1e6);
+    if (app::config::TELEMETRY_BACKLOG) {
+        const ::telemetry::backlog::Stats &backlog = ::telemetry::backlog::GetStats();
+        std::fprintf(out, "backlog        %lu appended, %lu sent, %lu pending (max %lu), %lu dropped, %lu torn, "
+                     "%lu recovered at boot, max %lu erases/sector\n",
+                     static_cast<unsigned long>(backlog.appended), static_cast<unsigned long>(backlog.sent),
+                     static_cast<unsigned long>(backlog.pending), static_cast<unsigned long>(backlog.max_pending),
+                     static_cast<unsigned long>(backlog.dropped), static_cast<unsigned long>(backlog.torn),
+                     static_cast<unsigned long>(backlog.recovered), static_cast<unsigned long>(backlog.max_erases));
+    }
+
+    if (app::config::MPU6050_FIFO) {
+        std::fprintf(out, "mpu6050 fifo   %u Hz sampled, %u Hz output, %llu samples lost to overflow\n",
+                     static_cast<unsigned>(app::config::MPU6050_SAMPLE_RATE_HZ),
+                     static_cast<unsigned>(app::config::MPU6050_OUTPUT_RATE_HZ),
+                     static_cast<unsigned long long>(board::Imu().FifoOverflows()));
+    }
+
+    if constexpr (app::config::SENSOR_HSCDTD) {
+        const sensors::mag_calibration::Status &cal = sensors::mag_calibration::GetStatus();
+        std::fprintf(out, "mag calibration %s, %lu fits (%lu rejected), %lu saved, radius %.1f counts, misfit %.2f %%, "
+                     "%lu samples collecting\n",
+                     cal.calibrated ? "applied" : "none", static_cast<unsigned long>(cal.fits),
+                     static_cast<unsigned long>(cal.rejected), static_cast<unsigned long>(cal.saves), cal.radius_counts,
+                     cal.residual_pct, static_cast<unsigned long>(cal.samples));
+    }
+    const flash::Stats &flash_stats = flash::GetStats();
+    std::fprintf(out, "flash          %llu sectors erased, %llu pages programmed, max %llu erases/sector, %llu lost bits\n",
+                 static_cast<unsigned long long>(flash_stats.sectors_erased),
+                 static_cast<unsigned long long>(flash_stats.pages_programmed),
+                 static_cast<unsigned long long>(flash_stats.max_sector_erases),
+                 static_cast<unsigned long long>(flash_stats.lost_bits));
+
+    const Ssd1306Device &display = board::Display();
+    std::fprintf(out, "\ndisplay        %llu data bytes, %llu command bytes\n",
+                 static_cast<unsigned long long>(display.DataBytes()),
+                 static_cast<unsigned long long>(display.CommandBytes()));
+    display.Dump(out);
+
+    // Nothing the firmware does may hold the GPS RX interrupt off for longer
+    // than the FIFO lasts (32 bytes, 33 ms at 9600 baud); UartTakeOverrun()
+    // counts each time it did.
+    if (rx.fifo_overruns > 0) {
+        std::fprintf(out, "\nFAILED: gps rx fifo overran %lu times\n", static_cast<unsigned long>(rx.fifo_overruns));
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace report
+}  // namespace sim
@@ -0,0 +1,14 @@
+#pragma once
+
+// End-of-run summary printed to stderr: virtual vs. wall time, active time and
+// host CPU per published cycle, per-device bus usage, UART throughput and the
+// final display contents. Checks that must hold in every run come last.
+namespace sim {
+namespace report {
+
+void Start();
+// Returns the process exit status: 1 if a check failed.
+int Print();
+
+}  // namespace report
+}  // namespace sim
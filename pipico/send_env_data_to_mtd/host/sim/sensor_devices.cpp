@@ -0,0 +1,552 @@
+#include "sim/sensor_devices.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "sim/environment.h"
+#include "sim/virtual_clock.h"
+
+namespace sim {
+
+namespace {
+
+int16_t ClampInt16(float value) {
+    if (value > 32767.0f) {
+        return 32767;
+    }
+    if (value < -32768.0f) {
+        return -32768;
+    }
+    return static_cast<int16_t>(std::lround(value));
+}
+
+uint8_t Crc8(const uint8_t *data, std::size_t len) {
+    uint8_t crc = 0xFF;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x31) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// BMP280 datasheet example trimming values (section 8.2).
+constexpr uint16_t kDigT1 = 27504;
+constexpr int16_t kDigT2 = 26435;
+constexpr int16_t kDigT3 = -1000;
+constexpr uint16_t kDigP1 = 36477;
+constexpr int16_t kDigP2 = -10685;
+constexpr int16_t kDigP3 = 3024;
+constexpr int16_t kDigP4 = 2855;
+constexpr int16_t kDigP5 = 140;
+constexpr int16_t kDigP6 = -7;
+constexpr int16_t kDigP7 = 15500;
+constexpr int16_t kDigP8 = -14600;
+constexpr int16_t kDigP9 = 6000;
+
+int32_t Bmp280TFine(int32_t adc_t) {
+    const int32_t var1 = ((((adc_t >> 3) - (static_cast<int32_t>(kDigT1) << 1))) * kDigT2) >> 11;
+    const int32_t var2 = (((((adc_t >> 4) - static_cast<int32_t>(kDigT1)) *
+                            ((adc_t >> 4) - static_cast<int32_t>(kDigT1))) >> 12) * kDigT3) >> 14;
+    return var1 + var2;
+}
+
+// Pressure in Q24.8 Pa, the datasheet's 64-bit reference implementation.
+int64_t Bmp280PressureQ8(int32_t adc_p, int32_t t_fine) {
+    int64_t var1 = static_cast<int64_t>(t_fine) - 128000;
+    int64_t var2 = var1 * var1 * kDigP6;
+    var2 += (var1 * kDigP5) << 17;
+    var2 += static_cast<int64_t>(kDigP4) << 35;
+    var1 = ((var1 * var1 * kDigP3) >> 8) + ((var1 * kDigP2) << 12);
+    var1 = ((static_cast<int64_t>(1) << 47) + var1) * kDigP1 >> 33;
+    if (var1 == 0) {
+        return 0;
+    }
+    int64_t p = 1048576 - adc_p;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (static_cast<int64_t>(kDigP9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (static_cast<int64_t>(kDigP8) * p) >> 19;
+    return ((p + var1 + var2) >> 8) + (static_cast<int64_t>(kDigP7) << 4);
+}
+
+// Invert the compensation by bisection; both curves are monotonic over the
+// 20-bit ADC range.
+int32_t Bmp280AdcForTemperature(float celsius) {
+    const int32_t target = static_cast<int32_t>(std::lround(celsius * 100.0f));
+    int32_t lo = 0;
+    int32_t hi = (1 << 20) - 1;
+    while (lo < hi) {
+        const int32_t mid = (lo + hi) / 2;
+        if (((Bmp280TFine(mid) * 5 + 128) >> 8) < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int32_t Bmp280AdcForPressure(float pascal, int32_t t_fine) {
+    const int64_t target = static_cast<int64_t>(pascal * 256.0f);
+    int32_t lo = 0;
+    int32_t hi = (1 << 20) - 1;
+    while (lo < hi) {
+        const int32_t mid = (lo + hi) / 2;
+        if (Bmp280PressureQ8(mid, t_fine) > target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint32_t Bmp280Oversampling(uint8_t field) {
+    return field == 0 ? 0 : (field >= 5 ? 16u : 1u << (field - 1));
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------- AHT20
+
+bool Aht20Device::Write(const uint8_t *src, std::size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    switch (src[0]) {
+        case 0xAC:  // trigger measurement
+            busy_ = true;
+            ready_at_us_ = clock::NowUs() + kConversionUs;
+            data_[0] |= 0x80;
+            break;
+        case 0xBA:  // soft reset
+            busy_ = false;
+            data_[0] = 0x18;
+            break;
+        default:  // 0xBE calibrate, 0x71 status: nothing to model
+            break;
+    }
+    return true;
+}
+
+bool Aht20Device::Read(uint8_t *dst, std::size_t len) {
+    if (busy_ && clock::NowUs() >= ready_at_us_) {
+        Latch();
+    }
+    uint8_t frame[7];
+    std::memcpy(frame, data_, sizeof(data_));
+    frame[6] = Crc8(data_, sizeof(data_));
+    for (std::size_t i = 0; i < len; ++i) {
+        dst[i] = i < sizeof(frame) ? frame[i] : 0xFF;
+    }
+    return true;
+}
+
+void Aht20Device::Latch() {
+    const environment::Conditions c = environment::At(ready_at_us_);
+    const uint32_t humidity = static_cast<uint32_t>(c.humidity_pct / 100.0f * 1048576.0f) & 0xFFFFF;
+    const uint32_t temperature = static_cast<uint32_t>((c.temperature_c + 50.0f) / 200.0f * 1048576.0f) & 0xFFFFF;
+    busy_ = false;
+    data_[0] = 0x18;
+    data_[1] = static_cast<uint8_t>(humidity >> 12);
+    data_[2] = static_cast<uint8_t>(humidity >> 4);
+    data_[3] = static_cast<uint8_t>(((humidity & 0x0F) << 4) | (temperature >> 16));
+    data_[4] = static_cast<uint8_t>(temperature >> 8);
+    data_[5] = static_cast<uint8_t>(temperature);
+}
+
+// ---------------------------------------------------------------- BMP280
+
+Bmp280Device::Bmp280Device() {
+    const uint16_t trim[12] = {
+        kDigT1, static_cast<uint16_t>(kDigT2), static_cast<uint16_t>(kDigT3),
+        kDigP1, static_cast<uint16_t>(kDigP2), static_cast<uint16_t>(kDigP3),
+        static_cast<uint16_t>(kDigP4), static_cast<uint16_t>(kDigP5), static_cast<uint16_t>(kDigP6),
+        static_cast<uint16_t>(kDigP7), static_cast<uint16_t>(kDigP8), static_cast<uint16_t>(kDigP9),
+    };
+    for (int i = 0; i < 12; ++i) {
+        Put16Le(static_cast<uint8_t>(0x88 + 2 * i), trim[i]);
+    }
+    regs_[0xD0] = 0x58;  // chip id
+    regs_[0xF7] = 0x80;  // reset values of the data registers
+    regs_[0xFA] = 0x80;
+}
+
+uint64_t Bmp280Device::MeasurementUs() const {
+    const uint8_t ctrl = regs_[0xF4];
+    const uint32_t osrs_t = Bmp280Oversampling((ctrl >> 5) & 0x07);
+    const uint32_t osrs_p = Bmp280Oversampling((ctrl >> 2) & 0x07);
+    // Typical t_measure from datasheet section 3.8.1.
+    return 1000 + 2000 * osrs_t + 2000 * osrs_p + (osrs_p > 0 ? 500 : 0);
+}
+
+uint64_t Bmp280Device::StandbyUs() const {
+    static const uint64_t kStandbyUs[8] = {500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000};
+    return kStandbyUs[(regs_[0xF5] >> 5) & 0x07];
+}
+
+void Bmp280Device::OnRegisterWrite(uint8_t reg, uint8_t value) {
+    if (reg == 0xE0) {
+        if (value == 0xB6) {
+            regs_[0xF4] = 0;
+            regs_[0xF5] = 0;
+            converting_ = false;
+        }
+        return;
+    }
+    if (reg < 0xF3 || reg > 0xF5) {
+        return;  // calibration and data registers are read-only
+    }
+    regs_[reg] = value;
+    if (reg != 0xF4) {
+        return;
+    }
+    const uint8_t mode = value & 0x03;
+    if (mode == 0x01 || mode == 0x02) {
+        converting_ = true;
+        ready_at_us_ = clock::NowUs() + MeasurementUs();
+    } else if (mode == 0x03) {
+        next_sample_us_ = clock::NowUs() + MeasurementUs();
+    }
+}
+
+void Bmp280Device::Update() {
+    const uint64_t now = clock::NowUs();
+    const uint8_t mode = regs_[0xF4] & 0x03;
+    if (converting_ && now >= ready_at_us_) {
+        converting_ = false;
+        Latch();
+        regs_[0xF4] &= 0xFC;  // forced mode falls back to sleep
+    } else if (mode == 0x03 && now >= next_sample_us_) {
+        Latch();
+        next_sample_us_ = now + MeasurementUs() + StandbyUs();
+    }
+    regs_[0xF3] = converting_ ? 0x08 : 0x00;
+}
+
+void Bmp280Device::Latch() {
+    const environment::Conditions c = environment::At(clock::NowUs());
+    const uint8_t ctrl = regs_[0xF4];
+    const int32_t adc_t = Bmp280AdcForTemperature(c.temperature_c + 0.6f);
+    const int32_t adc_p = ((ctrl >> 2) & 0x07) == 0 ? 0x80000 : Bmp280AdcForPressure(c.pressure_pa, Bmp280TFine(adc_t));
+    regs_[0xF7] = static_cast<uint8_t>(adc_p >> 12);
+    regs_[0xF8] = static_cast<uint8_t>(adc_p >> 4);
+    regs_[0xF9] = static_cast<uint8_t>((adc_p & 0x0F) << 4);
+    regs_[0xFA] = static_cast<uint8_t>(adc_t >> 12);
+    regs_[0xFB] = static_cast<uint8_t>(adc_t >> 4);
+    regs_[0xFC] = static_cast<uint8_t>((adc_t & 0x0F) << 4);
+}
+
+void Bmp280Device::BeforeRead(uint8_t reg) {
+    (void)reg;
+    Update();
+}
+
+// ---------------------------------------------------------------- MPU6050
+
+Mpu6050Device::Mpu6050Device() {
+    regs_[0x6B] = 0x40;  // powers up asleep
+    regs_[0x75] = 0x68;  // WHO_AM_I
+}
+
+void Mpu6050Device::OnRegisterWrite(uint8_t reg, uint8_t value) {
+    if (reg == 0x6B && (value & 0x80)) {
+        std::memset(regs_, 0, sizeof(regs_));
+        regs_[0x6B] = 0x40;
+        regs_[0x75] = 0x68;
+        fifo_.clear();
+        return;
+    }
+    if (reg == 0x75 || (reg >= 0x3A && reg <= 0x60) || reg == 0x72 || reg == 0x73) {
+        return;  // status, sensor output and FIFO count registers are read-only
+    }
+    if (reg == 0x74) {
+        return;  // the host never writes the FIFO
+    }
+    if (reg == 0x6A) {
+        // Sampling into the FIFO restarts from now; FIFO_RESET self-clears.
+        CatchUp(clock::NowUs());
+        if (value & 0x04) {
+            fifo_.clear();
+            UpdateFifoCount();
+        }
+        value &= static_cast<uint8_t>(~0x07);
+    }
+    regs_[reg] = value;
+}
+
+uint64_t Mpu6050Device::SamplePeriodUs() const {
+    // Gyro output rate is 8 kHz with the DLPF off (DLPF_CFG 0 or 7), else 1 kHz.
+    const uint8_t dlpf = regs_[0x1A] & 0x07;
+    const uint64_t gyro_rate_hz = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+    return 1000000ull * (1 + regs_[0x19]) / gyro_rate_hz;
+}
+
+bool Mpu6050Device::FifoEnabled() const {
+    return (regs_[0x6A] & 0x40) && regs_[0x23] != 0;
+}
+
+void Mpu6050Device::Latch(uint64_t now) {
+    const environment::Conditions c = environment::At(now);
+    const float accel_lsb = 16384.0f / static_cast<float>(1 << ((regs_[0x1C] >> 3) & 0x03));
+    const float gyro_lsb = 131.0f / static_cast<float>(1 << ((regs_[0x1B] >> 3) & 0x03));
+    float raw[7];
+    for (int axis = 0; axis < 3; ++axis) {
+        raw[axis] = c.accel_g[axis] * accel_lsb;
+        raw[4 + axis] = c.gyro_dps[axis] * gyro_lsb;
+    }
+    raw[3] = (c.temperature_c + 8.0f - 36.53f) * 340.0f;
+
+    // DLPF as a single pole at the accelerometer bandwidth of DLPF_CFG.
+    static const float kBandwidthHz[8] = {0.0f, 184.0f, 94.0f, 44.0f, 21.0f, 10.0f, 5.0f, 0.0f};
+    const float bandwidth = kBandwidthHz[regs_[0x1A] & 0x07];
+    const float dt = static_cast<float>(now - last_latch_us_) / 1e6f;
+    const float alpha = (bandwidth > 0.0f && last_latch_us_ != 0) ? 1.0f - std::exp(-2.0f * 3.14159265f * bandwidth * dt)
+                                                                   : 1.0f;
+    last_latch_us_ = now;
+    for (int i = 0; i < 7; ++i) {
+        filtered_[i] += alpha * (raw[i] - filtered_[i]);
+        Put16Be(static_cast<uint8_t>(0x3B + 2 * i), ClampInt16(filtered_[i]));
+    }
+    if (regs_[0x38] & 0x01) {
+        regs_[0x3A] |= 0x01;  // DATA_RDY_INT
+    }
+}
+
+void Mpu6050Device::PushFifo() {
+    // FIFO_EN bits: TEMP, XG, YG, ZG, ACCEL; slave FIFOs are not modelled.
+    std::size_t bytes = 0;
+    uint8_t sample[14];
+    const uint8_t enabled = regs_[0x23];
+    if (enabled & 0x08) {
+        std::memcpy(sample + bytes, regs_ + 0x3B, 6);
+        bytes += 6;
+    }
+    if (enabled & 0x80) {
+        std::memcpy(sample + bytes, regs_ + 0x41, 2);
+        bytes += 2;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        if (enabled & (0x40 >> axis)) {
+            std::memcpy(sample + bytes, regs_ + 0x43 + 2 * axis, 2);
+            bytes += 2;
+        }
+    }
+    if (bytes == 0) {
+        return;
+    }
+    if (fifo_.size() + bytes > kFifoBytes) {
+        fifo_.erase(fifo_.begin(), fifo_.begin() + static_cast<std::ptrdiff_t>(bytes));
+        ++fifo_overflows_;
+        if (regs_[0x38] & 0x10) {
+            regs_[0x3A] |= 0x10;  // FIFO_OFLOW_INT
+        }
+    }
+    fifo_.insert(fifo_.end(), sample, sample + bytes);
+}
+
+void Mpu6050Device::UpdateFifoCount() {
+    Put16Be(0x72, static_cast<int32_t>(fifo_.size()));
+}
+
+// Produces every sample due since the last access. Without the FIFO only
+// the latest one is observable, so only that one is computed.
+void Mpu6050Device::CatchUp(uint64_t now) {
+    if (regs_[0x6B] & 0x40) {
+        return;  // sleeping: outputs hold their last value
+    }
+    const uint64_t period = SamplePeriodUs();
+    const uint64_t sample = now / period;
+    if (sample == last_sample_) {
+        return;
+    }
+    if (!FifoEnabled()) {
+        last_sample_ = sample;
+        Latch(now);
+        return;
+    }
+    // More than a FIFO's worth (samples are at least 2 bytes) would only be
+    // overwritten again.
+    const uint64_t backlog = kFifoBytes / 2 + 1;
+    uint64_t next = sample - last_sample_ > backlog ? sample - backlog + 1 : last_sample_ + 1;
+    for (; next <= sample; ++next) {
+        Latch(next * period);
+        PushFifo();
+    }
+    last_sample_ = sample;
+    UpdateFifoCount();
+}
+
+void Mpu6050Device::BeforeRead(uint8_t reg) {
+    (void)reg;
+    CatchUp(clock::NowUs());
+}
+
+bool Mpu6050Device::Read(uint8_t *dst, std::size_t len) {
+    if (pointer_ != 0x74) {
+        return RegisterDevice::Read(dst, len);
+    }
+    // FIFO_R_W does not auto-increment: every byte comes from the FIFO.
+    CatchUp(clock::NowUs());
+    for (std::size_t i = 0; i < len; ++i) {
+        if (fifo_.empty()) {
+            dst[i] = 0;
+            continue;
+        }
+        dst[i] = fifo_.front();
+        fifo_.pop_front();
+    }
+    UpdateFifoCount();
+    return true;
+}
+
+void Mpu6050Device::AfterRead(uint8_t reg, std::size_t len) {
+    if (reg <= 0x3A && reg + len > 0x3A) {
+        regs_[0x3A] &= static_cast<uint8_t>(~0x11);  // DATA_RDY_INT, FIFO_OFLOW_INT
+    }
+}
+
+// ---------------------------------------------------------------- VEML7700
+
+uint32_t Veml7700Device::IntegrationUs() const {
+    switch ((regs_[0] >> 6) & 0x0F) {
+        case 0x0C: return 25000;
+        case 0x08: return 50000;
+        case 0x01: return 200000;
+        case 0x02: return 400000;
+        case 0x03: return 800000;
+        default: return 100000;
+    }
+}
+
+bool Veml7700Device::Write(const uint8_t *src, std::size_t len) {
+    if (len == 0) {
+        return true;
+    }
+    pointer_ = src[0] & 0x07;
+    if (len >= 3 && pointer_ <= 0x03) {
+        const bool was_shutdown = regs_[0] & 0x0001;
+        regs_[pointer_] = static_cast<uint16_t>(src[1] | (src[2] << 8));
+        if (pointer_ == 0 && was_shutdown && !(regs_[0] & 0x0001)) {
+            next_sample_us_ = clock::NowUs() + IntegrationUs();
+        }
+    }
+    return true;
+}
+
+void Veml7700Device::Update() {
+    const uint64_t now = clock::NowUs();
+    if ((regs_[0] & 0x0001) || now < next_sample_us_) {
+        return;
+    }
+    static const float kGain[4] = {1.0f, 2.0f, 0.125f, 0.25f};
+    const float gain = kGain[(regs_[0] >> 11) & 0x03];
+    const float resolution = 0.0576f * (100000.0f / static_cast<float>(IntegrationUs())) / gain;
+    const float counts = environment::At(now).lux / resolution;
+    regs_[4] = counts >= 65535.0f ? 0xFFFF : static_cast<uint16_t>(counts);
+    regs_[5] = static_cast<uint16_t>(regs_[4] * 0.9f);
+    next_sample_us_ = now + IntegrationUs();
+}
+
+bool Veml7700Device::Read(uint8_t *dst, std::size_t len) {
+    Update();
+    const uint16_t value = regs_[pointer_];
+    for (std::size_t i = 0; i < len; ++i) {
+        dst[i] = i == 0 ? static_cast<uint8_t>(value & 0xFF) : (i == 1 ? static_cast<uint8_t>(value >> 8) : 0xFF);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------- HSCDTD008A
+
+namespace {
+constexpr uint8_t HSCDTD_OUTX = 0x10;
+constexpr uint8_t HSCDTD_STAT = 0x18;
+constexpr uint8_t HSCDTD_CTRL1 = 0x1B;
+constexpr uint8_t HSCDTD_CTRL3 = 0x1D;
+constexpr uint8_t HSCDTD_DRDY = 0x40;
+constexpr float HSCDTD_UT_PER_LSB = 0.15f;
+// The board's own magnetism as the chip sees it: a fixed hard-iron field
+// (uT) plus a soft-iron distortion that stretches and shears the Earth's.
+constexpr float HSCDTD_HARD_IRON_UT[3] = {31.0f, -18.5f, 12.0f};
+constexpr float HSCDTD_SOFT_IRON[3][3] = {
+    {1.09f, 0.06f, -0.03f},
+    {0.06f, 0.92f, 0.04f},
+    {-0.03f, 0.04f, 1.02f},
+};
+}  // namespace
+
+HscdtdDevice::HscdtdDevice() {
+    regs_[0x0C] = 0x55;  // STB
+    regs_[0x0D] = 0x21;  // INFO
+    regs_[0x0F] = 0x49;  // WIA
+    regs_[HSCDTD_CTRL1] = 0x22;
+    regs_[0x1C] = 0x04;
+}
+
+uint64_t HscdtdDevice::PeriodUs() const {
+    static const uint64_t kPeriodUs[4] = {2000000, 100000, 50000, 10000};
+    return kPeriodUs[(regs_[HSCDTD_CTRL1] >> 3) & 0x03];
+}
+
+void HscdtdDevice::OnRegisterWrite(uint8_t reg, uint8_t value) {
+    if (reg == HSCDTD_CTRL1) {
+        regs_[reg] = value;
+        next_sample_us_ = clock::NowUs() + PeriodUs();
+        return;
+    }
+    if (reg == HSCDTD_CTRL3) {
+        const bool active = regs_[HSCDTD_CTRL1] & 0x80;
+        const bool force_state = regs_[HSCDTD_CTRL1] & 0x02;
+        if (value & 0x80) {  // SRST
+            HscdtdDevice fresh;
+            std::memcpy(regs_, fresh.regs_, sizeof(regs_));
+            forced_pending_ = false;
+        } else if ((value & 0x40) && active && force_state) {  // FRC
+            forced_pending_ = true;
+            ready_at_us_ = clock::NowUs() + kForcedMeasurementUs;
+        }
+        return;
+    }
+    if (reg >= 0x1C && reg <= 0x1E) {
+        regs_[reg] = value;
+    }
+}
+
+void HscdtdDevice::Latch() {
+    const environment::Conditions c = environment::At(clock::NowUs());
+    for (int axis = 0; axis < 3; ++axis) {
+        const float *row = HSCDTD_SOFT_IRON[axis];
+        const float ut = row[0] * c.mag_ut[0] + row[1] * c.mag_ut[1] + row[2] * c.mag_ut[2] + HSCDTD_HARD_IRON_UT[axis];
+        Put16Le(static_cast<uint8_t>(HSCDTD_OUTX + 2 * axis), ClampInt16(ut / HSCDTD_UT_PER_LSB));
+    }
+    regs_[HSCDTD_STAT] |= HSCDTD_DRDY;
+}
+
+void HscdtdDevice::Update() {
+    const uint64_t now = clock::NowUs();
+    const bool active = regs_[HSCDTD_CTRL1] & 0x80;
+    const bool force_state = regs_[HSCDTD_CTRL1] & 0x02;
+    if (forced_pending_ && now >= ready_at_us_) {
+        forced_pending_ = false;
+        Latch();
+    } else if (active && !force_state && now >= next_sample_us_) {
+        Latch();
+        next_sample_us_ = now + PeriodUs();
+    }
+}
+
+void HscdtdDevice::BeforeRead(uint8_t reg) {
+    (void)reg;
+    Update();
+}
+
+void HscdtdDevice::AfterRead(uint8_t reg, std::size_t len) {
+    // Reading any output register clears DRDY.
+    if (reg <= HSCDTD_OUTX + 5 && reg + len > HSCDTD_OUTX) {
+        regs_[HSCDTD_STAT] &= static_cast<uint8_t>(~HSCDTD_DRDY);
+    }
+}
+
+}  // namespace sim
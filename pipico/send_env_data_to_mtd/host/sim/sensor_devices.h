@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "sim/i2c_device.h"
+
+// Register-level models of the sensors on the board, driven by
+// sim::environment. Conversion times and status bits follow the datasheets
+// closely enough that drivers polling them behave as on hardware.
+namespace sim {
+
+class Aht20Device : public I2cDevice {
+public:
+    const char *Name() const override { return "aht20"; }
+    bool Write(const uint8_t *src, std::size_t len) override;
+    bool Read(uint8_t *dst, std::size_t len) override;
+
+private:
+    static constexpr uint64_t kConversionUs = 80000;
+
+    void Latch();
+
+    bool busy_ = false;
+    uint64_t ready_at_us_ = 0;
+    uint8_t data_[6] = {0x18, 0, 0, 0, 0, 0};
+};
+
+class Bmp280Device : public RegisterDevice {
+public:
+    Bmp280Device();
+    const char *Name() const override { return "bmp280"; }
+
+protected:
+    void BeforeRead(uint8_t reg) override;
+    void OnRegisterWrite(uint8_t reg, uint8_t value) override;
+
+private:
+    void Update();
+    void Latch();
+    uint64_t MeasurementUs() const;
+    uint64_t StandbyUs() const;
+
+    bool converting_ = false;
+    uint64_t ready_at_us_ = 0;
+    uint64_t next_sample_us_ = 0;
+};
+
+// Samples on the SMPLRT_DIV grid through a first-order model of the DLPF.
+// With USER_CTRL.FIFO_EN every sample is also queued in a 1024-byte FIFO
+// (the enabled FIFO_EN sources in register order), read through FIFO_R_W;
+// on overflow the oldest sample is dropped and FIFO_OFLOW set.
+class Mpu6050Device : public RegisterDevice {
+public:
+    Mpu6050Device();
+    const char *Name() const override { return "mpu6050"; }
+    bool Read(uint8_t *dst, std::size_t len) override;
+
+    uint64_t FifoOverflows() const { return fifo_overflows_; }
+
+protected:
+    void BeforeRead(uint8_t reg) override;
+    void AfterRead(uint8_t reg, std::size_t len) override;
+    void OnRegisterWrite(uint8_t reg, uint8_t value) override;
+
+private:
+    static constexpr std::size_t kFifoBytes = 1024;
+
+    uint64_t SamplePeriodUs() const;
+    bool FifoEnabled() const;
+    void CatchUp(uint64_t now);
+    void Latch(uint64_t now);
+    void PushFifo();
+    void UpdateFifoCount();
+
+    uint64_t last_sample_ = 0;
+    uint64_t last_latch_us_ = 0;
+    float filtered_[7] = {};  // accel x/y/z, temperature, gyro x/y/z, in LSB
+    std::deque<uint8_t> fifo_;
+    uint64_t fifo_overflows_ = 0;
+};
+
+class Veml7700Device : public I2cDevice {
+public:
+    const char *Name() const override { return "veml7700"; }
+    bool Write(const uint8_t *src, std::size_t len) override;
+    bool Read(uint8_t *dst, std::size_t len) override;
+
+private:
+    void Update();
+    uint32_t IntegrationUs() const;
+
+    uint16_t regs_[8] = {0x0001, 0, 0, 0, 0, 0, 0, 0xC481};
+    uint8_t pointer_ = 0;
+    uint64_t next_sample_us_ = 0;
+};
+
+class HscdtdDevice : public RegisterDevice {
+public:
+    HscdtdDevice();
+    const char *Name() const override { return "hscdtd008a"; }
+
+protected:
+    void BeforeRead(uint8_t reg) override;
+    void AfterRead(uint8_t reg, std::size_t len) override;
+    void OnRegisterWrite(uint8_t reg, uint8_t value) override;
+
+private:
+    static constexpr uint64_t kForcedMeasurementUs = 5000;
+
+    void Update();
+    void Latch();
+    uint64_t PeriodUs() const;
+
+    bool forced_pending_ = false;
+    uint64_t ready_at_us_ = 0;
+    uint64_t next_sample_us_ = 0;
+};
+
+}  // namespace sim
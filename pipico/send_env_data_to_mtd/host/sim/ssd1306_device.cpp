@@ -0,0 +1,144 @@
+#include "sim/ssd1306_device.h"
+
+namespace sim {
+
+namespace {
+
+int ParameterCount(uint8_t command) {
+    switch (command) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+}  // namespace
+
+bool Ssd1306Device::Write(const uint8_t *src, std::size_t len) {
+    std::size_t i = 0;
+    while (i < len) {
+        const uint8_t control = src[i++];
+        const bool continuation = control & 0x80;
+        const bool data = control & 0x40;
+        const std::size_t end = continuation ? (i + 1 < len ? i + 1 : len) : len;
+        for (; i < end; ++i) {
+            if (data) {
+                Data(src[i]);
+            } else {
+                Command(src[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool Ssd1306Device::Read(uint8_t *dst, std::size_t len) {
+    // Status byte: display on, not busy.
+    for (std::size_t i = 0; i < len; ++i) {
+        dst[i] = 0x00;
+    }
+    return true;
+}
+
+void Ssd1306Device::Command(uint8_t byte) {
+    ++command_bytes_;
+    if (pending_needed_ > 0) {
+        // pending_[0] is the command itself, parameters follow.
+        pending_[pending_count_++] = byte;
+        if (pending_count_ <= pending_needed_) {
+            return;
+        }
+        switch (pending_[0]) {
+            case 0x20:
+                mode_ = pending_[1] & 0x03;
+                break;
+            case 0x21:
+                column_start_ = column_ = pending_[1] & 0x7F;
+                column_end_ = pending_[2] & 0x7F;
+                break;
+            case 0x22:
+                page_start_ = page_ = pending_[1] & 0x03;
+                page_end_ = pending_[2] & 0x03;
+                break;
+            default:
+                break;
+        }
+        pending_needed_ = 0;
+        pending_count_ = 0;
+        return;
+    }
+
+    if (byte <= 0x0F) {
+        column_ = (column_ & 0xF0) | byte;
+    } else if (byte <= 0x1F) {
+        column_ = ((byte & 0x07) << 4) | (column_ & 0x0F);
+    } else if (byte >= 0xB0 && byte <= 0xB7) {
+        page_ = byte & 0x03;
+    } else if (ParameterCount(byte) > 0) {
+        pending_[0] = byte;
+        pending_count_ = 1;
+        pending_needed_ = ParameterCount(byte);
+    }
+}
+
+void Ssd1306Device::Data(uint8_t byte) {
+    ++data_bytes_;
+    ram_[page_][column_] = byte;
+    switch (mode_) {
+        case 0x00:  // horizontal
+            if (++column_ > column_end_) {
+                column_ = column_start_;
+                if (++page_ > page_end_) {
+                    page_ = page_start_;
+                }
+            }
+            break;
+        case 0x01:  // vertical
+            if (++page_ > page_end_) {
+                page_ = page_start_;
+                if (++column_ > column_end_) {
+                    column_ = column_start_;
+                }
+            }
+            break;
+        default:  // page
+            if (column_ < kWidth - 1) {
+                ++column_;
+            }
+            break;
+    }
+}
+
+bool Ssd1306Device::Pixel(int x, int y) const {
+    return (ram_[y / 8][x] >> (y % 8)) & 0x01;
+}
+
+void Ssd1306Device::Dump(std::FILE *out) const {
+    std::fputc('+', out);
+    for (int x = 0; x < kWidth; ++x) {
+        std::fputc('-', out);
+    }
+    std::fputs("+\n", out);
+    for (int y = 0; y < kPages * 8; ++y) {
+        std::fputc('|', out);
+        for (int x = 0; x < kWidth; ++x) {
+            std::fputc(Pixel(x, y) ? '#' : ' ', out);
+        }
+        std::fputs("|\n", out);
+    }
+    std::fputc('+', out);
+    for (int x = 0; x < kWidth; ++x) {
+        std::fputc('-', out);
+    }
+    std::fputs("+\n", out);
+}
+
+}  // namespace sim
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "sim/i2c_device.h"
+
+namespace sim {
+
+// SSD1306 controller model: decodes the command stream (addressing mode,
+// column/page windows) and writes data bytes into a 128x32 GDDRAM image.
+class Ssd1306Device : public I2cDevice {
+public:
+    static constexpr int kWidth = 128;
+    static constexpr int kPages = 4;
+
+    const char *Name() const override { return "ssd1306"; }
+    bool Write(const uint8_t *src, std::size_t len) override;
+    bool Read(uint8_t *dst, std::size_t len) override;
+
+    uint64_t DataBytes() const { return data_bytes_; }
+    uint64_t CommandBytes() const { return command_bytes_; }
+    bool Pixel(int x, int y) const;
+    void Dump(std::FILE *out) const;
+
+private:
+    void Command(uint8_t byte);
+    void Data(uint8_t byte);
+
+    uint8_t ram_[kPages][kWidth] = {};
+    uint8_t pending_[6] = {};
+    int pending_count_ = 0;
+    int pending_needed_ = 0;
+    uint8_t mode_ = 0x02;  // page addressing after reset
+    int column_ = 0;
+    int page_ = 0;
+    int column_start_ = 0;
+    int column_end_ = kWidth - 1;
+    int page_start_ = 0;
+    int page_end_ = kPages - 1;
+    uint64_t data_bytes_ = 0;
+    uint64_t command_bytes_ = 0;
+};
+
+}  // namespace sim
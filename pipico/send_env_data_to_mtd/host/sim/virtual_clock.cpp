@@ -0,0 +1,207 @@
+#include "sim/virtual_clock.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+
+#include "sim/report.h"
+
+namespace sim {
+namespace clock {
+
+namespace {
+uint64_t now_us = 0;
+uint64_t idle_us = 0;
+uint64_t duration_us = UINT64_MAX;
+constexpr uint64_t kWindowIdleUs = 1000000;
+uint64_t window_start_us = 0;
+WindowStats windows = {};
+
+bool on_core1 = false;
+uint64_t core1_now_us = 0;
+uint64_t core1_busy_us = 0;
+
+struct Event {
+    uint64_t at_us;
+    uint32_t id;
+    EventFn fn;
+    void *context;
+};
+std::vector<Event> events;
+uint32_t next_event_id = 1;
+
+// BusyMasked() spans, [start, end). One taken on core1 may still lie ahead
+// of core0, and models catching up on what happened meanwhile ask about
+// the past, so each is kept until core0 is well past it.
+constexpr uint64_t kMaskedKeepUs = 1000000;
+struct Span {
+    uint64_t start_us;
+    uint64_t end_us;
+};
+std::vector<Span> masked;
+
+// End of the masked span `at_us` falls in, or `at_us` itself.
+uint64_t Unmasked(uint64_t at_us) {
+    for (const Span &span : masked) {
+        if (at_us >= span.start_us && at_us < span.end_us) {
+            return span.end_us;
+        }
+    }
+    return at_us;
+}
+
+// Index of the event to run next, or -1.
+int NextEvent() {
+    int best = -1;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        if (best < 0 || events[i].at_us < events[best].at_us ||
+            (events[i].at_us == events[best].at_us && events[i].id < events[best].id)) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// Move the clock to `target_us`, running every event due on the way at its
+// own time. Events may schedule further events.
+void Advance(uint64_t target_us, bool idle) {
+    while (true) {
+        const int next = NextEvent();
+        if (next < 0 || events[next].at_us > target_us) {
+            break;
+        }
+        const uint64_t unmasked = Unmasked(events[next].at_us);
+        if (unmasked != events[next].at_us) {
+            events[next].at_us = unmasked;
+            continue;
+        }
+        const Event event = events[next];
+        events.erase(events.begin() + next);
+        if (event.at_us > now_us) {
+            if (idle) {
+                idle_us += event.at_us - now_us;
+            }
+            now_us = event.at_us;
+        }
+        event.fn(event.context);
+    }
+    if (target_us > now_us) {
+        if (idle) {
+            idle_us += target_us - now_us;
+        }
+        now_us = target_us;
+    }
+    for (std::size_t i = masked.size(); i-- > 0;) {
+        if (masked[i].end_us + kMaskedKeepUs <= now_us) {
+            masked.erase(masked.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+}
+
+void CheckDeadline() {
+    if (now_us >= duration_us) {
+        std::exit(report::Print());
+    }
+}
+
+}  // namespace
+
+uint64_t NowUs() {
+    return on_core1 ? core1_now_us : now_us;
+}
+
+uint64_t IdleUs() {
+    return idle_us;
+}
+
+const WindowStats &Windows() {
+    return windows;
+}
+
+void Busy(uint64_t us) {
+    if (on_core1) {
+        core1_now_us += us;
+        core1_busy_us += us;
+        return;
+    }
+    Advance(now_us + us, false);
+}
+
+void BusyMasked(uint64_t us) {
+    masked.push_back(Span{NowUs(), NowUs() + us});
+    Busy(us);
+}
+
+bool Masked(uint64_t at_us) {
+    return Unmasked(at_us) != at_us;
+}
+
+void Idle(uint64_t us) {
+    if (now_us + us > duration_us) {
+        us = duration_us > now_us ? duration_us - now_us : 0;
+    }
+    if (us >= kWindowIdleUs) {
+        const uint64_t window = now_us - window_start_us;
+        ++windows.count;
+        windows.total_us += window;
+        if (window > windows.max_us) {
+            windows.max_us = window;
+        }
+        window_start_us = now_us + us;
+    }
+    Advance(now_us + us, true);
+    CheckDeadline();
+}
+
+uint32_t Schedule(uint64_t at_us, EventFn fn, void *context) {
+    const uint32_t id = next_event_id++;
+    events.push_back(Event{at_us, id, fn, context});
+    return id;
+}
+
+void Cancel(uint32_t id) {
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        if (events[i].id == id) {
+            events.erase(events.begin() + static_cast<std::ptrdiff_t>(i));
+            return;
+        }
+    }
+}
+
+void RunOnCore1(void (*fn)()) {
+    if (core1_now_us < now_us) {
+        core1_now_us = now_us;
+    }
+    on_core1 = true;
+    fn();
+    on_core1 = false;
+}
+
+bool OnCore1() {
+    return on_core1;
+}
+
+uint64_t Core1FreeAtUs() {
+    return core1_now_us;
+}
+
+uint64_t Core1BusyUs() {
+    return core1_busy_us;
+}
+
+bool IdleUntilNextEvent() {
+    const int next = NextEvent();
+    if (next < 0) {
+        return false;
+    }
+    const uint64_t at_us = events[next].at_us;
+    Idle(at_us > now_us ? at_us - now_us : 0);
+    return true;
+}
+
+void SetDurationUs(uint64_t us) {
+    duration_us = us;
+}
+
+}  // namespace clock
+}  // namespace sim
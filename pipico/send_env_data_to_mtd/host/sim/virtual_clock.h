@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+// Virtual time base for the host simulator. Nothing ever waits on the wall
+// clock: bus transfers and blocking UART writes advance time by their modelled
+// cost ("busy"), sleeps jump straight to the wake-up time ("idle").
+//
+// Interrupts are modelled as scheduled events: when Busy() or Idle() carries
+// the clock past an event's time, the clock stops there and runs the event,
+// as an IRQ would preempt whatever the firmware was doing. BusyMasked()
+// holds them off on both cores, as a flash write does: what falls due
+// meanwhile runs when it ends, as a pending IRQ would.
+namespace sim {
+namespace clock {
+
+// Awake windows are the spans between idle periods of at least one second,
+// i.e. the active part of each sampling cycle.
+struct WindowStats {
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+};
+
+uint64_t NowUs();
+uint64_t IdleUs();
+const WindowStats &Windows();
+
+void Busy(uint64_t us);
+void BusyMasked(uint64_t us);
+void Idle(uint64_t us);
+// True while `at_us` falls within a BusyMasked() span, on either core.
+bool Masked(uint64_t at_us);
+
+using EventFn = void (*)(void *context);
+
+// Returns an id for Cancel(). Events due at the same time run in the order
+// they were scheduled.
+uint32_t Schedule(uint64_t at_us, EventFn fn, void *context);
+void Cancel(uint32_t id);
+// Idle up to the earliest pending event and run it; false if none is pending.
+bool IdleUntilNextEvent();
+
+// Second core. Code run through RunOnCore1() sees its own timeline, starting
+// when core1 last went idle or now, whichever is later; its Busy() time
+// moves only that timeline, so core0 is never stalled by it.
+void RunOnCore1(void (*fn)());
+bool OnCore1();
+uint64_t Core1FreeAtUs();
+uint64_t Core1BusyUs();
+
+// Run length in virtual time; reaching it ends the simulation with a report.
+void SetDurationUs(uint64_t us);
+
+}  // namespace clock
+}  // namespace sim
@@ -0,0 +1,106 @@
+#include "sim/watchdog.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "hal/hal.h"
+#include "sim/report.h"
+#include "sim/virtual_clock.h"
+
+namespace sim {
+namespace watchdog {
+
+namespace {
+constexpr uint32_t kImageMagic = 0x474F4457;  // "WDOG"
+
+struct Image {
+    uint32_t magic;
+    uint32_t scratch[hal::kWatchdogScratchWords];
+    alignas(8) uint8_t retained[hal::kRetainedRamBytes];
+};
+
+Image image = {};
+std::string image_path;
+uint64_t timeout_us = 0;
+uint32_t reset_event = 0;
+Stats stats = {};
+
+void Arm();
+
+void OnReset(void *) {
+    reset_event = 0;
+    if (stats.resets++ == 0) {
+        stats.first_reset_us = clock::NowUs();
+    }
+    std::printf("watchdog reset at %.3f s\n", static_cast<double>(clock::NowUs()) / 1e6);
+    if (image_path.empty()) {
+        Arm();
+        return;
+    }
+    if (std::FILE *file = std::fopen(image_path.c_str(), "wb")) {
+        image.magic = kImageMagic;
+        std::fwrite(&image, sizeof(image), 1, file);
+        std::fclose(file);
+    }
+    std::exit(report::Print());
+}
+
+void Arm() {
+    if (reset_event != 0) {
+        clock::Cancel(reset_event);
+    }
+    reset_event = clock::Schedule(clock::NowUs() + timeout_us, OnReset, nullptr);
+}
+
+}  // namespace
+
+void OpenImage(const char *path) {
+    if (path == nullptr || !image_path.empty()) {
+        return;
+    }
+    image_path = path;
+    std::FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return;
+    }
+    Image loaded;
+    if (std::fread(&loaded, sizeof(loaded), 1, file) == 1 && loaded.magic == kImageMagic) {
+        image = loaded;
+        stats.warm_boot = true;
+    }
+    std::fclose(file);
+    std::remove(path);
+}
+
+void Start(uint32_t timeout_ms) {
+    timeout_us = static_cast<uint64_t>(timeout_ms) * 1000;
+    Arm();
+}
+
+void Feed() {
+    if (timeout_us == 0) {
+        return;
+    }
+    ++stats.feeds;
+    Arm();
+}
+
+bool CausedReset() {
+    return stats.warm_boot;
+}
+
+uint32_t *Scratch() {
+    return image.scratch;
+}
+
+uint8_t *RetainedRam() {
+    return image.retained;
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace watchdog
+}  // namespace sim
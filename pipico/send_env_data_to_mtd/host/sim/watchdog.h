@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Simulated watchdog behind hal::Watchdog* and hal::RetainedRam(). The
+// reset is a clock event at the last feed plus the timeout. The model
+// cannot restart main(), so by default a reset is only counted and the run
+// goes on. With SIM_RETAINED_IMAGE naming a file, a reset ends the run
+// instead: the scratch registers and retained RAM are written to the file,
+// and the next run boots from them as the chip would after the reset,
+// then deletes it, so the run after that starts from power-up again.
+namespace sim {
+namespace watchdog {
+
+struct Stats {
+    uint64_t feeds;
+    uint64_t resets;
+    uint64_t first_reset_us;
+    bool warm_boot;  // this run started from a retained image
+};
+
+void OpenImage(const char *path);
+
+void Start(uint32_t timeout_ms);
+void Feed();
+bool CausedReset();
+uint32_t *Scratch();
+uint8_t *RetainedRam();
+
+const Stats &GetStats();
+
+}  // namespace watchdog
+}  // namespace sim
@@ -1,70 +1,296 @@
+#include <array>
 #include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include "ahrs/ahrs.h"
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "app/sensor_registry.h"
 #include "display/display.h"
 #include "gps/gps.h"
-#include "hardware/gpio.h"
-#include "hardware/i2c.h"
-#include "pico/stdlib.h"
-#include "sensors/aht20.h"
-#include "sensors/bmp280.h"
-#include "sensors/hscdtd.h"
-#include "sensors/mpu6050.h"
-#include "sensors/veml7700.h"
+#include "hal/hal.h"
+#include "i2c/transaction_queue.h"
+#include "output/output.h"
+#include "profile/profile.h"
+#include "scheduler/scheduler.h"
+#include "supervisor/supervisor.h"
+#include "telemetry/aggregate.h"
 #include "telemetry/telemetry.h"
 
-int main() {
-    stdio_init_all();
+namespace {
 
-    gpio_init(app::config::LED_PIN);
-    gpio_set_dir(app::config::LED_PIN, GPIO_OUT);
+// Latest reading of every source. Each task overwrites only its own field,
+// so a failing sensor leaves the others untouched.
+app::model::SensorSnapshot snapshot;
 
-    i2c_init(app::config::I2C_PORT, app::config::I2C_FREQUENCY_HZ);
-    gpio_set_function(app::config::SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(app::config::SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(app::config::SDA_PIN);
-    gpio_pull_up(app::config::SCL_PIN);
+// Shared body of the sensor jobs: start a conversion on the first call, then
+// poll Collect() until it finishes. Returning a delay hands the CPU back to
+// the scheduler while the conversion runs.
+template <typename Data>
+uint32_t SensorJob(bool first, bool (*start)(), sensors::Status (*collect)(Data &), Data &data,
+                   const char *name) {
+    sensors::Status status;
+    if (first && !start()) {
+        status = sensors::Status::kError;
+    } else {
+        status = collect(data);
+    }
+    if (status == sensors::Status::kPending) {
+        return sensors::kCollectPollUs;
+    }
+    if (status == sensors::Status::kError) {
+        data.valid = false;
+        printf("%s read error\n", name);
+    }
+    return 0;
+}
 
-    telemetry::Init();
-    gps::Init();
-    sensors::mpu6050::Init();
-    sensors::veml7700::Init();
-    sensors::hscdtd::Init();
-    sensors::bmp280::Init();
-    display::Init();
+// Feeds a finished job's readings to the window statistics when
+// aggregating. `sections` are the record sections the job refreshes.
+uint32_t Aggregate(uint32_t delay, uint16_t sections) {
+    if (app::config::TELEMETRY_AGGREGATE && delay == 0) {
+        telemetry::aggregate::Add(snapshot, sections);
+    }
+    return delay;
+}
+
+namespace rec = telemetry::record;
+namespace registry = app::registry;
+
+// Every IMU output also steps the orientation filter, with the latest
+// magnetometer reading.
+void OnImuOutput(const int16_t accel[3], const int16_t gyro[3]) {
+    ahrs::Update(accel, gyro, snapshot.hscdtd);
+}
+
+// Per-sensor wiring beyond the registry entry, picked by overload: what a
+// sensor's Init() is followed by, and what a finished reading updates
+// besides its own slot (returning the extra record sections).
+template <typename Sensor>
+void Attach(Sensor) {}
+
+[[maybe_unused]] void Attach(registry::Mpu6050) {
+    sensors::mpu6050::SetOutputHandler(OnImuOutput);
+}
+
+template <typename Sensor>
+uint16_t AfterReading(Sensor) {
+    return 0;
+}
 
-    gpio_put(app::config::LED_PIN, 1);
-    sleep_ms(500);
-    gpio_put(app::config::LED_PIN, 0);
-    sleep_ms(2000);
+[[maybe_unused]] uint16_t AfterReading(registry::Mpu6050) {
+    ahrs::Get(snapshot.orientation);
+    return 1u << rec::kOrientation;
+}
 
-    printf("AHT20 + BMP280 + MPU6050 + VEML7700 + HSCDTD008A ready\n");
+// A read that takes several steps is timed as one sample of their total,
+// and checks in with the supervisor once, when it is done.
+template <typename Sensor>
+uint32_t SensorTask(bool first) {
+    profile::ScopedTimer timer(Sensor::kStage);
+    supervisor::StageScope scope(Sensor::kStage);
+    const uint32_t delay = SensorJob(first, Sensor::Start, Sensor::Collect, snapshot.*Sensor::kSlot, Sensor::kName);
+    uint16_t sections = Sensor::kSections;
+    if (delay == 0) {
+        sections = static_cast<uint16_t>(sections | AfterReading(Sensor()));
+    } else {
+        timer.Continue();
+        scope.Continue();
+    }
+    return Aggregate(delay, sections);
+}
 
-    app::model::SensorSnapshot snapshot;
+// A read dropped at its deadline leaves the slot holding the previous
+// reading; mark it stale so it is not published as current.
+template <typename Sensor>
+void SensorAbandoned() {
+    (snapshot.*Sensor::kSlot).valid = false;
+    printf("%s read timed out\n", Sensor::kName);
+}
 
-    while (true) {
-        snapshot = app::model::SensorSnapshot{};  // reset fields
+template <typename... Sensors>
+std::array<scheduler::Task, sizeof...(Sensors)> SensorTasks(registry::List<Sensors...>) {
+    return {{{Sensors::kTask, Sensors::kPeriodUs, Sensors::kDeadlineUs, 0, SensorTask<Sensors>,
+              SensorAbandoned<Sensors>}...}};
+}
 
+uint32_t GpsJob(bool) {
+    {
+        profile::ScopedTimer timer(rec::kStageGps);
+        supervisor::StageScope scope(rec::kStageGps);
         gps::Poll(snapshot.gps);
+    }
+    return Aggregate(0, 1u << rec::kGpsFix | 1u << rec::kGpsTime | 1u << rec::kGpsMotion);
+}
+
+// Rendering and publishing happen on core1; core0 only hands over a copy.
+uint32_t DisplayJob(bool) {
+    output::Submit(snapshot, output::kRender);
+    return 0;
+}
 
-        if (!sensors::aht20::Read(snapshot.aht20)) {
-            printf("AHT20 read error\n");
-            sleep_ms(20000);
-            continue;
+// Blink the LED for 50 ms around each publish without blocking other tasks.
+// Each publish closes the IMU's statistics window, and when aggregating
+// the telemetry window too.
+uint32_t TelemetryJob(bool first) {
+    if (first) {
+        hal::GpioPut(app::config::LED_PIN, 1);
+        if (app::config::TELEMETRY_AGGREGATE) {
+            static telemetry::record::Summary summary;
+            telemetry::aggregate::Take(summary);
+            output::SubmitSummary(summary);
+        } else {
+            output::Submit(snapshot, output::kPublish);
         }
+        registry::ForEach(registry::Sensors(), [](auto sensor) { decltype(sensor)::OnPublish(); });
+        return 50 * 1000;
+    }
+    hal::GpioPut(app::config::LED_PIN, 0);
+    return 0;
+}
 
-        gpio_put(app::config::LED_PIN, 1);
+// The idle and bus counters as they stand, for the health record.
+static_assert(i2c::kMaxDevices <= telemetry::record::kMaxHealthDevices, "health record too small");
+uint32_t HealthJob(bool) {
+    const i2c::Health &bus = i2c::GetHealth();
+    const hal::SleepStats &sleep = hal::GetSleepStats();
+    telemetry::record::Health health;
+    const uint64_t now = hal::TimeUs();
+    health.asleep_permille = static_cast<uint32_t>(now > 0 ? sleep.asleep_us * 1000 / now : 0);
+    if (sleep.timed_wakes > 0) {
+        health.wake_latency_mean_us = static_cast<uint32_t>(sleep.wake_latency_total_us / sleep.timed_wakes);
+    }
+    health.wake_latency_max_us = sleep.wake_latency_max_us;
+    health.watchdog_resets = supervisor::GetStats().resets;
+    health.fault_stage = supervisor::GetStats().fault_stage;
+    const uint32_t irq = hal::CriticalEnter();
+    health.recoveries = bus.recoveries;
+    health.recovery_failures = bus.recovery_failures;
+    health.device_count = static_cast<uint8_t>(bus.device_count);
+    for (std::size_t i = 0; i < bus.device_count; ++i) {
+        const i2c::DeviceHealth &from = bus.devices[i];
+        telemetry::record::DeviceHealth &to = health.devices[i];
+        to.addr = from.addr;
+        to.completed = from.completed;
+        to.nacks = from.nacks;
+        to.timeouts = from.timeouts;
+        to.bus_errors = from.bus_errors;
+        to.retries = from.retries;
+        to.failed = from.failed;
+    }
+    hal::CriticalExit(irq);
+    output::SubmitHealth(health);
+    return 0;
+}
+
+// The timings are taken on core1, which times render and publish itself.
+uint32_t TimingJob(bool) {
+    output::RequestTiming();
+    return 0;
+}
+
+uint32_t WatchdogJob(bool) {
+    supervisor::Service();
+    return 0;
+}
+
+using app::config::DISPLAY_DEADLINE_US;
+using app::config::DISPLAY_PERIOD_US;
+using app::config::GPS_DEADLINE_US;
+using app::config::GPS_PERIOD_US;
+using app::config::HEALTH_DEADLINE_US;
+using app::config::HEALTH_PERIOD_US;
+using app::config::TELEMETRY_DEADLINE_US;
+using app::config::TELEMETRY_PERIOD_US;
+using app::config::TELEMETRY_PHASE_US;
+using app::config::TIMING_DEADLINE_US;
+using app::config::TIMING_PERIOD_US;
+using app::config::WATCHDOG_DEADLINE_US;
+using app::config::WATCHDOG_PERIOD_US;
+
+auto sensor_tasks = SensorTasks(registry::Sensors());
 
-        sensors::bmp280::Read(snapshot.bmp280);
-        sensors::mpu6050::Read(snapshot.mpu6050);
-        sensors::veml7700::Read(snapshot.veml7700);
-        sensors::hscdtd::Read(snapshot.hscdtd);
+scheduler::Task tasks[] = {
+    {"gps", GPS_PERIOD_US, GPS_DEADLINE_US, 0, GpsJob},
+    {"display", DISPLAY_PERIOD_US, DISPLAY_DEADLINE_US, TELEMETRY_PHASE_US, DisplayJob},
+    {"telemetry", TELEMETRY_PERIOD_US, TELEMETRY_DEADLINE_US, TELEMETRY_PHASE_US, TelemetryJob},
+    {"health", HEALTH_PERIOD_US, HEALTH_DEADLINE_US, TELEMETRY_PHASE_US, HealthJob},
+};
 
-        display::Render(snapshot);
-        telemetry::Publish(snapshot);
+scheduler::Task timing_task = {"timing", TIMING_PERIOD_US, TIMING_DEADLINE_US, TELEMETRY_PHASE_US, TimingJob};
 
-        sleep_ms(50);
-        gpio_put(app::config::LED_PIN, 0);
-        sleep_ms(20000);
+scheduler::Task watchdog_task = {"watchdog", WATCHDOG_PERIOD_US, WATCHDOG_DEADLINE_US, 0, WatchdogJob};
+
+// Every task main() may register, with the optional ones counted as if on.
+constexpr std::size_t kTaskCount =
+    std::tuple_size<decltype(sensor_tasks)>::value + std::extent<decltype(tasks)>::value + 2;
+static_assert(kTaskCount <= scheduler::kMaxTasks, "raise scheduler::kMaxTasks");
+
+// A task that fails to register would never run, and its stage would trip
+// the watchdog with nothing to say why; stop at boot with the reason instead.
+void AddTask(scheduler::Task &task) {
+    if (!scheduler::Add(task)) {
+        printf("scheduler: cannot add task %s\n", task.name);
+        hal::StdioFlush();
+        std::abort();
+    }
+}
+
+}  // namespace
+
+int main() {
+    hal::StdioInit();
+    hal::CriticalInit();
+    hal::LowPowerInit();
+
+    hal::GpioInitOutput(app::config::LED_PIN);
+
+    i2c::Init();
+
+    telemetry::Init();
+    gps::Init();
+    registry::ForEach(registry::Sensors(), [](auto sensor) {
+        decltype(sensor)::Init();
+        Attach(sensor);
+    });
+    display::Init();
+
+    // After a watchdog reset the node picks up where it stopped instead of
+    // pausing to show it has booted.
+    if (!supervisor::Resume()) {
+        hal::GpioPut(app::config::LED_PIN, 1);
+        hal::SleepMs(500);
+        hal::GpioPut(app::config::LED_PIN, 0);
+        hal::SleepMs(2000);
+    }
+
+    const char *separator = "";
+    registry::ForEach(registry::Sensors(), [&separator](auto sensor) {
+        printf("%s%s", separator, decltype(sensor)::kName);
+        separator = " + ";
+    });
+    printf(" ready\n");
+
+    output::Launch();
+
+    for (scheduler::Task &task : sensor_tasks) {
+        AddTask(task);
+    }
+    for (scheduler::Task &task : tasks) {
+        AddTask(task);
+    }
+    if (app::config::STAGE_TIMING) {
+        AddTask(timing_task);
+    }
+    if (app::config::WATCHDOG) {
+        supervisor::Watch(rec::kStageGps, GPS_PERIOD_US);
+        registry::ForEach(registry::Sensors(), [](auto sensor) {
+            supervisor::Watch(decltype(sensor)::kStage, decltype(sensor)::kPeriodUs);
+        });
+        supervisor::Watch(rec::kStageRender, DISPLAY_PERIOD_US);
+        supervisor::Watch(rec::kStagePublish, TELEMETRY_PERIOD_US);
+        AddTask(watchdog_task);
+        supervisor::Start();
     }
+    scheduler::Run();
 }
@@ -0,0 +1,40 @@
+# Hardware-independent sources shared by the firmware image and the host
+# simulator (host/CMakeLists.txt). Board-specific HAL backends are added by
+# each build.
+
+set(SEND_ENV_DATA_TO_MTD_COMMON_SOURCES
+    ${CMAKE_CURRENT_LIST_DIR}/send_env_data_to_mtd.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/ahrs/ahrs.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/ahrs/mahony_fixed.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/ahrs/mahony_float.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/display/display.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/display/lines.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/display/ssd1306.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/gps/gps.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/gps/coordinates.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/gps/nmea.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/i2c/transaction_queue.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/output/output.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/scheduler/scheduler.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/supervisor/supervisor.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/telemetry/aggregate.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/telemetry/backlog.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/telemetry/record.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/telemetry/telemetry.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/utils/random.cpp
+)
+
+# Stage timing (profile/profile.h), left out with STAGE_TIMING=OFF.
+set(SEND_ENV_DATA_TO_MTD_TIMING_SOURCES ${CMAKE_CURRENT_LIST_DIR}/src/profile/profile.cpp)
+
+# Sensor drivers, by the names of the sensors in app/sensor_registry.h. A
+# build adds those of the sensors it has turned on (SENSOR_<NAME>).
+set(SEND_ENV_DATA_TO_MTD_SENSORS AHT20 BMP280 MPU6050 VEML7700 HSCDTD)
+set(SEND_ENV_DATA_TO_MTD_SENSOR_SOURCES_AHT20 ${CMAKE_CURRENT_LIST_DIR}/src/sensors/aht20.cpp)
+set(SEND_ENV_DATA_TO_MTD_SENSOR_SOURCES_BMP280 ${CMAKE_CURRENT_LIST_DIR}/src/sensors/bmp280.cpp)
+set(SEND_ENV_DATA_TO_MTD_SENSOR_SOURCES_MPU6050 ${CMAKE_CURRENT_LIST_DIR}/src/sensors/mpu6050.cpp)
+set(SEND_ENV_DATA_TO_MTD_SENSOR_SOURCES_VEML7700 ${CMAKE_CURRENT_LIST_DIR}/src/sensors/veml7700.cpp)
+set(SEND_ENV_DATA_TO_MTD_SENSOR_SOURCES_HSCDTD
+    ${CMAKE_CURRENT_LIST_DIR}/src/sensors/hscdtd.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/src/sensors/mag_calibration.cpp
+)
@@ -0,0 +1,37 @@
+#include "ahrs/ahrs.h"
+
+#include <type_traits>
+
+#include "ahrs/mahony.h"
+#include "app/app_config.h"
+
+namespace ahrs {
+
+namespace {
+using Filter = std::conditional<app::config::AHRS_FIXED_POINT, MahonyFixed, MahonyFloat>::type;
+
+Filter filter(app::config::AHRS_RATE_HZ);
+uint32_t updates = 0;
+
+}  // namespace
+
+void Update(const int16_t accel[3], const int16_t gyro[3], const app::model::HscdtdData &mag) {
+    const int16_t field[3] = {mag.x, mag.y, mag.z};
+    filter.Update(accel, gyro, mag.valid ? field : nullptr);
+    ++updates;
+}
+
+void Get(app::model::OrientationData &orientation) {
+    // The first update only aligns; after that the estimate is usable.
+    if (updates < 2) {
+        orientation.valid = false;
+        return;
+    }
+    const Euler euler = ToEuler(filter.Get());
+    orientation.roll_deg = euler.roll_deg;
+    orientation.pitch_deg = euler.pitch_deg;
+    orientation.heading_deg = euler.yaw_deg > 0.0f ? 360.0f - euler.yaw_deg : -euler.yaw_deg;
+    orientation.valid = true;
+}
+
+}  // namespace ahrs
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/measurement_types.h"
+
+// Orientation stage: runs the Mahony filter (ahrs/mahony.h) on every IMU
+// output, at app::config::AHRS_RATE_HZ, with the latest magnetometer
+// reading. app::config::AHRS_FIXED_POINT selects the Q30 build.
+namespace ahrs {
+
+// Task context on core0. `mag` is used only while valid.
+void Update(const int16_t accel[3], const int16_t gyro[3], const app::model::HscdtdData &mag);
+
+// Roll, pitch and tilt-compensated heading of the current estimate.
+void Get(app::model::OrientationData &orientation);
+
+}  // namespace ahrs
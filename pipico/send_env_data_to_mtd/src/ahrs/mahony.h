@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+// Mahony attitude filter: integrates the gyro into an attitude quaternion
+// and steers it with proportional-integral feedback from the directions of
+// gravity (accelerometer) and the Earth's field (magnetometer).
+//
+// Inputs are raw counts in one right-handed board frame (x forward, y left,
+// z up on this board). Accel and mag only contribute their direction, so
+// their scale does not matter; the gyro is taken at the MPU6050's power-on
+// +-250 dps range. The world frame is x at magnetic north, z up.
+//
+// The same update exists twice: MahonyFloat in single precision for cores
+// with an FPU (RP2350), MahonyFixed in Q2.30 integers for cores without one.
+namespace ahrs {
+
+struct Quaternion {
+    float w = 1.0f;
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+// ZYX Euler angles of the board, degrees. Roll and pitch are right-handed
+// about x and y (right side down, nose down); yaw is counter-clockwise
+// from magnetic north, i.e. the negated compass heading.
+struct Euler {
+    float roll_deg = 0.0f;
+    float pitch_deg = 0.0f;
+    float yaw_deg = 0.0f;
+};
+
+constexpr float kGyroRadPerLsb = 3.14159265f / 180.0f / 131.0f;
+// Feedback gains: 1 rad/s per unit of direction error pulls the estimate to
+// the reference with a ~1 s time constant; the integral term trims gyro
+// bias over tens of seconds.
+constexpr float kKp = 1.0f;
+constexpr float kKi = 0.02f;
+
+// Attitude from one accel/mag pair: roll and pitch from gravity, yaw from
+// the field after removing that tilt. Seeds both filters.
+Quaternion Align(const int16_t accel[3], const int16_t *mag);
+
+Euler ToEuler(const Quaternion &q);
+
+class MahonyFloat {
+public:
+    explicit MahonyFloat(uint32_t rate_hz);
+
+    // One step of 1 / rate_hz. `mag` may be null when there is no field
+    // reading; yaw then drifts with the gyro alone. The first call only
+    // aligns to accel and mag.
+    void Update(const int16_t accel[3], const int16_t gyro[3], const int16_t *mag);
+    Quaternion Get() const;
+    void Reset();
+
+private:
+    float half_dt_;
+    float q_[4];
+    float integral_[3];
+    bool aligned_;
+};
+
+class MahonyFixed {
+public:
+    explicit MahonyFixed(uint32_t rate_hz);
+
+    void Update(const int16_t accel[3], const int16_t gyro[3], const int16_t *mag);
+    Quaternion Get() const;
+    void Reset();
+
+private:
+    // Per-step constants: gyro LSB to half-step angle (Q46), Kp to
+    // half-step (Q30), Ki to half-step integral increment (Q46).
+    int64_t gyro_q46_;
+    int32_t kp_q30_;
+    int64_t ki_q46_;
+    int32_t q_[4];         // Q2.30
+    int64_t integral_[3];  // half-step angle, Q46
+    bool aligned_;
+};
+
+}  // namespace ahrs
@@ -0,0 +1,174 @@
+#include "ahrs/mahony.h"
+
+#include <cmath>
+
+// Q2.30 build of MahonyFloat::Update: the same steps, in the same order,
+// with every unit vector and quaternion component an int32 scaled by 2^30.
+// Products go through 64 bits; the only divisions are the reciprocals of
+// the accel and mag norms, one each per update.
+namespace ahrs {
+
+namespace {
+constexpr int32_t kOne = int32_t{1} << 30;
+constexpr int32_t kHalf = int32_t{1} << 29;
+
+// Rounded, so the thousands of products per second do not all lean the
+// same way.
+int32_t Mul(int32_t a, int32_t b) {
+    return static_cast<int32_t>((static_cast<int64_t>(a) * b + (int64_t{1} << 29)) >> 30);
+}
+
+uint32_t SquareRoot(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(root);
+}
+
+// Raw counts to a Q30 unit vector; false for a zero vector. The norm is
+// taken with 10 fractional bits so small vectors (the magnetometer reads a
+// few hundred counts) keep their direction to better than 1e-5.
+bool Normalise(const int16_t raw[3], int32_t out[3]) {
+    const uint64_t norm_squared = static_cast<uint64_t>(static_cast<int64_t>(raw[0]) * raw[0] +
+                                                        static_cast<int64_t>(raw[1]) * raw[1] +
+                                                        static_cast<int64_t>(raw[2]) * raw[2]);
+    if (norm_squared == 0) {
+        return false;
+    }
+    const int64_t inverse = (int64_t{1} << 55) / SquareRoot(norm_squared << 20);  // 2^45 / norm
+    for (int i = 0; i < 3; ++i) {
+        out[i] = static_cast<int32_t>((raw[i] * inverse) >> 15);
+    }
+    return true;
+}
+
+int32_t ToQ30(float value) {
+    return static_cast<int32_t>(std::lround(value * static_cast<float>(kOne)));
+}
+
+float FromQ30(int32_t value) {
+    return static_cast<float>(value) / static_cast<float>(kOne);
+}
+
+}  // namespace
+
+MahonyFixed::MahonyFixed(uint32_t rate_hz) {
+    const double half_dt = 0.5 / rate_hz;
+    const double dt = 1.0 / rate_hz;
+    gyro_q46_ = std::llround(half_dt * kGyroRadPerLsb * 70368744177664.0);  // 2^46
+    kp_q30_ = static_cast<int32_t>(std::lround(half_dt * kKp * kOne));
+    ki_q46_ = std::llround(half_dt * kKi * dt * 70368744177664.0);
+    Reset();
+}
+
+void MahonyFixed::Reset() {
+    q_[0] = kOne;
+    q_[1] = q_[2] = q_[3] = 0;
+    integral_[0] = integral_[1] = integral_[2] = 0;
+    aligned_ = false;
+}
+
+Quaternion MahonyFixed::Get() const {
+    Quaternion q;
+    q.w = FromQ30(q_[0]);
+    q.x = FromQ30(q_[1]);
+    q.y = FromQ30(q_[2]);
+    q.z = FromQ30(q_[3]);
+    return q;
+}
+
+void MahonyFixed::Update(const int16_t accel[3], const int16_t gyro[3], const int16_t *mag) {
+    int32_t a[3];
+    const bool have_accel = Normalise(accel, a);
+    if (!aligned_) {
+        // One-off float maths; every later step is integer only.
+        if (have_accel) {
+            const Quaternion q = Align(accel, mag);
+            q_[0] = ToQ30(q.w);
+            q_[1] = ToQ30(q.x);
+            q_[2] = ToQ30(q.y);
+            q_[3] = ToQ30(q.z);
+            aligned_ = true;
+        }
+        return;
+    }
+
+    const int32_t q0 = q_[0];
+    const int32_t q1 = q_[1];
+    const int32_t q2 = q_[2];
+    const int32_t q3 = q_[3];
+    const int32_t q0q0 = Mul(q0, q0);
+    const int32_t q0q1 = Mul(q0, q1);
+    const int32_t q0q2 = Mul(q0, q2);
+    const int32_t q0q3 = Mul(q0, q3);
+    const int32_t q1q1 = Mul(q1, q1);
+    const int32_t q1q2 = Mul(q1, q2);
+    const int32_t q1q3 = Mul(q1, q3);
+    const int32_t q2q2 = Mul(q2, q2);
+    const int32_t q2q3 = Mul(q2, q3);
+    const int32_t q3q3 = Mul(q3, q3);
+    int32_t ex = 0;
+    int32_t ey = 0;
+    int32_t ez = 0;
+
+    if (have_accel) {
+        const int32_t vx = 2 * (q1q3 - q0q2);
+        const int32_t vy = 2 * (q0q1 + q2q3);
+        const int32_t vz = q0q0 - q1q1 - q2q2 + q3q3;
+        ex += Mul(a[1], vz) - Mul(a[2], vy);
+        ey += Mul(a[2], vx) - Mul(a[0], vz);
+        ez += Mul(a[0], vy) - Mul(a[1], vx);
+    }
+
+    int32_t m[3];
+    if (mag != nullptr && Normalise(mag, m)) {
+        const int32_t hx = 2 * (Mul(m[0], kHalf - q2q2 - q3q3) + Mul(m[1], q1q2 - q0q3) + Mul(m[2], q1q3 + q0q2));
+        const int32_t hy = 2 * (Mul(m[0], q1q2 + q0q3) + Mul(m[1], kHalf - q1q1 - q3q3) + Mul(m[2], q2q3 - q0q1));
+        const int32_t bx = static_cast<int32_t>(SquareRoot(static_cast<uint64_t>(static_cast<int64_t>(hx) * hx +
+                                                                                  static_cast<int64_t>(hy) * hy)));
+        const int32_t bz = 2 * (Mul(m[0], q1q3 - q0q2) + Mul(m[1], q2q3 + q0q1) + Mul(m[2], kHalf - q1q1 - q2q2));
+        const int32_t wx = 2 * (Mul(bx, kHalf - q2q2 - q3q3) + Mul(bz, q1q3 - q0q2));
+        const int32_t wy = 2 * (Mul(bx, q1q2 - q0q3) + Mul(bz, q0q1 + q2q3));
+        const int32_t wz = 2 * (Mul(bx, q0q2 + q1q3) + Mul(bz, kHalf - q1q1 - q2q2));
+        ex += Mul(m[1], wz) - Mul(m[2], wy);
+        ey += Mul(m[2], wx) - Mul(m[0], wz);
+        ez += Mul(m[0], wy) - Mul(m[1], wx);
+    }
+
+    // Half-step rotation angles, Q30 radians. Each integral increment is far
+    // below one Q30 step, so the sum is kept at Q46.
+    integral_[0] += (ex * ki_q46_) >> 30;
+    integral_[1] += (ey * ki_q46_) >> 30;
+    integral_[2] += (ez * ki_q46_) >> 30;
+    const int32_t gx = static_cast<int32_t>((gyro[0] * gyro_q46_ + integral_[0]) >> 16) + Mul(ex, kp_q30_);
+    const int32_t gy = static_cast<int32_t>((gyro[1] * gyro_q46_ + integral_[1]) >> 16) + Mul(ey, kp_q30_);
+    const int32_t gz = static_cast<int32_t>((gyro[2] * gyro_q46_ + integral_[2]) >> 16) + Mul(ez, kp_q30_);
+
+    const int32_t n0 = q0 - Mul(q1, gx) - Mul(q2, gy) - Mul(q3, gz);
+    const int32_t n1 = q1 + Mul(q0, gx) + Mul(q2, gz) - Mul(q3, gy);
+    const int32_t n2 = q2 + Mul(q0, gy) - Mul(q1, gz) + Mul(q3, gx);
+    const int32_t n3 = q3 + Mul(q0, gz) + Mul(q1, gy) - Mul(q2, gx);
+    const uint64_t norm_squared = static_cast<uint64_t>(
+        static_cast<int64_t>(n0) * n0 + static_cast<int64_t>(n1) * n1 + static_cast<int64_t>(n2) * n2 +
+        static_cast<int64_t>(n3) * n3);
+    // One step moves the norm by ~1e-5 at most, so 1/sqrt(x) ~ (3 - x) / 2
+    // around x = 1 is exact to well below one Q30 step.
+    const int32_t inverse = static_cast<int32_t>((3 * int64_t{kOne} - static_cast<int64_t>(norm_squared >> 30)) / 2);
+    q_[0] = Mul(n0, inverse);
+    q_[1] = Mul(n1, inverse);
+    q_[2] = Mul(n2, inverse);
+    q_[3] = Mul(n3, inverse);
+}
+
+}  // namespace ahrs
@@ -0,0 +1,169 @@
+#include "ahrs/mahony.h"
+
+#include <cmath>
+
+namespace ahrs {
+
+namespace {
+constexpr float kRadToDeg = 180.0f / 3.14159265f;
+
+// Normalises in place; false for a zero vector.
+bool Normalise(float &x, float &y, float &z) {
+    const float norm_squared = x * x + y * y + z * z;
+    if (norm_squared <= 0.0f) {
+        return false;
+    }
+    const float inverse = 1.0f / std::sqrt(norm_squared);
+    x *= inverse;
+    y *= inverse;
+    z *= inverse;
+    return true;
+}
+
+}  // namespace
+
+Quaternion Align(const int16_t accel[3], const int16_t *mag) {
+    const float ax = accel[0];
+    const float ay = accel[1];
+    const float az = accel[2];
+    const float roll = std::atan2(ay, az);
+    const float pitch = std::atan2(-ax, std::sqrt(ay * ay + az * az));
+
+    float yaw = 0.0f;
+    if (mag != nullptr) {
+        // Rotate the field back by roll, then pitch, to the level frame.
+        const float cr = std::cos(roll);
+        const float sr = std::sin(roll);
+        const float cp = std::cos(pitch);
+        const float sp = std::sin(pitch);
+        const float my = cr * mag[1] - sr * mag[2];
+        const float mz = sr * mag[1] + cr * mag[2];
+        const float hx = cp * mag[0] + sp * mz;
+        yaw = std::atan2(-my, hx);
+    }
+
+    const float cr = std::cos(roll * 0.5f);
+    const float sr = std::sin(roll * 0.5f);
+    const float cp = std::cos(pitch * 0.5f);
+    const float sp = std::sin(pitch * 0.5f);
+    const float cy = std::cos(yaw * 0.5f);
+    const float sy = std::sin(yaw * 0.5f);
+    Quaternion q;
+    q.w = cr * cp * cy + sr * sp * sy;
+    q.x = sr * cp * cy - cr * sp * sy;
+    q.y = cr * sp * cy + sr * cp * sy;
+    q.z = cr * cp * sy - sr * sp * cy;
+    return q;
+}
+
+Euler ToEuler(const Quaternion &q) {
+    Euler e;
+    e.roll_deg = std::atan2(2.0f * (q.w * q.x + q.y * q.z), 1.0f - 2.0f * (q.x * q.x + q.y * q.y)) * kRadToDeg;
+    float sin_pitch = 2.0f * (q.w * q.y - q.z * q.x);
+    sin_pitch = sin_pitch > 1.0f ? 1.0f : sin_pitch < -1.0f ? -1.0f : sin_pitch;
+    e.pitch_deg = std::asin(sin_pitch) * kRadToDeg;
+    e.yaw_deg = std::atan2(2.0f * (q.w * q.z + q.x * q.y), 1.0f - 2.0f * (q.y * q.y + q.z * q.z)) * kRadToDeg;
+    return e;
+}
+
+MahonyFloat::MahonyFloat(uint32_t rate_hz) : half_dt_(0.5f / static_cast<float>(rate_hz)) {
+    Reset();
+}
+
+void MahonyFloat::Reset() {
+    q_[0] = 1.0f;
+    q_[1] = q_[2] = q_[3] = 0.0f;
+    integral_[0] = integral_[1] = integral_[2] = 0.0f;
+    aligned_ = false;
+}
+
+Quaternion MahonyFloat::Get() const {
+    Quaternion q;
+    q.w = q_[0];
+    q.x = q_[1];
+    q.y = q_[2];
+    q.z = q_[3];
+    return q;
+}
+
+void MahonyFloat::Update(const int16_t accel[3], const int16_t gyro[3], const int16_t *mag) {
+    float ax = accel[0];
+    float ay = accel[1];
+    float az = accel[2];
+    const bool have_accel = Normalise(ax, ay, az);
+    if (!aligned_) {
+        if (have_accel) {
+            const Quaternion q = Align(accel, mag);
+            q_[0] = q.w;
+            q_[1] = q.x;
+            q_[2] = q.y;
+            q_[3] = q.z;
+            aligned_ = true;
+        }
+        return;
+    }
+
+    const float q0 = q_[0];
+    const float q1 = q_[1];
+    const float q2 = q_[2];
+    const float q3 = q_[3];
+    float ex = 0.0f;
+    float ey = 0.0f;
+    float ez = 0.0f;
+
+    if (have_accel) {
+        // Estimated "up" in the board frame against the measured one.
+        const float vx = 2.0f * (q1 * q3 - q0 * q2);
+        const float vy = 2.0f * (q0 * q1 + q2 * q3);
+        const float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        ex += ay * vz - az * vy;
+        ey += az * vx - ax * vz;
+        ez += ax * vy - ay * vx;
+    }
+
+    float mx = 0.0f;
+    float my = 0.0f;
+    float mz = 0.0f;
+    bool have_mag = false;
+    if (mag != nullptr) {
+        mx = mag[0];
+        my = mag[1];
+        mz = mag[2];
+        have_mag = Normalise(mx, my, mz);
+    }
+    if (have_mag) {
+        // The field in the world frame, folded onto north (x) and up (z),
+        // then rotated back as the estimate of the board-frame field.
+        const float hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+        const float hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+        const float bx = std::sqrt(hx * hx + hy * hy);
+        const float bz = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) + mz * (0.5f - q1 * q1 - q2 * q2));
+        const float wx = 2.0f * (bx * (0.5f - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2));
+        const float wy = 2.0f * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3));
+        const float wz = 2.0f * (bx * (q0 * q2 + q1 * q3) + bz * (0.5f - q1 * q1 - q2 * q2));
+        ex += my * wz - mz * wy;
+        ey += mz * wx - mx * wz;
+        ez += mx * wy - my * wx;
+    }
+
+    const float dt = 2.0f * half_dt_;
+    integral_[0] += kKi * ex * dt;
+    integral_[1] += kKi * ey * dt;
+    integral_[2] += kKi * ez * dt;
+    const float gx = (gyro[0] * kGyroRadPerLsb + kKp * ex + integral_[0]) * half_dt_;
+    const float gy = (gyro[1] * kGyroRadPerLsb + kKp * ey + integral_[1]) * half_dt_;
+    const float gz = (gyro[2] * kGyroRadPerLsb + kKp * ez + integral_[2]) * half_dt_;
+
+    // q += q * (0, g) * dt / 2
+    const float n0 = q0 - q1 * gx - q2 * gy - q3 * gz;
+    const float n1 = q1 + q0 * gx + q2 * gz - q3 * gy;
+    const float n2 = q2 + q0 * gy - q1 * gz + q3 * gx;
+    const float n3 = q3 + q0 * gz + q1 * gy - q2 * gx;
+    const float inverse = 1.0f / std::sqrt(n0 * n0 + n1 * n1 + n2 * n2 + n3 * n3);
+    q_[0] = n0 * inverse;
+    q_[1] = n1 * inverse;
+    q_[2] = n2 * inverse;
+    q_[3] = n3 * inverse;
+}
+
+}  // namespace ahrs
@@ -1,15 +1,14 @@
 #pragma once
 
-#include "hardware/i2c.h"
-#include "hardware/uart.h"
-#include "hardware/gpio.h"
+#include <cstdint>
 
 namespace app {
 namespace config {
 
-inline i2c_inst_t *const I2C_PORT = i2c1;
-constexpr uint SDA_PIN = 2;
-constexpr uint SCL_PIN = 3;
+// Peripheral instance numbers (i2c0/i2c1, uart0/uart1), resolved by the HAL.
+constexpr unsigned I2C_PORT = 1;
+constexpr unsigned SDA_PIN = 2;
+constexpr unsigned SCL_PIN = 3;
 
 constexpr uint8_t AHT20_ADDR = 0x38;
 constexpr uint8_t BMP280_ADDR = 0x77;
@@ -18,19 +17,197 @@ constexpr uint8_t VEML7700_ADDR = 0x10;
 constexpr uint8_t HSCDTD_ADDR = 0x0C;
 constexpr uint8_t DISPLAY_ADDR = 0x3C;
 
-constexpr uint LED_PIN = 15;
+// Sensors built into the image, see app/sensor_registry.h. Configure one
+// out with -DSENSOR_<NAME>=OFF when it is not fitted: its task, telemetry
+// fields and display lines go, and its driver is not linked.
+#ifndef SEND_ENV_SENSOR_AHT20
+#define SEND_ENV_SENSOR_AHT20 1
+#endif
+#ifndef SEND_ENV_SENSOR_BMP280
+#define SEND_ENV_SENSOR_BMP280 1
+#endif
+#ifndef SEND_ENV_SENSOR_MPU6050
+#define SEND_ENV_SENSOR_MPU6050 1
+#endif
+#ifndef SEND_ENV_SENSOR_VEML7700
+#define SEND_ENV_SENSOR_VEML7700 1
+#endif
+#ifndef SEND_ENV_SENSOR_HSCDTD
+#define SEND_ENV_SENSOR_HSCDTD 1
+#endif
+constexpr bool SENSOR_AHT20 = SEND_ENV_SENSOR_AHT20 != 0;
+constexpr bool SENSOR_BMP280 = SEND_ENV_SENSOR_BMP280 != 0;
+constexpr bool SENSOR_MPU6050 = SEND_ENV_SENSOR_MPU6050 != 0;
+constexpr bool SENSOR_VEML7700 = SEND_ENV_SENSOR_VEML7700 != 0;
+constexpr bool SENSOR_HSCDTD = SEND_ENV_SENSOR_HSCDTD != 0;
 
-inline uart_inst_t *const MESH_UART = uart0;
-constexpr uint BAUD_RATE = 115200;
-constexpr uint UART_TX_PIN = 0;
-constexpr uint UART_RX_PIN = 1;
+constexpr unsigned LED_PIN = 15;
 
-inline uart_inst_t *const GPS_UART = uart1;
-constexpr uint GPS_BAUD = 9600;
-constexpr uint GPS_TX_PIN = 4;  // Pico TX -> GPS RX
-constexpr uint GPS_RX_PIN = 5;  // Pico RX <- GPS TX
+constexpr unsigned MESH_UART = 0;
+constexpr unsigned BAUD_RATE = 115200;
+constexpr unsigned UART_TX_PIN = 0;
+constexpr unsigned UART_RX_PIN = 1;
+// The node's RTS (or any "ready" output) wired to UART0 CTS. With
+// MESH_FLOW_CONTROL, telemetry is only sent while it is held low; the pin
+// is pulled up, so a node that is off or unplugged holds records back.
+// Turn it off if nothing drives the pin.
+constexpr bool MESH_FLOW_CONTROL = true;
+constexpr unsigned MESH_CTS_PIN = 14;
 
-constexpr uint I2C_FREQUENCY_HZ = 100 * 1000;
+// Mesh telemetry encoding at boot: the ASCII key=value line, or the binary
+// record when configured with -DTELEMETRY_BINARY=ON.
+// telemetry::SetFormat() switches at run time.
+#ifndef SEND_ENV_TELEMETRY_BINARY
+#define SEND_ENV_TELEMETRY_BINARY 0
+#endif
+constexpr bool TELEMETRY_BINARY = SEND_ENV_TELEMETRY_BINARY != 0;
+// Binary records are deltas against the previous one, with a full keyframe
+// every this many records (5 minutes at the telemetry period) so a
+// receiver that lost a frame is back in sync soon.
+constexpr uint32_t TELEMETRY_KEYFRAME_INTERVAL = 15;
+// Store-and-forward: every record is appended to a log in flash and sent
+// from there as the mesh node takes it, so outages delay data instead of
+// losing it. 1 MB holds about 14 hours of ASCII lines, over 3 days of
+// binary records.
+constexpr bool TELEMETRY_BACKLOG = true;
+// Windowed aggregation, with -DTELEMETRY_AGGREGATE=ON: every reading of
+// every sensor is added to running statistics, and once a window the
+// telemetry task sends their summary (count, mean, min, max, standard
+// deviation per field, see telemetry/aggregate.h) instead of the latest
+// reading. The environmental sensors are then read ten times as often,
+// so one 300 s summary stands on 150 readings of each, and still costs a
+// seventh of the mesh traffic of the 15 ASCII lines it replaces (under a
+// third of the 15 binary records).
+#ifndef SEND_ENV_TELEMETRY_AGGREGATE
+#define SEND_ENV_TELEMETRY_AGGREGATE 0
+#endif
+#ifndef SEND_ENV_TELEMETRY_WINDOW_S
+#define SEND_ENV_TELEMETRY_WINDOW_S 300
+#endif
+constexpr bool TELEMETRY_AGGREGATE = SEND_ENV_TELEMETRY_AGGREGATE != 0;
+constexpr uint32_t TELEMETRY_WINDOW_S = SEND_ENV_TELEMETRY_WINDOW_S;
+static_assert(TELEMETRY_WINDOW_S > 0 && TELEMETRY_WINDOW_S <= 4000, "the telemetry period is a 32-bit us count");
+
+constexpr unsigned GPS_UART = 1;
+constexpr unsigned GPS_BAUD = 9600;
+constexpr unsigned GPS_TX_PIN = 4;  // Pico TX -> GPS RX
+constexpr unsigned GPS_RX_PIN = 5;  // Pico RX <- GPS TX
+
+// Bus clock at start-up, and for any target not listed below.
+constexpr unsigned I2C_FREQUENCY_HZ = 100 * 1000;
+// Fastest SCL the board's pull-ups and wiring allow: Fast mode, or
+// Fast-mode Plus with -DI2C_FAST_MODE_PLUS=ON, which needs pull-ups stiff
+// enough for a 120 ns rise time (about 2.2 kOhm on this bus).
+#ifndef SEND_ENV_I2C_FAST_MODE_PLUS
+#define SEND_ENV_I2C_FAST_MODE_PLUS 0
+#endif
+constexpr uint32_t I2C_BUS_MAX_HZ = SEND_ENV_I2C_FAST_MODE_PLUS != 0 ? 1000 * 1000 : 400 * 1000;
+// Fastest SCL each target is rated for (datasheets). Each transaction runs
+// at its target's rate capped by I2C_BUS_MAX_HZ; the queue changes the
+// clock only between transactions that need different rates.
+constexpr uint32_t AHT20_MAX_HZ = 400 * 1000;
+constexpr uint32_t BMP280_MAX_HZ = 3400 * 1000;  // high-speed capable, so Fm+ too
+constexpr uint32_t MPU6050_MAX_HZ = 400 * 1000;
+constexpr uint32_t VEML7700_MAX_HZ = 400 * 1000;
+constexpr uint32_t HSCDTD_MAX_HZ = 400 * 1000;
+constexpr uint32_t DISPLAY_MAX_HZ = 400 * 1000;
+
+// MPU6050 acquisition. With MPU6050_FIFO the chip samples at
+// MPU6050_SAMPLE_RATE_HZ behind its digital low-pass filter (DLPF_CFG, see
+// the register map: 3 = 44 Hz accel / 42 Hz gyro) into its FIFO, which the
+// IMU task drains in bursts. The driver averages blocks of samples down to
+// MPU6050_OUTPUT_RATE_HZ and keeps min/max/RMS over each publish window.
+// Without it the IMU task reads one sample per period.
+// Each FIFO sample is 14 bytes, ~0.32 ms on the wire at 400 kHz, so the
+// sample rate costs bus time: 200 Hz takes 6 % of the bus, 1 kHz a third.
+constexpr bool MPU6050_FIFO = true;
+constexpr uint32_t MPU6050_SAMPLE_RATE_HZ = 200;  // 4..1000, a divisor of 1000
+constexpr uint8_t MPU6050_DLPF_CFG = 3;
+constexpr uint32_t MPU6050_OUTPUT_RATE_HZ = 100;  // a divisor of the sample rate
+
+// Flash layout (Pico 2, 4 MB). The program image grows up from offset 0;
+// the telemetry backlog takes the top megabyte but one sector, which holds
+// the magnetometer calibration records.
+constexpr uint32_t FLASH_SIZE_BYTES = 4 * 1024 * 1024;
+constexpr uint32_t FLASH_CALIBRATION_OFFSET = FLASH_SIZE_BYTES - 4096;
+constexpr uint32_t FLASH_BACKLOG_BYTES = 1024 * 1024;
+constexpr uint32_t FLASH_BACKLOG_OFFSET = FLASH_CALIBRATION_OFFSET - FLASH_BACKLOG_BYTES;
+
+// Scheduler rates. Each task is released every *_PERIOD_US on a fixed
+// timeline and must finish within *_DEADLINE_US of its release.
+// In FIFO mode the IMU task drains whatever has accumulated, so it runs
+// far less often than the sample rate.
+constexpr uint32_t IMU_PERIOD_US = MPU6050_FIFO ? 50 * 1000 : 10 * 1000;  // 20 Hz / 100 Hz
+constexpr uint32_t IMU_DEADLINE_US = MPU6050_FIFO ? 40 * 1000 : 5 * 1000;
+// Orientation filter rate: every decimated FIFO output, or every IMU task
+// release without the FIFO. The Q30 build is for cores without an FPU; the
+// RP2350's single-precision FPU runs the float build faster.
+constexpr uint32_t AHRS_RATE_HZ = MPU6050_FIFO ? MPU6050_OUTPUT_RATE_HZ : 1000 * 1000 / IMU_PERIOD_US;
+constexpr bool AHRS_FIXED_POINT = false;
+// HSCDTD008A hard/soft-iron calibration. The correction stored in flash is
+// applied to every reading from boot; with MAG_ONLINE_CALIBRATION the
+// driver also fits a new one whenever the unit has been turned through
+// enough directions, and stores it if it differs from the stored one.
+constexpr bool MAG_ONLINE_CALIBRATION = true;
+constexpr uint32_t MAG_PERIOD_US = 100 * 1000;  // 10 Hz
+constexpr uint32_t MAG_DEADLINE_US = 50 * 1000;
+constexpr uint32_t GPS_PERIOD_US = 1000 * 1000;  // 1 Hz
+constexpr uint32_t GPS_DEADLINE_US = 100 * 1000;
+// With no good sentence for this long the receiver is taken as gone: the
+// fix, time and motion are cleared rather than repeated as current.
+constexpr uint32_t GPS_STALE_US = 3 * GPS_PERIOD_US;
+// AHT20, BMP280, VEML7700: 0.05 Hz, or 0.5 Hz when aggregating.
+constexpr uint32_t ENV_PERIOD_US = TELEMETRY_AGGREGATE ? 2 * 1000 * 1000 : 20 * 1000 * 1000;
+constexpr uint32_t ENV_DEADLINE_US = 400 * 1000;
+// The display rows after the fixed ones show other readings in turn:
+// picked at random every frame, or in a fixed order with
+// DISPLAY_ROUND_ROBIN (see display/lines.h).
+constexpr bool DISPLAY_ROUND_ROBIN = false;
+constexpr uint32_t DISPLAY_PERIOD_US = 5 * 1000 * 1000;
+constexpr uint32_t DISPLAY_DEADLINE_US = 500 * 1000;
+constexpr uint32_t TELEMETRY_PERIOD_US =
+    TELEMETRY_AGGREGATE ? TELEMETRY_WINDOW_S * 1000 * 1000 : 20 * 1000 * 1000;
+constexpr uint32_t TELEMETRY_DEADLINE_US = 500 * 1000;
+// Low-power idle (hal::IdleUntil): a wait for the next job of at least
+// LOW_POWER_MIN_SLEEP_US lets the chip into its sleep state instead of
+// only stopping the cores. Configure it out with -DLOW_POWER_IDLE=OFF to
+// keep stdio on USB.
+#ifndef SEND_ENV_LOW_POWER_IDLE
+#define SEND_ENV_LOW_POWER_IDLE 1
+#endif
+constexpr bool LOW_POWER_IDLE = SEND_ENV_LOW_POWER_IDLE != 0;
+constexpr uint32_t LOW_POWER_MIN_SLEEP_US = 1000;
+// Publish after the environmental readings of the same period have landed.
+constexpr uint32_t TELEMETRY_PHASE_US = ENV_DEADLINE_US;
+// I2C health record (per-address error counters, bus recoveries), sent on
+// the telemetry link alongside the readings.
+constexpr uint32_t HEALTH_PERIOD_US = 300u * 1000 * 1000;
+constexpr uint32_t HEALTH_DEADLINE_US = 500 * 1000;
+// Stage timing (profile/profile.h): per-stage duration histograms and
+// maxima, sent on the telemetry link as a timing record every
+// TIMING_PERIOD_US. Configure it out with -DSTAGE_TIMING=OFF; the timers
+// then compile to nothing.
+#ifndef SEND_ENV_STAGE_TIMING
+#define SEND_ENV_STAGE_TIMING 1
+#endif
+constexpr bool STAGE_TIMING = SEND_ENV_STAGE_TIMING != 0;
+constexpr uint32_t TIMING_PERIOD_US = 300u * 1000 * 1000;
+constexpr uint32_t TIMING_DEADLINE_US = 500 * 1000;
+// Watchdog supervision (supervisor/supervisor.h): the watchdog task feeds
+// the hardware watchdog every WATCHDOG_PERIOD_US while every stage keeps
+// finishing its jobs, each within twice its period plus
+// WATCHDOG_STAGE_SLACK_US; otherwise the chip resets WATCHDOG_TIMEOUT_MS
+// after the last feed and resumes warm. Configure it out with
+// -DWATCHDOG=OFF, e.g. to single-step in a debugger without a probe that
+// pauses it.
+#ifndef SEND_ENV_WATCHDOG
+#define SEND_ENV_WATCHDOG 1
+#endif
+constexpr bool WATCHDOG = SEND_ENV_WATCHDOG != 0;
+constexpr uint32_t WATCHDOG_TIMEOUT_MS = 2000;
+constexpr uint32_t WATCHDOG_PERIOD_US = 500 * 1000;
+constexpr uint32_t WATCHDOG_DEADLINE_US = 250 * 1000;
+constexpr uint32_t WATCHDOG_STAGE_SLACK_US = 1000 * 1000;
 
 }  // namespace config
 }  // namespace app
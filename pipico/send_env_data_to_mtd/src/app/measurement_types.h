@@ -20,6 +20,14 @@ struct Bmp280Data {
     float altitude_m = 0.0f;
 };
 
+// Spread of one axis over a publish window, in raw LSB. rms is about the
+// window mean, i.e. the vibration on top of the steady value.
+struct AxisWindow {
+    int16_t min = 0;
+    int16_t max = 0;
+    uint16_t rms = 0;
+};
+
 struct Mpu6050Data {
     bool valid = false;
     int16_t accel_x = 0;
@@ -29,6 +37,13 @@ struct Mpu6050Data {
     int16_t gyro_y = 0;
     int16_t gyro_z = 0;
     float temperature_c = 0.0f;
+    // FIFO mode only (app::config::MPU6050_FIFO): the values above are the
+    // latest decimated output, the windows cover every FIFO sample since
+    // sensors::mpu6050::ResetWindow().
+    uint32_t window_samples = 0;
+    uint16_t fifo_overflows = 0;     // FIFO resets since boot
+    AxisWindow accel_window[3];      // x, y, z
+    AxisWindow gyro_window[3];
 };
 
 struct Veml7700Data {
@@ -44,12 +59,27 @@ struct HscdtdData {
     float heading_deg = 0.0f;
 };
 
+// Output of the ahrs stage, from the MPU6050 and HSCDTD008A together.
+struct OrientationData {
+    bool valid = false;
+    float roll_deg = 0.0f;     // right side down
+    float pitch_deg = 0.0f;    // nose down
+    float heading_deg = 0.0f;  // tilt-compensated, clockwise from magnetic north
+};
+
 struct GpsData {
     bool fix = false;
-    float latitude = 0.0f;
-    float longitude = 0.0f;
+    int32_t latitude_e7 = 0;         // 1e-7 degree, see gps/coordinates.h
+    int32_t longitude_e7 = 0;
     bool datetime_valid = false;
     char datetime[20] = {0};
+    uint8_t fix_type = 0;            // GSA: 1 = none, 2 = 2D, 3 = 3D
+    uint8_t satellites_used = 0;     // GGA
+    uint8_t satellites_in_view = 0;  // GSV
+    uint16_t hdop_centi = 0;         // HDOP x100 (GGA, GSA)
+    bool motion_valid = false;
+    uint32_t speed_mm_s = 0;         // ground speed (VTG, RMC)
+    uint16_t course_centideg = 0;    // true course x100 (VTG, RMC)
 };
 
 struct SensorSnapshot {
@@ -58,6 +88,7 @@ struct SensorSnapshot {
     Mpu6050Data mpu6050;
     Veml7700Data veml7700;
     HscdtdData hscdtd;
+    OrientationData orientation;
     GpsData gps;
 };
 
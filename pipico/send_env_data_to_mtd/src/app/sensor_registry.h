@@ -0,0 +1,265 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "app/app_config.h"
+#include "app/measurement_types.h"
+#include "sensors/aht20.h"
+#include "sensors/bmp280.h"
+#include "sensors/hscdtd.h"
+#include "sensors/mpu6050.h"
+#include "sensors/veml7700.h"
+#include "telemetry/record_format.h"
+#include "utils/format.h"
+
+// The I2C sensors the firmware is built with, as a compile-time list.
+// Each entry describes one driver: its reading struct and where it lives
+// in the snapshot, init and two-phase read hooks, how often its task
+// runs, the record sections it refreshes, the stage its reads are timed
+// as, its fields on the telemetry line and its lines on the display. main() builds the sensor tasks from
+// the list, telemetry and the display iterate it, all by template
+// expansion with no virtual calls. A sensor configured out
+// (app::config::SENSOR_*) is left out of Sensors, so nothing references
+// its driver and the linker drops it.
+//
+// Adding a sensor: a reading struct and snapshot member
+// (measurement_types.h), the driver, and an entry here.
+namespace app {
+namespace registry {
+
+using model::SensorSnapshot;
+using utils::format::Writer;
+
+template <typename... Entries>
+struct List {
+    static constexpr int kSize = sizeof...(Entries);
+};
+
+// Calls fn(Entry()) for each entry, in list order.
+template <typename... Entries, typename Fn>
+void ForEach(List<Entries...>, Fn &&fn) {
+    (fn(Entries()), ...);
+}
+
+// A display line formatter for one sensor's reading.
+template <typename Data>
+using LineFn = void (*)(const Data &data, Writer &out);
+
+inline float ValueOrNan(bool valid, float value) {
+    return valid ? value : std::nanf("");
+}
+
+struct Aht20 {
+    using Data = model::Aht20Data;
+    static constexpr bool kEnabled = config::SENSOR_AHT20;
+    static constexpr const char *kName = "AHT20";
+    static constexpr const char *kTask = "aht20";
+    static constexpr uint32_t kPeriodUs = config::ENV_PERIOD_US;
+    static constexpr uint32_t kDeadlineUs = config::ENV_DEADLINE_US;
+    static constexpr uint16_t kSections = 1u << telemetry::record::kAht20;
+    static constexpr telemetry::record::Stage kStage = telemetry::record::kStageAht20;
+    static constexpr Data SensorSnapshot::*kSlot = &SensorSnapshot::aht20;
+
+    static void Init() {}
+    static bool Start() {
+        return sensors::aht20::Start();
+    }
+    static sensors::Status Collect(Data &data) {
+        return sensors::aht20::Collect(data);
+    }
+    static void OnPublish() {}
+
+    static void Telemetry(const Data &d, Writer &out) {
+        out.Text("ahtT=").Fixed(d.temperature_c, 2)
+            .Text(",ahtH=").Fixed(d.humidity_pct, 2)
+            .Text(",ahtStatus=0x").Hex(d.status, 2);
+    }
+    // The temperature has a fixed row of its own (display/lines.h).
+    static constexpr LineFn<Data> kLines[] = {
+        [](const Data &d, Writer &out) { out.Text("AHT H:").Fixed(d.humidity_pct, 1, 5).Char('%'); },
+        [](const Data &d, Writer &out) { out.Text("AHT St:0x").Hex(d.status, 2); },
+    };
+};
+
+struct Bmp280 {
+    using Data = model::Bmp280Data;
+    static constexpr bool kEnabled = config::SENSOR_BMP280;
+    static constexpr const char *kName = "BMP280";
+    static constexpr const char *kTask = "bmp280";
+    static constexpr uint32_t kPeriodUs = config::ENV_PERIOD_US;
+    static constexpr uint32_t kDeadlineUs = config::ENV_DEADLINE_US;
+    static constexpr uint16_t kSections = 1u << telemetry::record::kBmp280;
+    static constexpr telemetry::record::Stage kStage = telemetry::record::kStageBmp280;
+    static constexpr Data SensorSnapshot::*kSlot = &SensorSnapshot::bmp280;
+
+    static void Init() {
+        sensors::bmp280::Init();
+    }
+    static bool Start() {
+        return sensors::bmp280::Start();
+    }
+    static sensors::Status Collect(Data &data) {
+        return sensors::bmp280::Collect(data);
+    }
+    static void OnPublish() {}
+
+    static void Telemetry(const Data &d, Writer &out) {
+        out.Text("bmpT=").Fixed(ValueOrNan(d.valid, d.temperature_c), 2)
+            .Text(",bmpP=").Fixed(ValueOrNan(d.valid, d.pressure_pa), 2)
+            .Text(",alt=").Fixed(ValueOrNan(d.valid, d.altitude_m), 2);
+    }
+    static constexpr LineFn<Data> kLines[] = {
+        [](const Data &d, Writer &out) { out.Text("BMP T:").Fixed(d.temperature_c, 1, 5).Char('C'); },
+        [](const Data &d, Writer &out) { out.Text("BMP P:").Fixed(d.pressure_pa / 100.0f, 1, 7).Text("hPa"); },
+        [](const Data &d, Writer &out) { out.Text("BMP Alt:").Fixed(d.altitude_m, 1, 6).Char('m'); },
+    };
+};
+
+// The orientation filter is fed from the IMU task; main() attaches it.
+struct Mpu6050 {
+    using Data = model::Mpu6050Data;
+    static constexpr bool kEnabled = config::SENSOR_MPU6050;
+    static constexpr const char *kName = "MPU6050";
+    static constexpr const char *kTask = "imu";
+    static constexpr uint32_t kPeriodUs = config::IMU_PERIOD_US;
+    static constexpr uint32_t kDeadlineUs = config::IMU_DEADLINE_US;
+    static constexpr uint16_t kSections = 1u << telemetry::record::kMpu6050;
+    static constexpr telemetry::record::Stage kStage = telemetry::record::kStageMpu6050;
+    static constexpr Data SensorSnapshot::*kSlot = &SensorSnapshot::mpu6050;
+
+    static void Init() {
+        sensors::mpu6050::Init();
+    }
+    static bool Start() {
+        return sensors::mpu6050::Start();
+    }
+    static sensors::Status Collect(Data &data) {
+        return sensors::mpu6050::Collect(data);
+    }
+    // Each publish closes the vibration window.
+    static void OnPublish() {
+        sensors::mpu6050::ResetWindow();
+    }
+
+    static void Telemetry(const Data &d, Writer &out) {
+        out.Text("mpuOk=").Int(d.valid ? 1 : 0)
+            .Text(",ax=").Int(d.accel_x)
+            .Text(",ay=").Int(d.accel_y)
+            .Text(",az=").Int(d.accel_z)
+            .Text(",gx=").Int(d.gyro_x)
+            .Text(",gy=").Int(d.gyro_y)
+            .Text(",gz=").Int(d.gyro_z)
+            .Text(",mpuT=").Fixed(ValueOrNan(d.valid, d.temperature_c), 2);
+        // Vibration over the publish window, FIFO mode only.
+        if (d.valid && d.window_samples > 0) {
+            out.Text(",imuN=").Int(d.window_samples)
+                .Text(",axRms=").Int(d.accel_window[0].rms)
+                .Text(",ayRms=").Int(d.accel_window[1].rms)
+                .Text(",azRms=").Int(d.accel_window[2].rms)
+                .Text(",axPp=").Int(d.accel_window[0].max - d.accel_window[0].min)
+                .Text(",ayPp=").Int(d.accel_window[1].max - d.accel_window[1].min)
+                .Text(",azPp=").Int(d.accel_window[2].max - d.accel_window[2].min);
+        }
+    }
+    static constexpr LineFn<Data> kLines[] = {
+        [](const Data &d, Writer &out) { out.Text("MPU T:").Fixed(d.temperature_c, 1, 5).Char('C'); },
+        [](const Data &d, Writer &out) { out.Text("MPU Ax:").Int(d.accel_x, 6); },
+        [](const Data &d, Writer &out) { out.Text("MPU Ay:").Int(d.accel_y, 6); },
+        [](const Data &d, Writer &out) { out.Text("MPU Az:").Int(d.accel_z, 6); },
+        [](const Data &d, Writer &out) { out.Text("MPU Gx:").Int(d.gyro_x, 6); },
+        [](const Data &d, Writer &out) { out.Text("MPU Gy:").Int(d.gyro_y, 6); },
+        [](const Data &d, Writer &out) { out.Text("MPU Gz:").Int(d.gyro_z, 6); },
+    };
+};
+
+struct Veml7700 {
+    using Data = model::Veml7700Data;
+    static constexpr bool kEnabled = config::SENSOR_VEML7700;
+    static constexpr const char *kName = "VEML7700";
+    static constexpr const char *kTask = "veml7700";
+    static constexpr uint32_t kPeriodUs = config::ENV_PERIOD_US;
+    static constexpr uint32_t kDeadlineUs = config::ENV_DEADLINE_US;
+    static constexpr uint16_t kSections = 1u << telemetry::record::kVeml7700;
+    static constexpr telemetry::record::Stage kStage = telemetry::record::kStageVeml7700;
+    static constexpr Data SensorSnapshot::*kSlot = &SensorSnapshot::veml7700;
+
+    static void Init() {
+        sensors::veml7700::Init();
+    }
+    static bool Start() {
+        return sensors::veml7700::Start();
+    }
+    static sensors::Status Collect(Data &data) {
+        return sensors::veml7700::Collect(data);
+    }
+    static void OnPublish() {}
+
+    static void Telemetry(const Data &d, Writer &out) {
+        out.Text("luxOk=").Int(d.valid ? 1 : 0).Text(",lux=").Fixed(ValueOrNan(d.valid, d.lux), 2);
+    }
+    static constexpr LineFn<Data> kLines[] = {
+        [](const Data &d, Writer &out) { out.Text("VEML Lux:").Fixed(d.lux, 1, 6); },
+    };
+};
+
+struct Hscdtd {
+    using Data = model::HscdtdData;
+    static constexpr bool kEnabled = config::SENSOR_HSCDTD;
+    static constexpr const char *kName = "HSCDTD008A";
+    static constexpr const char *kTask = "mag";
+    static constexpr uint32_t kPeriodUs = config::MAG_PERIOD_US;
+    static constexpr uint32_t kDeadlineUs = config::MAG_DEADLINE_US;
+    static constexpr uint16_t kSections = 1u << telemetry::record::kHscdtd;
+    static constexpr telemetry::record::Stage kStage = telemetry::record::kStageHscdtd;
+    static constexpr Data SensorSnapshot::*kSlot = &SensorSnapshot::hscdtd;
+
+    static void Init() {
+        sensors::hscdtd::Init();
+    }
+    static bool Start() {
+        return sensors::hscdtd::Start();
+    }
+    static sensors::Status Collect(Data &data) {
+        return sensors::hscdtd::Collect(data);
+    }
+    static void OnPublish() {}
+
+    static void Telemetry(const Data &d, Writer &out) {
+        out.Text("magOk=").Int(d.valid ? 1 : 0)
+            .Text(",magX=").Int(d.x)
+            .Text(",magY=").Int(d.y)
+            .Text(",magZ=").Int(d.z)
+            .Text(",head=").Fixed(ValueOrNan(d.valid, d.heading_deg), 1);
+    }
+    static constexpr LineFn<Data> kLines[] = {
+        [](const Data &d, Writer &out) { out.Text("HSCD Head:").Fixed(d.heading_deg, 1, 5); },
+        [](const Data &d, Writer &out) { out.Text("HSCD X:").Int(d.x, 6); },
+        [](const Data &d, Writer &out) { out.Text("HSCD Y:").Int(d.y, 6); },
+        [](const Data &d, Writer &out) { out.Text("HSCD Z:").Int(d.z, 6); },
+    };
+};
+
+// `Entries` with the configured-out ones dropped, order kept.
+template <typename Kept, typename... Entries>
+struct Enabled {
+    using Type = Kept;
+};
+template <typename... Kept, typename Entry, typename... Rest>
+struct Enabled<List<Kept...>, Entry, Rest...> {
+    using Type = typename std::conditional_t<Entry::kEnabled, Enabled<List<Kept..., Entry>, Rest...>,
+                                             Enabled<List<Kept...>, Rest...>>::Type;
+};
+
+// In snapshot order, which is also the order of their fields on the
+// telemetry line and of their tasks in the scheduler.
+using Sensors = Enabled<List<>, Aht20, Bmp280, Mpu6050, Veml7700, Hscdtd>::Type;
+
+template <typename Entry, typename... Entries>
+constexpr bool Contains(List<Entries...>) {
+    return (std::is_same_v<Entry, Entries> || ...);
+}
+
+}  // namespace registry
+}  // namespace app
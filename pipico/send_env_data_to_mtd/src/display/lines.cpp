@@ -0,0 +1,146 @@
+#include "display/lines.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "app/sensor_registry.h"
+#include "gps/coordinates.h"
+#include "utils/format.h"
+#include "utils/random.h"
+
+namespace display {
+
+namespace {
+
+using app::model::SensorSnapshot;
+using utils::format::Writer;
+
+struct Line {
+    bool (*available)(const SensorSnapshot &snapshot);
+    void (*format)(const SensorSnapshot &snapshot, Writer &out);
+};
+
+// A sensor's lines are available while its reading is valid.
+template <typename Sensor>
+bool SensorValid(const SensorSnapshot &snapshot) {
+    return (snapshot.*Sensor::kSlot).valid;
+}
+
+template <typename Sensor, std::size_t Index>
+void SensorLine(const SensorSnapshot &snapshot, Writer &out) {
+    Sensor::kLines[Index](snapshot.*Sensor::kSlot, out);
+}
+
+template <typename Sensor, std::size_t... Index>
+constexpr std::array<Line, sizeof...(Index)> LinesOf(std::index_sequence<Index...>) {
+    return {{{SensorValid<Sensor>, SensorLine<Sensor, Index>}...}};
+}
+
+template <std::size_t... Size>
+constexpr std::array<Line, (Size + ... + 0)> Join(const std::array<Line, Size> &...parts) {
+    std::array<Line, (Size + ... + 0)> all{};
+    std::size_t next = 0;
+    auto append = [&](const auto &part) {
+        for (const Line &line : part) {
+            all[next++] = line;
+        }
+    };
+    (append(parts), ...);
+    return all;
+}
+
+template <typename... Sensors>
+constexpr auto SensorLines(app::registry::List<Sensors...>) {
+    return Join(LinesOf<Sensors>(std::make_index_sequence<std::size(Sensors::kLines)>())...);
+}
+
+constexpr std::array<Line, 2> kOrientationLines = {{
+    {[](const SensorSnapshot &s) { return s.orientation.valid; },
+     [](const SensorSnapshot &s, Writer &out) { out.Text("AHRS Hdg:").Fixed(s.orientation.heading_deg, 1, 5); }},
+    {[](const SensorSnapshot &s) { return s.orientation.valid; },
+     [](const SensorSnapshot &s, Writer &out) {
+         out.Text("R:").Fixed(s.orientation.roll_deg, 1, 5, true);
+         out.Text(" P:").Fixed(s.orientation.pitch_deg, 1, 5, true);
+     }},
+}};
+
+// The readings the rotating rows cycle through: each registered sensor's
+// lines (app/sensor_registry.h), then the orientation.
+constexpr auto kLines = Join(SensorLines(app::registry::Sensors()), kOrientationLines);
+constexpr int kLineCount = static_cast<int>(kLines.size());
+
+// Next table entry for kRoundRobin.
+int next_line = 0;
+
+// Fisher-Yates, stopped once the first `picks` places are settled: as
+// uniform as a full shuffle, for `picks` calls to rand().
+void PickRandom(uint8_t *ids, int count, int picks) {
+    utils::EnsureRandomSeeded();
+    for (int i = 0; i < picks && i < count - 1; ++i) {
+        const int j = i + std::rand() % (count - i);
+        const uint8_t tmp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = tmp;
+    }
+}
+
+// Up to `picks` available lines in table order from next_line, wrapping.
+int PickRoundRobin(const SensorSnapshot &snapshot, uint8_t *ids, int picks) {
+    int picked = 0;
+    for (int n = 0; n < kLineCount && picked < picks; ++n) {
+        const int id = (next_line + n) % kLineCount;
+        if (kLines[id].available(snapshot)) {
+            ids[picked++] = static_cast<uint8_t>(id);
+        }
+    }
+    if (picked > 0) {
+        next_line = (ids[picked - 1] + 1) % kLineCount;
+    }
+    return picked;
+}
+
+}  // namespace
+
+void ComposeRows(const SensorSnapshot &snapshot, Rotation rotation, char rows[kRows][kLineLength]) {
+    int row = 0;
+    if (app::config::SENSOR_AHT20) {
+        Writer(rows[row++], kLineLength).Text("AHT T:").Fixed(snapshot.aht20.temperature_c, 1, 5).Char('C');
+    }
+    if (snapshot.gps.fix) {
+        char latitude[10];  // "-180.0000"
+        char longitude[10];
+        gps::FormatDegrees(snapshot.gps.latitude_e7, 4, latitude, sizeof(latitude));
+        gps::FormatDegrees(snapshot.gps.longitude_e7, 4, longitude, sizeof(longitude));
+        Writer(rows[row++], kLineLength).Text("GPS ").Text(latitude).Char(' ').Text(longitude);
+    }
+
+    const int wanted = kRows - row;
+    uint8_t ids[kLineCount];
+    int picked = 0;
+    if (rotation == Rotation::kRoundRobin) {
+        picked = PickRoundRobin(snapshot, ids, wanted);
+    } else {
+        int available = 0;
+        for (int id = 0; id < kLineCount; ++id) {
+            if (kLines[id].available(snapshot)) {
+                ids[available++] = static_cast<uint8_t>(id);
+            }
+        }
+        PickRandom(ids, available, wanted);
+        picked = available < wanted ? available : wanted;
+    }
+
+    for (int i = 0; i < picked; ++i) {
+        Writer out(rows[row++], kLineLength);
+        kLines[ids[i]].format(snapshot, out);
+    }
+    while (row < kRows) {
+        std::strcpy(rows[row++], "DATA ---");
+    }
+}
+
+}  // namespace display
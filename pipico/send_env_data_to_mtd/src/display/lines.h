@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+#include "app/measurement_types.h"
+
+// Text content of the display. Each possible line is a descriptor in a
+// table, built from the sensor registry (app/sensor_registry.h) at compile
+// time: a test of whether the snapshot has its data and a formatter. Rows
+// are chosen on the tests alone and only the chosen lines are formatted,
+// so a render formats four lines however many readings there are.
+namespace display {
+
+constexpr int kRows = 4;
+constexpr std::size_t kLineLength = 24;
+
+// How the rows below the fixed ones cycle through the other readings.
+enum class Rotation {
+    kShuffle,     // a random pick every frame
+    kRoundRobin,  // in table order, continuing where the last frame stopped
+};
+
+// Fills `rows`: AHT20 temperature if it is built in, the GPS position if there is a fix, then
+// readings picked by `rotation`, and "DATA ---" for rows left over.
+void ComposeRows(const app::model::SensorSnapshot &snapshot, Rotation rotation, char rows[kRows][kLineLength]);
+
+}  // namespace display
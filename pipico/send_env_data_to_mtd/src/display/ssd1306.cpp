@@ -0,0 +1,200 @@
+#include "display/ssd1306.h"
+
+#include <cstring>
+
+#include "display/font5x7.h"
+
+namespace display {
+
+namespace {
+constexpr uint8_t DISPLAY_OFF = 0xAE;
+constexpr uint8_t DISPLAY_ON = 0xAF;
+constexpr uint8_t MEMORY_MODE = 0x20;
+constexpr uint8_t COLUMN_ADDR = 0x21;
+constexpr uint8_t PAGE_ADDR = 0x22;
+constexpr uint8_t START_LINE = 0x40;
+constexpr uint8_t CONTRAST = 0x81;
+constexpr uint8_t CHARGE_PUMP = 0x8D;
+constexpr uint8_t SEG_REMAP_OFF = 0xA0;
+constexpr uint8_t SEG_REMAP_ON = 0xA1;
+constexpr uint8_t RESUME_RAM = 0xA4;
+constexpr uint8_t NORMAL_DISPLAY = 0xA6;
+constexpr uint8_t MULTIPLEX = 0xA8;
+constexpr uint8_t COM_SCAN_INC = 0xC0;
+constexpr uint8_t COM_SCAN_DEC = 0xC8;
+constexpr uint8_t DISPLAY_OFFSET = 0xD3;
+constexpr uint8_t CLOCK_DIV = 0xD5;
+constexpr uint8_t PRECHARGE = 0xD9;
+constexpr uint8_t COM_PINS = 0xDA;
+constexpr uint8_t VCOM_DETECT = 0xDB;
+}  // namespace
+
+Ssd1306::Ssd1306(uint8_t address)
+    : address_(address),
+      window_{kControlCommand, COLUMN_ADDR, 0, kWidth - 1, PAGE_ADDR, 0, kPages - 1},
+      data_{kControlData},
+      window_transaction_(address, window_, sizeof(window_), nullptr, 0, OnSent, this),
+      data_transaction_(address, data_, sizeof(data_), nullptr, 0, OnSent, this) {
+    Clear();
+}
+
+void Ssd1306::Init() {
+    const uint8_t sequence[] = {
+        DISPLAY_OFF,
+        MEMORY_MODE, 0x00,  // horizontal addressing
+        START_LINE,
+        SEG_REMAP_ON,
+        MULTIPLEX, kHeight - 1,
+        COM_SCAN_DEC,
+        DISPLAY_OFFSET, 0x00,
+        COM_PINS, 0x02,  // sequential COM pins for 32-row panels
+        CLOCK_DIV, 0x80,
+        PRECHARGE, 0xF1,
+        VCOM_DETECT, 0x30,
+        CONTRAST, 0xFF,
+        RESUME_RAM,
+        NORMAL_DISPLAY,
+        CHARGE_PUMP, 0x14,
+        DISPLAY_ON,
+    };
+    Commands(sequence, sizeof(sequence));
+}
+
+void Ssd1306::SetOrientation(bool flipped) {
+    const uint8_t sequence[] = {
+        flipped ? SEG_REMAP_OFF : SEG_REMAP_ON,
+        flipped ? COM_SCAN_INC : COM_SCAN_DEC,
+    };
+    Commands(sequence, sizeof(sequence));
+}
+
+void Ssd1306::Clear() {
+    for (int page = 0; page < kPages; ++page) {
+        std::memset(&Cell(page, 0), 0, kWidth);
+    }
+}
+
+void Ssd1306::SetPixel(int x, int y, bool on) {
+    if (x < 0 || x >= kWidth || y < 0 || y >= kHeight) {
+        return;
+    }
+    uint8_t &cell = Cell(y / 8, x);
+    const uint8_t mask = static_cast<uint8_t>(1u << (y % 8));
+    cell = on ? (cell | mask) : (cell & ~mask);
+}
+
+void Ssd1306::DrawGlyph(int x, int y, char ch) {
+    if (ch < kFontFirstChar || ch > kFontLastChar) {
+        ch = '?';
+    }
+    const uint8_t *glyph = kFont5x7[ch - kFontFirstChar];
+    for (int col = 0; col < kFontGlyphWidth; ++col) {
+        const int px = x + col;
+        if (px < 0 || px >= kWidth) {
+            continue;
+        }
+        if (y >= 0 && y % 8 == 0 && y < kHeight) {
+            Cell(y / 8, px) |= glyph[col];
+            continue;
+        }
+        for (int row = 0; row < 8; ++row) {
+            if (glyph[col] & (1u << row)) {
+                SetPixel(px, y + row);
+            }
+        }
+    }
+}
+
+void Ssd1306::DrawText(int x, int y, const char *text) {
+    for (; *text != '\0' && x < kWidth; ++text, x += kFontCellWidth) {
+        DrawGlyph(x, y, *text);
+    }
+}
+
+void Ssd1306::Invalidate() {
+    shown_valid_ = false;
+}
+
+// Splits the differences between pages_ and shown_ in `page` into runs,
+// merging across short gaps, and takes them as shown.
+void Ssd1306::AddRuns(int page) {
+    const int first_run = run_count_;
+    for (int x = 0; x < kWidth; ++x) {
+        if (shown_valid_ && pages_[page][x] == shown_[page][x]) {
+            continue;
+        }
+        Run *last = run_count_ > first_run ? &runs_[run_count_ - 1] : nullptr;
+        if (last != nullptr && (x - last->last <= kMergeGap || run_count_ - first_run == kMaxRunsPerPage)) {
+            last->last = static_cast<uint8_t>(x);
+        } else {
+            runs_[run_count_++] = {static_cast<uint8_t>(page), static_cast<uint8_t>(x), static_cast<uint8_t>(x)};
+        }
+    }
+    std::memcpy(shown_[page], pages_[page], kWidth);
+}
+
+// Only one transfer is queued at a time: each completion queues the next,
+// so transfers other drivers submit meanwhile go out in between.
+void Ssd1306::SendBuffer() {
+    run_count_ = 0;
+    for (int page = 0; page < kPages; ++page) {
+        AddRuns(page);
+    }
+    shown_valid_ = true;
+    step_count_ = 2 * run_count_;
+    next_step_ = 0;
+    if (step_count_ > 0 && !SubmitStep(next_step_++)) {
+        next_step_ = step_count_;
+        shown_valid_ = false;
+    }
+}
+
+bool Ssd1306::SubmitStep(int step) {
+    const Run &run = runs_[step / 2];
+    if (step % 2 == 0) {
+        window_[2] = run.first;
+        window_[3] = run.last;
+        window_[5] = run.page;
+        window_[6] = run.page;
+        return i2c::Submit(window_transaction_);
+    }
+    const std::size_t len = static_cast<std::size_t>(run.last - run.first + 1);
+    std::memcpy(data_ + 1, &Cell(run.page, run.first), len);
+    data_transaction_.tx_len = 1 + len;
+    return i2c::Submit(data_transaction_);
+}
+
+void Ssd1306::OnSent(i2c::Transaction &transaction) {
+    Ssd1306 &self = *static_cast<Ssd1306 *>(transaction.context);
+    if (transaction.result < 0) {
+        // The panel is now in an unknown state.
+        self.next_step_ = self.step_count_;
+        self.shown_valid_ = false;
+        return;
+    }
+    if (self.next_step_ >= self.step_count_) {
+        return;
+    }
+    if (!self.SubmitStep(self.next_step_++)) {
+        self.next_step_ = self.step_count_;
+        self.shown_valid_ = false;
+    }
+}
+
+bool Ssd1306::Busy() const {
+    return next_step_ < step_count_ || window_transaction_.pending || data_transaction_.pending;
+}
+
+void Ssd1306::Commands(const uint8_t *commands, std::size_t count) {
+    uint8_t payload[32];
+    payload[0] = kControlCommand;
+    while (count > 0) {
+        const std::size_t chunk = count < sizeof(payload) - 1 ? count : sizeof(payload) - 1;
+        std::memcpy(payload + 1, commands, chunk);
+        i2c::Transfer(address_, payload, chunk + 1, nullptr, 0);
+        commands += chunk;
+        count -= chunk;
+    }
+}
+
+}  // namespace display
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "i2c/transaction_queue.h"
+
+namespace display {
+
+// Minimal SSD1306 128x32 driver on the I2C transaction queue. The framebuffer
+// uses the controller's native layout: one byte per column per 8-pixel page.
+//
+// The driver keeps a copy of what the panel shows and only sends what
+// differs from it: each changed run of columns within a page becomes a
+// column/page address window followed by just those bytes, so a frame costs
+// bus time roughly in proportion to what changed. Runs closer together
+// than the cost of a new window are merged.
+class Ssd1306 {
+public:
+    static constexpr int kWidth = 128;
+    static constexpr int kHeight = 32;
+    static constexpr int kPages = kHeight / 8;
+    static constexpr std::size_t kBufferSize = kWidth * kPages;
+
+    explicit Ssd1306(uint8_t address);
+    Ssd1306(const Ssd1306 &) = delete;
+    Ssd1306 &operator=(const Ssd1306 &) = delete;
+
+    void Init();
+    void SetOrientation(bool flipped);
+    void Clear();
+    void SetPixel(int x, int y, bool on = true);
+    void DrawText(int x, int y, const char *text);
+    // Queue the changes since the last frame and return; the framebuffer
+    // must not be drawn into until Busy() reports the transfer finished.
+    void SendBuffer();
+    // Send the whole framebuffer with the next SendBuffer(), e.g. after the
+    // panel lost power.
+    void Invalidate();
+    bool Busy() const;
+
+private:
+    static constexpr uint8_t kControlCommand = 0x00;
+    static constexpr uint8_t kControlData = 0x40;
+
+    // A new window costs its 7-byte command write, plus the address and
+    // control bytes of a second data write; a gap of unchanged columns up
+    // to this long is cheaper to resend.
+    static constexpr int kMergeGap = 10;
+    static constexpr int kMaxRunsPerPage = 4;
+    static constexpr int kMaxRuns = kPages * kMaxRunsPerPage;
+
+    // Columns first..last of one page.
+    struct Run {
+        uint8_t page;
+        uint8_t first;
+        uint8_t last;
+    };
+
+    static void OnSent(i2c::Transaction &transaction);
+
+    void Commands(const uint8_t *commands, std::size_t count);
+    void DrawGlyph(int x, int y, char ch);
+    void AddRuns(int page);
+    bool SubmitStep(int step);
+
+    uint8_t &Cell(int page, int x) {
+        return pages_[page][x];
+    }
+
+    uint8_t address_;
+    uint8_t pages_[kPages][kWidth];
+    // What the panel shows, as far as the driver knows; not trusted until
+    // one full frame went out.
+    uint8_t shown_[kPages][kWidth];
+    bool shown_valid_ = false;
+
+    // Each run goes out as a window command then a data write, one
+    // transfer at a time, so other devices' transfers interleave between
+    // them instead of waiting for the whole frame.
+    Run runs_[kMaxRuns];
+    int run_count_ = 0;
+    uint8_t window_[7];
+    uint8_t data_[1 + kWidth];
+    i2c::Transaction window_transaction_;
+    i2c::Transaction data_transaction_;
+    // Even steps send runs_[step / 2]'s window, odd steps its data.
+    volatile int next_step_ = 0;
+    volatile int step_count_ = 0;
+};
+
+}  // namespace display
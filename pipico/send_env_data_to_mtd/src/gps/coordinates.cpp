@@ -0,0 +1,56 @@
+#include "gps/coordinates.h"
+
+namespace gps {
+
+namespace {
+constexpr uint32_t kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+}  // namespace
+
+std::size_t FormatDegrees(int32_t e7, int decimals, char *out, std::size_t len) {
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 7) {
+        decimals = 7;
+    }
+
+    // Unsigned magnitude so INT32_MIN does not overflow; the rounding
+    // addition stays below 2^32.
+    uint32_t magnitude = e7 < 0 ? 0u - static_cast<uint32_t>(e7) : static_cast<uint32_t>(e7);
+    const uint32_t divisor = kPow10[7 - decimals];
+    magnitude = (magnitude + divisor / 2) / divisor;
+    uint32_t whole = magnitude / kPow10[decimals];
+    uint32_t fraction = magnitude % kPow10[decimals];
+
+    // Build right to left: fraction, point, whole degrees, sign.
+    char text[16];
+    std::size_t pos = sizeof(text);
+    for (int i = 0; i < decimals; ++i) {
+        text[--pos] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    if (decimals > 0) {
+        text[--pos] = '.';
+    }
+    do {
+        text[--pos] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    if (e7 < 0 && magnitude != 0) {
+        text[--pos] = '-';
+    }
+
+    const std::size_t length = sizeof(text) - pos;
+    if (length + 1 > len) {
+        if (len > 0) {
+            out[0] = '\0';
+        }
+        return 0;
+    }
+    for (std::size_t i = 0; i < length; ++i) {
+        out[i] = text[pos + i];
+    }
+    out[length] = '\0';
+    return length;
+}
+
+}  // namespace gps
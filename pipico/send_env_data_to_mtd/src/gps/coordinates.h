@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Positions are carried as int32 in units of 1e-7 degree: about 1.1 cm of
+// latitude, and +/-180 degrees still fits in 31 bits. Nothing on the way
+// from the NMEA parser to the display or the mesh touches floating point.
+namespace gps {
+
+constexpr int32_t kE7PerDegree = 10000000;
+
+// Writes `e7` as signed decimal degrees with `decimals` places (0..7),
+// rounded half away from zero, e.g. -412861790 with 4 places is "-41.2862".
+// Returns the length written, or 0 if `len` is too small.
+std::size_t FormatDegrees(int32_t e7, int decimals, char *out, std::size_t len);
+
+}  // namespace gps
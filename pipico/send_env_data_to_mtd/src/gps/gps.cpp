@@ -1,242 +1,96 @@
 #include "gps/gps.h"
 
-#include <cmath>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-
-#include "hardware/gpio.h"
-#include "hardware/uart.h"
+#include "gps/nmea.h"
+#include "hal/hal.h"
+#include "utils/spsc_ring.h"
 
 namespace gps {
 
 namespace {
-char line_buffer[128];
-int buffer_index = 0;
-
-void ParseGga(const char *line, app::model::GpsData &data) {
-    if (std::strncmp(line, "$GNGGA", 6) != 0 && std::strncmp(line, "$GPGGA", 6) != 0) {
-        return;
-    }
-
-    char temp[128];
-    std::strncpy(temp, line, sizeof(temp));
-    temp[sizeof(temp) - 1] = '\0';
-
-    char *token = std::strtok(temp, ",");
-    int field = 0;
-
-    float latitude = 0.0f;
-    float longitude = 0.0f;
-    char lat_dir = 0;
-    char lon_dir = 0;
-    int fix = 0;
-
-    while (token != nullptr) {
-        token = std::strtok(nullptr, ",");
-        ++field;
-        if (token == nullptr) {
-            break;
-        }
-
-        switch (field) {
-            case 2:
-                latitude = std::atof(token);
-                break;
-            case 3:
-                lat_dir = token[0];
-                break;
-            case 4:
-                longitude = std::atof(token);
-                break;
-            case 5:
-                lon_dir = token[0];
-                break;
-            case 6:
-                fix = std::atoi(token);
-                break;
-            default:
-                break;
-        }
-    }
-
-    data.fix = fix > 0;
-    if (!data.fix) {
-        return;
-    }
-
-    const int lat_deg = static_cast<int>(latitude / 100.0f);
-    const float lat_min = latitude - lat_deg * 100.0f;
-    data.latitude = lat_deg + lat_min / 60.0f;
-    if (lat_dir == 'S') {
-        data.latitude = -data.latitude;
-    }
-
-    const int lon_deg = static_cast<int>(longitude / 100.0f);
-    const float lon_min = longitude - lon_deg * 100.0f;
-    data.longitude = lon_deg + lon_min / 60.0f;
-    if (lon_dir == 'W') {
-        data.longitude = -data.longitude;
-    }
-}
-
-void ParseRmc(const char *line, app::model::GpsData &data) {
-    if (std::strncmp(line, "$GNRMC", 6) != 0 && std::strncmp(line, "$GPRMC", 6) != 0) {
-        return;
-    }
-
-    char temp[128];
-    std::strncpy(temp, line, sizeof(temp));
-    temp[sizeof(temp) - 1] = '\0';
-
-    char *token = std::strtok(temp, ",");
-    int field = 0;
-
-    float latitude = 0.0f;
-    float longitude = 0.0f;
-    char lat_dir = 0;
-    char lon_dir = 0;
-    char status = 'V';
-    char time_field[16] = {0};
-    char date_field[16] = {0};
-
-    while (token != nullptr) {
-        token = std::strtok(nullptr, ",");
-        ++field;
-        if (token == nullptr) {
-            break;
-        }
+// More than a second of NMEA at 9600 baud, so a 1 Hz Poll() never falls behind.
+constexpr std::size_t kRxRingSize = 1024;
 
-        switch (field) {
-            case 1:
-                std::strncpy(time_field, token, sizeof(time_field) - 1);
-                break;
-            case 2:
-                status = token[0];
-                break;
-            case 3:
-                latitude = std::atof(token);
-                break;
-            case 4:
-                lat_dir = token[0];
-                break;
-            case 5:
-                longitude = std::atof(token);
-                break;
-            case 6:
-                lon_dir = token[0];
-                break;
-            case 9:
-                std::strncpy(date_field, token, sizeof(date_field) - 1);
-                break;
-            default:
-                break;
-        }
-    }
+utils::SpscRing<char, kRxRingSize> rx_ring;
+RxStats rx_stats = {};
 
-    if (status != 'A') {
-        data.fix = false;
-        data.datetime_valid = false;
-        return;
+// UART RX interrupt: empty the hardware FIFO into the ring.
+void OnUartRx() {
+    if (hal::UartTakeOverrun(app::config::GPS_UART)) {
+        ++rx_stats.fifo_overruns;
     }
-
-    if (latitude != 0.0f && longitude != 0.0f) {
-        const int lat_deg = static_cast<int>(latitude / 100.0f);
-        const float lat_min = latitude - lat_deg * 100.0f;
-        data.latitude = lat_deg + lat_min / 60.0f;
-        if (lat_dir == 'S') {
-            data.latitude = -data.latitude;
-        }
-
-        const int lon_deg = static_cast<int>(longitude / 100.0f);
-        const float lon_min = longitude - lon_deg * 100.0f;
-        data.longitude = lon_deg + lon_min / 60.0f;
-        if (lon_dir == 'W') {
-            data.longitude = -data.longitude;
+    while (hal::UartReadable(app::config::GPS_UART)) {
+        if (rx_ring.Push(hal::UartGetc(app::config::GPS_UART))) {
+            ++rx_stats.bytes;
         }
-        data.fix = true;
     }
-
-    if (std::strlen(time_field) >= 6 && std::strlen(date_field) == 6) {
-        char hh[3] = {time_field[0], time_field[1], '\0'};
-        char mm[3] = {time_field[2], time_field[3], '\0'};
-        char ss[3] = {time_field[4], time_field[5], '\0'};
-
-        char dd[3] = {date_field[0], date_field[1], '\0'};
-        char mo[3] = {date_field[2], date_field[3], '\0'};
-        char yy[3] = {date_field[4], date_field[5], '\0'};
-
-        const int year = 2000 + std::atoi(yy);
-        const int month = std::atoi(mo);
-        const int day = std::atoi(dd);
-        const int hour = std::atoi(hh);
-        const int minute = std::atoi(mm);
-        const int second = std::atoi(ss);
-
-        std::snprintf(data.datetime, sizeof(data.datetime), "%04d%02d%02d %02d%02d%02d",
-                      year, month, day, hour, minute, second);
-        data.datetime_valid = true;
-    } else {
-        data.datetime_valid = false;
+    const uint32_t waiting = static_cast<uint32_t>(rx_ring.Size());
+    if (waiting > rx_stats.high_water) {
+        rx_stats.high_water = waiting;
     }
 }
 
-bool ReadLine(char *out, std::size_t maxlen) {
-    while (uart_is_readable(app::config::GPS_UART)) {
-        char ch = uart_getc(app::config::GPS_UART);
+// When Parse() last applied a sentence, for the staleness check in Poll().
+uint64_t last_sentence_us = 0;
+
+char line_buffer[128];
+std::size_t buffer_index = 0;
 
+// Assembles the next sentence in line_buffer. Returns its length, or 0 when
+// the ring runs dry first. Overlong lines are discarded.
+std::size_t ReadLine() {
+    char ch;
+    while (rx_ring.Pop(ch)) {
         if (ch == '\r') {
             continue;
         }
 
         if (ch == '\n') {
-            const int copy_len = buffer_index < static_cast<int>(maxlen - 1)
-                                     ? buffer_index
-                                     : static_cast<int>(maxlen - 1);
-            std::memcpy(out, line_buffer, copy_len);
-            out[copy_len] = '\0';
+            const std::size_t len = buffer_index;
+            line_buffer[len] = '\0';
             buffer_index = 0;
-            return true;
+            if (len > 0) {
+                return len;
+            }
+            continue;
         }
 
-        if (buffer_index < static_cast<int>(sizeof(line_buffer) - 1)) {
+        if (buffer_index < sizeof(line_buffer) - 1) {
             line_buffer[buffer_index++] = ch;
         } else {
             buffer_index = 0;
         }
     }
-    return false;
+    return 0;
 }
 
 }  // namespace
 
 void Init() {
-    uart_init(app::config::GPS_UART, app::config::GPS_BAUD);
-    gpio_set_function(app::config::GPS_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(app::config::GPS_RX_PIN, GPIO_FUNC_UART);
-    uart_set_fifo_enabled(app::config::GPS_UART, true);
+    hal::UartInit(app::config::GPS_UART, app::config::GPS_BAUD,
+                  app::config::GPS_TX_PIN, app::config::GPS_RX_PIN);
+    hal::UartSetRxHandler(app::config::GPS_UART, OnUartRx);
+    last_sentence_us = hal::TimeUs();
 }
 
-static bool start_of_line = true;
-
 void Poll(app::model::GpsData &data) {
-    char line[128];
-
-    while (ReadLine(line, sizeof(line))) {
-        // Ensure printable ASCII only
-        for (char *p = line; *p; ++p) {
-            if (*p < 0x20 || *p > 0x7E) {
-                *p = '?';
-            }
+    const uint64_t now = hal::TimeUs();
+    std::size_t len;
+    while ((len = ReadLine()) != 0) {
+        if (nmea::Parse(line_buffer, len, data) == nmea::Result::kApplied) {
+            last_sentence_us = now;
         }
-
-        // Send as ONE line
-        printf("GPS: %s\n", line);
-
-        // Parse
-        ParseGga(line, data);
-        ParseRmc(line, data);
     }
+    // A receiver that stopped talking sends no RMC to clear the fix.
+    if (now - last_sentence_us >= app::config::GPS_STALE_US) {
+        data.fix = false;
+        data.datetime_valid = false;
+        data.motion_valid = false;
+    }
+}
+
+const RxStats &GetRxStats() {
+    rx_stats.ring_overflows = rx_ring.Dropped();
+    return rx_stats;
 }
 
 }  // namespace gps
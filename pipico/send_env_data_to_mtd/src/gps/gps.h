@@ -7,7 +7,18 @@
 
 namespace gps {
 
+// Receive-path counters. Bytes are moved from the UART FIFO into a ring by
+// the RX interrupt; a non-zero overflow count means the ring or the FIFO
+// filled before it was drained.
+struct RxStats {
+    uint32_t bytes;
+    uint32_t ring_overflows;  // bytes dropped because the ring was full
+    uint32_t fifo_overruns;   // times the hardware FIFO overran before the IRQ ran
+    uint32_t high_water;      // most bytes ever waiting in the ring
+};
+
 void Init();
 void Poll(app::model::GpsData &data);
+const RxStats &GetRxStats();
 
 }  // namespace gps
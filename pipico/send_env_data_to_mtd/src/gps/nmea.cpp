@@ -0,0 +1,442 @@
+#include "gps/nmea.h"
+
+#include "gps/coordinates.h"
+
+namespace gps {
+namespace nmea {
+
+namespace {
+
+enum class Type : uint8_t {
+    kOther,
+    kGga,
+    kRmc,
+    kGsa,
+    kGsv,
+    kVtg,
+};
+
+// A field as a view into the sentence: [begin, end).
+struct Field {
+    const char *begin;
+    const char *end;
+
+    bool Empty() const {
+        return begin == end;
+    }
+};
+
+// Values decoded from one sentence; applied only once the checksum passes.
+// Negative numbers mean "field absent".
+struct Staged {
+    Type type = Type::kOther;
+    bool has_lat = false;
+    bool has_lon = false;
+    int32_t latitude_e7 = 0;
+    int32_t longitude_e7 = 0;
+    int32_t hhmmss = -1;
+    int32_t ddmmyy = -1;
+    char status = 0;
+    char mode = 0;
+    int32_t quality = -1;
+    int32_t fix_type = -1;
+    int32_t satellites = -1;
+    int32_t hdop_centi = -1;
+    int32_t speed_mm_s = -1;
+    int32_t course_centideg = -1;
+};
+
+Stats stats = {};
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Unsigned decimal scaled by 10^decimals; extra fraction digits are dropped.
+// "12.345" with decimals = 2 gives 1234.
+bool ParseScaled(Field field, int decimals, uint32_t &out) {
+    if (field.Empty()) {
+        return false;
+    }
+    uint32_t value = 0;
+    int fraction = -1;
+    for (const char *p = field.begin; p < field.end; ++p) {
+        if (*p == '.') {
+            if (fraction >= 0) {
+                return false;
+            }
+            fraction = 0;
+            continue;
+        }
+        if (!IsDigit(*p) || value > 429496728u) {
+            return false;
+        }
+        if (fraction < 0) {
+            value = value * 10 + static_cast<uint32_t>(*p - '0');
+        } else if (fraction < decimals) {
+            value = value * 10 + static_cast<uint32_t>(*p - '0');
+            ++fraction;
+        }
+    }
+    for (int i = fraction < 0 ? 0 : fraction; i < decimals; ++i) {
+        value *= 10;
+    }
+    out = value;
+    return true;
+}
+
+// "ddmm.mmmm" / "dddmm.mmmm" to 1e-7 degree, integer-only. Minutes are read
+// to 1e-6 (under 2 mm); 1e-6 minute is 1/6 of 1e-7 degree, so the fraction
+// converts with one rounded division.
+bool ParseCoordinate(Field field, int32_t &e7) {
+    const char *dot = field.begin;
+    while (dot < field.end && *dot != '.') {
+        ++dot;
+    }
+    uint32_t ddmm = 0;
+    uint32_t fraction_e6 = 0;
+    if (!ParseScaled(Field{field.begin, dot}, 0, ddmm) ||
+        (dot < field.end && !ParseScaled(Field{dot, field.end}, 6, fraction_e6)) || ddmm % 100u >= 60u ||
+        ddmm / 100u > 180u) {
+        return false;
+    }
+    const uint32_t minutes_e6 = (ddmm % 100u) * 1000000u + fraction_e6;
+    e7 = static_cast<int32_t>((ddmm / 100u) * static_cast<uint32_t>(kE7PerDegree) + (minutes_e6 + 3u) / 6u);
+    return true;
+}
+
+// Optional numeric field: empty leaves `out` untouched.
+bool ParseOptional(Field field, int decimals, int32_t &out) {
+    if (field.Empty()) {
+        return true;
+    }
+    uint32_t value = 0;
+    if (!ParseScaled(field, decimals, value) || value > 0x7FFFFFFFu) {
+        return false;
+    }
+    out = static_cast<int32_t>(value);
+    return true;
+}
+
+bool ParseHemisphere(Field field, char positive, char negative, int32_t &e7) {
+    if (field.end - field.begin != 1 || (*field.begin != positive && *field.begin != negative)) {
+        return false;
+    }
+    if (*field.begin == negative) {
+        e7 = -e7;
+    }
+    return true;
+}
+
+bool ParseChar(Field field, char &out) {
+    if (field.Empty()) {
+        return true;
+    }
+    if (field.end - field.begin != 1) {
+        return false;
+    }
+    out = *field.begin;
+    return true;
+}
+
+Type SentenceType(Field field) {
+    if (field.end - field.begin != 5) {
+        return Type::kOther;
+    }
+    const char *t = field.begin + 2;  // skip the talker id (GP, GN, GL, ...)
+    if (t[0] == 'G' && t[1] == 'G' && t[2] == 'A') {
+        return Type::kGga;
+    }
+    if (t[0] == 'R' && t[1] == 'M' && t[2] == 'C') {
+        return Type::kRmc;
+    }
+    if (t[0] == 'G' && t[1] == 'S' && t[2] == 'A') {
+        return Type::kGsa;
+    }
+    if (t[0] == 'G' && t[1] == 'S' && t[2] == 'V') {
+        return Type::kGsv;
+    }
+    if (t[0] == 'V' && t[1] == 'T' && t[2] == 'G') {
+        return Type::kVtg;
+    }
+    return Type::kOther;
+}
+
+// 1 kn = 1852 m/h. Clamped so the product stays within 32 bits.
+uint32_t KnotsMilliToMmPerS(uint32_t knots_milli) {
+    if (knots_milli > 2000000u) {
+        knots_milli = 2000000u;
+    }
+    return knots_milli * 1852u / 3600u;
+}
+
+// Empty coordinate fields are allowed (no fix); `present` says which it was.
+bool ParseCoordinateField(Field field, int32_t &e7, bool &present) {
+    present = false;
+    if (field.Empty()) {
+        return true;
+    }
+    present = ParseCoordinate(field, e7);
+    return present;
+}
+
+bool DecodeSpeedKnots(Field field, Staged &staged) {
+    int32_t knots_milli = -1;
+    if (!ParseOptional(field, 3, knots_milli)) {
+        return false;
+    }
+    if (knots_milli >= 0) {
+        staged.speed_mm_s = static_cast<int32_t>(KnotsMilliToMmPerS(static_cast<uint32_t>(knots_milli)));
+    }
+    return true;
+}
+
+bool DecodeCourse(Field field, Staged &staged) {
+    if (!ParseOptional(field, 2, staged.course_centideg)) {
+        return false;
+    }
+    if (staged.course_centideg >= 36000) {
+        staged.course_centideg %= 36000;
+    }
+    return true;
+}
+
+bool DecodeField(Staged &staged, int index, Field field) {
+    if (index == 0) {
+        staged.type = SentenceType(field);
+        return true;
+    }
+
+    switch (staged.type) {
+        case Type::kGga:
+            // time, lat, N/S, lon, E/W, quality, satellites, HDOP, ...
+            switch (index) {
+                case 1: return ParseOptional(field, 0, staged.hhmmss);
+                case 2: return ParseCoordinateField(field, staged.latitude_e7, staged.has_lat);
+                case 3: return !staged.has_lat || ParseHemisphere(field, 'N', 'S', staged.latitude_e7);
+                case 4: return ParseCoordinateField(field, staged.longitude_e7, staged.has_lon);
+                case 5: return !staged.has_lon || ParseHemisphere(field, 'E', 'W', staged.longitude_e7);
+                case 6: return ParseOptional(field, 0, staged.quality);
+                case 7: return ParseOptional(field, 0, staged.satellites);
+                case 8: return ParseOptional(field, 2, staged.hdop_centi);
+                default: return true;
+            }
+        case Type::kRmc:
+            // time, status, lat, N/S, lon, E/W, speed (kn), course, date, ...
+            switch (index) {
+                case 1: return ParseOptional(field, 0, staged.hhmmss);
+                case 2: return ParseChar(field, staged.status);
+                case 3: return ParseCoordinateField(field, staged.latitude_e7, staged.has_lat);
+                case 4: return !staged.has_lat || ParseHemisphere(field, 'N', 'S', staged.latitude_e7);
+                case 5: return ParseCoordinateField(field, staged.longitude_e7, staged.has_lon);
+                case 6: return !staged.has_lon || ParseHemisphere(field, 'E', 'W', staged.longitude_e7);
+                case 7: return DecodeSpeedKnots(field, staged);
+                case 8: return DecodeCourse(field, staged);
+                case 9: return ParseOptional(field, 0, staged.ddmmyy);
+                default: return true;
+            }
+        case Type::kGsa:
+            // mode, fix type, 12 satellite ids, PDOP, HDOP, VDOP
+            if (index == 2) {
+                return ParseOptional(field, 0, staged.fix_type);
+            }
+            if (index == 16) {
+                return ParseOptional(field, 2, staged.hdop_centi);
+            }
+            return true;
+        case Type::kGsv:
+            // message count, message number, satellites in view, ...
+            return index != 3 || ParseOptional(field, 0, staged.satellites);
+        case Type::kVtg:
+            // course T, "T", course M, "M", speed kn, "N", speed km/h, "K", mode
+            switch (index) {
+                case 1: return DecodeCourse(field, staged);
+                case 5: return DecodeSpeedKnots(field, staged);
+                case 7: {
+                    int32_t kmh_milli = -1;
+                    if (!ParseOptional(field, 3, kmh_milli)) {
+                        return false;
+                    }
+                    if (kmh_milli >= 0) {
+                        staged.speed_mm_s = kmh_milli * 10 / 36;
+                    }
+                    return true;
+                }
+                case 9: return ParseChar(field, staged.mode);
+                default: return true;
+            }
+        case Type::kOther:
+            return true;
+    }
+    return true;
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+void PutDigits(char *out, uint32_t value, int digits) {
+    for (int i = digits - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// "YYYYMMDD HHMMSS" from RMC's hhmmss and ddmmyy.
+bool FormatDatetime(uint32_t hhmmss, uint32_t ddmmyy, char *out) {
+    const uint32_t hour = hhmmss / 10000;
+    const uint32_t minute = hhmmss / 100 % 100;
+    const uint32_t second = hhmmss % 100;
+    const uint32_t day = ddmmyy / 10000;
+    const uint32_t month = ddmmyy / 100 % 100;
+    const uint32_t year = 2000 + ddmmyy % 100;
+    if (hour > 23 || minute > 59 || second > 60 || day < 1 || day > 31 || month < 1 || month > 12) {
+        return false;
+    }
+    PutDigits(out, year, 4);
+    PutDigits(out + 4, month, 2);
+    PutDigits(out + 6, day, 2);
+    out[8] = ' ';
+    PutDigits(out + 9, hour, 2);
+    PutDigits(out + 11, minute, 2);
+    PutDigits(out + 13, second, 2);
+    out[15] = '\0';
+    return true;
+}
+
+void ApplyMotion(const Staged &staged, app::model::GpsData &data) {
+    if (staged.speed_mm_s >= 0) {
+        data.speed_mm_s = static_cast<uint32_t>(staged.speed_mm_s);
+        data.motion_valid = true;
+    }
+    if (staged.course_centideg >= 0) {
+        data.course_centideg = static_cast<uint16_t>(staged.course_centideg);
+    }
+}
+
+uint16_t Hdop(int32_t centi) {
+    return static_cast<uint16_t>(centi > 0xFFFF ? 0xFFFF : centi);
+}
+
+void Apply(const Staged &staged, app::model::GpsData &data) {
+    switch (staged.type) {
+        case Type::kGga:
+            data.fix = staged.quality > 0;
+            if (data.fix && staged.has_lat && staged.has_lon) {
+                data.latitude_e7 = staged.latitude_e7;
+                data.longitude_e7 = staged.longitude_e7;
+            }
+            if (staged.satellites >= 0) {
+                data.satellites_used = static_cast<uint8_t>(staged.satellites > 0xFF ? 0xFF : staged.satellites);
+            }
+            if (staged.hdop_centi >= 0) {
+                data.hdop_centi = Hdop(staged.hdop_centi);
+            }
+            break;
+        case Type::kRmc:
+            if (staged.status != 'A') {
+                data.fix = false;
+                data.datetime_valid = false;
+                data.motion_valid = false;
+                break;
+            }
+            if (staged.has_lat && staged.has_lon) {
+                data.latitude_e7 = staged.latitude_e7;
+                data.longitude_e7 = staged.longitude_e7;
+                data.fix = true;
+            }
+            data.datetime_valid = staged.hhmmss >= 0 && staged.ddmmyy >= 0 &&
+                                  FormatDatetime(static_cast<uint32_t>(staged.hhmmss),
+                                                 static_cast<uint32_t>(staged.ddmmyy), data.datetime);
+            ApplyMotion(staged, data);
+            break;
+        case Type::kGsa:
+            if (staged.fix_type >= 0) {
+                data.fix_type = static_cast<uint8_t>(staged.fix_type);
+            }
+            if (staged.hdop_centi >= 0) {
+                data.hdop_centi = Hdop(staged.hdop_centi);
+            }
+            break;
+        case Type::kGsv:
+            if (staged.satellites >= 0) {
+                data.satellites_in_view = static_cast<uint8_t>(staged.satellites > 0xFF ? 0xFF : staged.satellites);
+            }
+            break;
+        case Type::kVtg:
+            if (staged.mode == 'N') {
+                data.motion_valid = false;
+                break;
+            }
+            ApplyMotion(staged, data);
+            break;
+        case Type::kOther:
+            break;
+    }
+}
+
+}  // namespace
+
+Result Parse(const char *line, std::size_t len, app::model::GpsData &data) {
+    const char *p = line;
+    const char *const end = line + len;
+    if (len < 7 || *p != '$') {
+        ++stats.malformed;
+        return Result::kMalformed;
+    }
+    ++p;
+
+    // One pass: XOR into the checksum and cut fields at each comma.
+    Staged staged;
+    uint8_t checksum = 0;
+    int index = 0;
+    bool fields_ok = true;
+    const char *field_begin = p;
+    for (; p < end && *p != '*'; ++p) {
+        checksum ^= static_cast<uint8_t>(*p);
+        if (*p == ',') {
+            fields_ok = DecodeField(staged, index++, Field{field_begin, p}) && fields_ok;
+            field_begin = p + 1;
+        }
+    }
+    if (end - p != 3) {
+        ++stats.bad_checksum;
+        return Result::kBadChecksum;
+    }
+    fields_ok = DecodeField(staged, index, Field{field_begin, p}) && fields_ok;
+
+    const int high = HexValue(p[1]);
+    const int low = HexValue(p[2]);
+    if (high < 0 || low < 0 || ((high << 4) | low) != checksum) {
+        ++stats.bad_checksum;
+        return Result::kBadChecksum;
+    }
+    if (!fields_ok) {
+        ++stats.malformed;
+        return Result::kMalformed;
+    }
+    if (staged.type == Type::kOther) {
+        ++stats.ignored;
+        return Result::kIgnored;
+    }
+
+    Apply(staged, data);
+    ++stats.applied;
+    return Result::kApplied;
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace nmea
+}  // namespace gps
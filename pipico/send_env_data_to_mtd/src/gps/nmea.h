@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "app/measurement_types.h"
+
+// Single-pass NMEA 0183 parser. One walk over the sentence computes the
+// checksum and decodes the fields in place (no copy, no strtok, no atof);
+// decoded values are staged and only applied to GpsData once the *hh
+// checksum matches. Handles GGA, RMC, GSA, GSV and VTG from any talker.
+namespace gps {
+namespace nmea {
+
+enum class Result {
+    kApplied,      // known sentence, checksum good, data updated
+    kIgnored,      // well formed but not a sentence we decode
+    kBadChecksum,  // checksum missing or wrong; data untouched
+    kMalformed,    // framing or field syntax error; data untouched
+};
+
+struct Stats {
+    uint32_t applied;
+    uint32_t ignored;
+    uint32_t bad_checksum;
+    uint32_t malformed;
+};
+
+// `line` is one sentence from '$' up to (not including) CR/LF.
+Result Parse(const char *line, std::size_t len, app::model::GpsData &data);
+
+const Stats &GetStats();
+
+}  // namespace nmea
+}  // namespace gps
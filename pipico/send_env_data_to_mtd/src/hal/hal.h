@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Thin hardware-abstraction layer. Drivers talk to the bus, UARTs, GPIO and
+// the clock only through these calls; hal_pico.cpp maps them onto the Pico
+// SDK and host/sim maps them onto simulated devices and a virtual clock.
+namespace hal {
+
+// Console. Never on a UART: both carry traffic (mesh telemetry, GPS), and
+// the mesh UART's flow control would stall console writes.
+void StdioInit();
+void StdioFlush();
+
+// Time
+uint64_t TimeUs();
+void SleepMs(uint32_t ms);
+void SleepUs(uint64_t us);
+
+// One-shot timer alarms against TimeUs(), one per user. The callback runs
+// in interrupt context; WaitForEvent() returns after it (or any other
+// event) fires.
+enum Alarm : unsigned {
+    kAlarmScheduler,
+    kAlarmI2c,  // i2c transaction timeouts and retry backoff
+    kAlarmCount,
+};
+void AlarmInit(Alarm alarm, void (*callback)());
+// Returns false if `at_us` has already passed, in which case nothing fires.
+// A new target replaces the previous one.
+bool AlarmSetTarget(Alarm alarm, uint64_t at_us);
+void AlarmCancel(Alarm alarm);
+// Runs the callback at once, in interrupt context on core0 (the core that
+// called AlarmInit()), as if the target had passed; the target is dropped.
+// Safe from either core.
+void AlarmTrigger(Alarm alarm);
+void WaitForEvent();
+
+// WaitForEvent() for a wait that should last until `wake_us`, when an
+// alarm is due. With app::config::LOW_POWER_IDLE, a gap of at least
+// LOW_POWER_MIN_SLEEP_US with no I2C transfer in flight lets the chip
+// into its sleep state: once core1 waits too, the clocks of everything
+// but the timer, UARTs, memories and bus fabric stop. The oscillators and
+// PLLs keep running, so any interrupt (the alarm, a GPS byte) wakes it with
+// every clock as it was and the UARTs never miss a byte.
+void IdleUntil(uint64_t wake_us);
+// Boot, before the first IdleUntil(): sets which clocks stop in the sleep
+// state. Does nothing without LOW_POWER_IDLE.
+void LowPowerInit();
+
+// Wake latency is measured on the chip only; the simulator does not model
+// it and leaves it 0.
+struct SleepStats {
+    uint32_t sleeps;                // core0 waits that let the chip sleep
+    uint64_t asleep_us;             // with both cores waiting, i.e. in the sleep state
+    uint32_t timed_wakes;           // woken by the alarm, not another interrupt
+    uint64_t wake_latency_total_us; // alarm target to running again, over those
+    uint32_t wake_latency_max_us;
+};
+const SleepStats &GetSleepStats();
+
+// Critical section against interrupt handlers and against the other core.
+// Not reentrant; keep it to a few dozen instructions. CriticalInit() claims
+// its spinlock; call it at boot before any interrupt is enabled.
+void CriticalInit();
+uint32_t CriticalEnter();
+void CriticalExit(uint32_t state);
+
+// Second core. `service` runs on core1 and is called again after every
+// event, so it must return once it has no more work. SignalEvent() wakes
+// whichever core is in WaitForEvent().
+void Core1Launch(void (*service)());
+void SignalEvent();
+// 0 or 1: the core the caller runs on.
+unsigned CoreNum();
+
+// GPIO
+void GpioInitOutput(unsigned pin);
+void GpioPut(unsigned pin, bool value);
+
+// I2C. Return values follow the SDK's i2c_*_timeout_us calls: the number
+// of bytes transferred, or one of the negative codes below.
+constexpr int kI2cTimeout = -1;   // PICO_ERROR_TIMEOUT
+constexpr int kI2cNack = -2;      // PICO_ERROR_GENERIC: address or data NACK
+constexpr int kI2cBusError = -6;  // PICO_ERROR_IO: arbitration lost, bus fault
+void I2cInit(unsigned port, unsigned sda_pin, unsigned scl_pin, uint32_t baud_hz);
+// Changes SCL between transfers, never during one, to the nearest rate the
+// controller's dividers give.
+void I2cSetClock(unsigned port, uint32_t baud_hz);
+// Blocking, but given up after `timeout_us` so a target holding the bus
+// cannot hang the caller.
+int I2cWrite(unsigned port, uint8_t addr, const uint8_t *src, std::size_t len, bool nostop, uint32_t timeout_us);
+int I2cRead(unsigned port, uint8_t addr, uint8_t *dst, std::size_t len, bool nostop, uint32_t timeout_us);
+
+// DMA-driven transfer: write `tx_len` bytes, then, if `rx_len` > 0, a
+// repeated START and a read of `rx_len` bytes, then STOP. `done` runs in
+// interrupt context with the byte count of the last phase or a negative
+// code. One transfer per port may be in flight; returns false if the port
+// is busy. Buffers must stay valid until `done` runs. The caller times the
+// transfer out: a target stretching SCL or holding SDA low stops it
+// indefinitely.
+using I2cDoneFn = void (*)(int result, void *context);
+bool I2cTransferAsync(unsigned port, uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx,
+                      std::size_t rx_len, I2cDoneFn done, void *context);
+// Stops the transfer in flight without calling its `done`.
+void I2cAbort(unsigned port);
+// Bus recovery (I2C spec 3.1.16): with the controller off, clocks SCL up to
+// nine times until a target that was part-way through sending releases
+// SDA, then makes a STOP and hands the pins back. Returns false if SDA is
+// still held low.
+bool I2cRecoverBus(unsigned port);
+
+// UART
+void UartInit(unsigned port, uint32_t baud, unsigned tx_pin, unsigned rx_pin);
+bool UartReadable(unsigned port);
+char UartGetc(unsigned port);
+void UartPuts(unsigned port, const char *text);
+void UartWrite(unsigned port, const uint8_t *data, std::size_t len);
+// Run `handler` in interrupt context whenever received bytes are waiting
+// (RX FIFO level or receive timeout); it drains them with UartGetc().
+void UartSetRxHandler(unsigned port, void (*handler)());
+// Returns and clears the hardware FIFO overrun flag: bytes arrived while
+// the RX FIFO was full and were lost.
+bool UartTakeOverrun(unsigned port);
+// Transmit flow control: the UART only sends while the receiver holds
+// `cts_pin` low. The pin is pulled up, so an unpowered or unplugged
+// receiver reads as not ready.
+void UartEnableCts(unsigned port, unsigned cts_pin);
+// True while the receiver asserts CTS; always true without UartEnableCts().
+bool UartClearToSend(unsigned port);
+
+// On-board flash, addressed by byte offset from its start. Erase works on
+// whole sectors and leaves them 0xFF; programming works on whole pages and
+// can only clear bits. Both return false for misaligned ranges. While they
+// run, execution from flash stops on both cores with interrupts held off:
+// about 1 ms per page programmed and 50 ms per sector erased. What a UART
+// with an RX handler receives meanwhile is kept for the handler.
+constexpr uint32_t kFlashSectorBytes = 4096;
+constexpr uint32_t kFlashPageBytes = 256;
+void FlashRead(uint32_t offset, void *dst, std::size_t len);
+bool FlashErase(uint32_t offset, std::size_t len);
+bool FlashProgram(uint32_t offset, const void *src, std::size_t len);
+
+// Watchdog. Once started it resets the chip unless WatchdogFeed() comes
+// within `timeout_ms`; it stops counting while a debugger halts the cores.
+// The scratch registers and the retained RAM keep their contents through
+// that reset, but not through a power cycle. Only two scratch registers are
+// ours: the SDK and the boot ROM use the others.
+void WatchdogStart(uint32_t timeout_ms);
+void WatchdogFeed();
+// True if this boot follows a reset by the watchdog started above.
+bool WatchdogCausedReset();
+constexpr std::size_t kWatchdogScratchWords = 2;
+void WatchdogScratchWrite(std::size_t index, uint32_t value);
+uint32_t WatchdogScratchRead(std::size_t index);
+// RAM the C runtime leaves alone at start-up: garbage after power-up.
+constexpr std::size_t kRetainedRamBytes = 1024;
+uint8_t *RetainedRam();
+
+}  // namespace hal
@@ -0,0 +1,646 @@
+#include "hal/hal.h"
+
+#include <cstring>
+
+#include "app/app_config.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/structs/clocks.h"
+#include "hardware/structs/scb.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/uart.h"
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+
+namespace hal {
+
+namespace {
+
+i2c_inst_t *I2cInstance(unsigned port) {
+    return port == 0 ? i2c0 : i2c1;
+}
+
+uart_inst_t *UartInstance(unsigned port) {
+    return port == 0 ? uart0 : uart1;
+}
+
+// State of the DMA transfer in flight on each I2C port. The TX channel
+// streams IC_DATA_CMD words (data bytes, then read commands carrying the
+// RESTART/STOP flags), the RX channel drains received bytes, and the
+// STOP_DET interrupt reports completion.
+constexpr std::size_t kMaxAsyncWords = 1 + 512 + 16;
+
+struct I2cAsync {
+    int tx_dma = -1;
+    int rx_dma = -1;
+    uint16_t commands[kMaxAsyncWords];
+    I2cDoneFn done = nullptr;
+    void *context = nullptr;
+    int length = 0;
+    volatile bool active = false;
+    int error = 0;  // hal::kI2cNack or kI2cBusError once the controller aborts
+};
+
+I2cAsync i2c_async[2];
+
+// What I2cRecoverBus() needs to take the pins over and set the port up
+// again, at the last clock set.
+struct I2cPort {
+    unsigned sda_pin = 0;
+    unsigned scl_pin = 0;
+    uint32_t baud_hz = 0;
+};
+
+I2cPort i2c_ports[2];
+
+void I2cIrq(unsigned port) {
+    i2c_hw_t *hw = i2c_get_hw(I2cInstance(port));
+    I2cAsync &state = i2c_async[port];
+    const uint32_t status = hw->intr_stat;
+
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NACK or arbitration loss: the controller flushes its TX FIFO and
+        // sends STOP; stop feeding it before clearing the abort.
+        const uint32_t source = hw->tx_abrt_source;
+        constexpr uint32_t kNackBits = I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS |
+                                       I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS;
+        state.error = (source & kNackBits) != 0 ? kI2cNack : kI2cBusError;
+        dma_channel_abort(static_cast<uint>(state.tx_dma));
+        dma_channel_abort(static_cast<uint>(state.rx_dma));
+        (void)hw->clr_tx_abrt;
+    }
+    if (!(status & I2C_IC_INTR_STAT_R_STOP_DET_BITS)) {
+        return;
+    }
+    (void)hw->clr_stop_det;
+    if (!state.active) {
+        return;
+    }
+
+    // The last byte reaches the RX FIFO before STOP; let the DMA drain it.
+    while (state.error == 0 && dma_channel_is_busy(static_cast<uint>(state.rx_dma))) {
+    }
+    hw->intr_mask = 0;
+    state.active = false;
+    state.done(state.error != 0 ? state.error : state.length, state.context);
+    // Core1 may be waiting on a transfer it queued.
+    __sev();
+}
+
+void I2c0Irq() {
+    I2cIrq(0);
+}
+
+void I2c1Irq() {
+    I2cIrq(1);
+}
+
+void (*uart_rx_handlers[2])() = {nullptr, nullptr};
+
+// A flash write holds interrupts off on both cores for up to a sector
+// erase (50-400 ms) while the 32-byte RX FIFO lasts 33 ms at 9600 baud. So
+// for each UART with an RX handler a DMA channel, which runs on regardless,
+// moves what the FIFO holds and what arrives into RAM for the length of
+// the write, and UartGetc() hands that out ahead of the FIFO. The buffer is
+// filled only while both cores are held and emptied only while neither is,
+// so the two never overlap. Its bytes go to the handler at the next RX
+// interrupt, which after the end of a GPS burst is the next burst.
+constexpr std::size_t kRxBridgeBytes = 512;  // 530 ms at 9600 baud
+
+struct RxBridge {
+    int channel = -1;
+    std::size_t filled = 0;
+    std::size_t taken = 0;
+    uint8_t buffer[kRxBridgeBytes];
+};
+RxBridge rx_bridges[2];
+
+void Uart0Irq() {
+    uart_rx_handlers[0]();
+}
+
+void Uart1Irq() {
+    uart_rx_handlers[1]();
+}
+
+spin_lock_t *critical_lock = nullptr;
+void (*core1_service)() = nullptr;
+
+#if PICO_RP2040
+constexpr uint32_t kScrSleepDeep = M0PLUS_SCR_SLEEPDEEP_BITS;
+#else
+constexpr uint32_t kScrSleepDeep = M33_SCR_SLEEPDEEP_BITS;
+#endif
+
+SleepStats sleep_stats = {};
+// The chip is only in its sleep state while both cores wait with SLEEPDEEP
+// set, so only that overlap counts as asleep: a bit per core, and when the
+// second one went down. Both under critical_lock.
+uint32_t cores_down = 0;
+uint64_t both_down_since_us = 0;
+
+void DeepWait() {
+    uint32_t state = spin_lock_blocking(critical_lock);
+    cores_down |= 1u << get_core_num();
+    if (cores_down == 3u) {
+        both_down_since_us = time_us_64();
+    }
+    spin_unlock(critical_lock, state);
+
+    scb_hw->scr |= kScrSleepDeep;
+    __wfe();
+    scb_hw->scr &= ~kScrSleepDeep;
+
+    state = spin_lock_blocking(critical_lock);
+    if (cores_down == 3u) {
+        sleep_stats.asleep_us += time_us_64() - both_down_since_us;
+    }
+    cores_down &= ~(1u << get_core_num());
+    spin_unlock(critical_lock, state);
+}
+
+bool I2cIdle() {
+    return !i2c_async[0].active && !i2c_async[1].active;
+}
+
+// The chip sleeps once both cores wait with SLEEPDEEP set, and only then
+// are the SLEEP_EN clocks the only ones running. Gated: what the firmware
+// never uses, and I2C and DMA, which neither core lets go of mid-transfer.
+// The timer, UARTs, SIO (the cores' FIFOs and spinlocks), memories and
+// bus fabric keep their clocks. On wake the WAKE_EN set is back at once.
+void GateClocksInSleep() {
+    clocks_hw->sleep_en0 &= ~(CLOCKS_SLEEP_EN0_CLK_SYS_ADC_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS |
+                              CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PIO1_BITS |
+                              CLOCKS_SLEEP_EN0_CLK_SYS_JTAG_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_I2C0_BITS |
+                              CLOCKS_SLEEP_EN0_CLK_SYS_I2C1_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS);
+    clocks_hw->sleep_en1 &= ~(CLOCKS_SLEEP_EN1_CLK_SYS_SPI0_BITS | CLOCKS_SLEEP_EN1_CLK_PERI_SPI0_BITS |
+                              CLOCKS_SLEEP_EN1_CLK_SYS_SPI1_BITS | CLOCKS_SLEEP_EN1_CLK_PERI_SPI1_BITS |
+                              CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS);
+}
+
+// Core1 always offers to sleep when it has nothing to do; core0, which
+// knows when the next job is, decides whether the chip does.
+void Core1Entry() {
+    flash_safe_execute_core_init();
+    while (true) {
+        core1_service();
+        if (app::config::LOW_POWER_IDLE && I2cIdle()) {
+            DeepWait();
+        } else {
+            __wfe();
+        }
+    }
+}
+
+int alarm_nums[kAlarmCount] = {-1, -1};
+void (*alarm_callbacks[kAlarmCount])() = {};
+
+void OnAlarm(uint alarm_num) {
+    for (unsigned i = 0; i < kAlarmCount; ++i) {
+        if (alarm_nums[i] == static_cast<int>(alarm_num) && alarm_callbacks[i] != nullptr) {
+            alarm_callbacks[i]();
+        }
+    }
+    // Latch an event so a WFE issued just after this IRQ still returns.
+    __sev();
+}
+
+}  // namespace
+
+void StdioInit() {
+    stdio_init_all();
+}
+
+void StdioFlush() {
+    stdio_flush();
+}
+
+uint64_t TimeUs() {
+    return time_us_64();
+}
+
+void SleepMs(uint32_t ms) {
+    sleep_ms(ms);
+}
+
+void SleepUs(uint64_t us) {
+    sleep_us(us);
+}
+
+void AlarmInit(Alarm alarm, void (*callback)()) {
+    alarm_callbacks[alarm] = callback;
+    if (alarm_nums[alarm] < 0) {
+        alarm_nums[alarm] = hardware_alarm_claim_unused(true);
+        hardware_alarm_set_callback(static_cast<uint>(alarm_nums[alarm]), OnAlarm);
+    }
+}
+
+bool AlarmSetTarget(Alarm alarm, uint64_t at_us) {
+    // hardware_alarm_set_target() returns true when the target is already missed.
+    return !hardware_alarm_set_target(static_cast<uint>(alarm_nums[alarm]), from_us_since_boot(at_us));
+}
+
+void AlarmCancel(Alarm alarm) {
+    hardware_alarm_cancel(static_cast<uint>(alarm_nums[alarm]));
+}
+
+// The SDK's IRQ handler only runs the callback for a target whose high word
+// has come, so point the target at now before forcing the IRQ.
+void AlarmTrigger(Alarm alarm) {
+    const uint num = static_cast<uint>(alarm_nums[alarm]);
+    if (hardware_alarm_set_target(num, from_us_since_boot(time_us_64()))) {
+        hardware_alarm_force_irq(num);
+    }
+}
+
+void WaitForEvent() {
+    __wfe();
+}
+
+// An interrupt between the checks and the WFE (an I2C retry starting, say)
+// ends with __sev(), so the WFE returns at once rather than sleeping on it.
+void IdleUntil(uint64_t wake_us) {
+    const uint64_t start = time_us_64();
+    if (!app::config::LOW_POWER_IDLE || wake_us < start + app::config::LOW_POWER_MIN_SLEEP_US || !I2cIdle()) {
+        __wfe();
+        return;
+    }
+    DeepWait();
+
+    const uint64_t woke = time_us_64();
+    ++sleep_stats.sleeps;
+    if (woke >= wake_us) {
+        const uint32_t latency = static_cast<uint32_t>(woke - wake_us);
+        ++sleep_stats.timed_wakes;
+        sleep_stats.wake_latency_total_us += latency;
+        if (latency > sleep_stats.wake_latency_max_us) {
+            sleep_stats.wake_latency_max_us = latency;
+        }
+    }
+}
+
+const SleepStats &GetSleepStats() {
+    return sleep_stats;
+}
+
+void LowPowerInit() {
+    if (app::config::LOW_POWER_IDLE) {
+        GateClocksInSleep();
+    }
+}
+
+void CriticalInit() {
+    critical_lock = spin_lock_init(static_cast<uint>(spin_lock_claim_unused(true)));
+}
+
+uint32_t CriticalEnter() {
+    return spin_lock_blocking(critical_lock);
+}
+
+void CriticalExit(uint32_t state) {
+    spin_unlock(critical_lock, state);
+}
+
+void Core1Launch(void (*service)()) {
+    core1_service = service;
+    // Either core may write flash (calibration on core0, the telemetry
+    // backlog on core1); each must be able to park the other.
+    flash_safe_execute_core_init();
+    multicore_launch_core1(Core1Entry);
+}
+
+void SignalEvent() {
+    __sev();
+}
+
+unsigned CoreNum() {
+    return get_core_num();
+}
+
+void GpioInitOutput(unsigned pin) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+}
+
+void GpioPut(unsigned pin, bool value) {
+    gpio_put(pin, value);
+}
+
+void I2cInit(unsigned port, unsigned sda_pin, unsigned scl_pin, uint32_t baud_hz) {
+    i2c_ports[port] = {sda_pin, scl_pin, baud_hz};
+    i2c_init(I2cInstance(port), baud_hz);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+
+    I2cAsync &state = i2c_async[port];
+    if (state.tx_dma < 0) {
+        state.tx_dma = dma_claim_unused_channel(true);
+        state.rx_dma = dma_claim_unused_channel(true);
+        // The blocking SDK calls poll the raw status, so the interrupt is
+        // only unmasked while an asynchronous transfer is running.
+        i2c_get_hw(I2cInstance(port))->intr_mask = 0;
+        const uint irq = port == 0 ? I2C0_IRQ : I2C1_IRQ;
+        irq_set_exclusive_handler(irq, port == 0 ? I2c0Irq : I2c1Irq);
+        irq_set_enabled(irq, true);
+    }
+}
+
+void I2cSetClock(unsigned port, uint32_t baud_hz) {
+    // Also sets the spike filter and SDA hold time for the new rate.
+    i2c_set_baudrate(I2cInstance(port), baud_hz);
+    i2c_ports[port].baud_hz = baud_hz;
+}
+
+int I2cWrite(unsigned port, uint8_t addr, const uint8_t *src, std::size_t len, bool nostop, uint32_t timeout_us) {
+    return i2c_write_timeout_us(I2cInstance(port), addr, src, len, nostop, timeout_us);
+}
+
+int I2cRead(unsigned port, uint8_t addr, uint8_t *dst, std::size_t len, bool nostop, uint32_t timeout_us) {
+    return i2c_read_timeout_us(I2cInstance(port), addr, dst, len, nostop, timeout_us);
+}
+
+bool I2cTransferAsync(unsigned port, uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx,
+                      std::size_t rx_len, I2cDoneFn done, void *context) {
+    I2cAsync &state = i2c_async[port];
+    const std::size_t words = tx_len + rx_len;
+    if (state.active || state.tx_dma < 0 || words == 0 || words > kMaxAsyncWords) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < tx_len; ++i) {
+        state.commands[i] = tx[i];
+    }
+    for (std::size_t i = 0; i < rx_len; ++i) {
+        uint16_t command = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0 && tx_len > 0) {
+            command |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        state.commands[tx_len + i] = command;
+    }
+    state.commands[words - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    i2c_inst_t *i2c = I2cInstance(port);
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_intr;
+
+    state.done = done;
+    state.context = context;
+    state.length = static_cast<int>(rx_len > 0 ? rx_len : tx_len);
+    state.error = 0;
+    state.active = true;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    if (rx_len > 0) {
+        dma_channel_config rx_config = dma_channel_get_default_config(static_cast<uint>(state.rx_dma));
+        channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&rx_config, false);
+        channel_config_set_write_increment(&rx_config, true);
+        channel_config_set_dreq(&rx_config, i2c_get_dreq(i2c, false));
+        dma_channel_configure(static_cast<uint>(state.rx_dma), &rx_config, rx, &hw->data_cmd, rx_len, true);
+    }
+
+    dma_channel_config tx_config = dma_channel_get_default_config(static_cast<uint>(state.tx_dma));
+    channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_16);
+    channel_config_set_read_increment(&tx_config, true);
+    channel_config_set_write_increment(&tx_config, false);
+    channel_config_set_dreq(&tx_config, i2c_get_dreq(i2c, true));
+    dma_channel_configure(static_cast<uint>(state.tx_dma), &tx_config, &hw->data_cmd, state.commands, words, true);
+    return true;
+}
+
+void I2cAbort(unsigned port) {
+    I2cAsync &state = i2c_async[port];
+    i2c_hw_t *hw = i2c_get_hw(I2cInstance(port));
+    hw->intr_mask = 0;
+    state.active = false;
+    if (state.tx_dma >= 0) {
+        dma_channel_abort(static_cast<uint>(state.tx_dma));
+        dma_channel_abort(static_cast<uint>(state.rx_dma));
+    }
+    // STOP and flush, as far as the bus lets the controller; the next
+    // transfer clears the resulting abort.
+    hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+}
+
+bool I2cRecoverBus(unsigned port) {
+    const I2cPort pins = i2c_ports[port];
+    if (pins.baud_hz == 0) {
+        return false;
+    }
+    I2cAbort(port);
+    i2c_deinit(I2cInstance(port));
+
+    // Open drain by hand: a pin is pulled low as an output driving 0 and
+    // released as an input, where the pull-up takes it high.
+    const uint32_t half_period_us = 500000 / pins.baud_hz + 1;
+    for (unsigned pin : {pins.sda_pin, pins.scl_pin}) {
+        gpio_init(pin);
+        gpio_pull_up(pin);
+        gpio_put(pin, false);
+    }
+    for (int pulse = 0; pulse < 9 && !gpio_get(pins.sda_pin); ++pulse) {
+        gpio_set_dir(pins.scl_pin, GPIO_OUT);
+        busy_wait_us_32(half_period_us);
+        gpio_set_dir(pins.scl_pin, GPIO_IN);
+        busy_wait_us_32(half_period_us);
+    }
+    // START then STOP with SCL high resets every target's bus logic.
+    gpio_set_dir(pins.sda_pin, GPIO_OUT);
+    busy_wait_us_32(half_period_us);
+    gpio_set_dir(pins.sda_pin, GPIO_IN);
+    busy_wait_us_32(half_period_us);
+    const bool released = gpio_get(pins.sda_pin);
+
+    I2cInit(port, pins.sda_pin, pins.scl_pin, pins.baud_hz);
+    return released;
+}
+
+void UartInit(unsigned port, uint32_t baud, unsigned tx_pin, unsigned rx_pin) {
+    uart_inst_t *uart = UartInstance(port);
+    uart_init(uart, baud);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(uart, true);
+}
+
+bool UartReadable(unsigned port) {
+    const RxBridge &bridge = rx_bridges[port];
+    return bridge.taken < bridge.filled || uart_is_readable(UartInstance(port));
+}
+
+char UartGetc(unsigned port) {
+    RxBridge &bridge = rx_bridges[port];
+    if (bridge.taken < bridge.filled) {
+        return static_cast<char>(bridge.buffer[bridge.taken++]);
+    }
+    return uart_getc(UartInstance(port));
+}
+
+void UartPuts(unsigned port, const char *text) {
+    uart_puts(UartInstance(port), text);
+}
+
+void UartWrite(unsigned port, const uint8_t *data, std::size_t len) {
+    uart_write_blocking(UartInstance(port), data, len);
+}
+
+void UartSetRxHandler(unsigned port, void (*handler)()) {
+    uart_rx_handlers[port] = handler;
+    if (rx_bridges[port].channel < 0) {
+        rx_bridges[port].channel = dma_claim_unused_channel(true);
+    }
+    const uint irq = port == 0 ? UART0_IRQ : UART1_IRQ;
+    irq_set_exclusive_handler(irq, port == 0 ? Uart0Irq : Uart1Irq);
+    irq_set_enabled(irq, true);
+    // RX level (half full) and receive-timeout interrupts; no TX interrupt.
+    uart_set_irq_enables(UartInstance(port), true, false);
+}
+
+bool UartTakeOverrun(unsigned port) {
+    uart_hw_t *hw = uart_get_hw(UartInstance(port));
+    if (!(hw->rsr & UART_UARTRSR_OE_BITS)) {
+        return false;
+    }
+    hw->rsr = UART_UARTRSR_OE_BITS;  // any write clears the error flags
+    return true;
+}
+
+void UartEnableCts(unsigned port, unsigned cts_pin) {
+    gpio_set_function(cts_pin, GPIO_FUNC_UART);
+    gpio_pull_up(cts_pin);
+    uart_set_hw_flow(UartInstance(port), true, false);
+}
+
+bool UartClearToSend(unsigned port) {
+    uart_hw_t *hw = uart_get_hw(UartInstance(port));
+    // FR.CTS mirrors the pin even with flow control off; only trust it when on.
+    return !(hw->cr & UART_UARTCR_CTSEN_BITS) || (hw->fr & UART_UARTFR_CTS_BITS);
+}
+
+namespace {
+// Generous: the other core only has to reach its lockout handler.
+constexpr uint32_t kFlashLockoutTimeoutMs = 100;
+
+struct FlashOp {
+    uint32_t offset;
+    const void *src;
+    std::size_t len;
+};
+
+// Both run inside the flash operation, with both cores held.
+void RxBridgeStart() {
+    for (unsigned port = 0; port < 2; ++port) {
+        RxBridge &bridge = rx_bridges[port];
+        if (bridge.channel < 0) {
+            continue;
+        }
+        if (bridge.taken == bridge.filled) {
+            bridge.taken = bridge.filled = 0;
+        }
+        uart_inst_t *uart = UartInstance(port);
+        dma_channel_config config = dma_channel_get_default_config(bridge.channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, uart_get_dreq(uart, false));
+        dma_channel_configure(bridge.channel, &config, bridge.buffer + bridge.filled, &uart_get_hw(uart)->dr,
+                              kRxBridgeBytes - bridge.filled, true);
+    }
+}
+
+void RxBridgeStop() {
+    for (RxBridge &bridge : rx_bridges) {
+        if (bridge.channel < 0) {
+            continue;
+        }
+        dma_channel_abort(bridge.channel);
+        bridge.filled = kRxBridgeBytes - dma_channel_hw_addr(bridge.channel)->transfer_count;
+    }
+}
+
+void EraseOp(void *param) {
+    const FlashOp *op = static_cast<const FlashOp *>(param);
+    RxBridgeStart();
+    flash_range_erase(op->offset, op->len);
+    RxBridgeStop();
+}
+
+void ProgramOp(void *param) {
+    const FlashOp *op = static_cast<const FlashOp *>(param);
+    RxBridgeStart();
+    flash_range_program(op->offset, static_cast<const uint8_t *>(op->src), op->len);
+    RxBridgeStop();
+}
+
+bool InFlash(uint32_t offset, std::size_t len) {
+    return offset <= PICO_FLASH_SIZE_BYTES && len <= PICO_FLASH_SIZE_BYTES - offset;
+}
+
+}  // namespace
+
+void FlashRead(uint32_t offset, void *dst, std::size_t len) {
+    // flash_range_erase/program flush the XIP cache, so the mapped view is
+    // current.
+    std::memcpy(dst, reinterpret_cast<const void *>(XIP_BASE + offset), len);
+}
+
+bool FlashErase(uint32_t offset, std::size_t len) {
+    if (offset % kFlashSectorBytes != 0 || len % kFlashSectorBytes != 0 || !InFlash(offset, len)) {
+        return false;
+    }
+    FlashOp op = {offset, nullptr, len};
+    return flash_safe_execute(EraseOp, &op, kFlashLockoutTimeoutMs) == PICO_OK;
+}
+
+// `src` must not be in flash itself: it is unreadable while the write runs.
+bool FlashProgram(uint32_t offset, const void *src, std::size_t len) {
+    if (offset % kFlashPageBytes != 0 || len % kFlashPageBytes != 0 || !InFlash(offset, len)) {
+        return false;
+    }
+    FlashOp op = {offset, src, len};
+    return flash_safe_execute(ProgramOp, &op, kFlashLockoutTimeoutMs) == PICO_OK;
+}
+
+namespace {
+// In .uninitialized_data, which crt0 neither loads nor zeroes.
+alignas(8) uint8_t __uninitialized_ram(retained_ram)[kRetainedRamBytes];
+}  // namespace
+
+void WatchdogStart(uint32_t timeout_ms) {
+    watchdog_enable(timeout_ms, true);
+}
+
+void WatchdogFeed() {
+    watchdog_update();
+}
+
+// watchdog_caused_reboot() also counts watchdog_reboot() and the boot
+// ROM's own reboots; only watchdog_enable() leaves this marker.
+bool WatchdogCausedReset() {
+    return watchdog_enable_caused_reboot();
+}
+
+void WatchdogScratchWrite(std::size_t index, uint32_t value) {
+    watchdog_hw->scratch[index] = value;
+}
+
+uint32_t WatchdogScratchRead(std::size_t index) {
+    return watchdog_hw->scratch[index];
+}
+
+uint8_t *RetainedRam() {
+    return retained_ram;
+}
+
+}  // namespace hal
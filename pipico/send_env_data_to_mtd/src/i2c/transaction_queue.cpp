@@ -0,0 +1,321 @@
+#include "i2c/transaction_queue.h"
+
+#include "app/app_config.h"
+#include "hal/hal.h"
+
+namespace i2c {
+
+namespace {
+// An address byte (twice with a repeated START) and 9 clocks per byte.
+constexpr uint32_t kBitsPerByte = 9;
+constexpr std::size_t kAddressBytes = 2;
+// Nine SCL pulses, START and STOP, with some margin.
+constexpr uint32_t kRecoveryClocks = 12;
+
+struct DeviceClock {
+    uint8_t addr;
+    uint32_t max_hz;
+};
+
+constexpr DeviceClock kDeviceClocks[] = {
+    {app::config::AHT20_ADDR, app::config::AHT20_MAX_HZ},
+    {app::config::BMP280_ADDR, app::config::BMP280_MAX_HZ},
+    {app::config::MPU6050_ADDR, app::config::MPU6050_MAX_HZ},
+    {app::config::VEML7700_ADDR, app::config::VEML7700_MAX_HZ},
+    {app::config::HSCDTD_ADDR, app::config::HSCDTD_MAX_HZ},
+    {app::config::DISPLAY_ADDR, app::config::DISPLAY_MAX_HZ},
+};
+
+Transaction *queue[kQueueDepth];
+std::size_t head = 0;
+std::size_t count = 0;
+// Failed transactions waiting out their backoff, unordered.
+Transaction *retrying[kQueueDepth];
+std::size_t retry_count = 0;
+Transaction *volatile in_flight = nullptr;
+uint64_t in_flight_deadline_us = 0;
+// What the controller is clocked at; bus recovery puts it back to this.
+uint32_t bus_hz = app::config::I2C_FREQUENCY_HZ;
+// Set while the bus is being recovered, which keeps transfers off it.
+bool recovering = false;
+Stats stats = {};
+Health health = {};
+
+uint32_t BusUs(uint32_t clocks, uint32_t clock_hz) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(clocks) * 1000000 + clock_hz - 1) / clock_hz);
+}
+
+// Caller holds the critical section. Null once the table is full.
+DeviceHealth *Device(uint8_t addr) {
+    for (std::size_t i = 0; i < health.device_count; ++i) {
+        if (health.devices[i].addr == addr) {
+            return &health.devices[i];
+        }
+    }
+    if (health.device_count == kMaxDevices) {
+        return nullptr;
+    }
+    DeviceHealth &device = health.devices[health.device_count++];
+    device = DeviceHealth();
+    device.addr = addr;
+    return &device;
+}
+
+void Finish(Transaction &transaction, int result) {
+    transaction.result = result;
+    transaction.pending = false;
+    if (transaction.done != nullptr) {
+        transaction.done(transaction);
+    }
+}
+
+void OnTransferDone(int result, void *);
+
+// Caller holds the critical section. Due retries go first, then the queue
+// in order.
+Transaction *TakeNext(uint64_t now) {
+    for (std::size_t i = 0; i < retry_count; ++i) {
+        if (retrying[i]->retry_at_us <= now) {
+            Transaction *transaction = retrying[i];
+            retrying[i] = retrying[--retry_count];
+            return transaction;
+        }
+    }
+    if (count == 0) {
+        return nullptr;
+    }
+    Transaction *transaction = queue[head];
+    head = (head + 1) % kQueueDepth;
+    --count;
+    return transaction;
+}
+
+// Caller holds the critical section. Points the alarm at the in-flight
+// deadline, or with the bus free at the next retry; false if that has
+// passed already. A retry that falls due during a transfer starts when
+// the transfer ends.
+bool ArmAlarm() {
+    uint64_t at = UINT64_MAX;
+    if (in_flight != nullptr) {
+        at = in_flight_deadline_us;
+    } else {
+        for (std::size_t i = 0; i < retry_count; ++i) {
+            if (retrying[i]->retry_at_us < at) {
+                at = retrying[i]->retry_at_us;
+            }
+        }
+    }
+    if (at == UINT64_MAX) {
+        hal::AlarmCancel(hal::kAlarmI2c);
+        return true;
+    }
+    return hal::AlarmSetTarget(hal::kAlarmI2c, at);
+}
+
+// Caller holds the critical section. Hands the next transaction to the
+// HAL; returns one the HAL refused, for the caller to fail outside the
+// critical section. `due` is set when the alarm could not be armed
+// because its time has come.
+Transaction *StartNext(bool &due) {
+    due = false;
+    if (recovering) {
+        return nullptr;
+    }
+    if (in_flight == nullptr) {
+        const uint64_t now = hal::TimeUs();
+        Transaction *transaction = TakeNext(now);
+        if (transaction != nullptr) {
+            if (transaction->clock_hz != bus_hz) {
+                hal::I2cSetClock(app::config::I2C_PORT, transaction->clock_hz);
+                bus_hz = transaction->clock_hz;
+                ++stats.clock_changes;
+            }
+            if (!hal::I2cTransferAsync(app::config::I2C_PORT, transaction->addr, transaction->tx,
+                                       transaction->tx_len, transaction->rx, transaction->rx_len, OnTransferDone,
+                                       nullptr)) {
+                ++stats.errors;
+                due = !ArmAlarm();
+                return transaction;
+            }
+            in_flight = transaction;
+            in_flight_deadline_us = now + TimeoutUs(transaction->tx_len + transaction->rx_len, bus_hz);
+        }
+    }
+    due = !ArmAlarm();
+    return nullptr;
+}
+
+void OnAlarm();
+
+// Completion callbacks may submit again, so they always run outside the
+// (non-reentrant) critical section.
+void Kick() {
+    while (true) {
+        bool due = false;
+        const uint32_t irq = hal::CriticalEnter();
+        Transaction *refused = StartNext(due);
+        hal::CriticalExit(irq);
+        if (refused != nullptr) {
+            Finish(*refused, hal::kI2cBusError);
+            continue;
+        }
+        if (due) {
+            OnAlarm();
+        }
+        return;
+    }
+}
+
+// Outcome of one attempt: done, or back for another after the backoff.
+void Complete(Transaction &transaction, int result) {
+    const uint32_t irq = hal::CriticalEnter();
+    ++stats.completed;
+    DeviceHealth *device = Device(transaction.addr);
+    ++transaction.attempts;
+    bool finished = true;
+    if (result >= 0) {
+        if (device != nullptr) {
+            ++device->completed;
+        }
+    } else {
+        ++stats.errors;
+        if (device != nullptr) {
+            uint32_t &cause = result == hal::kI2cNack      ? device->nacks
+                              : result == hal::kI2cTimeout ? device->timeouts
+                                                           : device->bus_errors;
+            ++cause;
+        }
+        if (transaction.attempts < kMaxAttempts && retry_count < kQueueDepth) {
+            transaction.retry_at_us = hal::TimeUs() + (kBackoffUs << (transaction.attempts - 1));
+            retrying[retry_count++] = &transaction;
+            finished = false;
+            if (device != nullptr) {
+                ++device->retries;
+            }
+        } else if (device != nullptr) {
+            ++device->failed;
+        }
+    }
+    hal::CriticalExit(irq);
+    if (finished) {
+        Finish(transaction, result);
+    }
+}
+
+// HAL completion interrupt for the transaction on the wire.
+void OnTransferDone(int result, void *) {
+    const uint32_t irq = hal::CriticalEnter();
+    Transaction *transaction = in_flight;
+    in_flight = nullptr;
+    hal::CriticalExit(irq);
+
+    if (transaction != nullptr) {
+        Complete(*transaction, result);
+    }
+    Kick();
+}
+
+// Timer interrupt: an attempt has overrun its timeout, a backoff ended, or
+// core1 submitted a transaction.
+// The overrunning transfer is taken off the bus and the bus recovered
+// before anything else goes out.
+void OnAlarm() {
+    const uint32_t irq = hal::CriticalEnter();
+    Transaction *timed_out = nullptr;
+    if (in_flight != nullptr && hal::TimeUs() >= in_flight_deadline_us) {
+        timed_out = in_flight;
+        in_flight = nullptr;
+        recovering = true;
+        hal::I2cAbort(app::config::I2C_PORT);
+    }
+    hal::CriticalExit(irq);
+
+    if (timed_out != nullptr) {
+        const bool released = hal::I2cRecoverBus(app::config::I2C_PORT);
+        const uint32_t irq_after = hal::CriticalEnter();
+        recovering = false;
+        ++health.recoveries;
+        if (!released) {
+            ++health.recovery_failures;
+        }
+        hal::CriticalExit(irq_after);
+        Complete(*timed_out, hal::kI2cTimeout);
+    }
+    Kick();
+}
+
+}  // namespace
+
+void Init() {
+    hal::I2cInit(app::config::I2C_PORT, app::config::SDA_PIN, app::config::SCL_PIN, app::config::I2C_FREQUENCY_HZ);
+    hal::AlarmInit(hal::kAlarmI2c, OnAlarm);
+}
+
+bool Submit(Transaction &transaction) {
+    const uint32_t irq = hal::CriticalEnter();
+    if (transaction.pending || count >= kQueueDepth) {
+        hal::CriticalExit(irq);
+        return false;
+    }
+    transaction.pending = true;
+    transaction.result = 0;
+    transaction.attempts = 0;
+    transaction.clock_hz = ClockHz(transaction.addr);
+    queue[(head + count) % kQueueDepth] = &transaction;
+    ++count;
+    ++stats.submitted;
+    const uint32_t depth = static_cast<uint32_t>(count + retry_count) + (in_flight != nullptr ? 1 : 0);
+    if (depth > stats.max_depth) {
+        stats.max_depth = depth;
+    }
+    hal::CriticalExit(irq);
+    if (hal::CoreNum() == 0) {
+        Kick();
+    } else {
+        hal::AlarmTrigger(hal::kAlarmI2c);
+    }
+    return true;
+}
+
+int Transfer(uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx, std::size_t rx_len) {
+    Transaction transaction(addr, tx, tx_len, rx, rx_len);
+    while (!Submit(transaction)) {
+        hal::WaitForEvent();
+    }
+    while (transaction.pending) {
+        hal::WaitForEvent();
+    }
+    return transaction.result;
+}
+
+bool Idle() {
+    return in_flight == nullptr && count == 0 && retry_count == 0;
+}
+
+uint32_t ClockHz(uint8_t addr) {
+    for (const DeviceClock &device : kDeviceClocks) {
+        if (device.addr == addr) {
+            return device.max_hz < app::config::I2C_BUS_MAX_HZ ? device.max_hz : app::config::I2C_BUS_MAX_HZ;
+        }
+    }
+    return app::config::I2C_FREQUENCY_HZ;
+}
+
+uint32_t TimeoutUs(std::size_t bytes, uint32_t clock_hz) {
+    return 2 * BusUs(static_cast<uint32_t>((bytes + kAddressBytes) * kBitsPerByte), clock_hz) + kTimeoutSlackUs;
+}
+
+uint32_t WorstCaseUs(std::size_t bytes, uint32_t clock_hz) {
+    const uint32_t attempt_us = TimeoutUs(bytes, clock_hz) + BusUs(kRecoveryClocks, clock_hz);
+    return kMaxAttempts * attempt_us + kBackoffUs * ((1u << (kMaxAttempts - 1)) - 1);
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+const Health &GetHealth() {
+    return health;
+}
+
+}  // namespace i2c
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Queued, DMA-driven I2C on app::config::I2C_PORT. Drivers describe each
+// transfer with a Transaction and submit it; the queue hands descriptors to
+// the HAL one at a time, and each completion interrupt starts the next one,
+// so back-to-back transfers go out without the CPU waiting on the bus.
+//
+// The queue also manages the bus. Every attempt has a timeout from its
+// length; one that overruns it is aborted and the bus recovered, so a
+// target holding SDA low costs a bounded time instead of the bus. A
+// NACK, timeout or bus error is retried after a backoff that doubles each
+// time, with the other queued transactions using the bus in between, up
+// to kMaxAttempts attempts. `done` therefore runs within WorstCaseUs() of
+// a transaction reaching the bus, and a failing target delays the others
+// by at most that per transaction of its own.
+//
+// Each transaction runs at the fastest SCL its target is rated for, within
+// what the bus allows (app::config::*_MAX_HZ). Transactions go out in
+// order, so a driver's burst stays at one rate and the controller is only
+// reclocked where the target rate changes.
+namespace i2c {
+
+struct Transaction;
+// Runs on core0 once the transaction has finished: in interrupt context,
+// or in a core0 Submit() call when the HAL refuses to start the transfer
+// queued ahead of it.
+using DoneFn = void (*)(Transaction &transaction);
+
+// Write `tx_len` bytes (e.g. a register pointer or register/value pairs),
+// then, if `rx_len` > 0, read `rx_len` bytes after a repeated START. The
+// descriptor and its buffers must stay untouched while `pending` is set.
+struct Transaction {
+    Transaction() = default;
+    Transaction(uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx, std::size_t rx_len,
+                DoneFn done = nullptr, void *context = nullptr)
+        : addr(addr), tx(tx), tx_len(tx_len), rx(rx), rx_len(rx_len), done(done), context(context) {}
+
+    uint8_t addr = 0;
+    const uint8_t *tx = nullptr;
+    std::size_t tx_len = 0;
+    uint8_t *rx = nullptr;
+    std::size_t rx_len = 0;
+    DoneFn done = nullptr;
+    void *context = nullptr;
+
+    // Set by Submit(), cleared just before `done` runs.
+    volatile bool pending = false;
+    // Bytes transferred in the last phase, or a negative hal::kI2c* code
+    // from the last attempt.
+    volatile int result = 0;
+
+    // Owned by the queue.
+    uint8_t attempts = 0;
+    uint32_t clock_hz = 0;
+    uint64_t retry_at_us = 0;
+};
+
+struct Stats {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t errors;
+    uint32_t max_depth;
+    uint32_t clock_changes;
+};
+
+// Counters of one target address since boot. Each failed attempt counts
+// once under its cause.
+struct DeviceHealth {
+    uint8_t addr;
+    uint32_t completed;   // transactions that succeeded, retried or not
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t bus_errors;
+    uint32_t retries;
+    uint32_t failed;      // transactions given up after kMaxAttempts
+};
+
+constexpr std::size_t kMaxDevices = 8;
+
+struct Health {
+    DeviceHealth devices[kMaxDevices];  // in order of first use
+    uint8_t device_count;
+    uint32_t recoveries;          // bus recoveries after a timeout
+    uint32_t recovery_failures;   // SDA still low afterwards
+};
+
+constexpr std::size_t kQueueDepth = 16;
+constexpr uint32_t kMaxAttempts = 3;
+// Allowance beyond the wire time, mostly for targets stretching SCL.
+constexpr uint32_t kTimeoutSlackUs = 1000;
+// Wait before the first retry; doubles for each further one.
+constexpr uint32_t kBackoffUs = 1000;
+
+// Bus and alarm set-up; call once from core0 before any Submit().
+void Init();
+
+// Queue a transaction. Safe from either core and from interrupt context,
+// including from a `done` callback; the queue is the bus arbiter, so
+// transfers from both cores never overlap. Returns false, in the caller's
+// context, if the transaction is already pending or the queue is full.
+// Everything else about a transaction, the bus work and `done`, stays on
+// core0: a Submit() on core1 hands the start over through the I2C alarm
+// interrupt rather than starting it there, so drivers that share state
+// with their `done` only need to guard against core0 interrupts.
+bool Submit(Transaction &transaction);
+
+// Queue a transfer and wait for it; returns the same values as the blocking
+// SDK calls. For initialisation code that has nothing else to do.
+int Transfer(uint8_t addr, const uint8_t *tx, std::size_t tx_len, uint8_t *rx, std::size_t rx_len);
+
+// True when nothing is queued or on the wire.
+bool Idle();
+
+// SCL rate of transactions to `addr`.
+uint32_t ClockHz(uint8_t addr);
+// Timeout of one attempt carrying `bytes` data bytes (tx_len + rx_len) at
+// `clock_hz`.
+uint32_t TimeoutUs(std::size_t bytes, uint32_t clock_hz);
+// Longest a transaction of `bytes` can take from reaching the bus to its
+// `done`: every attempt timing out, each followed by a bus recovery and
+// the backoff.
+uint32_t WorstCaseUs(std::size_t bytes, uint32_t clock_hz);
+
+const Stats &GetStats();
+const Health &GetHealth();
+
+}  // namespace i2c
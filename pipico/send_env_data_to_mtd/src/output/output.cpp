@@ -0,0 +1,137 @@
+#include "output/output.h"
+
+#include <atomic>
+
+#include "app/app_config.h"
+#include "display/display.h"
+#include "hal/hal.h"
+#include "profile/profile.h"
+#include "sensors/mag_calibration.h"
+#include "supervisor/supervisor.h"
+#include "telemetry/telemetry.h"
+#include "utils/spsc_ring.h"
+
+namespace output {
+
+namespace {
+constexpr std::size_t kRingSize = 4;
+// One per telemetry window, so core1 never has more than one to catch up on.
+constexpr std::size_t kSummaryRingSize = 2;
+constexpr std::size_t kHealthRingSize = 2;
+
+struct Item {
+    app::model::SensorSnapshot snapshot;
+    uint8_t actions;
+    uint64_t submitted_us;
+};
+
+utils::SpscRing<Item, kRingSize> ring;
+utils::SpscRing<telemetry::record::Summary, kSummaryRingSize> summaries;
+utils::SpscRing<telemetry::record::Health, kHealthRingSize> health_records;
+std::atomic<bool> timing_requested{false};
+Stats stats = {};
+
+// Drain everything core0 has handed over, then return to WaitForEvent().
+void Service() {
+    Item item;
+    while (ring.Pop(item)) {
+        const uint64_t latency = hal::TimeUs() - item.submitted_us;
+        if (latency > stats.max_latency_us) {
+            stats.max_latency_us = static_cast<uint32_t>(latency);
+        }
+        if (item.actions & kRender) {
+            profile::ScopedTimer timer(telemetry::record::kStageRender);
+            supervisor::StageScope scope(telemetry::record::kStageRender);
+            display::Render(item.snapshot);
+            ++stats.rendered;
+        }
+        if (item.actions & kPublish) {
+            profile::ScopedTimer timer(telemetry::record::kStagePublish);
+            supervisor::StageScope scope(telemetry::record::kStagePublish);
+            telemetry::Publish(item.snapshot);
+            ++stats.published;
+        }
+    }
+    // Too big for core1's stack.
+    static telemetry::record::Summary summary;
+    while (summaries.Pop(summary)) {
+        profile::ScopedTimer timer(telemetry::record::kStagePublish);
+        supervisor::StageScope scope(telemetry::record::kStagePublish);
+        telemetry::PublishSummary(summary);
+        ++stats.published;
+    }
+    static telemetry::record::Health health;
+    while (health_records.Pop(health)) {
+        telemetry::PublishHealth(health);
+        ++stats.published;
+    }
+    if constexpr (app::config::STAGE_TIMING) {
+        if (timing_requested.load(std::memory_order_acquire)) {
+            timing_requested.store(false, std::memory_order_relaxed);
+            static telemetry::record::Timing timing;
+            profile::Take(timing);
+            telemetry::PublishTiming(timing);
+            ++stats.published;
+        }
+    }
+    telemetry::Drain();
+    if constexpr (app::config::SENSOR_HSCDTD) {
+        sensors::mag_calibration::Store();
+    }
+}
+
+}  // namespace
+
+void Launch() {
+    hal::Core1Launch(Service);
+}
+
+bool Submit(const app::model::SensorSnapshot &snapshot, uint8_t actions) {
+    Item item;
+    // Sensor completion interrupts write into the snapshot; copy it whole.
+    const uint32_t irq = hal::CriticalEnter();
+    item.snapshot = snapshot;
+    hal::CriticalExit(irq);
+    item.actions = actions;
+    item.submitted_us = hal::TimeUs();
+
+    ++stats.submitted;
+    if (!ring.Push(item)) {
+        stats.dropped = ring.Dropped() + summaries.Dropped() + health_records.Dropped();
+        return false;
+    }
+    hal::SignalEvent();
+    return true;
+}
+
+bool SubmitSummary(const telemetry::record::Summary &summary) {
+    ++stats.submitted;
+    if (!summaries.Push(summary)) {
+        stats.dropped = ring.Dropped() + summaries.Dropped() + health_records.Dropped();
+        return false;
+    }
+    hal::SignalEvent();
+    return true;
+}
+
+bool SubmitHealth(const telemetry::record::Health &health) {
+    ++stats.submitted;
+    if (!health_records.Push(health)) {
+        stats.dropped = ring.Dropped() + summaries.Dropped() + health_records.Dropped();
+        return false;
+    }
+    hal::SignalEvent();
+    return true;
+}
+
+void RequestTiming() {
+    ++stats.submitted;
+    timing_requested.store(true, std::memory_order_release);
+    hal::SignalEvent();
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace output
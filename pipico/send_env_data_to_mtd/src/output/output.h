@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/measurement_types.h"
+#include "telemetry/record_format.h"
+
+// Core1 side of the firmware. Core0 only acquires; it hands snapshot copies
+// through a lock-free ring to core1, which formats, renders and publishes,
+// so the display and the mesh link never delay sampling. Core1 also stores
+// new magnetometer calibrations, which can take a flash sector erase.
+namespace output {
+
+enum Action : uint8_t {
+    kRender = 0x01,
+    kPublish = 0x02,
+};
+
+struct Stats {
+    uint32_t submitted;
+    uint32_t dropped;
+    uint32_t rendered;
+    uint32_t published;       // snapshots, summaries, health and timing records
+    uint32_t max_latency_us;  // hand-off to start of processing on core1
+};
+
+// Start servicing the ring on core1. Display and telemetry must already be
+// initialised.
+void Launch();
+
+// Core0 only. Copies `snapshot` into the ring; false if core1 has fallen a
+// full ring behind, in which case the snapshot is dropped.
+bool Submit(const app::model::SensorSnapshot &snapshot, uint8_t actions);
+
+// Core0 only. Queues a window summary for telemetry::PublishSummary(); false
+// if the previous ones are still waiting, in which case it is dropped.
+bool SubmitSummary(const telemetry::record::Summary &summary);
+
+// Core0 only. Queues an I2C health record for telemetry::PublishHealth();
+// false if the previous ones are still waiting.
+bool SubmitHealth(const telemetry::record::Health &health);
+
+// Core0 only. Has core1 take the stage timings (profile::Take(), which runs
+// there) and publish them with telemetry::PublishTiming(). Requests made
+// before core1 gets to them count as one.
+void RequestTiming();
+
+const Stats &GetStats();
+
+}  // namespace output
@@ -0,0 +1,109 @@
+#include "profile/profile.h"
+
+#include <atomic>
+
+namespace profile {
+
+namespace {
+using telemetry::record::kStageCount;
+using telemetry::record::kTimingBuckets;
+
+// Written only by the core that times the stage, so plain load-and-store
+// updates suffice; Take() reads them from core1.
+struct Counters {
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> total_us{0};  // wraps; windows take differences
+    std::atomic<uint32_t> peak_us{0};
+    std::atomic<uint32_t> window_max_us{0};
+    std::atomic<uint32_t> max_window{0};  // the window window_max_us is for
+    std::atomic<uint32_t> buckets[kTimingBuckets] = {};
+    uint32_t job_us = 0;  // earlier steps of the job in progress
+};
+
+// The counters as Take() last saw them. Core1 only.
+struct Taken {
+    uint32_t total_us;
+    uint64_t all_total_us;  // since boot, up to that Take()
+    uint32_t buckets[kTimingBuckets];
+};
+
+Counters counters[kStageCount];
+Taken taken[kStageCount];
+// Numbers the windows. A stage's first sample in a window resets its
+// maximum, so Take() never has to write to another core's counters.
+std::atomic<uint32_t> window{0};
+
+void Increase(std::atomic<uint32_t> &value, uint32_t by) {
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+void Add(Stage stage, uint32_t us, bool done) {
+    Counters &c = counters[stage];
+    if (!done) {
+        c.job_us += us;
+        return;
+    }
+    us += c.job_us;
+    c.job_us = 0;
+
+    Increase(c.buckets[telemetry::record::TimingBucket(us)], 1);
+    Increase(c.total_us, us);
+    if (us > c.peak_us.load(std::memory_order_relaxed)) {
+        c.peak_us.store(us, std::memory_order_relaxed);
+    }
+    const uint32_t current = window.load(std::memory_order_acquire);
+    if (c.max_window.load(std::memory_order_relaxed) != current) {
+        c.window_max_us.store(us, std::memory_order_relaxed);
+        c.max_window.store(current, std::memory_order_release);
+    } else if (us > c.window_max_us.load(std::memory_order_relaxed)) {
+        c.window_max_us.store(us, std::memory_order_relaxed);
+    }
+    c.count.store(c.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Take(telemetry::record::Timing &timing) {
+    timing = telemetry::record::Timing();
+    const uint32_t current = window.load(std::memory_order_relaxed);
+    for (int s = 0; s < kStageCount; ++s) {
+        const Counters &c = counters[s];
+        if (c.count.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        timing.stages = static_cast<uint16_t>(timing.stages | 1u << s);
+        telemetry::record::StageTiming &out = timing.stage[s];
+        Taken &last = taken[s];
+        for (int b = 0; b < kTimingBuckets; ++b) {
+            const uint32_t now = c.buckets[b].load(std::memory_order_relaxed);
+            out.buckets[b] = now - last.buckets[b];
+            out.count += out.buckets[b];
+            last.buckets[b] = now;
+        }
+        const uint32_t total_us = c.total_us.load(std::memory_order_relaxed);
+        const uint32_t window_us = total_us - last.total_us;
+        last.total_us = total_us;
+        last.all_total_us += window_us;
+        out.mean_us = out.count > 0 ? window_us / out.count : 0;
+        if (c.max_window.load(std::memory_order_acquire) == current) {
+            out.max_us = c.window_max_us.load(std::memory_order_relaxed);
+        }
+        out.peak_us = c.peak_us.load(std::memory_order_relaxed);
+    }
+    window.store(current + 1, std::memory_order_release);
+}
+
+StageStats GetStats(Stage stage) {
+    const Counters &c = counters[stage];
+    const Taken &last = taken[stage];
+    StageStats stats = {};
+    stats.count = c.count.load(std::memory_order_acquire);
+    stats.total_us = last.all_total_us + (c.total_us.load(std::memory_order_relaxed) - last.total_us);
+    stats.peak_us = c.peak_us.load(std::memory_order_relaxed);
+    for (int b = 0; b < kTimingBuckets; ++b) {
+        stats.buckets[b] = c.buckets[b].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+}  // namespace profile
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/app_config.h"
+#include "hal/hal.h"
+#include "telemetry/record_format.h"
+
+// Stage timing. A ScopedTimer around each stage of the firmware (see
+// telemetry::record::Stage) adds its duration to that stage's histogram
+// and maximum, and the timing task sends them as a timing record every
+// app::config::TIMING_PERIOD_US, so a regression in field firmware shows
+// up on the dashboards. Durations are hal::TimeUs() differences: wall time,
+// including interrupts and waits on the bus.
+//
+// With app::config::STAGE_TIMING off the timers are empty objects, this
+// module is not compiled and no timing record is sent.
+namespace profile {
+
+using telemetry::record::Stage;
+
+// Totals since boot, for the host simulator's report.
+struct StageStats {
+    uint32_t count;
+    uint64_t total_us;
+    uint32_t peak_us;
+    uint32_t buckets[telemetry::record::kTimingBuckets];
+};
+
+// Adds `us` to the job of `stage` in progress; with `done` that job is one
+// sample. A stage must only ever be timed from one core. The steps of a job
+// abandoned part-way count towards the next one.
+void Add(Stage stage, uint32_t us, bool done);
+
+// Core1 only. Fills `timing` with each stage's samples since the previous
+// call, and starts the next window. Samples on the other core that land
+// during the call may count in either window.
+void Take(telemetry::record::Timing &timing);
+
+StageStats GetStats(Stage stage);
+
+// Times its own scope as one sample of `stage`, or with Continue() as one
+// step of a job that carries on in a later call; the steps of a job then
+// add up to one sample.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage stage) : stage_(stage) {
+        if constexpr (app::config::STAGE_TIMING) {
+            start_us_ = hal::TimeUs();
+        }
+    }
+
+    ~ScopedTimer() {
+        if constexpr (app::config::STAGE_TIMING) {
+            Add(stage_, static_cast<uint32_t>(hal::TimeUs() - start_us_), !continued_);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    void Continue() {
+        continued_ = true;
+    }
+
+private:
+    Stage stage_;
+    bool continued_ = false;
+    uint64_t start_us_ = 0;
+};
+
+}  // namespace profile
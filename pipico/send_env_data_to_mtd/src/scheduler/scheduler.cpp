@@ -0,0 +1,138 @@
+#include "scheduler/scheduler.h"
+
+#include "hal/hal.h"
+
+namespace scheduler {
+
+namespace {
+Task *tasks[kMaxTasks];
+std::size_t task_count = 0;
+volatile bool alarm_fired = false;
+
+void OnAlarm() {
+    alarm_fired = true;
+}
+
+void WaitUntil(uint64_t wake_us) {
+    alarm_fired = false;
+    if (!hal::AlarmSetTarget(hal::kAlarmScheduler, wake_us)) {
+        return;  // already due
+    }
+    while (!alarm_fired) {
+        hal::IdleUntil(wake_us);
+    }
+}
+
+// Move the next release past `now`, keeping the original phase so the
+// task's timeline never drifts. Releases that were missed are counted.
+void AdvanceRelease(Task &task, uint64_t now) {
+    task.next_release_us += task.period_us;
+    if (task.next_release_us <= now) {
+        const uint64_t behind = (now - task.next_release_us) / task.period_us + 1;
+        task.skipped_releases += static_cast<uint32_t>(behind);
+        task.next_release_us += behind * task.period_us;
+    }
+}
+
+void Step(Task &task, uint64_t now) {
+    bool first = false;
+    if (!task.in_job) {
+        task.in_job = true;
+        task.job_release_us = task.next_release_us;
+        task.job_deadline_us = task.next_release_us + task.deadline_us;
+        AdvanceRelease(task, now);
+        ++task.jobs;
+        first = true;
+    } else if (now > task.job_deadline_us) {
+        // Abandon the overdue job; the next release starts a fresh one.
+        ++task.deadline_misses;
+        task.in_job = false;
+        task.wake_us = task.next_release_us;
+        if (task.abandon != nullptr) {
+            task.abandon();
+        }
+        return;
+    }
+
+    const uint32_t again_us = task.job(first);
+    const uint64_t after = hal::TimeUs();
+    if (again_us != 0) {
+        task.wake_us = after + again_us;
+        return;
+    }
+
+    task.in_job = false;
+    task.wake_us = task.next_release_us;
+    const uint64_t response = after - task.job_release_us;
+    if (after > task.job_deadline_us) {
+        ++task.deadline_misses;
+    }
+    if (response > task.worst_response_us) {
+        task.worst_response_us = static_cast<uint32_t>(response);
+    }
+}
+
+}  // namespace
+
+bool Add(Task &task) {
+    if (task_count >= kMaxTasks || task.period_us == 0 || task.job == nullptr) {
+        return false;
+    }
+    if (task.deadline_us == 0 || task.deadline_us > task.period_us) {
+        task.deadline_us = task.period_us;
+    }
+    task.in_job = false;
+    task.jobs = 0;
+    task.deadline_misses = 0;
+    task.skipped_releases = 0;
+    task.worst_response_us = 0;
+    tasks[task_count++] = &task;
+    return true;
+}
+
+void Run() {
+    hal::AlarmInit(hal::kAlarmScheduler, OnAlarm);
+
+    const uint64_t start = hal::TimeUs();
+    for (std::size_t i = 0; i < task_count; ++i) {
+        tasks[i]->next_release_us = start + tasks[i]->phase_us;
+        tasks[i]->wake_us = tasks[i]->next_release_us;
+    }
+
+    while (true) {
+        const uint64_t now = hal::TimeUs();
+        Task *next = nullptr;
+        uint64_t wake = UINT64_MAX;
+        for (std::size_t i = 0; i < task_count; ++i) {
+            Task &task = *tasks[i];
+            if (task.wake_us > now) {
+                if (task.wake_us < wake) {
+                    wake = task.wake_us;
+                }
+                continue;
+            }
+            const uint64_t deadline = task.in_job ? task.job_deadline_us : task.next_release_us + task.deadline_us;
+            const uint64_t best = next == nullptr ? UINT64_MAX
+                                  : (next->in_job ? next->job_deadline_us : next->next_release_us + next->deadline_us);
+            if (deadline < best) {
+                next = &task;
+            }
+        }
+
+        if (next != nullptr) {
+            Step(*next, now);
+        } else {
+            WaitUntil(wake);
+        }
+    }
+}
+
+std::size_t TaskCount() {
+    return task_count;
+}
+
+const Task &GetTask(std::size_t index) {
+    return *tasks[index];
+}
+
+}  // namespace scheduler
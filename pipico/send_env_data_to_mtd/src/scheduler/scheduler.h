@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Cooperative multi-rate scheduler woken by a hardware timer alarm.
+//
+// Each task is released strictly every `period_us` from its first release
+// (release times never drift with execution time) and must finish each job
+// within `deadline_us` of the release. A job is a function that may take
+// several steps: it returns 0 when done, or the delay before it wants to be
+// called again (e.g. while a sensor conversion is running), so a slow or
+// failing task never blocks the others. Among ready tasks the one with the
+// earliest absolute deadline runs first.
+namespace scheduler {
+
+// `first` is true on the call that starts a new job.
+using JobFn = uint32_t (*)(bool first);
+// Called instead of the job when an unfinished job is dropped at its deadline.
+using AbandonFn = void (*)();
+
+struct Task {
+    const char *name;
+    uint32_t period_us;
+    uint32_t deadline_us;
+    uint32_t phase_us;  // offset of the first release from Start()
+    JobFn job;
+    AbandonFn abandon = nullptr;
+
+    // Runtime state and statistics, owned by the scheduler.
+    uint64_t next_release_us = 0;
+    uint64_t wake_us = 0;
+    uint64_t job_deadline_us = 0;
+    uint64_t job_release_us = 0;
+    bool in_job = false;
+    uint32_t jobs = 0;
+    uint32_t deadline_misses = 0;
+    uint32_t skipped_releases = 0;
+    uint32_t worst_response_us = 0;
+};
+
+constexpr std::size_t kMaxTasks = 12;
+
+// Register a task; the Task must outlive the scheduler.
+bool Add(Task &task);
+
+// Arm the alarm and run tasks forever.
+[[noreturn]] void Run();
+
+std::size_t TaskCount();
+const Task &GetTask(std::size_t index);
+
+}  // namespace scheduler
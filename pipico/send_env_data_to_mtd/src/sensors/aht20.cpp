@@ -2,25 +2,21 @@
 
 #include <cmath>
 
-#include "hardware/i2c.h"
-#include "pico/time.h"
+#include "hal/hal.h"
 
 namespace sensors {
 namespace aht20 {
 
-bool Read(app::model::Aht20Data &data) {
-    uint8_t cmd[3] = {0xAC, 0x33, 0x00};
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::AHT20_ADDR, cmd, 3, false) != 3) {
-        data.valid = false;
-        return false;
-    }
-
-    sleep_ms(80);
+namespace {
+constexpr uint8_t STATUS_BUSY = 0x80;
+// Datasheet conversion time; the status byte is not worth polling before it.
+constexpr uint64_t kConversionUs = 80 * 1000;
+constexpr uint64_t kTimeoutUs = 200 * 1000;
 
-    uint8_t raw[6];
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::AHT20_ADDR, raw, 6, false) != 6) {
-        data.valid = false;
-        return false;
+// Runs in the I2C completion interrupt.
+Status Decode(const uint8_t *raw, app::model::Aht20Data &data) {
+    if (raw[0] & STATUS_BUSY) {
+        return Status::kPending;
     }
 
     data.status = raw[0];
@@ -38,8 +34,55 @@ bool Read(app::model::Aht20Data &data) {
     data.humidity_pct = (static_cast<float>(humidity) * 100.0f) / 1048576.0f;
     data.temperature_c = (static_cast<float>(temperature) * 200.0f) / 1048576.0f - 50.0f;
     data.valid = true;
+    return Status::kReady;
+}
+
+const uint8_t kTrigger[3] = {0xAC, 0x33, 0x00};
+i2c::Transaction trigger(app::config::AHT20_ADDR, kTrigger, sizeof(kTrigger), nullptr, 0);
+QueuedRead<app::model::Aht20Data, 6> sample(app::config::AHT20_ADDR, Decode);
+
+bool started = false;
+uint64_t started_us = 0;
+
+Status Fail(app::model::Aht20Data &data) {
+    started = false;
+    data.valid = false;
+    return Status::kError;
+}
+
+}  // namespace
+
+bool Start() {
+    sample.Reset();
+    if (!i2c::Submit(trigger)) {
+        started = false;
+        return false;
+    }
+    started = true;
+    started_us = hal::TimeUs();
     return true;
 }
 
+Status Collect(app::model::Aht20Data &data) {
+    if (!started) {
+        return Fail(data);
+    }
+    if (trigger.pending) {
+        return Status::kPending;
+    }
+    if (trigger.result != static_cast<int>(sizeof(kTrigger))) {
+        return Fail(data);
+    }
+
+    const Status status = sample.Poll(data, started_us + kConversionUs, started_us + kTimeoutUs);
+    if (status == Status::kError) {
+        return Fail(data);
+    }
+    if (status == Status::kReady) {
+        started = false;
+    }
+    return status;
+}
+
 }  // namespace aht20
 }  // namespace sensors
@@ -2,11 +2,15 @@
 
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "sensors/conversion.h"
 
 namespace sensors {
 namespace aht20 {
 
-bool Read(app::model::Aht20Data &data);
+// Two-phase API: Start() triggers a conversion, Collect() reports kPending
+// until the status byte's busy bit clears.
+bool Start();
+Status Collect(app::model::Aht20Data &data);
 
 }  // namespace aht20
 }  // namespace sensors
@@ -2,8 +2,7 @@
 
 #include <cmath>
 
-#include "hardware/i2c.h"
-#include "pico/stdlib.h"
+#include "hal/hal.h"
 
 namespace sensors {
 namespace bmp280 {
@@ -24,20 +23,35 @@ struct Calibration {
     int16_t dig_P9 = 0;
 };
 
+constexpr uint8_t STATUS = 0xF3;
+constexpr uint8_t CTRL_MEAS = 0xF4;
+constexpr uint8_t CONFIG = 0xF5;
+constexpr uint8_t STATUS_MEASURING = 0x08;
+// osrs_t x1, osrs_p x1; the mode bits select sleep (00) or one forced conversion (01).
+constexpr uint8_t CTRL_MEAS_SLEEP = 0x24;
+constexpr uint8_t CTRL_MEAS_FORCED = 0x25;
+// Typical t_measure for x1/x1 oversampling (datasheet 3.8.1).
+constexpr uint64_t kConversionUs = 5500;
+constexpr uint64_t kTimeoutUs = 50 * 1000;
+
 Calibration calibration;
 int32_t t_fine = 0;
 bool calibration_loaded = false;
+bool started = false;
+uint64_t started_us = 0;
+
+Status Decode(const uint8_t *raw, app::model::Bmp280Data &data);
+
+const uint8_t kStartForced[2] = {CTRL_MEAS, CTRL_MEAS_FORCED};
+i2c::Transaction trigger(app::config::BMP280_ADDR, kStartForced, 2, nullptr, 0);
+// One burst from STATUS through the data registers: 0xF3..0xFC.
+QueuedRead<app::model::Bmp280Data, 10> sample(app::config::BMP280_ADDR, STATUS, Decode);
 
 void LoadCalibration() {
     uint8_t reg = 0x88;
     uint8_t raw[24];
 
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, &reg, 1, true) != 1) {
-        calibration_loaded = false;
-        return;
-    }
-
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, raw, 24, false) != 24) {
+    if (i2c::Transfer(app::config::BMP280_ADDR, &reg, 1, raw, 24) != 24) {
         calibration_loaded = false;
         return;
     }
@@ -58,23 +72,6 @@ void LoadCalibration() {
     calibration_loaded = true;
 }
 
-bool ReadRaw(int32_t &adc_t, int32_t &adc_p) {
-    uint8_t reg = 0xF7;
-    uint8_t raw[6];
-
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, &reg, 1, true) != 1) {
-        return false;
-    }
-
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, raw, 6, false) != 6) {
-        return false;
-    }
-
-    adc_p = (raw[0] << 12) | (raw[1] << 4) | (raw[2] >> 4);
-    adc_t = (raw[3] << 12) | (raw[4] << 4) | (raw[5] >> 4);
-    return true;
-}
-
 float CompensateTemperature(int32_t adc_T) {
     int32_t var1 = ((((adc_T >> 3) - (static_cast<int32_t>(calibration.dig_T1) << 1))) *
                    static_cast<int32_t>(calibration.dig_T2)) >> 11;
@@ -115,39 +112,80 @@ float CalculateAltitude(float pressure_pa) {
     return 44330.0f * (1.0f - std::pow(pressure_pa / 101325.0f, 0.1903f));
 }
 
+// Runs in the I2C completion interrupt.
+Status Decode(const uint8_t *raw, app::model::Bmp280Data &data) {
+    if (raw[0] & STATUS_MEASURING) {
+        return Status::kPending;
+    }
+
+    const uint8_t *sample = raw + 4;
+    const int32_t adc_p = (sample[0] << 12) | (sample[1] << 4) | (sample[2] >> 4);
+    const int32_t adc_t = (sample[3] << 12) | (sample[4] << 4) | (sample[5] >> 4);
+
+    data.temperature_c = CompensateTemperature(adc_t);
+    data.pressure_pa = CompensatePressure(adc_p);
+    data.altitude_m = CalculateAltitude(data.pressure_pa);
+    data.valid = true;
+    return Status::kReady;
+}
+
+Status Fail(app::model::Bmp280Data &data) {
+    started = false;
+    data.valid = false;
+    return Status::kError;
+}
+
 }  // namespace
 
 void Init() {
     LoadCalibration();
-    uint8_t ctrl_meas[2] = {0xF4, 0x27};
-    uint8_t config[2] = {0xF5, 0xA0};
+    // Config is only writable in sleep mode; the sensor then idles between forced conversions.
+    uint8_t ctrl_meas[2] = {CTRL_MEAS, CTRL_MEAS_SLEEP};
+    uint8_t config[2] = {CONFIG, 0xA0};
 
-    i2c_write_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, ctrl_meas, 2, false);
-    i2c_write_blocking(app::config::I2C_PORT, app::config::BMP280_ADDR, config, 2, false);
+    i2c::Transfer(app::config::BMP280_ADDR, ctrl_meas, 2, nullptr, 0);
+    i2c::Transfer(app::config::BMP280_ADDR, config, 2, nullptr, 0);
 }
 
-bool Read(app::model::Bmp280Data &data) {
+bool Start() {
     if (!calibration_loaded) {
         LoadCalibration();
         if (!calibration_loaded) {
-            data.valid = false;
+            started = false;
             return false;
         }
     }
 
-    int32_t adc_t = 0;
-    int32_t adc_p = 0;
-    if (!ReadRaw(adc_t, adc_p)) {
-        data.valid = false;
+    sample.Reset();
+    if (!i2c::Submit(trigger)) {
+        started = false;
         return false;
     }
-
-    data.temperature_c = CompensateTemperature(adc_t);
-    data.pressure_pa = CompensatePressure(adc_p);
-    data.altitude_m = CalculateAltitude(data.pressure_pa);
-    data.valid = true;
+    started = true;
+    started_us = hal::TimeUs();
     return true;
 }
 
+Status Collect(app::model::Bmp280Data &data) {
+    if (!started) {
+        return Fail(data);
+    }
+    if (trigger.pending) {
+        return Status::kPending;
+    }
+    if (trigger.result != 2) {
+        return Fail(data);
+    }
+
+    const Status status = sample.Poll(data, started_us + kConversionUs, started_us + kTimeoutUs);
+    if (status == Status::kError) {
+        return Fail(data);
+    }
+    if (status == Status::kReady) {
+        started = false;
+    }
+    return status;
+}
+
 }  // namespace bmp280
 }  // namespace sensors
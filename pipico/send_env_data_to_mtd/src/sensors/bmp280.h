@@ -2,12 +2,17 @@
 
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "sensors/conversion.h"
 
 namespace sensors {
 namespace bmp280 {
 
 void Init();
-bool Read(app::model::Bmp280Data &data);
+
+// Two-phase API: Start() requests a forced-mode conversion, Collect() reports
+// kPending while the STATUS register's measuring bit is set.
+bool Start();
+Status Collect(app::model::Bmp280Data &data);
 
 }  // namespace bmp280
 }  // namespace sensors
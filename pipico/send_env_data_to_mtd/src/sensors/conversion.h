@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hal/hal.h"
+#include "i2c/transaction_queue.h"
+
+namespace sensors {
+
+// Outcome of a Collect() call in the two-phase Start()/Collect() driver API.
+enum class Status {
+    kPending,  // conversion still running, call Collect() again later
+    kReady,    // data filled in and marked valid
+    kError,    // bus error or conversion timed out; data marked invalid
+};
+
+// How long a sensor task waits before calling Collect() again.
+constexpr uint32_t kCollectPollUs = 1000;
+
+// Read half of a conversion, run through the I2C transaction queue. Poll()
+// queues a register read once the conversion may be done; the completion
+// interrupt decodes the bytes straight into the caller's snapshot field, and
+// the next Poll() reports the outcome. A decoder returning kPending means the
+// device reported "not ready", so the read is queued again on a later Poll().
+template <typename Data, std::size_t N>
+class QueuedRead {
+public:
+    using DecodeFn = Status (*)(const uint8_t *raw, Data &data);
+
+    // Register read: write the register pointer, then read N bytes.
+    QueuedRead(uint8_t addr, uint8_t reg, DecodeFn decode)
+        : reg_(reg), decode_(decode), transaction_(addr, &reg_, 1, raw_, N, OnDone, this) {}
+    // Plain read of N bytes, for devices without a register pointer.
+    QueuedRead(uint8_t addr, DecodeFn decode)
+        : reg_(0), decode_(decode), transaction_(addr, nullptr, 0, raw_, N, OnDone, this) {}
+    QueuedRead(const QueuedRead &) = delete;
+    QueuedRead &operator=(const QueuedRead &) = delete;
+
+    // Drop the outcome of an earlier conversion; call when starting a new one.
+    void Reset() {
+        issued_ = false;
+    }
+
+    // Not before `earliest_us`; kError once `deadline_us` passes without data.
+    Status Poll(Data &data, uint64_t earliest_us, uint64_t deadline_us) {
+        if (transaction_.pending) {
+            return Status::kPending;
+        }
+        if (issued_) {
+            issued_ = false;
+            if (outcome_ != Status::kPending) {
+                return outcome_;
+            }
+        }
+
+        const uint64_t now = hal::TimeUs();
+        if (now < earliest_us) {
+            return Status::kPending;
+        }
+        if (now >= deadline_us) {
+            return Status::kError;
+        }
+        target_ = &data;
+        outcome_ = Status::kPending;
+        if (!i2c::Submit(transaction_)) {
+            return Status::kError;
+        }
+        issued_ = true;
+        return Status::kPending;
+    }
+
+private:
+    static void OnDone(i2c::Transaction &transaction) {
+        QueuedRead &self = *static_cast<QueuedRead *>(transaction.context);
+        if (transaction.result != static_cast<int>(N)) {
+            self.outcome_ = Status::kError;
+            return;
+        }
+        self.outcome_ = self.decode_(self.raw_, *self.target_);
+    }
+
+    uint8_t reg_;
+    uint8_t raw_[N] = {};
+    DecodeFn decode_;
+    i2c::Transaction transaction_;
+    Data *target_ = nullptr;
+    volatile Status outcome_ = Status::kPending;
+    bool issued_ = false;
+};
+
+}  // namespace sensors
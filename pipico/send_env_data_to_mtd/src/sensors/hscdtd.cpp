@@ -2,39 +2,42 @@
 
 #include <cmath>
 
-#include "hardware/i2c.h"
+#include "hal/hal.h"
+#include "sensors/mag_calibration.h"
 
 namespace sensors {
 namespace hscdtd {
 
 namespace {
-constexpr uint8_t MODE_REGISTER = 0x0B;
-constexpr uint8_t MODE_CONTINUOUS = 0x01;
+constexpr uint8_t OUTX_L = 0x10;
+constexpr uint8_t STAT = 0x18;
+constexpr uint8_t CTRL1 = 0x1B;
+constexpr uint8_t CTRL3 = 0x1D;
+constexpr uint8_t CTRL4 = 0x1E;
+constexpr uint8_t CTRL1_ACTIVE_FORCE = 0x82;  // PC = active, FS = force state
+constexpr uint8_t CTRL3_FORCE = 0x40;         // FRC: start one measurement
+constexpr uint8_t CTRL4_15BIT = 0x90;         // RS = 15-bit output
+constexpr uint8_t STAT_DRDY = 0x40;
+constexpr uint64_t kTimeoutUs = 50 * 1000;
 constexpr float PI = 3.14159265358979323846f;
-}
 
-void Init() {
-    uint8_t payload[2] = {MODE_REGISTER, MODE_CONTINUOUS};
-    i2c_write_blocking(app::config::I2C_PORT, app::config::HSCDTD_ADDR, payload, 2, false);
+// Runs in the I2C completion interrupt.
+Status DecodeStatus(const uint8_t *raw, app::model::HscdtdData &) {
+    return (raw[0] & STAT_DRDY) ? Status::kReady : Status::kPending;
 }
 
-bool Read(app::model::HscdtdData &data) {
-    uint8_t reg = 0x00;
-    uint8_t raw[6];
-
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::HSCDTD_ADDR, &reg, 1, true) != 1) {
-        data.valid = false;
-        return false;
-    }
-
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::HSCDTD_ADDR, raw, 6, false) != 6) {
-        data.valid = false;
-        return false;
-    }
+// Uncorrected counts of the last sample, for the calibration fit.
+int16_t last_raw[3];
 
-    data.x = (raw[0] << 8) | raw[1];
-    data.y = (raw[2] << 8) | raw[3];
-    data.z = (raw[4] << 8) | raw[5];
+// Runs in the I2C completion interrupt.
+Status DecodeSample(const uint8_t *raw, app::model::HscdtdData &data) {
+    last_raw[0] = static_cast<int16_t>((raw[1] << 8) | raw[0]);
+    last_raw[1] = static_cast<int16_t>((raw[3] << 8) | raw[2]);
+    last_raw[2] = static_cast<int16_t>((raw[5] << 8) | raw[4]);
+    data.x = last_raw[0];
+    data.y = last_raw[1];
+    data.z = last_raw[2];
+    mag_calibration::Apply(data.x, data.y, data.z);
 
     const float heading = std::atan2(static_cast<float>(data.y), static_cast<float>(data.x));
     float heading_deg = heading * 180.0f / PI;
@@ -44,8 +47,78 @@ bool Read(app::model::HscdtdData &data) {
 
     data.heading_deg = heading_deg;
     data.valid = true;
+    return Status::kReady;
+}
+
+const uint8_t kForce[2] = {CTRL3, CTRL3_FORCE};
+i2c::Transaction trigger(app::config::HSCDTD_ADDR, kForce, 2, nullptr, 0);
+QueuedRead<app::model::HscdtdData, 1> status_read(app::config::HSCDTD_ADDR, STAT, DecodeStatus);
+// Reading the output registers clears DRDY.
+QueuedRead<app::model::HscdtdData, 6> sample(app::config::HSCDTD_ADDR, OUTX_L, DecodeSample);
+
+bool started = false;
+bool data_ready = false;
+uint64_t started_us = 0;
+
+Status Fail(app::model::HscdtdData &data) {
+    started = false;
+    data.valid = false;
+    return Status::kError;
+}
+
+}  // namespace
+
+void Init() {
+    mag_calibration::Load();
+    uint8_t ctrl1[2] = {CTRL1, CTRL1_ACTIVE_FORCE};
+    i2c::Transfer(app::config::HSCDTD_ADDR, ctrl1, 2, nullptr, 0);
+    uint8_t ctrl4[2] = {CTRL4, CTRL4_15BIT};
+    i2c::Transfer(app::config::HSCDTD_ADDR, ctrl4, 2, nullptr, 0);
+}
+
+bool Start() {
+    status_read.Reset();
+    sample.Reset();
+    data_ready = false;
+    if (!i2c::Submit(trigger)) {
+        started = false;
+        return false;
+    }
+    started = true;
+    started_us = hal::TimeUs();
     return true;
 }
 
+Status Collect(app::model::HscdtdData &data) {
+    if (!started) {
+        return Fail(data);
+    }
+    if (trigger.pending) {
+        return Status::kPending;
+    }
+    if (trigger.result != 2) {
+        return Fail(data);
+    }
+
+    const uint64_t deadline_us = started_us + kTimeoutUs;
+    if (!data_ready) {
+        const Status status = status_read.Poll(data, started_us, deadline_us);
+        if (status != Status::kReady) {
+            return status == Status::kError ? Fail(data) : Status::kPending;
+        }
+        data_ready = true;
+    }
+
+    const Status status = sample.Poll(data, started_us, deadline_us);
+    if (status == Status::kError) {
+        return Fail(data);
+    }
+    if (status == Status::kReady) {
+        started = false;
+        mag_calibration::AddSample(last_raw);
+    }
+    return status;
+}
+
 }  // namespace hscdtd
 }  // namespace sensors
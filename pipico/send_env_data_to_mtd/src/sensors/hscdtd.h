@@ -2,12 +2,20 @@
 
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "sensors/conversion.h"
 
 namespace sensors {
 namespace hscdtd {
 
+// Readings are corrected for hard and soft iron by the calibration in flash
+// (see mag_calibration.h), which Init() loads; Collect() feeds each raw
+// reading to the online fit.
 void Init();
-bool Read(app::model::HscdtdData &data);
+
+// Two-phase API: the HSCDTD008A runs in force state, Start() requests a
+// single measurement and Collect() reports kPending until STAT.DRDY is set.
+bool Start();
+Status Collect(app::model::HscdtdData &data);
 
 }  // namespace hscdtd
 }  // namespace sensors
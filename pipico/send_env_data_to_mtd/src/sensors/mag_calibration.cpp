@@ -0,0 +1,500 @@
+#include "sensors/mag_calibration.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "app/app_config.h"
+#include "hal/hal.h"
+#include "utils/crc16.h"
+#include "utils/spsc_ring.h"
+
+namespace sensors {
+namespace mag_calibration {
+
+namespace {
+constexpr float kUtPerLsb = 0.15f;  // 15-bit output
+constexpr int32_t kOneQ14 = 1 << 14;
+
+// Sample selection: a reading is kept only if it moved this far from the
+// last one kept, so a unit sitting still does not pile up one direction.
+constexpr int32_t kMinStepCounts = 16;
+constexpr uint32_t kMinSamples = 200;
+constexpr uint32_t kFitEvery = 50;
+// A collection that has not produced a good fit by now starts over.
+constexpr uint32_t kMaxSamples = 5000;
+
+// Fit checks. The samples must span most of the ellipsoid along every
+// axis; the field must be Earth-like and not too distorted; the points
+// must sit on the fitted surface.
+constexpr double kMinSpanRadii = 1.4;
+constexpr double kMaxAxisRatio = 1.5;
+constexpr double kMinFieldUt = 15.0;
+constexpr double kMaxFieldUt = 100.0;
+constexpr double kMaxResidualPct = 2.0;
+
+// A new fit replaces the stored one only if it moves some reading by about
+// 1% of the field.
+constexpr int32_t kSaveOffsetCounts = 3;
+constexpr int32_t kSaveMatrixQ14 = kOneQ14 / 100;
+
+// The normal equations are accumulated in units of 512 counts, which keeps
+// every term near 1.
+constexpr double kUnitCounts = 512.0;
+constexpr int kParams = 9;
+
+// One record per flash page; the sector is erased when all are used.
+constexpr uint32_t kMagic = 0x4C41434D;  // "MCAL"
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kSlots = hal::kFlashSectorBytes / hal::kFlashPageBytes;
+
+struct Record {
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t version;
+    uint16_t crc;  // over the whole record with this field 0
+    Correction correction;
+    float radius_counts;
+    float residual_pct;
+};
+static_assert(sizeof(Record) <= hal::kFlashPageBytes, "calibration record must fit one flash page");
+
+// Read by Apply() in the I2C completion interrupt.
+Correction active;
+bool have_active = false;
+
+// Accepted fits from AddSample() on core0, for Store() on core1. A sector
+// erase stalls both cores for tens of ms, too long for the magnetometer
+// task's deadline, so no flash work happens on core0.
+struct Fitted {
+    Correction correction;
+    float radius_counts;
+    float residual_pct;
+};
+utils::SpscRing<Fitted, 2> fitted;
+
+// Core1 only, after Load().
+Correction stored;
+bool have_stored = false;
+uint32_t stored_sequence = 0;
+int stored_slot = -1;
+
+// Normal equations of the fit (upper triangle of D'D, and D'1).
+double normal[kParams][kParams];
+double rhs[kParams];
+uint32_t samples = 0;
+int16_t last[3];
+int16_t low[3];
+int16_t high[3];
+
+Status status = {};
+
+uint16_t RecordCrc(Record record) {
+    record.crc = 0;
+    return utils::Crc16(reinterpret_cast<const uint8_t *>(&record), sizeof(record));
+}
+
+bool ReadSlot(uint32_t slot, Record &record) {
+    hal::FlashRead(app::config::FLASH_CALIBRATION_OFFSET + slot * hal::kFlashPageBytes, &record, sizeof(record));
+    return record.magic == kMagic && record.version == kVersion && record.crc == RecordCrc(record);
+}
+
+bool SlotErased(uint32_t slot) {
+    uint8_t page[hal::kFlashPageBytes];
+    hal::FlashRead(app::config::FLASH_CALIBRATION_OFFSET + slot * hal::kFlashPageBytes, page, sizeof(page));
+    for (uint8_t byte : page) {
+        if (byte != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SetActive(const Correction &correction) {
+    const uint32_t state = hal::CriticalEnter();
+    active = correction;
+    have_active = true;
+    hal::CriticalExit(state);
+    status.calibrated = true;
+}
+
+// Appends to the next free page, erasing the sector once it is full. A
+// power cut between that erase and the program loses the stored
+// calibration; the next rotation finds it again.
+bool Save(const Correction &correction, float radius_counts, float residual_pct) {
+    uint32_t slot = stored_slot < 0 ? 0 : static_cast<uint32_t>(stored_slot) + 1;
+    if (slot >= kSlots || !SlotErased(slot)) {
+        if (!hal::FlashErase(app::config::FLASH_CALIBRATION_OFFSET, hal::kFlashSectorBytes)) {
+            return false;
+        }
+        slot = 0;
+    }
+
+    static uint8_t page[hal::kFlashPageBytes];
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.magic = kMagic;
+    record.sequence = stored_sequence + 1;
+    record.version = kVersion;
+    record.correction = correction;
+    record.radius_counts = radius_counts;
+    record.residual_pct = residual_pct;
+    record.crc = RecordCrc(record);
+    std::memset(page, 0xFF, sizeof(page));
+    std::memcpy(page, &record, sizeof(record));
+    if (!hal::FlashProgram(app::config::FLASH_CALIBRATION_OFFSET + slot * hal::kFlashPageBytes, page,
+                           sizeof(page))) {
+        return false;
+    }
+
+    stored = correction;
+    have_stored = true;
+    stored_sequence = record.sequence;
+    stored_slot = static_cast<int>(slot);
+    ++status.saves;
+    return true;
+}
+
+bool Differs(const Correction &a, const Correction &b) {
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(a.offset[i] - b.offset[i]) > kSaveOffsetCounts) {
+            return true;
+        }
+    }
+    for (int i = 0; i < 9; ++i) {
+        if (std::abs(a.matrix[i] - b.matrix[i]) > kSaveMatrixQ14) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StartCollection() {
+    std::memset(normal, 0, sizeof(normal));
+    std::memset(rhs, 0, sizeof(rhs));
+    samples = 0;
+    status.samples = 0;
+}
+
+// Solves the symmetric positive-definite system in place by Cholesky;
+// false if it is singular, i.e. the samples do not pin down every term.
+bool Solve(double a[kParams][kParams], double b[kParams], double x[kParams]) {
+    for (int j = 0; j < kParams; ++j) {
+        double diagonal = a[j][j];
+        for (int k = 0; k < j; ++k) {
+            diagonal -= a[j][k] * a[j][k];
+        }
+        if (diagonal <= 1e-12 * a[j][j] || diagonal <= 0.0) {
+            return false;
+        }
+        a[j][j] = std::sqrt(diagonal);
+        for (int i = j + 1; i < kParams; ++i) {
+            double sum = a[i][j];
+            for (int k = 0; k < j; ++k) {
+                sum -= a[i][k] * a[j][k];
+            }
+            a[i][j] = sum / a[j][j];
+        }
+    }
+    for (int i = 0; i < kParams; ++i) {
+        double sum = b[i];
+        for (int k = 0; k < i; ++k) {
+            sum -= a[i][k] * x[k];
+        }
+        x[i] = sum / a[i][i];
+    }
+    for (int i = kParams - 1; i >= 0; --i) {
+        double sum = x[i];
+        for (int k = i + 1; k < kParams; ++k) {
+            sum -= a[k][i] * x[k];
+        }
+        x[i] = sum / a[i][i];
+    }
+    return true;
+}
+
+// Cyclic Jacobi: a becomes diagonal (the eigenvalues), v's columns the
+// eigenvectors.
+void Eigen(double a[3][3], double v[3][3]) {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            v[i][j] = i == j ? 1.0 : 0.0;
+        }
+    }
+    static const int kPairs[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    for (int sweep = 0; sweep < 16; ++sweep) {
+        if (a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2] < 1e-24) {
+            return;
+        }
+        for (const auto &pair : kPairs) {
+            const int p = pair[0];
+            const int q = pair[1];
+            if (a[p][q] == 0.0) {
+                continue;
+            }
+            const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+            const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+            const double c = 1.0 / std::sqrt(t * t + 1.0);
+            const double s = t * c;
+            for (int k = 0; k < 3; ++k) {
+                const double kp = a[k][p];
+                const double kq = a[k][q];
+                a[k][p] = c * kp - s * kq;
+                a[k][q] = s * kp + c * kq;
+            }
+            for (int k = 0; k < 3; ++k) {
+                const double pk = a[p][k];
+                const double qk = a[q][k];
+                a[p][k] = c * pk - s * qk;
+                a[q][k] = s * pk + c * qk;
+            }
+            for (int k = 0; k < 3; ++k) {
+                const double kp = v[k][p];
+                const double kq = v[k][q];
+                v[k][p] = c * kp - s * kq;
+                v[k][q] = s * kp + c * kq;
+            }
+        }
+    }
+}
+
+// Fits x'Mx + 2v'x = 1 to the samples, recentres it as
+// (x - c)'A(x - c) = 1 and takes the correction as R * sqrt(A), R the
+// geometric mean radius. False if the fit fails a check.
+bool Fit(Correction &correction, float &radius_counts, float &residual_pct) {
+    double a[kParams][kParams];
+    double b[kParams];
+    double p[kParams];
+    for (int i = 0; i < kParams; ++i) {
+        for (int j = 0; j < kParams; ++j) {
+            a[i][j] = i <= j ? normal[i][j] : normal[j][i];
+        }
+        b[i] = rhs[i];
+    }
+    if (!Solve(a, b, p)) {
+        return false;
+    }
+
+    // Misfit of the algebraic equation, from the accumulated sums.
+    double sse = static_cast<double>(samples);
+    for (int i = 0; i < kParams; ++i) {
+        sse -= 2.0 * p[i] * rhs[i];
+        for (int j = 0; j < kParams; ++j) {
+            sse += p[i] * p[j] * (i <= j ? normal[i][j] : normal[j][i]);
+        }
+    }
+
+    const double m[3][3] = {{p[0], p[3], p[4]}, {p[3], p[1], p[5]}, {p[4], p[5], p[2]}};
+    const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                       m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                       m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (det <= 0.0) {
+        return false;
+    }
+    const double inverse[3][3] = {
+        {(m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det, (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det,
+         (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det},
+        {(m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det, (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det,
+         (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det},
+        {(m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det, (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det,
+         (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det},
+    };
+    double centre[3];
+    double k = 1.0;
+    for (int i = 0; i < 3; ++i) {
+        centre[i] = -(inverse[i][0] * p[6] + inverse[i][1] * p[7] + inverse[i][2] * p[8]);
+        k -= p[6 + i] * centre[i];
+    }
+    if (k <= 0.0) {
+        return false;
+    }
+
+    double shape[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            shape[i][j] = m[i][j] / k;
+        }
+    }
+    double axes[3][3];
+    Eigen(shape, axes);
+    double radius[3];
+    for (int i = 0; i < 3; ++i) {
+        if (shape[i][i] <= 0.0) {
+            return false;
+        }
+        radius[i] = 1.0 / std::sqrt(shape[i][i]);
+    }
+    const double mean_radius = std::cbrt(radius[0] * radius[1] * radius[2]);
+    const double smallest = std::fmin(radius[0], std::fmin(radius[1], radius[2]));
+    const double largest = std::fmax(radius[0], std::fmax(radius[1], radius[2]));
+    const double mean_counts = mean_radius * kUnitCounts;
+    const double field_ut = mean_counts * kUtPerLsb;
+    if (largest > kMaxAxisRatio * smallest || field_ut < kMinFieldUt || field_ut > kMaxFieldUt) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (high[i] - low[i] < kMinSpanRadii * mean_counts || std::fabs(centre[i] * kUnitCounts) > 30000.0) {
+            return false;
+        }
+    }
+    // Near the surface the equation's error is 2k times the relative
+    // radial error.
+    const double residual = 100.0 * std::sqrt(std::fmax(sse, 0.0) / samples) / (2.0 * k);
+    if (residual > kMaxResidualPct) {
+        return false;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        correction.offset[i] = static_cast<int16_t>(std::lround(centre[i] * kUnitCounts));
+        for (int j = 0; j < 3; ++j) {
+            double w = 0.0;
+            for (int e = 0; e < 3; ++e) {
+                w += axes[i][e] * (mean_radius / radius[e]) * axes[j][e];
+            }
+            correction.matrix[3 * i + j] = static_cast<int32_t>(std::lround(w * kOneQ14));
+        }
+    }
+    radius_counts = static_cast<float>(mean_counts);
+    residual_pct = static_cast<float>(residual);
+    return true;
+}
+
+}  // namespace
+
+void Load() {
+    Record newest{};
+    bool found = false;
+    for (uint32_t slot = 0; slot < kSlots; ++slot) {
+        Record record;
+        if (ReadSlot(slot, record) && (!found || record.sequence > newest.sequence)) {
+            newest = record;
+            stored_slot = static_cast<int>(slot);
+            found = true;
+        }
+    }
+    StartCollection();
+    if (!found) {
+        return;
+    }
+    stored = newest.correction;
+    have_stored = true;
+    stored_sequence = newest.sequence;
+    status.radius_counts = newest.radius_counts;
+    status.residual_pct = newest.residual_pct;
+    SetActive(stored);
+}
+
+bool Apply(int16_t &x, int16_t &y, int16_t &z) {
+    if (!have_active) {
+        return false;
+    }
+    const int32_t d[3] = {x - active.offset[0], y - active.offset[1], z - active.offset[2]};
+    int16_t *out[3] = {&x, &y, &z};
+    for (int i = 0; i < 3; ++i) {
+        const int32_t *row = &active.matrix[3 * i];
+        int64_t sum = static_cast<int64_t>(row[0]) * d[0] + static_cast<int64_t>(row[1]) * d[1] +
+                      static_cast<int64_t>(row[2]) * d[2];
+        sum = (sum + kOneQ14 / 2) >> 14;
+        *out[i] = static_cast<int16_t>(sum > 32767 ? 32767 : sum < -32768 ? -32768 : sum);
+    }
+    return true;
+}
+
+void AddSample(const int16_t raw[3]) {
+    if (!app::config::MAG_ONLINE_CALIBRATION) {
+        return;
+    }
+    if (samples > 0) {
+        int32_t step = 0;
+        for (int i = 0; i < 3; ++i) {
+            const int32_t d = raw[i] - last[i];
+            step += d * d;
+        }
+        if (step < kMinStepCounts * kMinStepCounts) {
+            return;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        last[i] = raw[i];
+        low[i] = samples == 0 || raw[i] < low[i] ? raw[i] : low[i];
+        high[i] = samples == 0 || raw[i] > high[i] ? raw[i] : high[i];
+    }
+
+    const double x = raw[0] / kUnitCounts;
+    const double y = raw[1] / kUnitCounts;
+    const double z = raw[2] / kUnitCounts;
+    const double d[kParams] = {x * x, y * y, z * z, 2 * x * y, 2 * x * z, 2 * y * z, 2 * x, 2 * y, 2 * z};
+    for (int i = 0; i < kParams; ++i) {
+        for (int j = i; j < kParams; ++j) {
+            normal[i][j] += d[i] * d[j];
+        }
+        rhs[i] += d[i];
+    }
+    status.samples = ++samples;
+
+    if (samples < kMinSamples || samples % kFitEvery != 0) {
+        return;
+    }
+    ++status.fits;
+    Correction correction;
+    float radius_counts = 0.0f;
+    float residual_pct = 0.0f;
+    if (!Fit(correction, radius_counts, residual_pct)) {
+        ++status.rejected;
+        if (samples >= kMaxSamples) {
+            StartCollection();
+        }
+        return;
+    }
+
+    status.radius_counts = radius_counts;
+    status.residual_pct = residual_pct;
+    SetActive(correction);
+    // Dropped if core1 has two waiting; the next fit is queued instead.
+    fitted.Push(Fitted{correction, radius_counts, residual_pct});
+    hal::SignalEvent();
+    StartCollection();
+}
+
+void Store() {
+    Fitted fit;
+    while (fitted.Pop(fit)) {
+        if (!have_stored || Differs(fit.correction, stored)) {
+            Save(fit.correction, fit.radius_counts, fit.residual_pct);
+        }
+    }
+}
+
+static_assert(sizeof(State::normal) == sizeof(normal) && sizeof(State::rhs) == sizeof(rhs), "fit size mismatch");
+
+void GetState(State &state) {
+    state.active = active;
+    state.have_active = have_active;
+    state.samples = samples;
+    std::memcpy(state.last, last, sizeof(last));
+    std::memcpy(state.low, low, sizeof(low));
+    std::memcpy(state.high, high, sizeof(high));
+    std::memcpy(state.normal, normal, sizeof(normal));
+    std::memcpy(state.rhs, rhs, sizeof(rhs));
+}
+
+void SetState(const State &state) {
+    if (state.have_active) {
+        SetActive(state.active);
+    }
+    samples = state.samples;
+    status.samples = samples;
+    std::memcpy(last, state.last, sizeof(last));
+    std::memcpy(low, state.low, sizeof(low));
+    std::memcpy(high, state.high, sizeof(high));
+    std::memcpy(normal, state.normal, sizeof(normal));
+    std::memcpy(rhs, state.rhs, sizeof(rhs));
+}
+
+const Status &GetStatus() {
+    return status;
+}
+
+}  // namespace mag_calibration
+}  // namespace sensors
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+// Hard- and soft-iron calibration of the HSCDTD008A. Metal and magnets on
+// the board add a fixed field (hard iron) and distort the Earth's field by
+// direction (soft iron), so as the unit turns its readings trace an offset,
+// tilted ellipsoid instead of a sphere about zero. The correction
+//
+//   corrected = matrix * (raw - offset)
+//
+// maps that ellipsoid back onto a sphere of the same mean radius, in counts.
+// The matrix is symmetric, Q14, so applying it costs nine integer
+// multiplies per reading.
+//
+// The fit runs online: samples that differ enough from the last one kept
+// feed the normal equations of a 9-parameter least-squares ellipsoid fit,
+// and once they cover every axis the fit is solved, checked and, if it
+// holds, applied at once and handed to core1, which appends it to the
+// calibration sector in flash if it differs from the stored one. A unit
+// that only ever turns about one axis cannot be calibrated; turn it
+// through every orientation once after mounting.
+namespace sensors {
+namespace mag_calibration {
+
+struct Correction {
+    int16_t offset[3];   // counts
+    int32_t matrix[9];   // row-major, Q14
+};
+
+struct Status {
+    bool calibrated;         // a correction is applied
+    uint32_t samples;        // accepted into the current fit
+    uint32_t fits;           // fits attempted
+    uint32_t rejected;       // ... of which failed the checks
+    uint32_t saves;          // records written to flash since boot, by core1
+    float radius_counts;     // of the last accepted fit
+    float residual_pct;      // RMS misfit of the last accepted fit
+};
+
+// What a watchdog reset would lose: the correction applied and the fit
+// in progress. The supervisor keeps it in retained RAM.
+struct State {
+    Correction active;
+    bool have_active;
+    uint32_t samples;
+    int16_t last[3];
+    int16_t low[3];
+    int16_t high[3];
+    double normal[9][9];
+    double rhs[9];
+};
+
+// Boot: loads the newest valid record from the calibration sector, or
+// leaves readings uncorrected if there is none.
+void Load();
+
+// Corrects one reading in place; false (and untouched) while there is no
+// correction. Safe in interrupt context.
+bool Apply(int16_t &x, int16_t &y, int16_t &z);
+
+// Core0, task context: one raw reading for the online fit. May solve a
+// fit, which takes a few ms, but never writes flash.
+void AddSample(const int16_t raw[3]);
+
+// Core1: stores the fits AddSample() accepted since the last call.
+void Store();
+
+// Task context, like AddSample(). SetState() follows Load() on a warm
+// boot and replaces what it applied.
+void GetState(State &state);
+void SetState(const State &state);
+
+const Status &GetStatus();
+
+}  // namespace mag_calibration
+}  // namespace sensors
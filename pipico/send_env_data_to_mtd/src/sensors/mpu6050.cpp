@@ -1,50 +1,387 @@
 #include "sensors/mpu6050.h"
 
-#include "hardware/i2c.h"
-#include "pico/time.h"
+#include <cmath>
+
+#include "hal/hal.h"
 
 namespace sensors {
 namespace mpu6050 {
 
 namespace {
+constexpr uint8_t SMPLRT_DIV = 0x19;
+constexpr uint8_t CONFIG = 0x1A;
+constexpr uint8_t FIFO_EN = 0x23;
+constexpr uint8_t INT_ENABLE = 0x38;
+constexpr uint8_t INT_STATUS = 0x3A;
+constexpr uint8_t USER_CTRL = 0x6A;
 constexpr uint8_t PWR_MGMT_1 = 0x6B;
-constexpr uint8_t ACCEL_XOUT_H = 0x3B;
+constexpr uint8_t FIFO_COUNTH = 0x72;
+constexpr uint8_t FIFO_R_W = 0x74;
+constexpr uint8_t DATA_RDY = 0x01;
+constexpr uint8_t FIFO_EN_TEMP_GYRO_ACCEL = 0xF8;  // TEMP, XG, YG, ZG, ACCEL
+constexpr uint8_t USER_CTRL_FIFO_EN = 0x40;
+constexpr uint8_t USER_CTRL_FIFO_RESET = 0x04;
+// Two polls inside the IMU task's deadline, so a stuck read fails here and
+// marks the data invalid before the scheduler abandons the job.
+constexpr uint64_t kTimeoutUs = app::config::IMU_DEADLINE_US - 2 * kCollectPollUs;
+static_assert(app::config::IMU_DEADLINE_US > 2 * kCollectPollUs, "IMU_DEADLINE_US too short to time reads out");
+
+// With TEMP, gyro and accel enabled the FIFO holds samples in register
+// order, ACCEL_XOUT_H..GYRO_ZOUT_L, the same 14 bytes as a direct read.
+constexpr std::size_t kSampleBytes = 14;
+constexpr std::size_t kFifoBytes = 1024;
+// Samples per FIFO read; bounds how long one transfer holds the bus.
+constexpr std::size_t kBurstSamples = 8;
+constexpr uint32_t kGyroRateHz = 1000;  // with the DLPF enabled
+constexpr uint32_t kDecimation = app::config::MPU6050_SAMPLE_RATE_HZ / app::config::MPU6050_OUTPUT_RATE_HZ;
+
+static_assert(app::config::MPU6050_DLPF_CFG >= 1 && app::config::MPU6050_DLPF_CFG <= 6,
+              "DLPF_CFG 0 and 7 change the gyro output rate to 8 kHz");
+static_assert(kGyroRateHz % app::config::MPU6050_SAMPLE_RATE_HZ == 0 &&
+              kGyroRateHz / app::config::MPU6050_SAMPLE_RATE_HZ <= 256,
+              "MPU6050_SAMPLE_RATE_HZ must be 1 kHz / (SMPLRT_DIV + 1)");
+static_assert(kDecimation >= 1 && app::config::MPU6050_SAMPLE_RATE_HZ % app::config::MPU6050_OUTPUT_RATE_HZ == 0,
+              "MPU6050_OUTPUT_RATE_HZ must divide MPU6050_SAMPLE_RATE_HZ");
+
+int16_t Be16(const uint8_t *raw) {
+    return static_cast<int16_t>((raw[0] << 8) | raw[1]);
 }
 
-void Init() {
-    uint8_t payload[2] = {PWR_MGMT_1, 0x00};
-    i2c_write_blocking(app::config::I2C_PORT, app::config::MPU6050_ADDR, payload, 2, false);
-    sleep_ms(100);
+float TemperatureC(int16_t raw) {
+    return static_cast<float>(raw) / 340.0f + 36.53f;
 }
 
-bool Read(app::model::Mpu6050Data &data) {
-    uint8_t reg = ACCEL_XOUT_H;
-    uint8_t raw[14];
+// Runs in the I2C completion interrupt. raw[0] is INT_STATUS, followed by
+// the 14 sample bytes from ACCEL_XOUT_H.
+Status Decode(const uint8_t *raw, app::model::Mpu6050Data &data) {
+    if (!(raw[0] & DATA_RDY)) {
+        return Status::kPending;
+    }
 
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::MPU6050_ADDR, &reg, 1, true) != 1) {
-        data.valid = false;
-        return false;
+    const uint8_t *sample = raw + 1;
+    data.accel_x = Be16(sample);
+    data.accel_y = Be16(sample + 2);
+    data.accel_z = Be16(sample + 4);
+    data.temperature_c = TemperatureC(Be16(sample + 6));
+    data.gyro_x = Be16(sample + 8);
+    data.gyro_y = Be16(sample + 10);
+    data.gyro_z = Be16(sample + 12);
+
+    data.valid = true;
+    return Status::kReady;
+}
+
+// Reading INT_STATUS clears DATA_RDY.
+QueuedRead<app::model::Mpu6050Data, 15> sample(app::config::MPU6050_ADDR, INT_STATUS, Decode);
+
+bool started = false;
+uint64_t started_us = 0;
+OutputFn output_handler = nullptr;
+
+Status Fail(app::model::Mpu6050Data &data) {
+    started = false;
+    data.valid = false;
+    return Status::kError;
+}
+
+// FIFO mode ------------------------------------------------------------------
+//
+// Start() reads FIFO_COUNT; Collect() then reads the whole samples it
+// reported in bursts of at most kBurstSamples and folds each one into the
+// decimator and the window. A single read per drain cannot tear a sample:
+// the FIFO only ever grows by whole samples, so a count that is not a
+// multiple of 14 means it overflowed and dropped bytes, and is reset.
+
+// Channel order of a FIFO sample: accel x/y/z, temperature, gyro x/y/z.
+constexpr int kChannels = 7;
+constexpr int kTempChannel = 3;
+
+// Boxcar average over kDecimation samples (a first-order CIC). The DLPF
+// already band-limits below the output Nyquist rate; the average takes out
+// what is left between the two and the sample noise.
+struct Decimator {
+    int32_t sum[kChannels] = {};
+    uint32_t count = 0;
+};
+
+struct AxisAccumulator {
+    int16_t min = 0;
+    int16_t max = 0;
+    int64_t sum = 0;
+    int64_t sum_squares = 0;  // at most n * 2^30
+};
+
+// The window runs from one publish to the next and takes every sample, not
+// just the decimated outputs; sum_squares stays exact below 2^33 of them.
+constexpr uint64_t kMaxWindowSamples =
+    uint64_t{app::config::MPU6050_SAMPLE_RATE_HZ} * app::config::TELEMETRY_PERIOD_US / (1000 * 1000) + 1;
+static_assert(kMaxWindowSamples < (uint64_t{1} << 33), "IMU statistics window too long for its 64-bit sums");
+
+struct Window {
+    uint32_t samples = 0;
+    AxisAccumulator axes[6];  // accel x/y/z, gyro x/y/z
+};
+
+const uint8_t kFifoCountReg = FIFO_COUNTH;
+const uint8_t kFifoDataReg = FIFO_R_W;
+const uint8_t kFifoReset[2] = {USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_FIFO_RESET};
+uint8_t count_raw[2] = {};
+uint8_t burst_raw[kBurstSamples * kSampleBytes] = {};
+
+// Set once a FIFO reset has actually gone through; StartFifo() queues one
+// whenever it is clear.
+volatile bool fifo_running = false;
+
+// Runs in the I2C completion interrupt.
+void OnFifoReset(i2c::Transaction &transaction) {
+    fifo_running = transaction.result == static_cast<int>(transaction.tx_len);
+}
+
+i2c::Transaction count_read(app::config::MPU6050_ADDR, &kFifoCountReg, 1, count_raw, 2);
+i2c::Transaction burst_read(app::config::MPU6050_ADDR, &kFifoDataReg, 1, burst_raw, 0);
+i2c::Transaction fifo_reset(app::config::MPU6050_ADDR, kFifoReset, 2, nullptr, 0, OnFifoReset);
+
+enum class Phase { kCount, kBurst };
+Phase phase = Phase::kCount;
+std::size_t samples_left = 0;
+std::size_t burst_samples = 0;
+Decimator decimator;
+Window window;
+uint16_t fifo_overflows = 0;
+bool output_valid = false;
+int16_t output[kChannels] = {};
+
+// Rounds half away from zero, like the hardware's own averaging.
+int16_t Average(int32_t sum, uint32_t count) {
+    const int32_t half = static_cast<int32_t>(count / 2);
+    return static_cast<int16_t>((sum >= 0 ? sum + half : sum - half) / static_cast<int32_t>(count));
+}
+
+void Accumulate(AxisAccumulator &axis, int16_t value, bool first) {
+    if (first || value < axis.min) {
+        axis.min = value;
+    }
+    if (first || value > axis.max) {
+        axis.max = value;
     }
+    axis.sum += value;
+    axis.sum_squares += static_cast<int64_t>(value) * value;
+}
+
+void AddSample(const uint8_t *raw) {
+    int16_t channel[kChannels];
+    for (int i = 0; i < kChannels; ++i) {
+        channel[i] = Be16(raw + 2 * i);
+    }
+
+    const bool first = window.samples == 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        Accumulate(window.axes[axis], channel[axis], first);
+        Accumulate(window.axes[3 + axis], channel[kTempChannel + 1 + axis], first);
+    }
+    ++window.samples;
+
+    for (int i = 0; i < kChannels; ++i) {
+        decimator.sum[i] += channel[i];
+    }
+    if (++decimator.count == kDecimation) {
+        for (int i = 0; i < kChannels; ++i) {
+            output[i] = Average(decimator.sum[i], kDecimation);
+            decimator.sum[i] = 0;
+        }
+        decimator.count = 0;
+        output_valid = true;
+        if (output_handler != nullptr) {
+            const int16_t accel[3] = {output[0], output[1], output[2]};
+            const int16_t gyro[3] = {output[4], output[5], output[6]};
+            output_handler(accel, gyro);
+        }
+    }
+}
+
+app::model::AxisWindow Summarise(const AxisAccumulator &axis, uint32_t samples) {
+    app::model::AxisWindow summary;
+    summary.min = axis.min;
+    summary.max = axis.max;
+    if (samples > 0) {
+        // n * sum_squares would pass 64 bits within minutes at 1 kHz, so the
+        // variance is taken in double, as telemetry::aggregate does.
+        const double mean = static_cast<double>(axis.sum) / samples;
+        const double variance = static_cast<double>(axis.sum_squares) / samples - mean * mean;
+        const long rms = std::lround(variance > 0.0 ? std::sqrt(variance) : 0.0);
+        summary.rms = static_cast<uint16_t>(rms > 0xFFFF ? 0xFFFF : rms);
+    }
+    return summary;
+}
 
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::MPU6050_ADDR, raw, 14, false) != 14) {
-        data.valid = false;
+void Publish(app::model::Mpu6050Data &data) {
+    data.accel_x = output[0];
+    data.accel_y = output[1];
+    data.accel_z = output[2];
+    data.temperature_c = TemperatureC(output[kTempChannel]);
+    data.gyro_x = output[4];
+    data.gyro_y = output[5];
+    data.gyro_z = output[6];
+    data.window_samples = window.samples;
+    data.fifo_overflows = fifo_overflows;
+    for (int axis = 0; axis < 3; ++axis) {
+        data.accel_window[axis] = Summarise(window.axes[axis], window.samples);
+        data.gyro_window[axis] = Summarise(window.axes[3 + axis], window.samples);
+    }
+    data.valid = output_valid;
+}
+
+bool SubmitBurst() {
+    burst_samples = samples_left < kBurstSamples ? samples_left : kBurstSamples;
+    burst_read.rx_len = burst_samples * kSampleBytes;
+    return i2c::Submit(burst_read);
+}
+
+bool StartFifo() {
+    if (count_read.pending || burst_read.pending) {
+        started = false;
         return false;
     }
+    // Empty the FIFO on the first drain rather than in Init(), so the boot
+    // delay before the scheduler starts does not overflow it, and again
+    // after a reset that failed. The count read queues behind it.
+    if (!fifo_running && !fifo_reset.pending && !i2c::Submit(fifo_reset)) {
+        started = false;
+        return false;
+    }
+    phase = Phase::kCount;
+    if (!i2c::Submit(count_read)) {
+        started = false;
+        return false;
+    }
+    started = true;
+    started_us = hal::TimeUs();
+    return true;
+}
 
-    data.accel_x = (raw[0] << 8) | raw[1];
-    data.accel_y = (raw[2] << 8) | raw[3];
-    data.accel_z = (raw[4] << 8) | raw[5];
+// Reports the drained samples, or, before the decimator has produced its
+// first output, goes back for more.
+Status Finish(app::model::Mpu6050Data &data) {
+    if (!output_valid) {
+        if (hal::TimeUs() - started_us >= kTimeoutUs) {
+            return Fail(data);
+        }
+        phase = Phase::kCount;
+        return i2c::Submit(count_read) ? Status::kPending : Fail(data);
+    }
+    started = false;
+    Publish(data);
+    return Status::kReady;
+}
 
-    const int16_t temp_raw = (raw[6] << 8) | raw[7];
-    data.temperature_c = static_cast<float>(temp_raw) / 340.0f + 36.53f;
+Status CollectFifo(app::model::Mpu6050Data &data) {
+    if (!started) {
+        return Fail(data);
+    }
+    i2c::Transaction &current = phase == Phase::kCount ? count_read : burst_read;
+    if (current.pending) {
+        return hal::TimeUs() - started_us < kTimeoutUs ? Status::kPending : Fail(data);
+    }
 
-    data.gyro_x = (raw[8] << 8) | raw[9];
-    data.gyro_y = (raw[10] << 8) | raw[11];
-    data.gyro_z = (raw[12] << 8) | raw[13];
+    if (phase == Phase::kCount) {
+        if (count_read.result != 2) {
+            return Fail(data);
+        }
+        const std::size_t count = static_cast<std::size_t>(count_raw[0] << 8 | count_raw[1]);
+        if (count > kFifoBytes - kSampleBytes || count % kSampleBytes != 0) {
+            // Full or torn: samples were lost. Start over from an empty FIFO
+            // and report the decimated output as it stands.
+            ++fifo_overflows;
+            decimator = Decimator();
+            fifo_running = false;
+            if (!fifo_reset.pending && !i2c::Submit(fifo_reset)) {
+                return Fail(data);
+            }
+            samples_left = 0;
+        } else {
+            samples_left = count / kSampleBytes;
+        }
+        if (samples_left == 0) {
+            return Finish(data);
+        }
+        phase = Phase::kBurst;
+        return SubmitBurst() ? Status::kPending : Fail(data);
+    }
 
-    data.valid = true;
+    if (burst_read.result != static_cast<int>(burst_read.rx_len)) {
+        return Fail(data);
+    }
+    for (std::size_t i = 0; i < burst_samples; ++i) {
+        AddSample(burst_raw + i * kSampleBytes);
+    }
+    samples_left -= burst_samples;
+    if (samples_left > 0) {
+        return SubmitBurst() ? Status::kPending : Fail(data);
+    }
+    return Finish(data);
+}
+
+}  // namespace
+
+void Init() {
+    uint8_t payload[2] = {PWR_MGMT_1, 0x00};
+    i2c::Transfer(app::config::MPU6050_ADDR, payload, 2, nullptr, 0);
+    hal::SleepMs(100);
+
+    if (app::config::MPU6050_FIFO) {
+        uint8_t rate[3] = {SMPLRT_DIV, static_cast<uint8_t>(kGyroRateHz / app::config::MPU6050_SAMPLE_RATE_HZ - 1),
+                           app::config::MPU6050_DLPF_CFG};  // CONFIG follows SMPLRT_DIV
+        i2c::Transfer(app::config::MPU6050_ADDR, rate, 3, nullptr, 0);
+        uint8_t fifo_en[2] = {FIFO_EN, FIFO_EN_TEMP_GYRO_ACCEL};
+        i2c::Transfer(app::config::MPU6050_ADDR, fifo_en, 2, nullptr, 0);
+        return;
+    }
+
+    // DATA_RDY only latches in INT_STATUS while its interrupt is enabled.
+    uint8_t int_enable[2] = {INT_ENABLE, DATA_RDY};
+    i2c::Transfer(app::config::MPU6050_ADDR, int_enable, 2, nullptr, 0);
+}
+
+bool Start() {
+    if (app::config::MPU6050_FIFO) {
+        return StartFifo();
+    }
+    sample.Reset();
+    started = true;
+    started_us = hal::TimeUs();
     return true;
 }
 
+Status Collect(app::model::Mpu6050Data &data) {
+    if (app::config::MPU6050_FIFO) {
+        return CollectFifo(data);
+    }
+    if (!started) {
+        return Fail(data);
+    }
+
+    const Status status = sample.Poll(data, started_us, started_us + kTimeoutUs);
+    if (status == Status::kError) {
+        return Fail(data);
+    }
+    if (status == Status::kReady) {
+        started = false;
+        if (output_handler != nullptr) {
+            const int16_t accel[3] = {data.accel_x, data.accel_y, data.accel_z};
+            const int16_t gyro[3] = {data.gyro_x, data.gyro_y, data.gyro_z};
+            output_handler(accel, gyro);
+        }
+    }
+    return status;
+}
+
+void SetOutputHandler(OutputFn handler) {
+    output_handler = handler;
+}
+
+void ResetWindow() {
+    window = Window();
+}
+
 }  // namespace mpu6050
 }  // namespace sensors
@@ -2,12 +2,29 @@
 
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "sensors/conversion.h"
 
 namespace sensors {
 namespace mpu6050 {
 
 void Init();
-bool Read(app::model::Mpu6050Data &data);
+
+// Two-phase API. The MPU6050 samples continuously, so Start() has nothing to
+// trigger; Collect() reports kPending until INT_STATUS flags a fresh sample.
+// With app::config::MPU6050_FIFO, Start() queues a FIFO_COUNT read instead
+// and Collect() drains every buffered sample before reporting kReady.
+bool Start();
+Status Collect(app::model::Mpu6050Data &data);
+
+// Called from Collect() with every decimated output (FIFO mode) or every
+// sample, in task context, so consumers such as the ahrs stage see the full
+// output rate rather than one value per IMU task run.
+using OutputFn = void (*)(const int16_t accel[3], const int16_t gyro[3]);
+void SetOutputHandler(OutputFn handler);
+
+// FIFO mode: start a new min/max/RMS window. The next Collect() reports
+// statistics over the samples drained from then on.
+void ResetWindow();
 
 }  // namespace mpu6050
 }  // namespace sensors
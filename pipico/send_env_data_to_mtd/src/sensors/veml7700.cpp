@@ -1,7 +1,6 @@
 #include "sensors/veml7700.h"
 
-#include "hardware/i2c.h"
-#include "pico/time.h"
+#include "hal/hal.h"
 
 namespace sensors {
 namespace veml7700 {
@@ -9,35 +8,46 @@ namespace veml7700 {
 namespace {
 constexpr uint8_t ALS_CONF = 0x00;
 constexpr uint8_t ALS_DATA = 0x04;
+// Gain x1, 100 ms integration (ALS_CONF = 0x0000): first result after power-on
+// is available one integration plus the 2.5 ms wake-up later.
+constexpr uint64_t kFirstResultUs = 103 * 1000;
+
+uint64_t powered_on_us = 0;
+
+// Runs in the I2C completion interrupt.
+Status Decode(const uint8_t *raw, app::model::Veml7700Data &data) {
+    const uint16_t raw_value = (raw[1] << 8) | raw[0];
+    data.lux = static_cast<float>(raw_value) * 0.0576f;
+    data.valid = true;
+    return Status::kReady;
 }
 
+QueuedRead<app::model::Veml7700Data, 2> sample(app::config::VEML7700_ADDR, ALS_DATA, Decode);
+
+}  // namespace
+
 void Init() {
     uint8_t payload[3];
     payload[0] = ALS_CONF;
     payload[1] = 0x00;
     payload[2] = 0x00;
-    i2c_write_blocking(app::config::I2C_PORT, app::config::VEML7700_ADDR, payload, 3, false);
-    sleep_ms(100);
+    i2c::Transfer(app::config::VEML7700_ADDR, payload, 3, nullptr, 0);
+    powered_on_us = hal::TimeUs();
 }
 
-bool Read(app::model::Veml7700Data &data) {
-    uint8_t reg = ALS_DATA;
-    uint8_t raw[2];
-
-    if (i2c_write_blocking(app::config::I2C_PORT, app::config::VEML7700_ADDR, &reg, 1, true) != 1) {
-        data.valid = false;
-        return false;
-    }
+bool Start() {
+    sample.Reset();
+    return true;
+}
 
-    if (i2c_read_blocking(app::config::I2C_PORT, app::config::VEML7700_ADDR, raw, 2, false) != 2) {
+// The sensor integrates continuously, so only the very first result after
+// power-on has to be waited for.
+Status Collect(app::model::Veml7700Data &data) {
+    const Status status = sample.Poll(data, powered_on_us + kFirstResultUs, UINT64_MAX);
+    if (status == Status::kError) {
         data.valid = false;
-        return false;
     }
-
-    const uint16_t raw_value = (raw[1] << 8) | raw[0];
-    data.lux = static_cast<float>(raw_value) * 0.0576f;
-    data.valid = true;
-    return true;
+    return status;
 }
 
 }  // namespace veml7700
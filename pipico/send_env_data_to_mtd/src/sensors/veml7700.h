@@ -2,12 +2,18 @@
 
 #include "app/app_config.h"
 #include "app/measurement_types.h"
+#include "sensors/conversion.h"
 
 namespace sensors {
 namespace veml7700 {
 
 void Init();
-bool Read(app::model::Veml7700Data &data);
+
+// Two-phase API. The VEML7700 integrates continuously and has no data-ready
+// flag; the ALS register always holds the last completed integration, so
+// Collect() is ready as soon as the first integration after Init() is done.
+bool Start();
+Status Collect(app::model::Veml7700Data &data);
 
 }  // namespace veml7700
 }  // namespace sensors
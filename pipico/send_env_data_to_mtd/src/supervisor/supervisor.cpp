@@ -0,0 +1,174 @@
+#include "supervisor/supervisor.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "hal/hal.h"
+#include "sensors/mag_calibration.h"
+#include "telemetry/telemetry.h"
+#include "utils/crc16.h"
+
+namespace supervisor {
+
+namespace {
+constexpr uint32_t kMagic = 0x50555357;  // "WSUP"
+// Bump when Retained changes, so a new image never boots from an old one's.
+constexpr uint16_t kVersion = 1;
+
+using telemetry::record::kStageCount;
+
+struct Retained {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t crc;  // over the whole block with this field 0
+    uint32_t resets;
+    uint8_t sequence;
+    uint8_t overdue;  // the stage feeding was held back for, or kNoStage
+    bool have_calibration;
+    sensors::mag_calibration::State calibration;
+};
+static_assert(sizeof(Retained) <= hal::kRetainedRamBytes, "retained state must fit the retained RAM");
+
+// Built here and copied out whole: a reset part-way through the copy
+// leaves a block whose CRC fails, and the next boot is a cold one.
+Retained retained = {};
+
+struct Watched {
+    uint64_t limit_us;  // 0: not watched
+    uint32_t seen;      // jobs at the last change
+    uint64_t progress_us;
+};
+Watched watched[kStageCount] = {};
+
+// Finished jobs per stage, counted on the stage's core.
+std::atomic<uint32_t> jobs[kStageCount] = {};
+
+Stats stats = {0, kNoStage, 0, 0};
+
+// Render and publish run on core1, every other stage on core0. Each core
+// marks the stage it is in, as stage + 1, in its own scratch register.
+std::size_t Slot(Stage stage) {
+    return stage == telemetry::record::kStageRender || stage == telemetry::record::kStagePublish ? 1 : 0;
+}
+
+uint16_t RetainedCrc(Retained block) {
+    block.crc = 0;
+    return utils::Crc16(reinterpret_cast<const uint8_t *>(&block), sizeof(block));
+}
+
+const char *StageName(uint8_t stage) {
+    return stage < kStageCount ? telemetry::record::kStageNames[stage] : "no stage";
+}
+
+void Retain(uint8_t overdue) {
+    retained.magic = kMagic;
+    retained.version = kVersion;
+    retained.resets = stats.resets;
+    retained.sequence = telemetry::NextSequence();
+    retained.overdue = overdue;
+    retained.have_calibration = app::config::SENSOR_HSCDTD;
+    if constexpr (app::config::SENSOR_HSCDTD) {
+        sensors::mag_calibration::GetState(retained.calibration);
+    }
+    retained.crc = RetainedCrc(retained);
+    std::memcpy(hal::RetainedRam(), &retained, sizeof(retained));
+}
+
+}  // namespace
+
+bool Resume() {
+    if (!app::config::WATCHDOG || !hal::WatchdogCausedReset()) {
+        return false;
+    }
+    std::memcpy(&retained, hal::RetainedRam(), sizeof(retained));
+    const bool intact =
+        retained.magic == kMagic && retained.version == kVersion && retained.crc == RetainedCrc(retained);
+    stats.resets = intact ? retained.resets + 1 : 1;
+    stats.fault_stage = intact && retained.overdue < kStageCount ? retained.overdue : kNoStage;
+    for (std::size_t slot = 0; slot < hal::kWatchdogScratchWords && stats.fault_stage == kNoStage; ++slot) {
+        const uint32_t marked = hal::WatchdogScratchRead(slot);
+        if (marked >= 1 && marked <= kStageCount) {
+            stats.fault_stage = static_cast<uint8_t>(marked - 1);
+        }
+    }
+    printf("watchdog reset %lu since power-up, in %s%s\n", static_cast<unsigned long>(stats.resets),
+           StageName(stats.fault_stage), intact ? "" : ", retained state lost");
+    if (!intact) {
+        return false;
+    }
+
+    telemetry::ResumeSequence(retained.sequence);
+    if constexpr (app::config::SENSOR_HSCDTD) {
+        if (retained.have_calibration) {
+            sensors::mag_calibration::SetState(retained.calibration);
+        }
+    }
+    return true;
+}
+
+void Watch(Stage stage, uint32_t period_us) {
+    watched[stage].limit_us = 2ull * period_us + app::config::WATCHDOG_STAGE_SLACK_US;
+}
+
+void Start() {
+    if (!app::config::WATCHDOG) {
+        return;
+    }
+    const uint64_t now = hal::TimeUs();
+    for (int s = 0; s < kStageCount; ++s) {
+        watched[s].seen = jobs[s].load(std::memory_order_relaxed);
+        watched[s].progress_us = now;
+    }
+    for (std::size_t slot = 0; slot < hal::kWatchdogScratchWords; ++slot) {
+        hal::WatchdogScratchWrite(slot, 0);
+    }
+    Retain(kNoStage);
+    hal::WatchdogStart(app::config::WATCHDOG_TIMEOUT_MS);
+}
+
+void Service() {
+    const uint64_t now = hal::TimeUs();
+    uint8_t overdue = kNoStage;
+    for (int s = 0; s < kStageCount; ++s) {
+        Watched &stage = watched[s];
+        if (stage.limit_us == 0) {
+            continue;
+        }
+        const uint32_t count = jobs[s].load(std::memory_order_relaxed);
+        if (count != stage.seen) {
+            stage.seen = count;
+            stage.progress_us = now;
+        } else if (overdue == kNoStage && now - stage.progress_us > stage.limit_us) {
+            overdue = static_cast<uint8_t>(s);
+        }
+    }
+
+    if (overdue == kNoStage) {
+        hal::WatchdogFeed();
+        ++stats.feeds;
+    } else {
+        if (retained.overdue == kNoStage) {
+            printf("%s overdue, leaving the watchdog unfed\n", StageName(overdue));
+        }
+        ++stats.held;
+    }
+    Retain(overdue);
+}
+
+void Enter(Stage stage) {
+    hal::WatchdogScratchWrite(Slot(stage), stage + 1u);
+}
+
+void Leave(Stage stage, bool done) {
+    hal::WatchdogScratchWrite(Slot(stage), 0);
+    if (done) {
+        jobs[stage].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace supervisor
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/app_config.h"
+#include "telemetry/record_format.h"
+
+// Watchdog supervision. A StageScope around each stage of the firmware (see
+// telemetry::record::Stage) checks it in whenever it finishes a job, and
+// the watchdog task calls Service(), which feeds the hardware watchdog only
+// while every watched stage has finished a job within twice its period
+// plus app::config::WATCHDOG_STAGE_SLACK_US. A call that never returns
+// stops its core; a stage that no longer gets a job done stops the
+// feeding. Either way the chip resets WATCHDOG_TIMEOUT_MS after the last
+// feed.
+//
+// What the reboot would lose is kept through the reset in retained RAM,
+// refreshed on every Service(): the telemetry sequence number and the
+// magnetometer calibration with its fit in progress. The stage to blame is
+// the overdue one, or else the one a core was inside, which each core marks
+// in a watchdog scratch register. Resume() puts it all back, and main() then
+// skips its start-up pause.
+//
+// With app::config::WATCHDOG off the scopes compile to nothing and the
+// watchdog is never started.
+namespace supervisor {
+
+using telemetry::record::Stage;
+using telemetry::record::kNoStage;
+
+struct Stats {
+    uint32_t resets;      // watchdog resets since power-up
+    uint8_t fault_stage;  // blamed for the last one, or kNoStage
+    uint32_t feeds;
+    uint32_t held;        // Service() calls that left the watchdog unfed
+};
+
+// Boot, after the drivers' Init() and before output::Launch(): true after a
+// watchdog reset that left the retained state intact, which is then
+// restored.
+bool Resume();
+
+// Supervise `stage`, which finishes a job at least every `period_us`.
+void Watch(Stage stage, uint32_t period_us);
+
+// Starts the watchdog; call it just before scheduler::Run(), with the
+// watchdog task added.
+void Start();
+
+// The watchdog task's job.
+void Service();
+
+// `stage` has started a job or one step of it; then it has stopped, with
+// `done` once the job is finished.
+void Enter(Stage stage);
+void Leave(Stage stage, bool done);
+
+// Marks its own scope as one job of `stage`, or with Continue() as one
+// step of a job that carries on in a later call.
+class StageScope {
+public:
+    explicit StageScope(Stage stage) : stage_(stage) {
+        if constexpr (app::config::WATCHDOG) {
+            Enter(stage_);
+        }
+    }
+
+    ~StageScope() {
+        if constexpr (app::config::WATCHDOG) {
+            Leave(stage_, !continued_);
+        }
+    }
+
+    StageScope(const StageScope &) = delete;
+    StageScope &operator=(const StageScope &) = delete;
+
+    void Continue() {
+        continued_ = true;
+    }
+
+private:
+    Stage stage_;
+    bool continued_ = false;
+};
+
+const Stats &GetStats();
+
+}  // namespace supervisor
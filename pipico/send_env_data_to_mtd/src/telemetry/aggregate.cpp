@@ -0,0 +1,136 @@
+#include "telemetry/aggregate.h"
+
+#include <cmath>
+
+#include "hal/hal.h"
+#include "telemetry/record.h"
+
+namespace telemetry {
+namespace aggregate {
+
+namespace {
+
+using record::kFieldCount;
+using record::kFields;
+using record::kFullTurn;
+using record::kSectionCount;
+
+// Differences are from `first`; angles are unwrapped, so `last` (the
+// previous difference) and the extremes may leave 0..360 degrees.
+struct Accumulator {
+    int32_t first;
+    int32_t last;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    double sum_squares;  // can exceed 64 bits after a GPS jump
+};
+
+Accumulator fields[kFieldCount];
+uint32_t counts[kSectionCount];
+uint64_t window_start_us = 0;
+bool started = false;
+
+// Nearest equivalent of `difference` to `last`, for angles.
+int32_t Unwrap(int32_t difference, int32_t last) {
+    while (difference - last > kFullTurn / 2) {
+        difference -= kFullTurn;
+    }
+    while (difference - last < -kFullTurn / 2) {
+        difference += kFullTurn;
+    }
+    return difference;
+}
+
+int32_t NormaliseAngle(int32_t value) {
+    value %= kFullTurn;
+    return value < 0 ? value + kFullTurn : value;
+}
+
+int32_t RoundedQuotient(int64_t sum, uint32_t count) {
+    const int64_t half = count / 2;
+    return static_cast<int32_t>(sum >= 0 ? (sum + half) / count : (sum - half) / count);
+}
+
+}  // namespace
+
+void Add(const app::model::SensorSnapshot &snapshot, uint16_t sections) {
+    if (!started) {
+        window_start_us = hal::TimeUs();
+        started = true;
+    }
+    record::Sample sample;
+    record::Quantize(snapshot, sample);
+    sections &= sample.sections;
+    if (sections == 0) {
+        return;
+    }
+
+    for (int i = 0; i < kFieldCount; ++i) {
+        const int section = kFields[i].section;
+        if ((sections & (1u << section)) == 0) {
+            continue;
+        }
+        Accumulator &field = fields[i];
+        const int32_t value = sample.values[i];
+        if (counts[section] == 0) {
+            field = {value, 0, 0, 0, 0, 0.0};
+            continue;
+        }
+        int32_t difference = record::WrappingDelta(value, field.first);
+        if (record::IsAngle(i)) {
+            difference = Unwrap(difference, field.last);
+        }
+        field.last = difference;
+        field.min = difference < field.min ? difference : field.min;
+        field.max = difference > field.max ? difference : field.max;
+        field.sum += difference;
+        field.sum_squares += static_cast<double>(difference) * difference;
+    }
+    for (int s = 0; s < kSectionCount; ++s) {
+        if ((sections & (1u << s)) != 0) {
+            ++counts[s];
+        }
+    }
+}
+
+void Take(record::Summary &summary) {
+    const uint64_t now = hal::TimeUs();
+    const uint64_t window_s = started ? (now - window_start_us + 500000) / 1000000 : 0;
+    summary.window_s = static_cast<uint16_t>(window_s > 0xFFFF ? 0xFFFF : window_s);
+    summary.sections = 0;
+    for (int s = 0; s < kSectionCount; ++s) {
+        summary.counts[s] = counts[s];
+        if (counts[s] > 0) {
+            summary.sections = static_cast<uint16_t>(summary.sections | 1u << s);
+        }
+    }
+
+    for (int i = 0; i < kFieldCount; ++i) {
+        const uint32_t count = counts[kFields[i].section];
+        record::FieldSummary &out = summary.fields[i];
+        if (count == 0) {
+            out = record::FieldSummary();
+            continue;
+        }
+        const Accumulator &field = fields[i];
+        const int32_t mean = RoundedQuotient(field.sum, count);
+        const double exact_mean = static_cast<double>(field.sum) / count;
+        const double variance = field.sum_squares / count - exact_mean * exact_mean;
+        out.sd = static_cast<uint32_t>(std::lround(variance > 0.0 ? std::sqrt(variance) : 0.0));
+        out.mean = record::WrappingAdd(field.first, mean);
+        if (record::IsAngle(i)) {
+            out.mean = NormaliseAngle(out.mean);
+        }
+        out.min = record::WrappingAdd(out.mean, record::WrappingDelta(field.min, mean));
+        out.max = record::WrappingAdd(out.mean, record::WrappingDelta(field.max, mean));
+    }
+
+    for (uint32_t &count : counts) {
+        count = 0;
+    }
+    window_start_us = now;
+}
+
+}  // namespace aggregate
+}  // namespace telemetry
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "app/measurement_types.h"
+#include "telemetry/record_format.h"
+
+// Windowed aggregation of the telemetry fields (app::config::
+// TELEMETRY_AGGREGATE). Every acquisition adds its fresh readings, in the
+// wire units of the binary record, to running sums; at the end of each
+// window those become one record::Summary of count, mean, min, max and
+// standard deviation per field, which goes to the mesh node in place of the
+// individual samples.
+//
+// Each field keeps its first value of the window, and sums of the
+// differences from it and of their squares. The differences stay small, so
+// the mean is exact and the variance does not cancel away, and an
+// acquisition costs a few additions per field. Angles are unwrapped from
+// one sample to the next before they are summed, so a heading swinging
+// through north averages to north rather than to south.
+//
+// Core0 only: Add() from the acquisition tasks, Take() from the publish
+// task.
+namespace telemetry {
+namespace aggregate {
+
+// Accumulates the fields of `sections` (bits of record::Section) that are
+// valid in `snapshot`. Call it once per new reading of those sections.
+void Add(const app::model::SensorSnapshot &snapshot, uint16_t sections);
+
+// Summarises everything added since the last call into `summary` and
+// starts the next window. The sequence number is left alone.
+void Take(record::Summary &summary);
+
+}  // namespace aggregate
+}  // namespace telemetry
@@ -0,0 +1,435 @@
+#include "telemetry/backlog.h"
+
+#include <cstring>
+
+#include "app/app_config.h"
+#include "hal/hal.h"
+#include "utils/crc16.h"
+
+namespace telemetry {
+namespace backlog {
+
+namespace {
+constexpr uint32_t kSectorBytes = hal::kFlashSectorBytes;
+constexpr uint32_t kSectors = app::config::FLASH_BACKLOG_BYTES / kSectorBytes;
+static_assert(app::config::FLASH_BACKLOG_BYTES % kSectorBytes == 0, "backlog must be whole sectors");
+static_assert(app::config::FLASH_BACKLOG_OFFSET % kSectorBytes == 0, "backlog must be sector aligned");
+
+// Sector header: u32 magic, u32 sequence, u32 erase count, u16 CRC of the
+// first 12 bytes, 2 bytes left erased.
+constexpr uint32_t kMagic = 0x474C4254;  // "TBLG"
+constexpr uint32_t kSectorHeaderBytes = 16;
+constexpr uint32_t kRecordHeaderBytes = 5;
+// An ASCII summary line (telemetry.cpp), the longest record sent.
+constexpr std::size_t kMaxPayload = 1280;
+
+constexpr uint8_t kFree = 0xFF;
+constexpr uint8_t kCommitted = 0xFE;
+constexpr uint8_t kSent = 0xFC;
+constexpr uint16_t kErasedLength = 0xFFFF;
+
+struct Position {
+    uint32_t sector;
+    uint32_t offset;
+};
+
+struct SectorHeader {
+    uint32_t sequence;
+    uint32_t erases;
+};
+
+struct RecordHeader {
+    uint8_t state;
+    uint16_t length;
+    uint16_t crc;
+};
+
+enum class Entry {
+    kEnd,      // free space or the end of the sector
+    kTorn,     // not committed or not parseable: nothing after it is trusted
+    kPending,
+    kSent,
+};
+
+// The page being appended to, held in RAM until it is full so that each
+// page is programmed once however many records it takes.
+uint8_t staged[hal::kFlashPageBytes];
+uint32_t staged_address = 0;
+bool have_staged = false;
+// Sent markers not yet programmed, all in one page: 0xFF where there is
+// none, so programming the page changes only the markers.
+uint8_t marks[hal::kFlashPageBytes];
+uint32_t marks_address = 0;
+bool have_marks = false;
+
+bool have_sector = false;
+uint32_t write_sector = 0;
+uint32_t write_offset = kSectorBytes;
+uint32_t next_sequence = 1;
+// Next record to send; meaningful while stats.pending > 0.
+Position read = {0, kSectorHeaderBytes};
+Stats stats = {};
+
+uint32_t Address(uint32_t sector, uint32_t offset) {
+    return app::config::FLASH_BACKLOG_OFFSET + sector * kSectorBytes + offset;
+}
+
+uint32_t Next(uint32_t sector) {
+    return sector + 1 < kSectors ? sector + 1 : 0;
+}
+
+uint32_t Load32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+void Store32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t PageOf(uint32_t address) {
+    return address - address % hal::kFlashPageBytes;
+}
+
+// Flash as it will be once the staged page and the markers are programmed.
+void Read(uint32_t address, uint8_t *dst, std::size_t len) {
+    hal::FlashRead(address, dst, len);
+    for (std::size_t i = 0; i < len; ++i) {
+        const uint32_t at = address + static_cast<uint32_t>(i);
+        if (have_staged && PageOf(at) == staged_address) {
+            dst[i] = staged[at - staged_address];
+        }
+        if (have_marks && PageOf(at) == marks_address) {
+            dst[i] &= marks[at - marks_address];
+        }
+    }
+}
+
+bool FlushStaged() {
+    if (!have_staged) {
+        return true;
+    }
+    have_staged = false;
+    return hal::FlashProgram(staged_address, staged, sizeof(staged));
+}
+
+bool FlushMarks() {
+    if (!have_marks) {
+        return true;
+    }
+    have_marks = false;
+    return hal::FlashProgram(marks_address, marks, sizeof(marks));
+}
+
+// Appends at `address`, which must be where the previous Stage() ended or
+// a new page; each page is programmed as soon as it is complete.
+bool Stage(uint32_t address, const uint8_t *data, std::size_t len) {
+    while (len > 0) {
+        const uint32_t page = PageOf(address);
+        if (!have_staged || staged_address != page) {
+            if (!FlushStaged()) {
+                return false;
+            }
+            // Earlier records may share the page; programming them again
+            // with the same bytes changes nothing.
+            hal::FlashRead(page, staged, sizeof(staged));
+            if (have_marks && marks_address == page) {
+                for (uint32_t i = 0; i < hal::kFlashPageBytes; ++i) {
+                    staged[i] &= marks[i];
+                }
+                have_marks = false;
+            }
+            staged_address = page;
+            have_staged = true;
+        }
+        const uint32_t in_page = address - page;
+        const std::size_t chunk =
+            len < hal::kFlashPageBytes - in_page ? len : static_cast<std::size_t>(hal::kFlashPageBytes - in_page);
+        std::memcpy(staged + in_page, data, chunk);
+        address += static_cast<uint32_t>(chunk);
+        data += chunk;
+        len -= chunk;
+        if (address % hal::kFlashPageBytes == 0 && !FlushStaged()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Marks the record at `address` sent: in the staged page if it is there,
+// else with the other markers of its page, programmed by FlushMarks().
+bool MarkSent(uint32_t address) {
+    const uint32_t page = PageOf(address);
+    if (have_staged && staged_address == page) {
+        staged[address - page] &= kSent;
+        return true;
+    }
+    if (!have_marks || marks_address != page) {
+        if (!FlushMarks()) {
+            return false;
+        }
+        std::memset(marks, 0xFF, sizeof(marks));
+        marks_address = page;
+        have_marks = true;
+    }
+    marks[address - page] &= kSent;
+    return true;
+}
+
+// Programs an arbitrary byte range a page at a time, leaving the rest of
+// each page 0xFF, which programming leaves untouched.
+bool Program(uint32_t address, const uint8_t *data, std::size_t len) {
+    static uint8_t page[hal::kFlashPageBytes];
+    while (len > 0) {
+        const uint32_t page_start = address - address % hal::kFlashPageBytes;
+        const uint32_t in_page = address - page_start;
+        const std::size_t chunk =
+            len < hal::kFlashPageBytes - in_page ? len : static_cast<std::size_t>(hal::kFlashPageBytes - in_page);
+        std::memset(page, 0xFF, sizeof(page));
+        std::memcpy(page + in_page, data, chunk);
+        if (!hal::FlashProgram(page_start, page, sizeof(page))) {
+            return false;
+        }
+        address += static_cast<uint32_t>(chunk);
+        data += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+bool ReadSectorHeader(uint32_t sector, SectorHeader &header) {
+    uint8_t raw[kSectorHeaderBytes];
+    Read(Address(sector, 0), raw, sizeof(raw));
+    const uint16_t crc = static_cast<uint16_t>(raw[12] | raw[13] << 8);
+    if (Load32(raw) != kMagic || crc != utils::Crc16(raw, 12)) {
+        return false;
+    }
+    header.sequence = Load32(raw + 4);
+    header.erases = Load32(raw + 8);
+    return true;
+}
+
+Entry ReadEntry(const Position &at, RecordHeader &header) {
+    if (at.offset + kRecordHeaderBytes > kSectorBytes) {
+        return Entry::kEnd;
+    }
+    uint8_t raw[kRecordHeaderBytes];
+    Read(Address(at.sector, at.offset), raw, sizeof(raw));
+    header.state = raw[0];
+    header.length = static_cast<uint16_t>(raw[1] | raw[2] << 8);
+    header.crc = static_cast<uint16_t>(raw[3] | raw[4] << 8);
+    if (header.state == kFree && header.length == kErasedLength) {
+        return Entry::kEnd;
+    }
+    if (header.length == 0 || header.length > kMaxPayload ||
+        at.offset + kRecordHeaderBytes + header.length > kSectorBytes) {
+        return Entry::kTorn;
+    }
+    if (header.state == kCommitted) {
+        return Entry::kPending;
+    }
+    return header.state == kSent ? Entry::kSent : Entry::kTorn;
+}
+
+void Advance(Position &at, const RecordHeader &header) {
+    at.offset += kRecordHeaderBytes + header.length;
+}
+
+// Pending records from `at` to the end of its sector.
+uint32_t CountPending(Position at) {
+    uint32_t count = 0;
+    RecordHeader header;
+    for (Entry entry = ReadEntry(at, header); entry == Entry::kPending || entry == Entry::kSent;
+         entry = ReadEntry(at, header)) {
+        count += entry == Entry::kPending ? 1 : 0;
+        Advance(at, header);
+    }
+    return count;
+}
+
+// Erases the next sector of the ring and writes its header. If that sector
+// still holds unsent records the ring is full, and they are dropped.
+bool OpenSector() {
+    const uint32_t sector = have_sector ? Next(write_sector) : 0;
+    if (stats.pending > 0 && read.sector == sector) {
+        const uint32_t lost = CountPending(read);
+        stats.dropped += lost;
+        stats.pending -= lost;
+        read = {Next(sector), kSectorHeaderBytes};
+    }
+
+    // Markers for the sector about to be erased are moot, but the page
+    // left staged in the last one is not.
+    if (!FlushStaged() || !FlushMarks()) {
+        return false;
+    }
+    SectorHeader old;
+    const uint32_t erases = ReadSectorHeader(sector, old) ? old.erases + 1 : 1;
+    if (!hal::FlashErase(Address(sector, 0), kSectorBytes)) {
+        return false;
+    }
+    uint8_t raw[kSectorHeaderBytes];
+    std::memset(raw, 0xFF, sizeof(raw));
+    Store32(raw, kMagic);
+    Store32(raw + 4, next_sequence);
+    Store32(raw + 8, erases);
+    const uint16_t crc = utils::Crc16(raw, 12);
+    raw[12] = static_cast<uint8_t>(crc);
+    raw[13] = static_cast<uint8_t>(crc >> 8);
+    if (!Program(Address(sector, 0), raw, sizeof(raw))) {
+        return false;
+    }
+
+    ++next_sequence;
+    have_sector = true;
+    write_sector = sector;
+    write_offset = kSectorHeaderBytes;
+    if (erases > stats.max_erases) {
+        stats.max_erases = erases;
+    }
+    return true;
+}
+
+}  // namespace
+
+void Init() {
+    uint32_t newest = 0;
+    bool found = false;
+    SectorHeader header;
+    for (uint32_t sector = 0; sector < kSectors; ++sector) {
+        if (!ReadSectorHeader(sector, header)) {
+            continue;
+        }
+        if (!found || header.sequence > newest) {
+            newest = header.sequence;
+            write_sector = sector;
+            found = true;
+        }
+        if (header.erases > stats.max_erases) {
+            stats.max_erases = header.erases;
+        }
+    }
+    if (!found) {
+        return;
+    }
+    have_sector = true;
+    next_sequence = newest + 1;
+
+    // Oldest to newest: sectors are opened in address order, so the ring
+    // starts just after the newest one.
+    bool found_read = false;
+    for (uint32_t i = 1; i <= kSectors; ++i) {
+        const uint32_t sector = (write_sector + i) % kSectors;
+        if (!ReadSectorHeader(sector, header)) {
+            continue;
+        }
+        Position at = {sector, kSectorHeaderBytes};
+        RecordHeader record;
+        Entry entry;
+        while ((entry = ReadEntry(at, record)) == Entry::kPending || entry == Entry::kSent) {
+            if (entry == Entry::kPending) {
+                if (!found_read) {
+                    read = at;
+                    found_read = true;
+                }
+                ++stats.pending;
+            }
+            Advance(at, record);
+        }
+        if (entry == Entry::kTorn) {
+            ++stats.torn;
+        }
+        if (sector == write_sector) {
+            write_offset = entry == Entry::kEnd ? at.offset : kSectorBytes;
+        }
+    }
+    stats.recovered = stats.pending;
+    stats.max_pending = stats.pending;
+}
+
+bool Append(const uint8_t *data, std::size_t len) {
+    static uint8_t record[kRecordHeaderBytes + kMaxPayload];
+    if (len == 0 || len > kMaxPayload) {
+        return false;
+    }
+    const uint32_t total = static_cast<uint32_t>(kRecordHeaderBytes + len);
+    if (!have_sector || write_offset + total > kSectorBytes) {
+        if (!OpenSector()) {
+            return false;
+        }
+    }
+
+    const uint16_t crc = utils::Crc16(data, len);
+    record[0] = kCommitted;
+    record[1] = static_cast<uint8_t>(len);
+    record[2] = static_cast<uint8_t>(len >> 8);
+    record[3] = static_cast<uint8_t>(crc);
+    record[4] = static_cast<uint8_t>(crc >> 8);
+    std::memcpy(record + kRecordHeaderBytes, data, len);
+    const Position at = {write_sector, write_offset};
+    if (!Stage(Address(at.sector, at.offset), record, total)) {
+        // Whatever got written ends this sector.
+        have_staged = false;
+        write_offset = kSectorBytes;
+        return false;
+    }
+    write_offset += total;
+
+    if (stats.pending == 0) {
+        read = at;
+    }
+    ++stats.appended;
+    if (++stats.pending > stats.max_pending) {
+        stats.max_pending = stats.pending;
+    }
+    return true;
+}
+
+uint32_t Drain(uint32_t max_records) {
+    static uint8_t payload[kMaxPayload];
+    uint32_t sent = 0;
+    while (stats.pending > 0 && sent < max_records && hal::UartClearToSend(app::config::MESH_UART)) {
+        RecordHeader header;
+        const Entry entry = ReadEntry(read, header);
+        if (entry == Entry::kEnd || entry == Entry::kTorn) {
+            if (read.sector == write_sector) {
+                // Nothing left after all; the count was off.
+                stats.pending = 0;
+                break;
+            }
+            read = {Next(read.sector), kSectorHeaderBytes};
+            continue;
+        }
+        const Position at = read;
+        Advance(read, header);
+        if (entry == Entry::kSent) {
+            continue;
+        }
+
+        --stats.pending;
+        Read(Address(at.sector, at.offset) + kRecordHeaderBytes, payload, header.length);
+        if (utils::Crc16(payload, header.length) != header.crc) {
+            ++stats.torn;
+            continue;
+        }
+        hal::UartWrite(app::config::MESH_UART, payload, header.length);
+        MarkSent(Address(at.sector, at.offset));
+        ++stats.sent;
+        ++sent;
+    }
+    FlushMarks();
+    return sent;
+}
+
+bool Empty() {
+    return stats.pending == 0;
+}
+
+const Stats &GetStats() {
+    return stats;
+}
+
+}  // namespace backlog
+}  // namespace telemetry
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Store-and-forward log of telemetry records in on-board flash. A record
+// the mesh node has no room for (CTS), or that would overtake older ones
+// still waiting, is appended here and sent from here, oldest first, once
+// the node takes data again, so an outage or a congested node delays data
+// instead of losing it.
+//
+// The log is a ring of flash sectors used strictly in turn, so wear is
+// spread evenly over all of them. Each sector opens with a header holding
+// a sequence number, which orders the ring again after a reset, and the
+// sector's erase count. Records are packed back to back behind it:
+//   u8  state    0xFF free, 0xFE pending, 0xFC sent (bits only clear)
+//   u16 length   LE
+//   u16 crc      CRC-16 of the payload, LE
+//   payload      exactly the bytes that go to the UART
+// Each flash operation stalls both cores with interrupts off, so they are
+// kept few: records collect in a RAM copy of the page they fall in, which
+// is programmed once it is full, and Drain() programs the sent markers of
+// one call together, a page at a time. A reset therefore loses the records
+// not yet programmed, at most a page of them, and may send those of the
+// last Drain() twice. A record cut short by a reset fails its CRC and is
+// skipped.
+//
+// When the ring is full the oldest sector is reused and its unsent records
+// are counted as dropped.
+namespace telemetry {
+namespace backlog {
+
+struct Stats {
+    uint32_t appended;
+    uint32_t sent;
+    uint32_t pending;      // committed, not yet sent
+    uint32_t max_pending;
+    uint32_t dropped;      // unsent, erased because the ring was full
+    uint32_t torn;         // uncommitted or corrupt records skipped
+    uint32_t recovered;    // pending records found at boot
+    uint32_t max_erases;   // of the most-erased sector
+};
+
+// Scans the log and picks up where the last run left off.
+void Init();
+
+// Appends one encoded record; false if it is too long or flash failed.
+bool Append(const uint8_t *data, std::size_t len);
+
+// Sends up to `max_records` pending records, in order, while the mesh UART
+// is clear to send. Returns how many went.
+uint32_t Drain(uint32_t max_records);
+
+// True while nothing is waiting to be sent.
+bool Empty();
+
+const Stats &GetStats();
+
+}  // namespace backlog
+}  // namespace telemetry
@@ -0,0 +1,277 @@
+#include "telemetry/record.h"
+
+namespace telemetry {
+namespace record {
+
+namespace {
+
+int32_t Round(float value) {
+    return static_cast<int32_t>(value < 0.0f ? value - 0.5f : value + 0.5f);
+}
+
+// Largest and smallest values a field can carry on the wire.
+int32_t Saturate(int32_t value, const FieldFormat &format) {
+    const int bits = format.bytes * 8;
+    int64_t low = 0;
+    int64_t high = 0;
+    if (format.is_signed) {
+        low = -(int64_t{1} << (bits - 1));
+        high = (int64_t{1} << (bits - 1)) - 1;
+    } else {
+        high = (int64_t{1} << bits) - 1;
+    }
+    if (value < low) {
+        return static_cast<int32_t>(low);
+    }
+    if (value > high) {
+        return static_cast<int32_t>(high);
+    }
+    return value;
+}
+
+uint32_t TwoDigits(const char *text) {
+    return static_cast<uint32_t>(text[0] - '0') * 10 + static_cast<uint32_t>(text[1] - '0');
+}
+
+// Days from 2000-01-01 to y-m-d (proleptic Gregorian).
+uint32_t DaysSince2000(uint32_t year, uint32_t month, uint32_t day) {
+    if (month <= 2) {
+        year -= 1;
+        month += 12;
+    }
+    const uint32_t days = 365 * year + year / 4 - year / 100 + year / 400 + (153 * (month - 3) + 2) / 5 + day;
+    return days - 730426;  // the same expression for 2000-01-01
+}
+
+// "YYYYMMDD HHMMSS" as produced by the NMEA parser.
+uint32_t SecondsSince2000(const char *datetime) {
+    const uint32_t year = TwoDigits(datetime) * 100 + TwoDigits(datetime + 2);
+    const uint32_t days = DaysSince2000(year, TwoDigits(datetime + 4), TwoDigits(datetime + 6));
+    return days * 86400 + TwoDigits(datetime + 9) * 3600 + TwoDigits(datetime + 11) * 60 + TwoDigits(datetime + 13);
+}
+
+std::size_t WriteHeader(uint8_t sequence, uint16_t sections, Kind kind, uint8_t *out) {
+    out[0] = static_cast<uint8_t>(kVersion << 4 | static_cast<uint8_t>(kind));
+    out[1] = sequence;
+    out[2] = static_cast<uint8_t>(sections);
+    out[3] = static_cast<uint8_t>(sections >> 8);
+    return kHeaderBytes;
+}
+
+std::size_t WriteFixed(int32_t value, int bytes, uint8_t *out) {
+    for (int b = 0; b < bytes; ++b) {
+        out[b] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * b));
+    }
+    return static_cast<std::size_t>(bytes);
+}
+
+// LEB128: seven bits per byte, low first, top bit set on all but the last.
+std::size_t WriteVarint(uint32_t value, uint8_t *out) {
+    std::size_t pos = 0;
+    while (value >= 0x80) {
+        out[pos++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[pos++] = static_cast<uint8_t>(value);
+    return pos;
+}
+
+}  // namespace
+
+void Quantize(const app::model::SensorSnapshot &snapshot, Sample &sample) {
+    int32_t *v = sample.values;
+    uint16_t sections = 0;
+
+    if (snapshot.aht20.valid) {
+        sections |= 1u << kAht20;
+        v[kAhtTemperature] = Round(snapshot.aht20.temperature_c * 100.0f);
+        v[kAhtHumidity] = Round(snapshot.aht20.humidity_pct * 100.0f);
+        v[kAhtStatus] = snapshot.aht20.status;
+    }
+    if (snapshot.bmp280.valid) {
+        sections |= 1u << kBmp280;
+        v[kBmpTemperature] = Round(snapshot.bmp280.temperature_c * 100.0f);
+        v[kBmpPressure] = Round(snapshot.bmp280.pressure_pa * 100.0f);
+    }
+    if (snapshot.mpu6050.valid) {
+        sections |= 1u << kMpu6050;
+        v[kAccelX] = snapshot.mpu6050.accel_x;
+        v[kAccelY] = snapshot.mpu6050.accel_y;
+        v[kAccelZ] = snapshot.mpu6050.accel_z;
+        v[kGyroX] = snapshot.mpu6050.gyro_x;
+        v[kGyroY] = snapshot.mpu6050.gyro_y;
+        v[kGyroZ] = snapshot.mpu6050.gyro_z;
+        v[kMpuTemperature] = Round(snapshot.mpu6050.temperature_c * 100.0f);
+    }
+    if (snapshot.veml7700.valid) {
+        sections |= 1u << kVeml7700;
+        v[kLux] = Round(snapshot.veml7700.lux * 100.0f);
+    }
+    if (snapshot.hscdtd.valid) {
+        sections |= 1u << kHscdtd;
+        v[kMagX] = snapshot.hscdtd.x;
+        v[kMagY] = snapshot.hscdtd.y;
+        v[kMagZ] = snapshot.hscdtd.z;
+        v[kHeading] = Round(snapshot.hscdtd.heading_deg * 100.0f);
+    }
+
+    if (snapshot.orientation.valid) {
+        sections |= 1u << kOrientation;
+        v[kRoll] = Round(snapshot.orientation.roll_deg * 100.0f);
+        v[kPitch] = Round(snapshot.orientation.pitch_deg * 100.0f);
+        v[kOrientationHeading] = Round(snapshot.orientation.heading_deg * 100.0f);
+    }
+
+    const app::model::GpsData &gps = snapshot.gps;
+    if (gps.fix) {
+        sections |= 1u << kGpsFix;
+        v[kLatitude] = gps.latitude_e7;
+        v[kLongitude] = gps.longitude_e7;
+        v[kFixType] = gps.fix_type;
+        v[kSatellites] = gps.satellites_used;
+        v[kHdop] = gps.hdop_centi;
+    }
+    if (gps.datetime_valid) {
+        sections |= 1u << kGpsTime;
+        v[kTime] = static_cast<int32_t>(SecondsSince2000(gps.datetime));
+    }
+    if (gps.fix && gps.motion_valid) {
+        sections |= 1u << kGpsMotion;
+        v[kSpeed] = static_cast<int32_t>(gps.speed_mm_s > 0x7FFFFFFFu ? 0x7FFFFFFFu : gps.speed_mm_s);
+        v[kCourse] = gps.course_centideg;
+    }
+
+    for (int i = 0; i < kFieldCount; ++i) {
+        if ((sections & (1u << kFields[i].section)) != 0) {
+            v[i] = Saturate(v[i], kFields[i]);
+        }
+    }
+    sample.sections = sections;
+}
+
+std::size_t PackKeyframe(const Sample &sample, uint8_t *out) {
+    std::size_t pos = WriteHeader(sample.sequence, sample.sections, Kind::kKeyframe, out);
+    for (int i = 0; i < kFieldCount; ++i) {
+        const FieldFormat &format = kFields[i];
+        if ((sample.sections & (1u << format.section)) == 0) {
+            continue;
+        }
+        pos += WriteFixed(sample.values[i], format.bytes, out + pos);
+    }
+    return pos;
+}
+
+std::size_t PackDelta(const Sample &sample, const Sample &reference, uint8_t *out) {
+    std::size_t pos = WriteHeader(sample.sequence, sample.sections, Kind::kDelta, out);
+    for (int i = 0; i < kFieldCount; ++i) {
+        if ((sample.sections & (1u << kFields[i].section)) == 0) {
+            continue;
+        }
+        pos += WriteVarint(ZigZag(WrappingDelta(sample.values[i], reference.values[i])), out + pos);
+    }
+    return pos;
+}
+
+std::size_t PackSummary(const Summary &summary, uint8_t *out) {
+    std::size_t pos = WriteHeader(summary.sequence, summary.sections, Kind::kSummary, out);
+    pos += WriteFixed(summary.window_s, kWindowBytes, out + pos);
+    for (int s = 0; s < kSectionCount; ++s) {
+        if ((summary.sections & (1u << s)) != 0) {
+            pos += WriteVarint(summary.counts[s], out + pos);
+        }
+    }
+    for (int i = 0; i < kFieldCount; ++i) {
+        if ((summary.sections & (1u << kFields[i].section)) == 0) {
+            continue;
+        }
+        const FieldSummary &field = summary.fields[i];
+        pos += WriteFixed(field.mean, kFields[i].bytes, out + pos);
+        pos += WriteVarint(ZigZag(WrappingDelta(field.min, field.mean)), out + pos);
+        pos += WriteVarint(ZigZag(WrappingDelta(field.max, field.mean)), out + pos);
+        pos += WriteVarint(field.sd, out + pos);
+    }
+    return pos;
+}
+
+std::size_t PackHealth(const Health &health, uint8_t *out) {
+    std::size_t pos = WriteHeader(health.sequence, 0, Kind::kHealth, out);
+    pos += WriteVarint(health.asleep_permille, out + pos);
+    pos += WriteVarint(health.wake_latency_mean_us, out + pos);
+    pos += WriteVarint(health.wake_latency_max_us, out + pos);
+    pos += WriteVarint(health.recoveries, out + pos);
+    pos += WriteVarint(health.recovery_failures, out + pos);
+    pos += WriteVarint(health.watchdog_resets, out + pos);
+    out[pos++] = health.fault_stage;
+    const uint8_t count = health.device_count < kMaxHealthDevices ? health.device_count : kMaxHealthDevices;
+    out[pos++] = count;
+    for (uint8_t i = 0; i < count; ++i) {
+        const DeviceHealth &device = health.devices[i];
+        out[pos++] = device.addr;
+        pos += WriteVarint(device.completed, out + pos);
+        pos += WriteVarint(device.nacks, out + pos);
+        pos += WriteVarint(device.timeouts, out + pos);
+        pos += WriteVarint(device.bus_errors, out + pos);
+        pos += WriteVarint(device.retries, out + pos);
+        pos += WriteVarint(device.failed, out + pos);
+    }
+    return pos;
+}
+
+std::size_t PackTiming(const Timing &timing, uint8_t *out) {
+    std::size_t pos = WriteHeader(timing.sequence, timing.stages, Kind::kTiming, out);
+    for (int s = 0; s < kStageCount; ++s) {
+        if ((timing.stages & (1u << s)) == 0) {
+            continue;
+        }
+        const StageTiming &stage = timing.stage[s];
+        pos += WriteVarint(stage.count, out + pos);
+        pos += WriteVarint(stage.mean_us, out + pos);
+        pos += WriteVarint(stage.max_us, out + pos);
+        pos += WriteVarint(stage.peak_us, out + pos);
+        for (uint32_t bucket : stage.buckets) {
+            pos += WriteVarint(bucket, out + pos);
+        }
+    }
+    return pos;
+}
+
+void Advance(const Sample &sample, Kind kind, Sample &reference) {
+    for (int i = 0; i < kFieldCount; ++i) {
+        if ((sample.sections & (1u << kFields[i].section)) != 0) {
+            reference.values[i] = sample.values[i];
+        } else if (kind == Kind::kKeyframe) {
+            reference.values[i] = 0;
+        }
+    }
+    reference.sequence = sample.sequence;
+    reference.sections = sample.sections;
+}
+
+std::size_t Frame(const uint8_t *record, std::size_t len, uint8_t *out) {
+    const uint16_t crc = Crc16(record, len);
+    const uint8_t trailer[kCrcBytes] = {static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+
+    // COBS: each code byte gives the distance to the next zero (or 0xFF
+    // for a full 254-byte run without one).
+    std::size_t code_pos = 0;
+    std::size_t pos = 1;
+    uint8_t code = 1;
+    for (std::size_t i = 0; i < len + kCrcBytes; ++i) {
+        const uint8_t byte = i < len ? record[i] : trailer[i - len];
+        if (byte != 0) {
+            out[pos++] = byte;
+            ++code;
+        }
+        if (byte == 0 || code == 0xFF) {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;
+    return pos;
+}
+
+}  // namespace record
+}  // namespace telemetry
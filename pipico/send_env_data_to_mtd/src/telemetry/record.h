@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "app/measurement_types.h"
+#include "telemetry/record_format.h"
+
+// Device side of the binary telemetry record (format in record_format.h).
+namespace telemetry {
+namespace record {
+
+// Converts the snapshot to wire units. Sections whose data is not valid are
+// left out of `sample.sections`; the sequence number is left alone.
+void Quantize(const app::model::SensorSnapshot &snapshot, Sample &sample);
+
+// Writes `sample` as a keyframe; `out` must hold kMaxRecordBytes. Returns
+// the record length.
+std::size_t PackKeyframe(const Sample &sample, uint8_t *out);
+
+// Writes `sample` as varint deltas against `reference`, the sample sent
+// just before it. Returns the record length.
+std::size_t PackDelta(const Sample &sample, const Sample &reference, uint8_t *out);
+
+// Writes `summary` as a summary record; `out` must hold kMaxSummaryBytes.
+// Returns the record length.
+std::size_t PackSummary(const Summary &summary, uint8_t *out);
+
+// Writes `health` as a health record; `out` must hold kMaxHealthBytes.
+// Returns the record length.
+std::size_t PackHealth(const Health &health, uint8_t *out);
+
+// Writes `timing` as a timing record; `out` must hold kMaxTimingBytes.
+// Returns the record length.
+std::size_t PackTiming(const Timing &timing, uint8_t *out);
+
+// Moves `reference` on past `sample` once it has been sent, as the decoder
+// will: fields in sample's sections take its values, a keyframe zeroes the
+// rest.
+void Advance(const Sample &sample, Kind kind, Sample &reference);
+
+// Appends the CRC-16, COBS-encodes and terminates with 0x00. `out` must hold
+// FrameBytes(len). Returns the frame length including the delimiter.
+std::size_t Frame(const uint8_t *record, std::size_t len, uint8_t *out);
+
+}  // namespace record
+}  // namespace telemetry
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utils/crc16.h"
+
+// Wire format of the binary telemetry record. Header-only and free of
+// firmware types so the host decoder compiles the same table.
+//
+// Frame on the mesh UART:  COBS(record || CRC-16 LE) 0x00
+// Record:
+//   u8  version << 4 | kind
+//   u8  sequence (wraps)
+//   u16 section bitmap (LE), bit n set = section n present and valid
+//   then, for each present section in order, each field as
+//     keyframe: little-endian at the width in kFields
+//     delta:    zigzag LEB128 varint of (value - reference value)
+// The reference is the previous record of the stream: every field starts
+// at 0 on a keyframe and takes the value of each field sent. A delta is
+// only usable if the record with sequence - 1 was decoded.
+// BMP280 altitude is not sent; it is a fixed function of pressure
+// (44330 * (1 - (p / 101325)^0.1903)) and the decoder recomputes it.
+//
+// A summary covers a window of samples instead of one, and stands alone:
+//   header as above, kind kSummary, sections with at least one sample
+//   u16 window length in seconds (LE)
+//   for each present section in order, a varint sample count
+//   for each field of those sections, in wire units:
+//     mean at the keyframe width, then zigzag varints of (min - mean) and
+//     (max - mean), then a varint of the standard deviation
+// Angles (IsAngle) are averaged on the circle: the mean is in 0..360
+// degrees and min/max are the furthest excursions either side of it, so
+// they may lie outside that range.
+//
+// A health record reports the I2C bus (see i2c/transaction_queue.h) and
+// the low-power idle (hal::IdleUntil) since boot, and the watchdog resets
+// (supervisor/supervisor.h) since power-up, and stands alone too:
+//   header as above, kind kHealth, section bitmap 0
+//   varint permille of the time spent in the sleep state (both cores
+//   down), varints of the mean and maximum wake-up latency in microseconds
+//   (0 from the simulator, which does not model it)
+//   varint bus recoveries, varint recoveries that left SDA held low
+//   varint watchdog resets, u8 stage blamed for the last one (kNoStage if
+//   none)
+//   u8 device count, then per device u8 address and varints of completed
+//   attempts, NACKs, timeouts, other bus errors, retries and transactions
+//   that failed for good
+//
+// A timing record reports how long each firmware stage took (see
+// profile/profile.h) over the window since the previous timing record,
+// and stands alone too:
+//   header as above, kind kTiming, with a stage bitmap in place of the
+//   section bitmap, bit n set = stage n has run since boot
+//   for each present stage in order, varints of the samples in the window,
+//   their mean and maximum in microseconds, the maximum since boot, then
+//   kTimingBuckets varint counts of the window's samples by duration
+namespace telemetry {
+namespace record {
+
+// 2: section bitmap widened to 16 bits, orientation section added.
+constexpr uint8_t kVersion = 2;
+
+enum class Kind : uint8_t {
+    kKeyframe = 0,
+    kDelta = 1,
+    kSummary = 2,
+    kHealth = 3,
+    kTiming = 4,
+};
+
+enum Section : uint8_t {
+    kAht20,
+    kBmp280,
+    kMpu6050,
+    kVeml7700,
+    kHscdtd,
+    kGpsFix,
+    kGpsTime,
+    kGpsMotion,
+    kOrientation,
+    kSectionCount,
+};
+
+enum Field : uint8_t {
+    kAhtTemperature,
+    kAhtHumidity,
+    kAhtStatus,
+    kBmpTemperature,
+    kBmpPressure,
+    kAccelX,
+    kAccelY,
+    kAccelZ,
+    kGyroX,
+    kGyroY,
+    kGyroZ,
+    kMpuTemperature,
+    kLux,
+    kMagX,
+    kMagY,
+    kMagZ,
+    kHeading,
+    kLatitude,
+    kLongitude,
+    kFixType,
+    kSatellites,
+    kHdop,
+    kTime,
+    kSpeed,
+    kCourse,
+    kRoll,
+    kPitch,
+    kOrientationHeading,
+    kFieldCount,
+};
+
+struct FieldFormat {
+    Section section;
+    uint8_t bytes;     // 1..4 on the wire
+    bool is_signed;
+    int32_t scale;     // wire value / scale = engineering unit
+    const char *name;  // key in the ASCII line
+};
+
+// In Field order; fields of one section are contiguous.
+constexpr FieldFormat kFields[kFieldCount] = {
+    {kAht20, 2, true, 100, "ahtT"},            // degC
+    {kAht20, 2, false, 100, "ahtH"},           // %RH
+    {kAht20, 1, false, 1, "ahtStatus"},
+    {kBmp280, 2, true, 100, "bmpT"},           // degC
+    {kBmp280, 3, false, 100, "bmpP"},          // Pa
+    {kMpu6050, 2, true, 1, "ax"},              // raw LSB
+    {kMpu6050, 2, true, 1, "ay"},
+    {kMpu6050, 2, true, 1, "az"},
+    {kMpu6050, 2, true, 1, "gx"},
+    {kMpu6050, 2, true, 1, "gy"},
+    {kMpu6050, 2, true, 1, "gz"},
+    {kMpu6050, 2, true, 100, "mpuT"},          // degC
+    {kVeml7700, 3, false, 100, "lux"},
+    {kHscdtd, 2, true, 1, "magX"},             // LSB, after calibration
+    {kHscdtd, 2, true, 1, "magY"},
+    {kHscdtd, 2, true, 1, "magZ"},
+    {kHscdtd, 2, false, 100, "head"},          // degrees
+    {kGpsFix, 4, true, 10000000, "lat"},       // degrees
+    {kGpsFix, 4, true, 10000000, "lon"},
+    {kGpsFix, 1, false, 1, "fixType"},
+    {kGpsFix, 1, false, 1, "sats"},
+    {kGpsFix, 2, false, 100, "hdop"},
+    {kGpsTime, 4, false, 1, "time"},           // seconds since 2000-01-01 UTC
+    {kGpsMotion, 3, false, 1000, "spd"},       // m/s
+    {kGpsMotion, 2, false, 100, "crs"},        // degrees
+    {kOrientation, 2, true, 100, "roll"},      // degrees
+    {kOrientation, 2, true, 100, "pitch"},
+    {kOrientation, 2, false, 100, "hdg"},
+};
+
+// Prefix of the per-section sample counts in the ASCII summary line.
+constexpr const char *kSectionNames[kSectionCount] = {
+    "aht", "bmp", "mpu", "lux", "mag", "fix", "time", "motion", "ahrs",
+};
+
+// Headings and course wrap at 360 degrees.
+constexpr bool IsAngle(int field) {
+    return field == kHeading || field == kCourse || field == kOrientationHeading;
+}
+constexpr int32_t kFullTurn = 36000;  // of an angle field, in wire units
+
+constexpr std::size_t kHeaderBytes = 4;
+
+static_assert(kSectionCount <= 16, "section bitmap is 16 bits");
+constexpr std::size_t kCrcBytes = 2;
+
+constexpr std::size_t kMaxVarintBytes = 5;
+
+constexpr std::size_t MaxKeyframeBytes() {
+    std::size_t total = kHeaderBytes;
+    for (const FieldFormat &field : kFields) {
+        total += field.bytes;
+    }
+    return total;
+}
+
+constexpr std::size_t kMaxKeyframeBytes = MaxKeyframeBytes();
+constexpr std::size_t kMaxDeltaBytes = kHeaderBytes + kMaxVarintBytes * kFieldCount;
+constexpr std::size_t kMaxRecordBytes = kMaxDeltaBytes > kMaxKeyframeBytes ? kMaxDeltaBytes : kMaxKeyframeBytes;
+// COBS adds one byte per 254 plus the leading code byte; then the delimiter.
+constexpr std::size_t FrameBytes(std::size_t record_bytes) {
+    return record_bytes + kCrcBytes + (record_bytes + kCrcBytes) / 254 + 2;
+}
+constexpr std::size_t kMaxFrameBytes = FrameBytes(kMaxRecordBytes);
+// Summaries are sent once a window and are several times larger, so they
+// get their own bounds rather than growing every per-sample buffer.
+constexpr std::size_t kWindowBytes = 2;
+constexpr std::size_t kMaxSummaryBytes =
+    MaxKeyframeBytes() + kWindowBytes + kMaxVarintBytes * (kSectionCount + 3 * kFieldCount);
+constexpr std::size_t kMaxSummaryFrameBytes = FrameBytes(kMaxSummaryBytes);
+
+// One record's worth of quantised values; only fields of sections set in
+// `sections` are meaningful.
+struct Sample {
+    uint8_t sequence = 0;
+    uint16_t sections = 0;
+    int32_t values[kFieldCount] = {};
+};
+
+// Statistics of one field over a summary window, in wire units.
+struct FieldSummary {
+    int32_t mean = 0;
+    int32_t min = 0;
+    int32_t max = 0;
+    uint32_t sd = 0;  // population standard deviation
+};
+
+// One window's worth of summaries; only sections set in `sections` (those
+// with counts[section] > 0) are meaningful.
+struct Summary {
+    uint8_t sequence = 0;
+    uint16_t sections = 0;
+    uint16_t window_s = 0;
+    uint32_t counts[kSectionCount] = {};
+    FieldSummary fields[kFieldCount] = {};
+};
+
+// Per-address I2C counters, as in i2c::DeviceHealth.
+struct DeviceHealth {
+    uint8_t addr = 0;
+    uint32_t completed = 0;
+    uint32_t nacks = 0;
+    uint32_t timeouts = 0;
+    uint32_t bus_errors = 0;
+    uint32_t retries = 0;
+    uint32_t failed = 0;
+};
+
+constexpr std::size_t kMaxHealthDevices = 8;
+constexpr std::size_t kDeviceHealthCounters = 6;
+
+struct Health {
+    uint8_t sequence = 0;
+    uint32_t asleep_permille = 0;
+    uint32_t wake_latency_mean_us = 0;
+    uint32_t wake_latency_max_us = 0;
+    uint32_t recoveries = 0;
+    uint32_t recovery_failures = 0;
+    uint32_t watchdog_resets = 0;
+    uint8_t fault_stage = 0xFF;  // kNoStage
+    uint8_t device_count = 0;
+    DeviceHealth devices[kMaxHealthDevices];
+};
+
+constexpr std::size_t kMaxHealthBytes =
+    kHeaderBytes + 6 * kMaxVarintBytes + 2 + kMaxHealthDevices * (1 + kDeviceHealthCounters * kMaxVarintBytes);
+constexpr std::size_t kMaxHealthFrameBytes = FrameBytes(kMaxHealthBytes);
+
+// Stages of the firmware timed for the timing record and supervised by the
+// watchdog: the GPS poll, each sensor's read, rendering the display and
+// publishing the readings.
+enum Stage : uint8_t {
+    kStageGps,
+    kStageAht20,
+    kStageBmp280,
+    kStageMpu6050,
+    kStageVeml7700,
+    kStageHscdtd,
+    kStageRender,
+    kStagePublish,
+    kStageCount,
+};
+// In place of a stage: none.
+constexpr uint8_t kNoStage = 0xFF;
+
+// Prefix of each stage's keys in the ASCII timing line.
+constexpr const char *kStageNames[kStageCount] = {
+    "gps", "aht", "bmp", "mpu", "lux", "mag", "render", "publish",
+};
+
+// Duration histogram buckets, doubling in width: bucket 0 counts samples
+// under kTimingBucketBaseUs, bucket n those under kTimingBucketBaseUs << n,
+// and the last everything longer.
+constexpr int kTimingBuckets = 12;
+constexpr uint32_t kTimingBucketBaseUs = 32;
+
+inline int TimingBucket(uint32_t us) {
+    int bucket = 0;
+    while (bucket < kTimingBuckets - 1 && us >= kTimingBucketBaseUs << bucket) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+struct StageTiming {
+    uint32_t count = 0;  // samples in the window
+    uint32_t mean_us = 0;
+    uint32_t max_us = 0;
+    uint32_t peak_us = 0;  // since boot
+    uint32_t buckets[kTimingBuckets] = {};
+};
+
+struct Timing {
+    uint8_t sequence = 0;
+    uint16_t stages = 0;  // bit n set = stages[n] is meaningful
+    StageTiming stage[kStageCount];
+};
+
+static_assert(kStageCount <= 16, "stage bitmap is 16 bits");
+constexpr std::size_t kMaxTimingBytes = kHeaderBytes + kStageCount * (4 + kTimingBuckets) * kMaxVarintBytes;
+constexpr std::size_t kMaxTimingFrameBytes = FrameBytes(kMaxTimingBytes);
+
+// Zigzag maps small magnitudes of either sign to small unsigned values:
+// 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+inline uint32_t ZigZag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+inline int32_t UnZigZag(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1u)));
+}
+
+// Difference in 32-bit two's complement, so deltas wrap instead of
+// overflowing; applying it with the same wrap restores the value exactly.
+inline int32_t WrappingDelta(int32_t value, int32_t reference) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value) - static_cast<uint32_t>(reference));
+}
+
+inline int32_t WrappingAdd(int32_t reference, int32_t delta) {
+    return static_cast<int32_t>(static_cast<uint32_t>(reference) + static_cast<uint32_t>(delta));
+}
+
+// Frame check: CRC-16/CCITT-FALSE over the record.
+using utils::Crc16;
+
+}  // namespace record
+}  // namespace telemetry
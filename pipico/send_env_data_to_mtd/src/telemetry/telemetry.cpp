@@ -1,89 +1,370 @@
 #include "telemetry/telemetry.h"
 
-#include <cmath>
+#include <atomic>
 #include <cstdio>
 
 #include "app/app_config.h"
-#include "hardware/gpio.h"
-#include "hardware/uart.h"
-#include "pico/stdlib.h"
+#include "app/sensor_registry.h"
+#include "hal/hal.h"
+#include "telemetry/backlog.h"
+#include "telemetry/record.h"
+#include "utils/format.h"
 
 namespace telemetry {
 
 namespace {
-constexpr std::size_t kBufferSize = 320;
+constexpr std::size_t kBufferSize = 448;
+// Four numbers for each of the 28 fields.
+constexpr std::size_t kSummaryBufferSize = 1280;
+// Four numbers and up to twelve buckets for each of the 8 stages.
+constexpr std::size_t kTimingBufferSize = 1024;
+// Backlog records sent per Drain(), bounding the time core1 spends on it
+// after an outage; CTS usually stops it sooner.
+constexpr uint32_t kDrainRecords = 16;
 
-float ValueOrNan(bool valid, float value) {
-    return valid ? value : std::nanf("");
-}
+using app::registry::ValueOrNan;
 
 int BoolToInt(bool flag) {
     return flag ? 1 : 0;
 }
 
-}  // namespace
+Format format = app::config::TELEMETRY_BINARY ? Format::kBinary : Format::kAscii;
+// Read by the supervisor on core0 to keep it through a watchdog reset.
+std::atomic<uint8_t> sequence{0};
 
-void Init() {
-    uart_init(app::config::MESH_UART, app::config::BAUD_RATE);
-    gpio_set_function(app::config::UART_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(app::config::UART_RX_PIN, GPIO_FUNC_UART);
-    uart_set_fifo_enabled(app::config::MESH_UART, true);
+// Delta stream state: the last record sent, and how many records remain
+// before the next keyframe (0 forces one).
+uint32_t keyframe_interval = app::config::TELEMETRY_KEYFRAME_INTERVAL;
+uint32_t until_keyframe = 0;
+record::Sample reference;
+
+// Whether a binary frame went out since boot or the last format change.
+bool framing = false;
+
+// Straight to the node when it is ready for it and nothing older is
+// waiting, which keeps flash out of the normal path; otherwise through the
+// flash backlog when it is on, or not at all.
+void Send(const uint8_t *data, std::size_t len) {
+    if (app::config::TELEMETRY_BACKLOG) {
+        if (!backlog::Empty()) {
+            backlog::Drain(kDrainRecords);
+        }
+        if (!backlog::Empty() || !hal::UartClearToSend(app::config::MESH_UART)) {
+            backlog::Append(data, len);
+            return;
+        }
+    }
+    if (hal::UartClearToSend(app::config::MESH_UART)) {
+        hal::UartWrite(app::config::MESH_UART, data, len);
+    }
 }
 
-void Publish(const app::model::SensorSnapshot &snapshot) {
+// A frame only ends at a 0x00, so the first one also starts with one:
+// half a record from before a reset, or console output sharing the link,
+// then ends there instead of corrupting it. Frames never carry anything
+// else in between, not even console output.
+void SendFrame(const uint8_t *frame, std::size_t len) {
+    if (!framing) {
+        static const uint8_t kDelimiter = 0x00;
+        Send(&kDelimiter, 1);
+        framing = true;
+    }
+    Send(frame, len);
+}
+
+void PublishAscii(const app::model::SensorSnapshot &snapshot) {
     char buffer[kBufferSize];
+    utils::format::Writer out(buffer, sizeof(buffer));
 
-    const float altitude = snapshot.bmp280.valid ? snapshot.bmp280.altitude_m : std::nanf("");
-
-    int length = std::snprintf(buffer, sizeof(buffer),
-                               "ahtT=%.2f,ahtH=%.2f,ahtStatus=0x%02X,"
-                               "bmpT=%.2f,bmpP=%.2f,alt=%.2f,"
-                               "mpuOk=%d,ax=%d,ay=%d,az=%d,gx=%d,gy=%d,gz=%d,mpuT=%.2f,"
-                               "luxOk=%d,lux=%.2f,"
-                               "magOk=%d,magX=%d,magY=%d,magZ=%d,head=%.1f,"
-                               "gpsfix=%d",
-                               snapshot.aht20.temperature_c,
-                               snapshot.aht20.humidity_pct,
-                               snapshot.aht20.status,
-                               ValueOrNan(snapshot.bmp280.valid, snapshot.bmp280.temperature_c),
-                               ValueOrNan(snapshot.bmp280.valid, snapshot.bmp280.pressure_pa),
-                               altitude,
-                               BoolToInt(snapshot.mpu6050.valid),
-                               snapshot.mpu6050.accel_x,
-                               snapshot.mpu6050.accel_y,
-                               snapshot.mpu6050.accel_z,
-                               snapshot.mpu6050.gyro_x,
-                               snapshot.mpu6050.gyro_y,
-                               snapshot.mpu6050.gyro_z,
-                               ValueOrNan(snapshot.mpu6050.valid, snapshot.mpu6050.temperature_c),
-                               BoolToInt(snapshot.veml7700.valid),
-                               ValueOrNan(snapshot.veml7700.valid, snapshot.veml7700.lux),
-                               BoolToInt(snapshot.hscdtd.valid),
-                               snapshot.hscdtd.x,
-                               snapshot.hscdtd.y,
-                               snapshot.hscdtd.z,
-                               ValueOrNan(snapshot.hscdtd.valid, snapshot.hscdtd.heading_deg),
-                               BoolToInt(snapshot.gps.fix));
-
-    if (length < 0 || static_cast<std::size_t>(length) >= sizeof(buffer)) {
+    // The sensors' fields, then those derived from several of them.
+    auto separate = [&out] {
+        if (out.Length() > 0) {
+            out.Char(',');
+        }
+    };
+    app::registry::ForEach(app::registry::Sensors(), [&](auto sensor) {
+        using Sensor = decltype(sensor);
+        separate();
+        Sensor::Telemetry(snapshot.*Sensor::kSlot, out);
+    });
+    separate();
+    const app::model::OrientationData &ahrs = snapshot.orientation;
+    out.Text("ahrsOk=").Int(BoolToInt(ahrs.valid))
+        .Text(",roll=").Fixed(ValueOrNan(ahrs.valid, ahrs.roll_deg), 1)
+        .Text(",pitch=").Fixed(ValueOrNan(ahrs.valid, ahrs.pitch_deg), 1)
+        .Text(",hdg=").Fixed(ValueOrNan(ahrs.valid, ahrs.heading_deg), 1)
+        .Text(",gpsfix=").Int(BoolToInt(snapshot.gps.fix));
+
+    if (snapshot.gps.fix) {
+        const app::model::GpsData &gps = snapshot.gps;
+        out.Text(",lat=").Decimal(gps.latitude_e7, 7)
+            .Text(",lon=").Decimal(gps.longitude_e7, 7)
+            .Text(",sats=").Int(gps.satellites_used)
+            .Text(",hdop=").Decimal(gps.hdop_centi, 2)
+            .Text(",spd=").Int(gps.speed_mm_s)
+            .Text(",crs=").Decimal(gps.course_centideg, 2);
+    }
+    out.Char('\n');
+    if (!out.Ok()) {
         return;
     }
 
-    if (snapshot.gps.fix) {
-        const int appended = std::snprintf(buffer + length, sizeof(buffer) - static_cast<std::size_t>(length),
-                                           ",lat=%.6f,lon=%.6f\n",
-                                           snapshot.gps.latitude,
-                                           snapshot.gps.longitude);
-        if (appended > 0) {
-            length += appended;
-        }
+    printf("%s", buffer);
+    Send(reinterpret_cast<const uint8_t *>(buffer), out.Length());
+}
+
+// Packed record, as deltas against the previous one between keyframes. A
+// delta that would not be smaller (say, after a section comes back) goes
+// out as a keyframe instead.
+void PublishBinary(const app::model::SensorSnapshot &snapshot) {
+    record::Sample sample;
+    record::Quantize(snapshot, sample);
+    sample.sequence = sequence++;
+
+    uint8_t keyframe[record::kMaxRecordBytes];
+    uint8_t delta[record::kMaxRecordBytes];
+    const std::size_t keyframe_len = record::PackKeyframe(sample, keyframe);
+    std::size_t delta_len = 0;
+    if (until_keyframe > 0) {
+        delta_len = record::PackDelta(sample, reference, delta);
+    }
+
+    const bool use_delta = delta_len > 0 && delta_len < keyframe_len;
+    const record::Kind kind = use_delta ? record::Kind::kDelta : record::Kind::kKeyframe;
+    if (use_delta) {
+        --until_keyframe;
     } else {
-        std::snprintf(buffer + length, sizeof(buffer) - static_cast<std::size_t>(length), "\n");
+        until_keyframe = keyframe_interval > 0 ? keyframe_interval - 1 : 0;
+    }
+    record::Advance(sample, kind, reference);
+
+    uint8_t frame[record::kMaxFrameBytes];
+    const std::size_t frame_len =
+        record::Frame(use_delta ? delta : keyframe, use_delta ? delta_len : keyframe_len, frame);
+
+    SendFrame(frame, frame_len);
+}
+
+// Decimal places of a power-of-ten wire scale.
+int Decimals(int32_t scale) {
+    int decimals = 0;
+    for (; scale >= 10; scale /= 10) {
+        ++decimals;
+    }
+    return decimals;
+}
+
+void PublishSummaryAscii(const record::Summary &summary) {
+    // Core1's stack is small; this only ever runs there.
+    static char buffer[kSummaryBufferSize];
+    utils::format::Writer out(buffer, sizeof(buffer));
+
+    out.Text("win=").Int(summary.window_s);
+    for (int s = 0; s < record::kSectionCount; ++s) {
+        if ((summary.sections & (1u << s)) != 0) {
+            out.Char(',').Text(record::kSectionNames[s]).Text("N=").Int(summary.counts[s]);
+        }
+    }
+    // Wire units are fixed point already, so the statistics print exactly.
+    for (int i = 0; i < record::kFieldCount; ++i) {
+        const record::FieldFormat &format = record::kFields[i];
+        if ((summary.sections & (1u << format.section)) == 0) {
+            continue;
+        }
+        const record::FieldSummary &field = summary.fields[i];
+        const int decimals = Decimals(format.scale);
+        out.Char(',').Text(format.name).Char('=').Decimal(field.mean, decimals)
+            .Char('/').Decimal(field.min, decimals)
+            .Char('/').Decimal(field.max, decimals)
+            .Char('/').Decimal(field.sd, decimals);
+    }
+    out.Char('\n');
+    if (!out.Ok()) {
+        return;
+    }
+
+    printf("%s", buffer);
+    Send(reinterpret_cast<const uint8_t *>(buffer), out.Length());
+}
+
+// Summaries stand alone, so they take a sequence number but leave the delta
+// stream alone; the next per-sample record is a keyframe.
+void PublishSummaryBinary(const record::Summary &summary) {
+    static uint8_t packed[record::kMaxSummaryBytes];
+    static uint8_t frame[record::kMaxSummaryFrameBytes];
+    static record::Summary numbered;
+    numbered = summary;
+    numbered.sequence = sequence++;
+    until_keyframe = 0;
+    const std::size_t frame_len = record::Frame(packed, record::PackSummary(numbered, packed), frame);
+
+    SendFrame(frame, frame_len);
+}
+
+void PublishHealthAscii(const record::Health &health) {
+    char buffer[kBufferSize];
+    utils::format::Writer out(buffer, sizeof(buffer));
+
+    out.Text("sleep=").Decimal(health.asleep_permille, 1)
+        .Text(",wakeUs=").Int(health.wake_latency_mean_us).Char('/').Int(health.wake_latency_max_us)
+        .Text(",i2cRec=").Int(health.recoveries).Char('/').Int(health.recovery_failures)
+        .Text(",wdt=").Int(health.watchdog_resets).Char('/')
+        .Text(health.fault_stage < record::kStageCount ? record::kStageNames[health.fault_stage] : "-");
+    for (uint8_t i = 0; i < health.device_count && i < record::kMaxHealthDevices; ++i) {
+        const record::DeviceHealth &device = health.devices[i];
+        out.Text(",i2c").Hex(device.addr, 2).Char('=').Int(device.completed)
+            .Char('/').Int(device.nacks)
+            .Char('/').Int(device.timeouts)
+            .Char('/').Int(device.bus_errors)
+            .Char('/').Int(device.retries)
+            .Char('/').Int(device.failed);
+    }
+    out.Char('\n');
+    if (!out.Ok()) {
+        return;
+    }
+
+    printf("%s", buffer);
+    Send(reinterpret_cast<const uint8_t *>(buffer), out.Length());
+}
+
+// Off the delta stream like a summary.
+void PublishHealthBinary(const record::Health &health) {
+    uint8_t packed[record::kMaxHealthBytes];
+    uint8_t frame[record::kMaxHealthFrameBytes];
+    record::Health numbered = health;
+    numbered.sequence = sequence++;
+    until_keyframe = 0;
+    const std::size_t frame_len = record::Frame(packed, record::PackHealth(numbered, packed), frame);
+
+    SendFrame(frame, frame_len);
+}
+
+// Histograms stop at the last non-empty bucket.
+void PublishTimingAscii(const record::Timing &timing) {
+    static char buffer[kTimingBufferSize];
+    utils::format::Writer out(buffer, sizeof(buffer));
+
+    for (int s = 0; s < record::kStageCount; ++s) {
+        if ((timing.stages & (1u << s)) == 0) {
+            continue;
+        }
+        const record::StageTiming &stage = timing.stage[s];
+        if (out.Length() > 0) {
+            out.Char(',');
+        }
+        out.Text(record::kStageNames[s]).Char('=').Int(stage.count)
+            .Char('/').Int(stage.mean_us)
+            .Char('/').Int(stage.max_us)
+            .Char('/').Int(stage.peak_us)
+            .Char(',').Text(record::kStageNames[s]).Text("H=").Int(stage.buckets[0]);
+        int last = record::kTimingBuckets - 1;
+        while (last > 0 && stage.buckets[last] == 0) {
+            --last;
+        }
+        for (int b = 1; b <= last; ++b) {
+            out.Char(':').Int(stage.buckets[b]);
+        }
+    }
+    out.Char('\n');
+    if (!out.Ok()) {
+        return;
     }
 
     printf("%s", buffer);
-    uart_puts(app::config::MESH_UART, buffer);
-    stdio_flush();
+    Send(reinterpret_cast<const uint8_t *>(buffer), out.Length());
+}
+
+// Off the delta stream like a summary.
+void PublishTimingBinary(const record::Timing &timing) {
+    static uint8_t packed[record::kMaxTimingBytes];
+    static uint8_t frame[record::kMaxTimingFrameBytes];
+    static record::Timing numbered;
+    numbered = timing;
+    numbered.sequence = sequence++;
+    until_keyframe = 0;
+    const std::size_t frame_len = record::Frame(packed, record::PackTiming(numbered, packed), frame);
+
+    SendFrame(frame, frame_len);
+}
+
+}  // namespace
+
+void Init() {
+    hal::UartInit(app::config::MESH_UART, app::config::BAUD_RATE,
+                  app::config::UART_TX_PIN, app::config::UART_RX_PIN);
+    if (app::config::MESH_FLOW_CONTROL) {
+        hal::UartEnableCts(app::config::MESH_UART, app::config::MESH_CTS_PIN);
+    }
+    if (app::config::TELEMETRY_BACKLOG) {
+        backlog::Init();
+    }
+}
+
+void SetFormat(Format new_format) {
+    format = new_format;
+    until_keyframe = 0;
+    framing = false;
+}
+
+void SetKeyframeInterval(uint32_t records) {
+    keyframe_interval = records;
+    until_keyframe = 0;
+}
+
+Format GetFormat() {
+    return format;
+}
+
+uint8_t NextSequence() {
+    return sequence.load(std::memory_order_relaxed);
+}
+
+void ResumeSequence(uint8_t next) {
+    sequence.store(next, std::memory_order_relaxed);
+    until_keyframe = 0;
+}
+
+void Drain() {
+    if (app::config::TELEMETRY_BACKLOG) {
+        backlog::Drain(kDrainRecords);
+    }
+}
+
+void Publish(const app::model::SensorSnapshot &snapshot) {
+    if (format == Format::kBinary) {
+        PublishBinary(snapshot);
+    } else {
+        PublishAscii(snapshot);
+    }
+    hal::StdioFlush();
+}
+
+void PublishSummary(const record::Summary &summary) {
+    if (format == Format::kBinary) {
+        PublishSummaryBinary(summary);
+    } else {
+        PublishSummaryAscii(summary);
+    }
+    hal::StdioFlush();
+}
+
+void PublishHealth(const record::Health &health) {
+    if (format == Format::kBinary) {
+        PublishHealthBinary(health);
+    } else {
+        PublishHealthAscii(health);
+    }
+    hal::StdioFlush();
+}
+
+void PublishTiming(const record::Timing &timing) {
+    if (format == Format::kBinary) {
+        PublishTimingBinary(timing);
+    } else {
+        PublishTimingAscii(timing);
+    }
+    hal::StdioFlush();
 }
 
 }  // namespace telemetry
@@ -1,10 +1,50 @@
 #pragma once
 
+#include <cstdint>
+
 #include "app/measurement_types.h"
+#include "telemetry/record_format.h"
 
 namespace telemetry {
 
+// What Publish() sends to the mesh node. kAscii is the key=value line;
+// kBinary is the COBS-framed record described in record_format.h, a
+// fraction of the size. The boot default is app::config::TELEMETRY_BINARY.
+enum class Format {
+    kAscii,
+    kBinary,
+};
+
 void Init();
+void SetFormat(Format format);
+Format GetFormat();
+// Binary format only: send a keyframe every `records` records and deltas
+// in between. 1 (or 0) sends keyframes only.
+void SetKeyframeInterval(uint32_t records);
+// The sequence number the next binary record takes. After a watchdog
+// reset the supervisor carries on from where the stream stopped, starting
+// with a keyframe; call it before output::Launch().
+uint8_t NextSequence();
+void ResumeSequence(uint8_t next);
+// Encodes the snapshot and queues it for the mesh node (see backlog.h).
 void Publish(const app::model::SensorSnapshot &snapshot);
+// Encodes one window summary (see aggregate.h) and queues it the same way.
+// ASCII: win=<s>, a <section>N=<count> per section, then
+// <field>=<mean>/<min>/<max>/<sd> per field, in the units of the record.
+void PublishSummary(const record::Summary &summary);
+// Encodes the I2C health counters and queues them the same way.
+// ASCII: sleep=<% of time in the sleep state>,wakeUs=<mean>/<max wake-up
+// latency>,i2cRec=<recoveries>/<failed recoveries>,wdt=<watchdog
+// resets>/<stage blamed for the last, or ->, then per address
+// i2c<addr>=<completed>/<nacks>/<timeouts>/<bus errors>/<retries>/<failed>.
+void PublishHealth(const record::Health &health);
+// Encodes one window of stage timings (see profile/profile.h) and queues
+// it the same way. ASCII, per stage that has run: <stage>=<samples>/<mean
+// us>/<max us>/<max us since boot>,<stage>H=<bucket 0>:<bucket 1>:... up
+// to the last non-empty bucket.
+void PublishTiming(const record::Timing &timing);
+// Sends what the backlog holds while the node takes it. Core1 calls it on
+// every wake-up, so a backlog drains between publishes too.
+void Drain();
 
 }  // namespace telemetry
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Allocation-free number formatting straight into caller buffers, for the
+// telemetry line and the display. It covers what those used printf for
+// (integers in a field width, fixed decimals, hex, NaN) without printf's
+// double-precision arithmetic, which the RP2350 does in software, and its
+// large stack frame. A float is split into whole and fractional parts in
+// single precision, and digits come from 32-bit division whenever the
+// value fits.
+namespace utils {
+namespace format {
+
+// Appends to a fixed buffer and keeps it NUL-terminated. Output that does
+// not fit is cut off and Ok() turns false; calls chain either way.
+class Writer {
+public:
+    Writer(char *buffer, std::size_t size) : buffer_(buffer), size_(size) {
+        if (size_ > 0) {
+            buffer_[0] = '\0';
+        } else {
+            ok_ = false;
+        }
+    }
+
+    Writer &Char(char c) {
+        Put(&c, 1, 0);
+        return *this;
+    }
+
+    Writer &Text(const char *text) {
+        std::size_t len = 0;
+        while (text[len] != '\0') {
+            ++len;
+        }
+        Put(text, len, 0);
+        return *this;
+    }
+
+    // Decimal, right-aligned in `width` characters like printf's %*d;
+    // `plus` puts a + before values >= 0.
+    Writer &Int(int64_t value, int width = 0, bool plus = false) {
+        return Decimal(value, 0, width, plus);
+    }
+
+    // Upper-case hex, zero-padded to `digits` (%0*X).
+    Writer &Hex(uint32_t value, int digits) {
+        char text[8];
+        int pos = sizeof(text);
+        do {
+            text[--pos] = "0123456789ABCDEF"[value & 0x0F];
+            value >>= 4;
+        } while (value != 0 && pos > 0);
+        while (pos > 0 && static_cast<int>(sizeof(text)) - pos < digits) {
+            text[--pos] = '0';
+        }
+        Put(text + pos, sizeof(text) - static_cast<std::size_t>(pos), 0);
+        return *this;
+    }
+
+    // An integer count of 10^-decimals units, exactly: Decimal(-1623, 2) is
+    // "-16.23". For values already in fixed point, such as wire units.
+    Writer &Decimal(int64_t value, int decimals, int width = 0, bool plus = false) {
+        decimals = Clamp(decimals);
+        const uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        const uint32_t unit = kPow10[decimals];
+        uint64_t whole;
+        uint32_t fraction;
+        if (magnitude <= 0xFFFFFFFFu) {
+            whole = static_cast<uint32_t>(magnitude) / unit;
+            fraction = static_cast<uint32_t>(magnitude) % unit;
+        } else {
+            whole = magnitude / unit;
+            fraction = static_cast<uint32_t>(magnitude % unit);
+        }
+        Number(value < 0, whole, fraction, decimals, width, plus);
+        return *this;
+    }
+
+    // `value` to `decimals` places (0..7), like %*.*f: rounded to nearest,
+    // ties to even. NaN is written "nan" and infinities "inf" / "-inf".
+    Writer &Fixed(float value, int decimals, int width = 0, bool plus = false) {
+        decimals = Clamp(decimals);
+        if (value != value) {
+            Put("nan", 3, width);
+            return *this;
+        }
+        const bool negative = value < 0.0f;
+        const float magnitude = negative ? -value : value;
+        if (magnitude > 1.8e19f) {  // also infinity; beyond uint64
+            Put(negative ? "-inf" : "inf", negative ? 4 : 3, width);
+            return *this;
+        }
+        uint64_t whole = magnitude < 4294967296.0f ? static_cast<uint32_t>(magnitude)
+                                                   : static_cast<uint64_t>(magnitude);
+        // Exact: the whole part is one of the float's own values.
+        const float scaled = (magnitude - static_cast<float>(whole)) * static_cast<float>(kPow10[decimals]);
+        uint32_t fraction = static_cast<uint32_t>(scaled);
+        const float rest = scaled - static_cast<float>(fraction);
+        const bool odd = decimals > 0 ? (fraction & 1) != 0 : (whole & 1) != 0;
+        if (rest > 0.5f || (rest == 0.5f && odd)) {
+            ++fraction;
+        }
+        if (fraction >= kPow10[decimals]) {
+            fraction -= kPow10[decimals];
+            ++whole;
+        }
+        Number(negative, whole, fraction, decimals, width, plus);
+        return *this;
+    }
+
+    bool Ok() const {
+        return ok_;
+    }
+
+    std::size_t Length() const {
+        return length_;
+    }
+
+    const char *Str() const {
+        return buffer_;
+    }
+
+private:
+    static constexpr uint32_t kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+
+    static int Clamp(int decimals) {
+        return decimals < 0 ? 0 : decimals > 7 ? 7 : decimals;
+    }
+
+    // Built right to left: fraction, point, whole part, sign.
+    void Number(bool negative, uint64_t whole, uint32_t fraction, int decimals, int width, bool plus) {
+        char text[32];
+        int pos = sizeof(text);
+        for (int i = 0; i < decimals; ++i) {
+            text[--pos] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        if (decimals > 0) {
+            text[--pos] = '.';
+        }
+        while (whole > 0xFFFFFFFFu) {
+            text[--pos] = static_cast<char>('0' + whole % 10);
+            whole /= 10;
+        }
+        uint32_t low = static_cast<uint32_t>(whole);
+        do {
+            text[--pos] = static_cast<char>('0' + low % 10);
+            low /= 10;
+        } while (low != 0);
+        if (negative) {
+            text[--pos] = '-';
+        } else if (plus) {
+            text[--pos] = '+';
+        }
+        Put(text + pos, sizeof(text) - static_cast<std::size_t>(pos), width);
+    }
+
+    void Put(const char *text, std::size_t len, int width) {
+        for (int i = static_cast<int>(len); i < width; ++i) {
+            Append(' ');
+        }
+        for (std::size_t i = 0; i < len; ++i) {
+            Append(text[i]);
+        }
+        if (size_ > 0) {
+            buffer_[length_] = '\0';
+        }
+    }
+
+    void Append(char c) {
+        if (length_ + 1 < size_) {
+            buffer_[length_++] = c;
+        } else {
+            ok_ = false;
+        }
+    }
+
+    char *buffer_;
+    std::size_t size_;
+    std::size_t length_ = 0;
+    bool ok_ = true;
+};
+
+}  // namespace format
+}  // namespace utils
@@ -2,14 +2,14 @@
 
 #include <cstdlib>
 
-#include "pico/time.h"
+#include "hal/hal.h"
 
 namespace utils {
 
 void EnsureRandomSeeded() {
     static bool seeded = false;
     if (!seeded) {
-        srand(static_cast<unsigned>(time_us_64()));
+        srand(static_cast<unsigned>(hal::TimeUs()));
         seeded = true;
     }
 }